@@ -10,13 +10,17 @@
 #include <stdbool.h>    // only required for C99
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 // OpenGL context+window using GLFW
 #define WINDOW_TITLE "shader hot reload demo"
 GLFWwindow* window;
-// set a max limit on shader length to avoid dynamic memory allocation
-#define MAX_SHADER_SZ 100000
+// both shaders' text is read into this one buffer. it's kept between reloads and only ever grows, so shaders can be
+// any length but reloading doesn't allocate memory every time
+char* shader_text_buffer;
+size_t shader_text_buffer_sz;
 
 // geometry to display
 GLuint triangle_vao;   // mesh/attribute descriptor handle
@@ -162,28 +166,47 @@ GLuint create_shader_program_from_files( const char* vertex_shader_filename, con
 
   printf( "loading shader from files `%s` and `%s`\n", vertex_shader_filename, fragment_shader_filename );
 
-  char vs_shader_str[MAX_SHADER_SZ];
-  char fs_shader_str[MAX_SHADER_SZ];
-  vs_shader_str[0] = fs_shader_str[0] = '\0';
-  { // read vertex shader file into a buffer
-    FILE* fp = fopen( vertex_shader_filename, "r" );
+  struct stat vs_stat, fs_stat;
+  if ( 0 != stat( vertex_shader_filename, &vs_stat ) ) {
+    fprintf( stderr, "ERROR: could not open vertex shader file `%s`\n", vertex_shader_filename );
+    return 0;
+  }
+  if ( 0 != stat( fragment_shader_filename, &fs_stat ) ) {
+    fprintf( stderr, "ERROR: could not open fragment shader file `%s`\n", fragment_shader_filename );
+    return 0;
+  }
+  { // grow the buffer if the files won't fit. +1 each for a null terminator
+    size_t sz_needed = (size_t)vs_stat.st_size + 1 + (size_t)fs_stat.st_size + 1;
+    if ( sz_needed > shader_text_buffer_sz ) {
+      char* grown = realloc( shader_text_buffer, sz_needed );
+      if ( !grown ) {
+        fprintf( stderr, "ERROR: out of memory for %u bytes of shader text\n", (unsigned int)sz_needed );
+        return 0;
+      }
+      shader_text_buffer    = grown;
+      shader_text_buffer_sz = sz_needed;
+    }
+  }
+  char* vs_shader_str = shader_text_buffer;
+  char* fs_shader_str = shader_text_buffer + vs_stat.st_size + 1;
+  { // read vertex shader file into the buffer in one go
+    FILE* fp = fopen( vertex_shader_filename, "rb" );
     if ( !fp ) {
       fprintf( stderr, "ERROR: could not open vertex shader file `%s`\n", vertex_shader_filename );
       return 0;
     }
-    size_t count = fread( vs_shader_str, 1, MAX_SHADER_SZ - 1, fp );
-    assert( count < MAX_SHADER_SZ - 1 ); // file was too long
+    // if an editor is part way through saving the file this may come up short. pressing R again reloads it
+    size_t count         = fread( vs_shader_str, 1, (size_t)vs_stat.st_size, fp );
     vs_shader_str[count] = '\0';
     fclose( fp );
   }
-  { // read fragment shader file into a buffer
-    FILE* fp = fopen( fragment_shader_filename, "r" );
+  { // read fragment shader file into the buffer in one go
+    FILE* fp = fopen( fragment_shader_filename, "rb" );
     if ( !fp ) {
       fprintf( stderr, "ERROR: could not open fragment shader file `%s`\n", fragment_shader_filename );
       return 0;
     }
-    size_t count = fread( fs_shader_str, 1, MAX_SHADER_SZ - 1, fp );
-    assert( count < MAX_SHADER_SZ - 1 ); // file was too long
+    size_t count         = fread( fs_shader_str, 1, (size_t)fs_stat.st_size, fp );
     fs_shader_str[count] = '\0';
     fclose( fp );
   }
@@ -244,6 +267,7 @@ int main() {
     }
   } // endwhile
 
+  free( shader_text_buffer );
   stop_opengl();
   return 0;
 }
@@ -0,0 +1,243 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless report for gl_log. No GL context required.                          |
+| Times messages per second through the demos' gl_log(), which opens and       |
+| closes the file every call, and through the buffered one on 1 and 4          |
+| threads: how fast callers get back, and how fast messages reach the file.    |
+| Checks every message arrives once, in order per thread, and that long        |
+| messages, level filtering, and flushing at exit and on a crash (abort() in   |
+| a child process) all work.                                                   |
+| Usage: bench_gl_log [message_count]                                          |
+\******************************************************************************/
+#include "gl_log.h"
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/wait.h>
+#include <unistd.h>
+#define BENCH_CAN_FORK 1
+#endif
+
+#define DEFAULT_MESSAGES 200000
+// the old gl_log gets this many times fewer messages, or it takes minutes
+#define OLD_LOG_DIVISOR 20
+#define MAX_THREADS 4
+#define CRASH_MESSAGES 5000
+#define TMP_LOG_FILE "bench_gl_log_tmp.log"
+#define TMP_OLD_LOG_FILE "bench_gl_log_old_tmp.log"
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+// the demos' gl_log(), for comparison
+static bool old_gl_log( const char* message, ... ) {
+  va_list argptr;
+  FILE* file = fopen( TMP_OLD_LOG_FILE, "a" );
+  if ( !file ) {
+    fprintf( stderr, "ERROR: could not open GL_LOG_FILE %s file for appending\n", TMP_OLD_LOG_FILE );
+    return false;
+  }
+  va_start( argptr, message );
+  vfprintf( file, message, argptr );
+  va_end( argptr );
+  fclose( file );
+  return true;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+/* every line after the header must be a "t<thread> m<number>" message, with
+each of n_threads' numbers running 0 to n_messages - 1 in order. returns the
+number of failures */
+static int check_log( const char* file_name, int n_threads, int n_messages ) {
+  FILE* f = fopen( file_name, "r" );
+  if ( !f ) {
+    fprintf( stderr, "ERROR: could not open %s\n", file_name );
+    return 1;
+  }
+  int next[MAX_THREADS] = { 0 };
+  int bad               = 0;
+  char line[1024];
+  while ( fgets( line, sizeof( line ), f ) ) {
+    if ( '[' != line[0] ) { continue; }
+    double seconds = 0.0;
+    char level     = 0;
+    int t = -1, m = -1;
+    if ( 4 != sscanf( line, "[%lf] %c t%i m%i", &seconds, &level, &t, &m ) || 'I' != level || t < 0 || t >= n_threads || m != next[t] ) {
+      if ( bad++ < 3 ) { fprintf( stderr, "ERROR: unexpected line in %s: %s", file_name, line ); }
+      continue;
+    }
+    next[t]++;
+  }
+  fclose( f );
+  for ( int t = 0; t < n_threads; t++ ) {
+    if ( next[t] != n_messages ) {
+      fprintf( stderr, "ERROR: %s has %i of thread %i's %i messages\n", file_name, next[t], t, n_messages );
+      bad++;
+    }
+  }
+  return bad ? 1 : 0;
+}
+
+static char* read_file( const char* file_name, long* sz ) {
+  FILE* f = fopen( file_name, "rb" );
+  if ( !f ) { return NULL; }
+  fseek( f, 0, SEEK_END );
+  *sz = ftell( f );
+  fseek( f, 0, SEEK_SET );
+  char* data = (char*)malloc( *sz + 1 );
+  *sz        = (long)fread( data, 1, *sz, f );
+  data[*sz]  = '\0';
+  fclose( f );
+  return data;
+}
+
+/* a message spanning many slots comes out whole, one too long for the ring
+is cut at GL_LOG_MAX_MESSAGE, and messages under the level are dropped.
+returns the number of failures */
+static int check_long_and_levels() {
+  int failures = 0;
+  if ( !restart_gl_log_file( TMP_LOG_FILE ) ) { return 1; }
+  const int long_len = 5000, too_long_len = GL_LOG_MAX_MESSAGE + 1000;
+  char* text         = (char*)malloc( too_long_len + 1 );
+  for ( int i = 0; i < too_long_len; i++ ) { text[i] = 'a' + i % 26; }
+  text[too_long_len] = '\0';
+  gl_log( "long %.*s\n", long_len, text );
+  gl_log( "too long %s\n", text );
+  set_gl_log_level( GL_LOG_WARNING );
+  gl_log( "dropped info\n" );
+  gl_log_at( GL_LOG_DEBUG, "dropped debug\n" );
+  gl_log_at( GL_LOG_WARNING, "kept warning\n" );
+  set_gl_log_level( GL_LOG_DEBUG );
+  close_gl_log();
+
+  long sz    = 0;
+  char* data = read_file( TMP_LOG_FILE, &sz );
+  if ( !data ) { return 1; }
+  const char* l = strstr( data, "] I long " );
+  if ( !l || strncmp( l + 9, text, long_len ) || '\n' != l[9 + long_len] ) {
+    fprintf( stderr, "ERROR: a %i character message didn't come out whole\n", long_len );
+    failures++;
+  }
+  const char* t = strstr( data, "] I too long " );
+  // cut to GL_LOG_MAX_MESSAGE including the "too long " and no newline
+  int kept = GL_LOG_MAX_MESSAGE - 9;
+  if ( !t || strncmp( t + 13, text, kept ) || t[13 + kept] != '[' ) {
+    fprintf( stderr, "ERROR: a message longer than GL_LOG_MAX_MESSAGE wasn't cut to it\n" );
+    failures++;
+  }
+  if ( strstr( data, "dropped" ) || !strstr( data, "] W kept warning\n" ) ) {
+    fprintf( stderr, "ERROR: set_gl_log_level() didn't filter messages\n" );
+    failures++;
+  }
+  printf( "long messages and level filtering: %s\n", failures ? "FAILED" : "ok" );
+  free( data );
+  free( text );
+  remove( TMP_LOG_FILE );
+  return failures;
+}
+
+#ifdef BENCH_CAN_FORK
+/* a static object built before the log first opens is destroyed after the
+log's own at-exit close, like a demo logging from a global's destructor */
+static bool g_log_at_destruction = false;
+struct log_after_close {
+  ~log_after_close() {
+    if ( g_log_at_destruction ) { gl_log( "t0 m%i after exit\n", CRASH_MESSAGES ); }
+  }
+};
+static log_after_close g_log_after_close;
+
+/* logs CRASH_MESSAGES in a child, which then aborts (crash) or exits without
+flushing. all of them must be in the file, and on exit, one more logged after
+the log was closed at exit. returns the number of failures */
+static int check_child_flush( bool crash ) {
+  fflush( stdout );
+  pid_t pid = fork();
+  if ( pid < 0 ) { return 1; }
+  if ( 0 == pid ) {
+    g_log_at_destruction = !crash;
+    if ( !restart_gl_log_file( TMP_LOG_FILE ) ) { _exit( 1 ); }
+    for ( int i = 0; i < CRASH_MESSAGES; i++ ) { gl_log( "t0 m%i about to %s\n", i, crash ? "crash" : "exit" ); }
+    if ( crash ) { abort(); }
+    exit( 0 );
+  }
+  int status = 0;
+  waitpid( pid, &status, 0 );
+  bool died_as_expected = crash ? ( WIFSIGNALED( status ) && SIGABRT == WTERMSIG( status ) ) : ( WIFEXITED( status ) && 0 == WEXITSTATUS( status ) );
+  int failures          = died_as_expected ? 0 : 1;
+  if ( !died_as_expected ) { fprintf( stderr, "ERROR: the child didn't %s as it should\n", crash ? "abort" : "exit" ); }
+  failures += check_log( TMP_LOG_FILE, 1, crash ? CRASH_MESSAGES : CRASH_MESSAGES + 1 );
+  printf( "flush on %s: %s\n", crash ? "abort()" : "exit()", failures ? "FAILED" : "ok" );
+  remove( TMP_LOG_FILE );
+  return failures;
+}
+#endif
+
+/*-----------------------------------TIMING-----------------------------------*/
+static void log_messages( int t, int n, double* ms ) {
+  double t0 = now_ms();
+  for ( int i = 0; i < n; i++ ) { gl_log( "t%i m%i GL_MAX_TEXTURE_IMAGE_UNITS %i\n", t, i, 32 ); }
+  *ms = now_ms() - t0;
+}
+
+// n messages on each of n_threads. returns the number of failures
+static int time_buffered( int n_threads, int n ) {
+  if ( !restart_gl_log_file( TMP_LOG_FILE ) ) { return 1; }
+  std::thread threads[MAX_THREADS];
+  double thread_ms[MAX_THREADS];
+  double t0 = now_ms();
+  for ( int t = 1; t < n_threads; t++ ) { threads[t] = std::thread( log_messages, t, n, &thread_ms[t] ); }
+  log_messages( 0, n, &thread_ms[0] );
+  for ( int t = 1; t < n_threads; t++ ) { threads[t].join(); }
+  double queued_ms = now_ms() - t0;
+  flush_gl_log();
+  double flushed_ms = now_ms() - t0;
+  close_gl_log();
+  double call_ns = 0.0;
+  for ( int t = 0; t < n_threads; t++ ) { call_ns += thread_ms[t] * 1e6 / n / n_threads; }
+  double total = (double)n * n_threads;
+  printf( "  buffered gl_log, %i thread%s %10.0f msgs/s queued %10.0f msgs/s in the file %8.0fns per call\n", n_threads, n_threads > 1 ? "s" : " ",
+    total / queued_ms * 1000.0, total / flushed_ms * 1000.0, call_ns );
+  int failures = check_log( TMP_LOG_FILE, n_threads, n );
+  remove( TMP_LOG_FILE );
+  return failures;
+}
+
+int main( int argc, char** argv ) {
+  int n        = argc > 1 ? atoi( argv[1] ) : DEFAULT_MESSAGES;
+  int n_old    = n / OLD_LOG_DIVISOR > 0 ? n / OLD_LOG_DIVISOR : 1;
+  int failures = 0;
+  printf( "%i messages per thread (%i for the old gl_log). ring of %i %i-byte slots\n", n, n_old, GL_LOG_SLOTS, GL_LOG_SLOT_BYTES );
+
+  remove( TMP_OLD_LOG_FILE );
+  double t0 = now_ms();
+  for ( int i = 0; i < n_old; i++ ) {
+    if ( !old_gl_log( "t0 m%i GL_MAX_TEXTURE_IMAGE_UNITS %i\n", i, 32 ) ) {
+      failures++;
+      break;
+    }
+  }
+  double old_ms = now_ms() - t0;
+  printf( "  fopen per call gl_log     %10.0f msgs/s %33.0fns per call\n", n_old / old_ms * 1000.0, old_ms * 1e6 / n_old );
+  remove( TMP_OLD_LOG_FILE );
+
+  failures += time_buffered( 1, n );
+  failures += time_buffered( MAX_THREADS, n );
+  failures += check_long_and_levels();
+#ifdef BENCH_CAN_FORK
+  failures += check_child_flush( false );
+  failures += check_child_flush( true );
+#endif
+
+  if ( failures ) { fprintf( stderr, "%i log check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,869 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless micro-benchmark suite for maths_funcs. No GL context required.      |
+| 1. checks SIMD/batch/fast paths against reference results                    |
+| 2. times every public function, warm (inputs in L1) and cold (inputs spread  |
+|    over more memory than any cache), in ns/op and millions of ops/s          |
+| 3. times some workloads lifted from the demos                                |
+| Usage: bench_maths [--json results.json]                                     |
+| The JSON has every timing so builds can be compared for regressions.         |
+| Built twice: bench_maths links maths_funcs.cpp and bench_maths_inline uses   |
+| the MATHS_HEADER_ONLY mode. check_maths_modes checks the two agree exactly.  |
+\******************************************************************************/
+#include "maths_funcs.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_OBJECTS 4096
+#define NUM_FRAMES 200
+#define NUM_VERTICES 1000000
+#define NUM_CAMERA_UPDATES 1000000
+#define NUM_CULL_OBJECTS 100000
+// per-function suite. see bench_functions()
+#define WARM_SLOTS 64
+#define COLD_SLOTS ( 1 << 19 )
+#define OPS_PER_RUN 1000000
+// batch function suite. see bench_batch_functions()
+#define BATCH_WARM_ELEMS 1024
+#define BATCH_COLD_ELEMS ( 1 << 21 )
+#define MAX_RESULTS 256
+
+#ifdef MATHS_HEADER_ONLY
+// these must be computable at compile time in header-only mode
+static constexpr mat4 k_identity = identity_mat4();
+static_assert( k_identity.m[0] == 1.0f && k_identity.m[1] == 0.0f && k_identity.m[15] == 1.0f, "identity_mat4 not constexpr" );
+#endif
+
+/*------------------------------SCALAR REFERENCE------------------------------*/
+// copies of the original scalar code to compare results and timings against
+static mat4 ref_mat4_mul( const mat4& a, const mat4& b ) {
+  mat4 r;
+  int r_index = 0;
+  for ( int col = 0; col < 4; col++ ) {
+    for ( int row = 0; row < 4; row++ ) {
+      float sum = 0.0f;
+      for ( int i = 0; i < 4; i++ ) { sum += b.m[i + col * 4] * a.m[row + i * 4]; }
+      r.m[r_index] = sum;
+      r_index++;
+    }
+  }
+  return r;
+}
+
+static vec4 ref_mat4_mul_vec4( const mat4& m, const vec4& v ) {
+  float x = m.m[0] * v.v[0] + m.m[4] * v.v[1] + m.m[8] * v.v[2] + m.m[12] * v.v[3];
+  float y = m.m[1] * v.v[0] + m.m[5] * v.v[1] + m.m[9] * v.v[2] + m.m[13] * v.v[3];
+  float z = m.m[2] * v.v[0] + m.m[6] * v.v[1] + m.m[10] * v.v[2] + m.m[14] * v.v[3];
+  float w = m.m[3] * v.v[0] + m.m[7] * v.v[1] + m.m[11] * v.v[2] + m.m[15] * v.v[3];
+  return vec4( x, y, z, w );
+}
+
+/*----------------------------------HELPERS-----------------------------------*/
+static float rand_float( float min, float max ) { return min + ( max - min ) * ( (float)rand() / (float)RAND_MAX ); }
+
+static mat4 rand_model_mat() {
+  mat4 m = identity_mat4();
+  m      = scale( m, vec3( rand_float( 0.5f, 2.0f ), rand_float( 0.5f, 2.0f ), rand_float( 0.5f, 2.0f ) ) );
+  m      = rotate_y_deg( m, rand_float( 0.0f, 360.0f ) );
+  m      = rotate_x_deg( m, rand_float( 0.0f, 360.0f ) );
+  return translate( m, vec3( rand_float( -50.0f, 50.0f ), rand_float( -50.0f, 50.0f ), rand_float( -50.0f, 50.0f ) ) );
+}
+
+static double now_ns() {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+// stops the optimiser throwing away results
+static volatile float g_sink;
+
+/*----------------------------------RESULTS-----------------------------------*/
+struct bench_result {
+  char name[64];
+  const char* variant; // "warm", "cold", or "workload"
+  double ns_per_op;
+};
+static bench_result g_results[MAX_RESULTS];
+static int g_n_results;
+
+static void record( const char* name, const char* variant, double ns_per_op ) {
+  if ( g_n_results >= MAX_RESULTS ) { return; }
+  bench_result* r = &g_results[g_n_results++];
+  snprintf( r->name, sizeof( r->name ), "%s", name );
+  r->variant   = variant;
+  r->ns_per_op = ns_per_op;
+}
+
+static bool write_json( const char* file_name ) {
+  FILE* fp = fopen( file_name, "w" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+    return false;
+  }
+#ifdef MATHS_HEADER_ONLY
+  bool header_only = true;
+#else
+  bool header_only = false;
+#endif
+  fprintf( fp, "{\n  \"simd\": \"%s\",\n  \"header_only\": %s,\n  \"results\": [\n", maths_simd_path(), header_only ? "true" : "false" );
+  for ( int i = 0; i < g_n_results; i++ ) {
+    const bench_result& r = g_results[i];
+    fprintf( fp, "    { \"name\": \"%s\", \"variant\": \"%s\", \"ns_per_op\": %.3f, \"mops_per_s\": %.3f }%s\n", r.name, r.variant, r.ns_per_op, 1000.0 / r.ns_per_op,
+      i < g_n_results - 1 ? "," : "" );
+  }
+  fprintf( fp, "  ]\n}\n" );
+  fclose( fp );
+  printf( "wrote %i results to %s\n", g_n_results, file_name );
+  return true;
+}
+
+// FNV-1a hash of some bytes, to compare results between builds
+static unsigned int hash_bytes( unsigned int h, const void* data, size_t sz ) {
+  const unsigned char* p = (const unsigned char*)data;
+  for ( size_t i = 0; i < sz; i++ ) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// returns number of results that weren't bit-for-bit equal to the scalar code
+static int check_simd_matches_scalar( int n ) {
+  int mismatches = 0;
+  for ( int i = 0; i < n; i++ ) {
+    mat4 a = rand_model_mat();
+    mat4 b = rand_model_mat();
+    for ( int j = 0; j < 16; j++ ) {
+      // sprinkle in some awkward values
+      if ( rand() % 8 == 0 ) { b.m[j] = rand_float( -1e6f, 1e6f ); }
+      if ( rand() % 16 == 0 ) { b.m[j] = -0.0f; }
+    }
+    vec4 v( rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), 1.0f );
+    mat4 simd_m = a * b;
+    mat4 ref_m  = ref_mat4_mul( a, b );
+    vec4 simd_v = a * v;
+    vec4 ref_v  = ref_mat4_mul_vec4( a, v );
+    if ( memcmp( simd_m.m, ref_m.m, sizeof( simd_m.m ) ) != 0 ) { mismatches++; }
+    if ( memcmp( simd_v.v, ref_v.v, sizeof( simd_v.v ) ) != 0 ) { mismatches++; }
+  }
+  return mismatches;
+}
+
+/*----------------------------------WORKLOADS---------------------------------*/
+/* what the demos do for each object every frame: build P * V * M and push a
+point through it. V changes every frame as the camera moves. every component
+of the result is used - with only one, an inlined scalar product shrinks to a
+quarter of its work, which SIMD lanes can't, and the comparison says nothing.
+the scalar and SIMD loops are kept apart so neither's registers crowd the
+other's.
+NB: in header-only mode the compiler sees through both loops - it hoists P * V
+out of the object loop and SLP-vectorises the inlined scalar reference into
+the same shuffle/mulps code as the intrinsics, so the two times land within
+a ns or so of each other there and the ratio says nothing about the kernel */
+static double bench_scene_transform_ref( const mat4* models, int n ) {
+  mat4 P = perspective( 67.0f, 1.333f, 0.1f, 100.0f );
+  vec4 p( 0.5f, 0.5f, 0.5f, 1.0f );
+  float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  double start = now_ns();
+  for ( int frame = 0; frame < NUM_FRAMES; frame++ ) {
+    mat4 V = look_at( vec3( 0.0f, 0.0f, 10.0f + 0.01f * frame ), vec3( 0.0f, 0.0f, 0.0f ), vec3( 0.0f, 1.0f, 0.0f ) );
+    for ( int i = 0; i < n; i++ ) {
+      mat4 PVM = ref_mat4_mul( ref_mat4_mul( P, V ), models[i] );
+      vec4 r   = ref_mat4_mul_vec4( PVM, p );
+      for ( int k = 0; k < 4; k++ ) { acc[k] += r.v[k]; }
+    }
+  }
+  double elapsed = now_ns() - start;
+  g_sink         = acc[0] + acc[1] + acc[2] + acc[3];
+  return elapsed / ( (double)NUM_FRAMES * n );
+}
+
+static double bench_scene_transform( const mat4* models, int n ) {
+  mat4 P = perspective( 67.0f, 1.333f, 0.1f, 100.0f );
+  vec4 p( 0.5f, 0.5f, 0.5f, 1.0f );
+  float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  double start = now_ns();
+  for ( int frame = 0; frame < NUM_FRAMES; frame++ ) {
+    mat4 V = look_at( vec3( 0.0f, 0.0f, 10.0f + 0.01f * frame ), vec3( 0.0f, 0.0f, 0.0f ), vec3( 0.0f, 1.0f, 0.0f ) );
+    for ( int i = 0; i < n; i++ ) {
+      mat4 PVM = P * V * models[i];
+      vec4 r   = PVM * p;
+      for ( int k = 0; k < 4; k++ ) { acc[k] += r.v[k]; }
+    }
+  }
+  double elapsed = now_ns() - start;
+  g_sink         = acc[0] + acc[1] + acc[2] + acc[3];
+  return elapsed / ( (double)NUM_FRAMES * n );
+}
+
+/* the per-frame quaternion camera update from the virtual camera demos: lots
+of tiny calls (quaternion and vec3 operators, quat_to_mat4, mat4 * vec4,
+translate, inverse) which is where inlining pays off */
+static void bench_camera_update( int n_frames ) {
+  mat4 P = perspective( 67.0f, 1.333f, 0.1f, 100.0f );
+  vec3 cam_pos( 0.0f, 0.0f, 5.0f );
+  versor q = quat_from_axis_deg( 0.0f, 0.0f, 1.0f, 0.0f );
+  vec4 up( 0.0f, 1.0f, 0.0f, 0.0f );
+  vec4 rgt( 1.0f, 0.0f, 0.0f, 0.0f );
+  unsigned int h = 2166136261u;
+
+  double start = now_ns();
+  for ( int i = 0; i < n_frames; i++ ) {
+    versor q_yaw   = quat_from_axis_deg( 0.1f, up.v[0], up.v[1], up.v[2] );
+    versor q_pitch = quat_from_axis_deg( 0.05f, rgt.v[0], rgt.v[1], rgt.v[2] );
+    q              = q_yaw * q;
+    q              = q_pitch * q;
+    mat4 R         = quat_to_mat4( q );
+    vec4 fwd       = R * vec4( 0.0f, 0.0f, -1.0f, 0.0f );
+    rgt            = R * vec4( 1.0f, 0.0f, 0.0f, 0.0f );
+    up             = R * vec4( 0.0f, 1.0f, 0.0f, 0.0f );
+
+    cam_pos += vec3( fwd ) * 0.01f;
+    cam_pos = cam_pos + vec3( rgt ) * 0.001f;
+
+    mat4 T  = translate( identity_mat4(), vec3( -cam_pos.v[0], -cam_pos.v[1], -cam_pos.v[2] ) );
+    mat4 V  = inverse( R ) * inverse( T );
+    mat4 PV = P * V;
+    // only hash a few frames, the hashing would otherwise dominate
+    if ( i % 1024 == 0 ) { h = hash_bytes( h, PV.m, sizeof( PV.m ) ); }
+  }
+  double elapsed = now_ns() - start;
+  h              = hash_bytes( h, cam_pos.v, sizeof( cam_pos.v ) );
+  printf( "camera update: %.2f ns/frame over %i frames. checksum %08x\n", elapsed / n_frames, n_frames, h );
+  record( "camera update", "workload", elapsed / n_frames );
+}
+
+static mat4 rand_rigid_mat() {
+  mat4 m = rotate_z_deg( identity_mat4(), rand_float( 0.0f, 360.0f ) );
+  m      = rotate_y_deg( m, rand_float( 0.0f, 360.0f ) );
+  m      = rotate_x_deg( m, rand_float( 0.0f, 360.0f ) );
+  return translate( m, vec3( rand_float( -50.0f, 50.0f ), rand_float( -50.0f, 50.0f ), rand_float( -50.0f, 50.0f ) ) );
+}
+
+static float max_abs_diff( const mat4& a, const mat4& b ) {
+  float d = 0.0f;
+  for ( int i = 0; i < 16; i++ ) {
+    float e = fabsf( a.m[i] - b.m[i] );
+    if ( e > d ) { d = e; }
+  }
+  return d;
+}
+
+/* validates the affine/rigid inverses against the general one, and times
+all of them on n matrices. returns 1 if any error is too big */
+static int bench_inverses( int n ) {
+  mat4* rigid  = (mat4*)malloc( n * sizeof( mat4 ) );
+  mat4* affine = (mat4*)malloc( n * sizeof( mat4 ) );
+  for ( int i = 0; i < n; i++ ) {
+    rigid[i]  = rand_rigid_mat();
+    affine[i] = rand_model_mat();
+  }
+  float rigid_err = 0.0f, affine_err = 0.0f, auto_err = 0.0f;
+  for ( int i = 0; i < n; i++ ) {
+    mat4 ref_r = inverse( rigid[i] );
+    mat4 ref_a = inverse( affine[i] );
+    rigid_err  = fmaxf( rigid_err, max_abs_diff( inverse_rigid( rigid[i] ), ref_r ) );
+    affine_err = fmaxf( affine_err, fmaxf( max_abs_diff( inverse_affine( affine[i] ), ref_a ), max_abs_diff( inverse_affine( rigid[i] ), ref_r ) ) );
+    auto_err   = fmaxf( auto_err, fmaxf( max_abs_diff( inverse_auto( affine[i] ), ref_a ), max_abs_diff( inverse_auto( rigid[i] ), ref_r ) ) );
+  }
+  // translations go up to ~50 units so a few float ULPs of that
+  const float max_err = 0.0001f;
+  int failed          = rigid_err > max_err || affine_err > max_err || auto_err > max_err;
+  printf( "inverse max abs error vs inverse(): rigid %g, affine %g, auto %g%s\n", rigid_err, affine_err, auto_err, failed ? " TOO BIG" : "" );
+
+  const char* names[4] = { "inverse", "inverse_affine", "inverse_rigid", "inverse_auto" };
+  float acc            = 0.0f;
+  for ( int f = 0; f < 4; f++ ) {
+    double start = now_ns();
+    for ( int i = 0; i < n; i++ ) {
+      mat4 r;
+      switch ( f ) {
+      case 0: r = inverse( rigid[i] ); break;
+      case 1: r = inverse_affine( rigid[i] ); break;
+      case 2: r = inverse_rigid( rigid[i] ); break;
+      default: r = inverse_auto( rigid[i] ); break;
+      }
+      acc += r.m[12];
+    }
+    double ns = ( now_ns() - start ) / n;
+    printf( "  %-15s %6.2f ns/op on view matrices\n", names[f], ns );
+    char name[64];
+    snprintf( name, sizeof( name ), "%s of view matrix", names[f] );
+    record( name, "workload", ns );
+  }
+  g_sink = acc;
+  free( rigid );
+  free( affine );
+  return failed;
+}
+
+// NB: unit axis, as normalise( versor ) leaves anything within 0.0001 of unit length alone
+static versor rand_versor() {
+  vec3 axis = normalise( vec3( rand_float( -1.0f, 1.0f ), rand_float( -1.0f, 1.0f ), rand_float( -1.0f, 1.0f ) ) );
+  return quat_from_axis_deg( rand_float( -180.0f, 180.0f ), axis.v[0], axis.v[1], axis.v[2] );
+}
+
+/* angle in degrees between the rotations of two versors. divides by the
+lengths as slerp's result is only as unit-length as its inputs */
+static double versor_angle_deg( const versor& a, const versor& b ) {
+  double ab = 0.0, aa = 0.0, bb = 0.0;
+  for ( int i = 0; i < 4; i++ ) {
+    ab += (double)a.q[i] * b.q[i];
+    aa += (double)a.q[i] * a.q[i];
+    bb += (double)b.q[i] * b.q[i];
+  }
+  double d = fabs( ab ) / sqrt( aa * bb );
+  if ( d > 1.0 ) { d = 1.0; }
+  return 2.0 * acos( d ) * 57.29577951308232;
+}
+
+// slerp in doubles, as the reference to measure the float versions' errors against
+static versor slerp_double( const versor& q, const versor& r, float t ) {
+  double qq[4], rr[4], qn = 0.0, rn = 0.0, c = 0.0;
+  for ( int i = 0; i < 4; i++ ) {
+    qn += (double)q.q[i] * q.q[i];
+    rn += (double)r.q[i] * r.q[i];
+  }
+  for ( int i = 0; i < 4; i++ ) {
+    qq[i] = q.q[i] / sqrt( qn );
+    rr[i] = r.q[i] / sqrt( rn );
+    c += qq[i] * rr[i];
+  }
+  if ( c < 0.0 ) {
+    for ( int i = 0; i < 4; i++ ) { qq[i] = -qq[i]; }
+    c = -c;
+  }
+  versor result;
+  double theta = acos( c > 1.0 ? 1.0 : c );
+  for ( int i = 0; i < 4; i++ ) {
+    double v    = theta < 1e-9 ? qq[i] : ( sin( ( 1.0 - t ) * theta ) * qq[i] + sin( t * theta ) * rr[i] ) / sin( theta );
+    result.q[i] = (float)v;
+  }
+  return result;
+}
+
+/* the rotation keyframe sampling from skeleton_animate() for a crowd of
+skeletons: each frame every bone finds its prev/next keys and interpolates.
+the key lookup is done up front so only the interpolation is timed */
+static int bench_keyframe_slerp( int n_bones, int n_frames ) {
+  const int n_keys = 32;
+  versor* keys     = (versor*)malloc( n_bones * n_keys * sizeof( versor ) );
+  for ( int b = 0; b < n_bones; b++ ) {
+    keys[b * n_keys] = rand_versor();
+    // neighbouring keys up to 60 degrees apart, sometimes on the far side of the hypersphere
+    for ( int k = 1; k < n_keys; k++ ) {
+      versor step          = quat_from_axis_deg( rand_float( -60.0f, 60.0f ), 0.0f, 1.0f, 0.0f );
+      keys[b * n_keys + k] = step * keys[b * n_keys + k - 1];
+      if ( rand() % 4 == 0 ) { keys[b * n_keys + k] = keys[b * n_keys + k] * -1.0f; }
+    }
+  }
+  versor* q    = (versor*)malloc( n_bones * sizeof( versor ) );
+  versor* r    = (versor*)malloc( n_bones * sizeof( versor ) );
+  float* t     = (float*)malloc( n_bones * sizeof( float ) );
+  versor* out  = (versor*)malloc( n_bones * sizeof( versor ) );
+  versor* ref  = (versor*)malloc( n_bones * sizeof( versor ) );
+  versor* exact = (versor*)malloc( n_bones * sizeof( versor ) );
+  double ns[4] = { 0.0, 0.0, 0.0, 0.0 };
+  double slerp_err = 0.0, fast_err = 0.0, nlerp_err = 0.0;
+  int mismatches  = 0;
+  for ( int f = 0; f < n_frames; f++ ) {
+    float anim_time = (float)f / n_frames * ( n_keys - 1 );
+    for ( int b = 0; b < n_bones; b++ ) {
+      // each bone on a different part of its track
+      float bt = fmodf( anim_time + b * 0.37f, (float)( n_keys - 1 ) );
+      int prev = (int)bt;
+      q[b]     = keys[b * n_keys + prev];
+      r[b]     = keys[b * n_keys + prev + 1];
+      t[b]     = bt - prev;
+    }
+    double start = now_ns();
+    for ( int b = 0; b < n_bones; b++ ) { ref[b] = slerp( q[b], r[b], t[b] ); }
+    ns[0] += now_ns() - start;
+    for ( int b = 0; b < n_bones; b++ ) { exact[b] = slerp_double( q[b], r[b], t[b] ); }
+    for ( int b = 0; b < n_bones; b++ ) { slerp_err = fmax( slerp_err, versor_angle_deg( ref[b], exact[b] ) ); }
+    start = now_ns();
+    slerp_n( q, r, t, out, n_bones, SLERP_ACCURATE );
+    ns[1] += now_ns() - start;
+    mismatches += memcmp( out, ref, n_bones * sizeof( versor ) ) != 0;
+    start = now_ns();
+    slerp_n( q, r, t, out, n_bones, SLERP_FAST );
+    ns[2] += now_ns() - start;
+    for ( int b = 0; b < n_bones; b++ ) { fast_err = fmax( fast_err, versor_angle_deg( out[b], exact[b] ) ); }
+    start = now_ns();
+    nlerp_n( q, r, t, out, n_bones );
+    ns[3] += now_ns() - start;
+    for ( int b = 0; b < n_bones; b++ ) { nlerp_err = fmax( nlerp_err, versor_angle_deg( out[b], exact[b] ) ); }
+  }
+  const char* names[4] = { "slerp loop", "slerp_n accurate", "slerp_n fast", "nlerp_n" };
+  printf( "keyframe interpolation, %i bones x %i frames:\n", n_bones, n_frames );
+  for ( int i = 0; i < 4; i++ ) {
+    double ns_per_bone = ns[i] / ( (double)n_bones * n_frames );
+    printf( "  %-16s %6.2f ns/bone\n", names[i], ns_per_bone );
+    char name[64];
+    snprintf( name, sizeof( name ), "keyframe %s", names[i] );
+    record( name, "workload", ns_per_bone );
+  }
+  printf( "  slerp_n accurate vs slerp: %s\n", mismatches ? "DIFFERENT" : "identical" );
+  printf( "  max error vs double precision slerp: slerp %g deg, fast %g deg, nlerp %g deg\n", slerp_err, fast_err, nlerp_err );
+  free( keys );
+  free( q );
+  free( r );
+  free( t );
+  free( out );
+  free( ref );
+  free( exact );
+  return mismatches;
+}
+
+/* pre-transforming a big mesh on the CPU: one mat4 * vec4 per vertex through
+temporaries, vs one transform_points call over the whole array */
+static int bench_batch_transform( int n ) {
+  float* in      = (float*)malloc( n * 3 * sizeof( float ) );
+  float* out_ref = (float*)malloc( n * 3 * sizeof( float ) );
+  float* out     = (float*)malloc( n * 3 * sizeof( float ) );
+  for ( int i = 0; i < n * 3; i++ ) { in[i] = rand_float( -10.0f, 10.0f ); }
+  mat4 M = rand_model_mat();
+
+  double start = now_ns();
+  for ( int i = 0; i < n; i++ ) {
+    vec4 r             = M * vec4( in[i * 3], in[i * 3 + 1], in[i * 3 + 2], 1.0f );
+    out_ref[i * 3]     = r.v[0];
+    out_ref[i * 3 + 1] = r.v[1];
+    out_ref[i * 3 + 2] = r.v[2];
+  }
+  double loop_ns = now_ns() - start;
+  start          = now_ns();
+  transform_points( M, in, out, n, 0 );
+  double batch_ns = now_ns() - start;
+
+  record( "pre-transform mesh, mat4 * vec4 loop", "workload", loop_ns / n );
+  record( "pre-transform mesh, transform_points", "workload", batch_ns / n );
+  int mismatches = memcmp( out, out_ref, n * 3 * sizeof( float ) ) != 0;
+  printf( "transform %i points: mat4 * vec4 loop %.2f ms, transform_points %.2f ms (%.2fx)%s\n", n, loop_ns * 1e-6, batch_ns * 1e-6, loop_ns / batch_ns,
+    mismatches ? " RESULTS DIFFER" : "" );
+  free( in );
+  free( out_ref );
+  free( out );
+  return mismatches;
+}
+
+/* normalising and dotting a big batch of vectors (particle/picking style):
+one vec3 at a time through the AoS functions vs the SoA batch versions */
+static int bench_soa( int n ) {
+  vec3* aos       = (vec3*)malloc( n * sizeof( vec3 ) );
+  float* aos_dots = (float*)malloc( n * sizeof( float ) );
+  for ( int i = 0; i < n; i++ ) { aos[i] = vec3( rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ) ); }
+  aos[0] = vec3( 0.0f, 0.0f, 0.0f ); // zero-length case
+  vec3_soa soa, soa_out;
+  vec3_soa_alloc( soa, n );
+  vec3_soa_alloc( soa_out, n );
+  float* soa_dots = (float*)malloc( n * sizeof( float ) );
+  vec3_soa_from_interleaved( aos[0].v, 0, soa );
+  // touch the output pages first so we don't time page faults
+  memset( soa_out.x, 0, n * sizeof( float ) );
+  memset( soa_out.y, 0, n * sizeof( float ) );
+  memset( soa_out.z, 0, n * sizeof( float ) );
+  memset( soa_dots, 0, n * sizeof( float ) );
+
+  double start = now_ns();
+  for ( int i = 0; i < n; i++ ) {
+    aos[i]      = normalise( aos[i] );
+    aos_dots[i] = dot( aos[i], aos[i] );
+  }
+  double aos_ns = now_ns() - start;
+  start         = now_ns();
+  normalise( soa, soa_out );
+  dot( soa_out, soa_out, soa_dots );
+  double soa_ns = now_ns() - start;
+
+  record( "normalise + dot, vec3 loop", "workload", aos_ns / n );
+  record( "normalise + dot, vec3_soa", "workload", soa_ns / n );
+  float* back = (float*)malloc( n * 3 * sizeof( float ) );
+  vec3_soa_to_interleaved( soa_out, back, 0 );
+  int mismatches = memcmp( back, aos[0].v, n * 3 * sizeof( float ) ) != 0 || memcmp( soa_dots, aos_dots, n * sizeof( float ) ) != 0;
+  printf( "normalise + dot %i vec3: AoS loop %.2f ms, SoA batch %.2f ms (%.2fx)%s\n", n, aos_ns * 1e-6, soa_ns * 1e-6, aos_ns / soa_ns, mismatches ? " RESULTS DIFFER" : "" );
+  free( back );
+  free( soa_dots );
+  vec3_soa_free( soa );
+  vec3_soa_free( soa_out );
+  free( aos_dots );
+  free( aos );
+  return mismatches;
+}
+
+/* culling a scene of bounding spheres, and AABBs around them, against the
+camera frustum: a plain loop over vec3 centres vs the batch cull functions.
+the indices of the visible ones must come out the same */
+static int bench_culling( int n ) {
+  vec3* centres_aos = (vec3*)malloc( n * sizeof( vec3 ) );
+  float* radii      = (float*)malloc( n * sizeof( float ) );
+  for ( int i = 0; i < n; i++ ) {
+    centres_aos[i] = vec3( rand_float( -100.0f, 100.0f ), rand_float( -100.0f, 100.0f ), rand_float( -100.0f, 100.0f ) );
+    radii[i]       = rand_float( 0.5f, 3.0f );
+  }
+  vec3_soa centres, mins, maxs;
+  vec3_soa_alloc( centres, n );
+  vec3_soa_alloc( mins, n );
+  vec3_soa_alloc( maxs, n );
+  vec3_soa_from_interleaved( centres_aos[0].v, 0, centres );
+  for ( int i = 0; i < n; i++ ) {
+    mins.x[i] = centres.x[i] - radii[i];
+    mins.y[i] = centres.y[i] - radii[i];
+    mins.z[i] = centres.z[i] - radii[i];
+    maxs.x[i] = centres.x[i] + radii[i];
+    maxs.y[i] = centres.y[i] + radii[i];
+    maxs.z[i] = centres.z[i] + radii[i];
+  }
+  unsigned int* visible_ref = (unsigned int*)malloc( n * sizeof( unsigned int ) );
+  unsigned int* visible     = (unsigned int*)malloc( n * sizeof( unsigned int ) );
+  memset( visible_ref, 0, n * sizeof( unsigned int ) );
+  memset( visible, 0, n * sizeof( unsigned int ) );
+
+  mat4 P     = perspective( 67.0f, 1.333f, 0.1f, 100.0f );
+  mat4 V     = look_at( vec3( 0.0f, 0.0f, 50.0f ), vec3( 0.0f, 0.0f, 0.0f ), vec3( 0.0f, 1.0f, 0.0f ) );
+  frustum f  = frustum_from_mat4( P * V );
+  int failed = 0;
+
+  // sanity check a few obvious cases first
+  vec3_soa probe;
+  vec3_soa_alloc( probe, 3 );
+  const float probe_pos[9]   = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 60.0f, 500.0f, 0.0f, 0.0f }; // in front, behind camera, far off to the side
+  const float probe_radii[3] = { 1.0f, 1.0f, 1.0f };
+  unsigned int probe_visible[3];
+  vec3_soa_from_interleaved( probe_pos, 0, probe );
+  if ( cull_spheres( f, probe, probe_radii, probe_visible ) != 1 || probe_visible[0] != 0 ) { failed = 1; }
+  vec3_soa_free( probe );
+
+  const int reps = 20;
+  size_t n_ref   = 0;
+  double start   = now_ns();
+  for ( int rep = 0; rep < reps; rep++ ) {
+    n_ref = 0;
+    for ( int i = 0; i < n; i++ ) {
+      bool inside = true;
+      for ( int p = 0; p < 6; p++ ) {
+        float d = f.planes[p][0] * centres_aos[i].v[0] + f.planes[p][1] * centres_aos[i].v[1] + f.planes[p][2] * centres_aos[i].v[2] + f.planes[p][3];
+        if ( !( d >= -radii[i] ) ) {
+          inside = false;
+          break;
+        }
+      }
+      if ( inside ) { visible_ref[n_ref++] = i; }
+    }
+  }
+  double loop_ns = ( now_ns() - start ) / reps;
+  size_t n_vis   = 0;
+  start          = now_ns();
+  for ( int rep = 0; rep < reps; rep++ ) { n_vis = cull_spheres( f, centres, radii, visible ); }
+  double spheres_ns = ( now_ns() - start ) / reps;
+  if ( n_vis != n_ref || memcmp( visible, visible_ref, n_vis * sizeof( unsigned int ) ) != 0 ) { failed = 1; }
+  size_t n_aabb = 0;
+  start         = now_ns();
+  for ( int rep = 0; rep < reps; rep++ ) { n_aabb = cull_aabbs( f, mins, maxs, visible ); }
+  double aabbs_ns = ( now_ns() - start ) / reps;
+  // boxes around the spheres are bigger, so must keep at least the same ones
+  if ( n_aabb < n_vis ) { failed = 1; }
+
+  printf( "frustum culling %i objects, %i spheres visible, %i AABBs visible:\n", n, (int)n_vis, (int)n_aabb );
+  printf( "  vec3 sphere loop %8.3f ms\n", loop_ns * 1e-6 );
+  printf( "  cull_spheres     %8.3f ms (%.2fx)\n", spheres_ns * 1e-6, loop_ns / spheres_ns );
+  printf( "  cull_aabbs       %8.3f ms%s\n", aabbs_ns * 1e-6, failed ? " RESULTS WRONG" : "" );
+  record( "cull spheres, vec3 loop", "workload", loop_ns / n );
+  record( "cull_spheres", "workload", spheres_ns / n );
+  record( "cull_aabbs", "workload", aabbs_ns / n );
+
+  vec3_soa_free( centres );
+  vec3_soa_free( mins );
+  vec3_soa_free( maxs );
+  free( centres_aos );
+  free( radii );
+  free( visible_ref );
+  free( visible );
+  return failed;
+}
+
+/*----------------------------PER-FUNCTION SUITE------------------------------*/
+/* every op reads its inputs from slot j of these arrays. warm runs cycle
+through the first WARM_SLOTS slots, which stay in L1. cold runs hop around all
+COLD_SLOTS slots (~100MB in total) in a scattered order, so almost every op
+has to go out to memory */
+static mat4* g_ma;
+static mat4* g_mb;
+static vec4* g_v4;
+static vec3* g_v3a;
+static vec3* g_v3b;
+static versor* g_qa;
+static versor* g_qb;
+static float* g_f;
+
+/* op_<name>( n, mask ) does n ops and returns a sum of some of the results
+so that the optimiser can't remove them. (i * 7919) & mask visits every slot
+in a power-of-two range, in an order the prefetcher can't follow */
+#define BENCH_OP( op_name, expr )                 \
+  static float op_name( int n, int mask ) {       \
+    float acc = 0.0f;                             \
+    for ( int i = 0; i < n; i++ ) {               \
+      int j = ( i * 7919 ) & mask;                \
+      acc += ( expr );                            \
+    }                                             \
+    return acc;                                   \
+  }
+
+BENCH_OP( op_mat4_mul_mat4, ( g_ma[j] * g_mb[j] ).m[5] )
+BENCH_OP( op_mat4_mul_vec4, ( g_ma[j] * g_v4[j] ).v[1] )
+BENCH_OP( op_determinant, determinant( g_ma[j] ) )
+BENCH_OP( op_inverse, inverse( g_ma[j] ).m[5] )
+BENCH_OP( op_inverse_affine, inverse_affine( g_ma[j] ).m[5] )
+BENCH_OP( op_inverse_rigid, inverse_rigid( g_ma[j] ).m[5] )
+BENCH_OP( op_inverse_auto, inverse_auto( g_ma[j] ).m[5] )
+BENCH_OP( op_transpose, transpose( g_ma[j] ).m[5] )
+BENCH_OP( op_translate, translate( g_ma[j], g_v3a[j] ).m[12] )
+BENCH_OP( op_rotate_x_deg, rotate_x_deg( g_ma[j], g_f[j] ).m[5] )
+BENCH_OP( op_rotate_y_deg, rotate_y_deg( g_ma[j], g_f[j] ).m[5] )
+BENCH_OP( op_rotate_z_deg, rotate_z_deg( g_ma[j], g_f[j] ).m[5] )
+BENCH_OP( op_scale, scale( g_ma[j], g_v3a[j] ).m[5] )
+BENCH_OP( op_look_at, look_at( g_v3a[j], g_v3b[j], vec3( 0.0f, 1.0f, 0.0f ) ).m[12] )
+BENCH_OP( op_perspective, perspective( g_f[j], 1.333f, 0.1f, 100.0f ).m[0] )
+BENCH_OP( op_vec3_add, ( g_v3a[j] + g_v3b[j] ).v[1] )
+BENCH_OP( op_vec3_mul_float, ( g_v3a[j] * g_f[j] ).v[1] )
+BENCH_OP( op_dot_vec3, dot( g_v3a[j], g_v3b[j] ) )
+BENCH_OP( op_cross, cross( g_v3a[j], g_v3b[j] ).v[1] )
+BENCH_OP( op_length, length( g_v3a[j] ) )
+BENCH_OP( op_normalise_vec3, normalise( g_v3a[j] ).v[1] )
+BENCH_OP( op_quat_from_axis_deg, quat_from_axis_deg( g_f[j], 0.0f, 1.0f, 0.0f ).q[1] )
+BENCH_OP( op_quat_to_mat4, quat_to_mat4( g_qa[j] ).m[5] )
+BENCH_OP( op_versor_mul, ( g_qa[j] * g_qb[j] ).q[1] )
+BENCH_OP( op_normalise_versor, normalise( g_qa[j] ).q[1] )
+BENCH_OP( op_slerp, slerp( g_qa[j], g_qb[j], 0.3f ).q[1] )
+BENCH_OP( op_nlerp, nlerp( g_qa[j], g_qb[j], 0.3f ).q[1] )
+BENCH_OP( op_frustum_from_mat4, frustum_from_mat4( g_ma[j] ).planes[0][3] )
+
+struct bench_op {
+  const char* name;
+  float ( *func )( int n, int mask );
+};
+
+static void bench_functions() {
+  const bench_op ops[] = { { "mat4 * mat4", op_mat4_mul_mat4 }, { "mat4 * vec4", op_mat4_mul_vec4 }, { "determinant", op_determinant }, { "inverse", op_inverse },
+    { "inverse_affine", op_inverse_affine }, { "inverse_rigid", op_inverse_rigid }, { "inverse_auto", op_inverse_auto }, { "transpose", op_transpose },
+    { "translate", op_translate }, { "rotate_x_deg", op_rotate_x_deg }, { "rotate_y_deg", op_rotate_y_deg }, { "rotate_z_deg", op_rotate_z_deg },
+    { "scale", op_scale }, { "look_at", op_look_at }, { "perspective", op_perspective }, { "vec3 + vec3", op_vec3_add }, { "vec3 * float", op_vec3_mul_float },
+    { "dot( vec3 )", op_dot_vec3 }, { "cross", op_cross }, { "length", op_length }, { "normalise( vec3 )", op_normalise_vec3 },
+    { "quat_from_axis_deg", op_quat_from_axis_deg }, { "quat_to_mat4", op_quat_to_mat4 }, { "versor * versor", op_versor_mul },
+    { "normalise( versor )", op_normalise_versor }, { "slerp", op_slerp }, { "nlerp", op_nlerp },
+    { "frustum_from_mat4", op_frustum_from_mat4 } };
+  const int n_ops = sizeof( ops ) / sizeof( ops[0] );
+
+  g_ma  = (mat4*)malloc( COLD_SLOTS * sizeof( mat4 ) );
+  g_mb  = (mat4*)malloc( COLD_SLOTS * sizeof( mat4 ) );
+  g_v4  = (vec4*)malloc( COLD_SLOTS * sizeof( vec4 ) );
+  g_v3a = (vec3*)malloc( COLD_SLOTS * sizeof( vec3 ) );
+  g_v3b = (vec3*)malloc( COLD_SLOTS * sizeof( vec3 ) );
+  g_qa  = (versor*)malloc( COLD_SLOTS * sizeof( versor ) );
+  g_qb  = (versor*)malloc( COLD_SLOTS * sizeof( versor ) );
+  g_f   = (float*)malloc( COLD_SLOTS * sizeof( float ) );
+  for ( int i = 0; i < COLD_SLOTS; i++ ) {
+    // rigid model matrices so every inverse variant is valid
+    g_ma[i]  = rand_rigid_mat();
+    g_mb[i]  = rand_model_mat();
+    g_v4[i]  = vec4( rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), 1.0f );
+    g_v3a[i] = vec3( rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ) );
+    g_v3b[i] = vec3( rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ), rand_float( -10.0f, 10.0f ) );
+    g_qa[i]  = rand_versor();
+    g_qb[i]  = rand_versor();
+    g_f[i]   = rand_float( 30.0f, 90.0f );
+  }
+
+  printf( "per-function timings, %i ops each:\n", OPS_PER_RUN );
+  printf( "  %-22s %12s %12s %12s %12s\n", "", "warm ns/op", "warm Mop/s", "cold ns/op", "cold Mop/s" );
+  float acc = 0.0f;
+  for ( int i = 0; i < n_ops; i++ ) {
+    double ns[2];
+    const int masks[2] = { WARM_SLOTS - 1, COLD_SLOTS - 1 };
+    for ( int v = 0; v < 2; v++ ) {
+      acc += ops[i].func( WARM_SLOTS, masks[v] ); // warm up the code and branch predictors
+      double start = now_ns();
+      acc += ops[i].func( OPS_PER_RUN, masks[v] );
+      ns[v] = ( now_ns() - start ) / OPS_PER_RUN;
+    }
+    record( ops[i].name, "warm", ns[0] );
+    record( ops[i].name, "cold", ns[1] );
+    printf( "  %-22s %12.2f %12.2f %12.2f %12.2f\n", ops[i].name, ns[0], 1000.0 / ns[0], ns[1], 1000.0 / ns[1] );
+  }
+  g_sink = acc;
+
+  free( g_ma );
+  free( g_mb );
+  free( g_v4 );
+  free( g_v3a );
+  free( g_v3b );
+  free( g_qa );
+  free( g_qb );
+  free( g_f );
+}
+
+/*------------------------------BATCH FUNCTIONS-------------------------------*/
+/* the batch functions are timed per element. warm runs repeat over the first
+BATCH_WARM_ELEMS elements, cold runs stream through BATCH_COLD_ELEMS once */
+static mat4 g_batch_m;
+static float* g_fin;
+static float* g_fout;
+static vec3_soa g_sa, g_sb, g_sout;
+static float* g_sdots;
+static versor* g_bqa;
+static versor* g_bqb;
+static versor* g_bqout;
+static float* g_bt;
+
+// a vec3_soa pointing at elements [first, first + n) of s
+static vec3_soa soa_view( const vec3_soa& s, size_t first, size_t n ) {
+  vec3_soa v;
+  v.x = s.x + first;
+  v.y = s.y + first;
+  v.z = s.z + first;
+  v.n = n;
+  return v;
+}
+
+static void batch_transform_points( size_t first, size_t n ) { transform_points( g_batch_m, &g_fin[first * 3], &g_fout[first * 3], n, 0 ); }
+static void batch_transform_normals( size_t first, size_t n ) { transform_normals( g_batch_m, &g_fin[first * 3], &g_fout[first * 3], n, 0 ); }
+static void batch_soa_dot( size_t first, size_t n ) { dot( soa_view( g_sa, first, n ), soa_view( g_sb, first, n ), &g_sdots[first] ); }
+static void batch_soa_cross( size_t first, size_t n ) {
+  vec3_soa out = soa_view( g_sout, first, n );
+  cross( soa_view( g_sa, first, n ), soa_view( g_sb, first, n ), out );
+}
+static void batch_soa_length( size_t first, size_t n ) { length( soa_view( g_sa, first, n ), &g_sdots[first] ); }
+static void batch_soa_normalise( size_t first, size_t n ) {
+  vec3_soa out = soa_view( g_sout, first, n );
+  normalise( soa_view( g_sa, first, n ), out );
+}
+static void batch_soa_lerp( size_t first, size_t n ) {
+  vec3_soa out = soa_view( g_sout, first, n );
+  lerp( soa_view( g_sa, first, n ), soa_view( g_sb, first, n ), 0.3f, out );
+}
+static void batch_slerp_n_accurate( size_t first, size_t n ) { slerp_n( &g_bqa[first], &g_bqb[first], &g_bt[first], &g_bqout[first], n, SLERP_ACCURATE ); }
+static void batch_slerp_n_fast( size_t first, size_t n ) { slerp_n( &g_bqa[first], &g_bqb[first], &g_bt[first], &g_bqout[first], n, SLERP_FAST ); }
+static void batch_nlerp_n( size_t first, size_t n ) { nlerp_n( &g_bqa[first], &g_bqb[first], &g_bt[first], &g_bqout[first], n ); }
+
+struct bench_batch_op {
+  const char* name;
+  void ( *func )( size_t first, size_t n );
+};
+
+static void bench_batch_functions() {
+  const bench_batch_op ops[] = { { "transform_points", batch_transform_points }, { "transform_normals", batch_transform_normals },
+    { "dot( vec3_soa )", batch_soa_dot }, { "cross( vec3_soa )", batch_soa_cross }, { "length( vec3_soa )", batch_soa_length },
+    { "normalise( vec3_soa )", batch_soa_normalise }, { "lerp( vec3_soa )", batch_soa_lerp }, { "slerp_n accurate", batch_slerp_n_accurate },
+    { "slerp_n fast", batch_slerp_n_fast }, { "nlerp_n", batch_nlerp_n } };
+  const int n_ops = sizeof( ops ) / sizeof( ops[0] );
+  const size_t n  = BATCH_COLD_ELEMS;
+
+  g_batch_m = rand_model_mat();
+  g_fin     = (float*)malloc( n * 3 * sizeof( float ) );
+  g_fout    = (float*)malloc( n * 3 * sizeof( float ) );
+  g_sdots   = (float*)malloc( n * sizeof( float ) );
+  g_bqa     = (versor*)malloc( n * sizeof( versor ) );
+  g_bqb     = (versor*)malloc( n * sizeof( versor ) );
+  g_bqout   = (versor*)malloc( n * sizeof( versor ) );
+  g_bt      = (float*)malloc( n * sizeof( float ) );
+  vec3_soa_alloc( g_sa, n );
+  vec3_soa_alloc( g_sb, n );
+  vec3_soa_alloc( g_sout, n );
+  for ( size_t i = 0; i < n * 3; i++ ) { g_fin[i] = rand_float( -10.0f, 10.0f ); }
+  // outputs written once first so we don't time page faults
+  memcpy( g_fout, g_fin, n * 3 * sizeof( float ) );
+  vec3_soa_from_interleaved( g_fin, 0, g_sa );
+  vec3_soa_from_interleaved( g_fin, 0, g_sb );
+  vec3_soa_from_interleaved( g_fin, 0, g_sout );
+  memcpy( g_sdots, g_fin, n * sizeof( float ) );
+  for ( size_t i = 0; i < n; i++ ) {
+    g_bqa[i] = rand_versor();
+    g_bqb[i] = rand_versor();
+    g_bt[i]  = rand_float( 0.0f, 1.0f );
+  }
+  memcpy( g_bqout, g_bqa, n * sizeof( versor ) );
+
+  printf( "batch function timings, warm %i elements repeated, cold %i elements:\n", BATCH_WARM_ELEMS, BATCH_COLD_ELEMS );
+  printf( "  %-22s %12s %12s %12s %12s\n", "", "warm ns/el", "warm Mel/s", "cold ns/el", "cold Mel/s" );
+  for ( int i = 0; i < n_ops; i++ ) {
+    ops[i].func( 0, BATCH_WARM_ELEMS ); // warm up
+    double start = now_ns();
+    for ( int rep = 0; rep < BATCH_COLD_ELEMS / BATCH_WARM_ELEMS; rep++ ) { ops[i].func( 0, BATCH_WARM_ELEMS ); }
+    double warm_ns = ( now_ns() - start ) / BATCH_COLD_ELEMS;
+    start          = now_ns();
+    ops[i].func( 0, BATCH_COLD_ELEMS );
+    double cold_ns = ( now_ns() - start ) / BATCH_COLD_ELEMS;
+    record( ops[i].name, "warm", warm_ns );
+    record( ops[i].name, "cold", cold_ns );
+    printf( "  %-22s %12.2f %12.2f %12.2f %12.2f\n", ops[i].name, warm_ns, 1000.0 / warm_ns, cold_ns, 1000.0 / cold_ns );
+  }
+
+  vec3_soa_free( g_sa );
+  vec3_soa_free( g_sb );
+  vec3_soa_free( g_sout );
+  free( g_fin );
+  free( g_fout );
+  free( g_sdots );
+  free( g_bqa );
+  free( g_bqb );
+  free( g_bqout );
+  free( g_bt );
+}
+
+int main( int argc, char** argv ) {
+  const char* json_file_name = NULL;
+  for ( int i = 1; i < argc; i++ ) {
+    if ( 0 == strcmp( argv[i], "--json" ) && i + 1 < argc ) {
+      json_file_name = argv[++i];
+    } else {
+      fprintf( stderr, "usage: %s [--json results.json]\n", argv[0] );
+      return 1;
+    }
+  }
+  srand( 1234 );
+#ifdef MATHS_HEADER_ONLY
+  printf( "maths_funcs SIMD path: %s, header-only\n", maths_simd_path() );
+#else
+  printf( "maths_funcs SIMD path: %s\n", maths_simd_path() );
+#endif
+
+  int mismatches = check_simd_matches_scalar( 100000 );
+  printf( "mat4 products vs scalar reference: %i mismatches in 200000 results\n", mismatches );
+
+  mat4* models = (mat4*)malloc( NUM_OBJECTS * sizeof( mat4 ) );
+  for ( int i = 0; i < NUM_OBJECTS; i++ ) { models[i] = rand_model_mat(); }
+  // best of a few runs each, alternating, so one noisy run doesn't decide the ratio
+  double ref_ns = 0.0, simd_ns = 0.0;
+  for ( int run = 0; run < 3; run++ ) {
+    double r = bench_scene_transform_ref( models, NUM_OBJECTS );
+    double s = bench_scene_transform( models, NUM_OBJECTS );
+    if ( 0 == run || r < ref_ns ) { ref_ns = r; }
+    if ( 0 == run || s < simd_ns ) { simd_ns = s; }
+  }
+  printf( "scene transform (P * V * M then * vec4), %i objects x %i frames:\n", NUM_OBJECTS, NUM_FRAMES );
+  printf( "  scalar %8.2f ns/object\n", ref_ns );
+  printf( "  %-6s %8.2f ns/object (%.2fx)\n", maths_simd_path(), simd_ns, ref_ns / simd_ns );
+  record( "scene transform, scalar reference", "workload", ref_ns );
+  record( "scene transform", "workload", simd_ns );
+  free( models );
+
+  mismatches += bench_batch_transform( NUM_VERTICES );
+  mismatches += bench_soa( NUM_VERTICES );
+  bench_camera_update( NUM_CAMERA_UPDATES );
+  mismatches += bench_inverses( NUM_OBJECTS * 64 );
+  mismatches += bench_keyframe_slerp( 64 * 256, 100 );
+  mismatches += bench_culling( NUM_CULL_OBJECTS );
+
+  bench_functions();
+  bench_batch_functions();
+
+  if ( json_file_name && !write_json( json_file_name ) ) { return 1; }
+  return mismatches == 0 ? 0 : 1;
+}
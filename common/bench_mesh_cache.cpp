@@ -0,0 +1,172 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless benchmark for the binary mesh cache. No GL context required.        |
+| For each face count: writes a synthetic OBJ, then times                      |
+|   parse   - load_obj_file_indexed() straight from the text                   |
+|   miss    - load_obj_file_cached() with no cache: parse + write the cache    |
+|   hit     - load_obj_file_cached() again: map the cache                      |
+|   hit+read- the same, plus reading every byte, as glBufferData() would       |
+|   touched - after changing only the source's mtime: hash + map               |
+| and checks the hit gives the same arrays as the parse, and that editing the  |
+| source, or a header whose counts don't match its streams, makes the cache    |
+| rebuild. The OS file cache stays warm throughout, so these are best-case     |
+| disk numbers for both paths.                                                 |
+| Usage: bench_mesh_cache [face_count ...]                                     |
+\******************************************************************************/
+#include "mesh_cache.h"
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#define DEFAULT_FACE_COUNT 1000000
+#define TMP_OBJ_FILE "bench_mesh_cache_tmp.obj"
+#define TMP_CACHE_FILE TMP_OBJ_FILE MESH_CACHE_SUFFIX
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+static volatile unsigned int g_sink;
+
+// reads a byte from every cache line so the pages really get faulted in
+static unsigned int touch_all( const mesh_data* m ) {
+  unsigned int sum = 0;
+  const unsigned char* arrays[4] = { (const unsigned char*)m->points, (const unsigned char*)m->tex_coords, (const unsigned char*)m->normals,
+    (const unsigned char*)m->indices };
+  size_t sizes[4] = { (size_t)m->vertex_count * 12, (size_t)m->vertex_count * 8, (size_t)m->vertex_count * 12, (size_t)m->index_count * m->index_size };
+  for ( int a = 0; a < 4; a++ ) {
+    for ( size_t i = 0; arrays[a] && i < sizes[a]; i += 64 ) { sum += arrays[a][i]; }
+  }
+  return sum;
+}
+
+static bool same_mesh( const mesh_data* a, const mesh_data* b ) {
+  if ( a->vertex_count != b->vertex_count || a->index_count != b->index_count || a->index_size != b->index_size ) { return false; }
+  size_t vc = (size_t)a->vertex_count;
+  return !memcmp( a->points, b->points, vc * 12 ) && !memcmp( a->tex_coords, b->tex_coords, vc * 8 ) && !memcmp( a->normals, b->normals, vc * 12 ) &&
+         !memcmp( a->indices, b->indices, (size_t)a->index_count * a->index_size ) && !memcmp( a->aabb_min, b->aabb_min, sizeof( a->aabb_min ) ) &&
+         !memcmp( a->aabb_max, b->aabb_max, sizeof( a->aabb_max ) );
+}
+
+static int bench_size( int face_count ) {
+  int failures = 0;
+  remove( TMP_CACHE_FILE );
+  size_t sz = write_grid_obj( TMP_OBJ_FILE, face_count, false );
+  if ( !sz ) { return 1; }
+
+  // plain parse, for the baseline
+  float *p = NULL, *t = NULL, *n = NULL;
+  void* indices = NULL;
+  int vc = 0, ic = 0, is = 0;
+  double t0 = now_ms();
+  if ( !load_obj_file_indexed( TMP_OBJ_FILE, p, t, n, vc, indices, ic, is ) ) { return 1; }
+  double parse_ms = now_ms() - t0;
+  free( p );
+  free( t );
+  free( n );
+  free( indices );
+
+  mesh_data miss, hit, touched;
+  bool was_hit[3] = { false, false, false };
+  t0              = now_ms();
+  bool ok         = load_obj_file_cached( TMP_OBJ_FILE, &miss, &was_hit[0] );
+  double miss_ms  = now_ms() - t0;
+  t0              = now_ms();
+  ok              = load_obj_file_cached( TMP_OBJ_FILE, &hit, &was_hit[1] ) && ok;
+  double hit_ms   = now_ms() - t0;
+  g_sink          = touch_all( &hit );
+  double read_ms  = now_ms() - t0;
+  if ( !ok || was_hit[0] || !was_hit[1] || !same_mesh( &miss, &hit ) ) {
+    fprintf( stderr, "ERROR: cache hit doesn't match the parsed mesh\n" );
+    failures++;
+  }
+  free_mesh_data( &hit );
+
+  // new mtime, same bytes: should still hit, after hashing the source
+  utime( TMP_OBJ_FILE, NULL );
+  t0                = now_ms();
+  ok                = load_obj_file_cached( TMP_OBJ_FILE, &touched, &was_hit[2] );
+  double touched_ms = now_ms() - t0;
+  if ( !ok || !was_hit[2] || !same_mesh( &miss, &touched ) ) {
+    fprintf( stderr, "ERROR: cache not reused after touching the source\n" );
+    failures++;
+  }
+  free_mesh_data( &touched );
+  free_mesh_data( &miss );
+
+  // a real edit, same size: must rebuild. flip the sign of the first vertex's x
+  {
+    FILE* fp = fopen( TMP_OBJ_FILE, "r+b" );
+    char head[64];
+    size_t got = fp ? fread( head, 1, sizeof( head ), fp ) : 0;
+    char* v    = (char*)memchr( head, '\n', got );
+    v          = v ? (char*)memchr( v + 1, '\n', got - ( v + 1 - head ) ) : NULL;
+    // "v -50.000000" -> "v +50.000000"
+    if ( v && '-' == v[3] ) {
+      fseek( fp, (long)( v + 3 - head ), SEEK_SET );
+      fputc( '+', fp );
+    }
+    if ( fp ) { fclose( fp ); }
+    mesh_data edited;
+    bool edited_hit = true;
+    ok              = load_obj_file_cached( TMP_OBJ_FILE, &edited, &edited_hit );
+    if ( !ok || edited_hit || !edited.points || edited.points[0] != 50.0f ) {
+      fprintf( stderr, "ERROR: cache not rebuilt after editing the source\n" );
+      failures++;
+    }
+    free_mesh_data( &edited );
+  }
+
+  // a header whose counts disagree with its streams must be rebuilt, not handed out
+  for ( int c = 0; c < 2; c++ ) {
+    mesh_cache_header h;
+    FILE* fp  = fopen( TMP_CACHE_FILE, "r+b" );
+    bool read = fp && 1 == fread( &h, sizeof( h ), 1, fp );
+    if ( read ) {
+      if ( 0 == c ) {
+        h.vertex_count++;
+      } else {
+        h.index_size = 3;
+      }
+      fseek( fp, 0, SEEK_SET );
+      fwrite( &h, sizeof( h ), 1, fp );
+    }
+    if ( fp ) { fclose( fp ); }
+    mesh_data rebuilt;
+    bool rebuilt_hit = true;
+    ok               = read && load_obj_file_cached( TMP_OBJ_FILE, &rebuilt, &rebuilt_hit );
+    if ( !ok || rebuilt_hit || !rebuilt.points || rebuilt.points[0] != 50.0f ) {
+      fprintf( stderr, "ERROR: cache with a bad %s not rebuilt\n", 0 == c ? "vertex count" : "index size" );
+      failures++;
+    }
+    free_mesh_data( &rebuilt );
+  }
+
+  double mb = (double)sz / ( 1024.0 * 1024.0 );
+  printf( "%i faces, %.1f MB obj: parse %.1fms | miss (parse+write) %.1fms | hit %.3fms | hit+read %.1fms | touched %.1fms | %.0fx faster\n",
+    face_count, mb, parse_ms, miss_ms, hit_ms, read_ms, touched_ms, parse_ms / read_ms );
+  remove( TMP_OBJ_FILE );
+  remove( TMP_CACHE_FILE );
+  return failures;
+}
+
+int main( int argc, char** argv ) {
+  printf( "mesh cache header %i bytes, version %u\n", (int)sizeof( mesh_cache_header ), MESH_CACHE_VERSION );
+  int failures = 0;
+  int n_sizes  = argc > 1 ? argc - 1 : 1;
+  for ( int i = 0; i < n_sizes; i++ ) { failures += bench_size( argc > 1 ? atoi( argv[i + 1] ) : DEFAULT_FACE_COUNT ); }
+  if ( failures ) { fprintf( stderr, "%i mesh cache check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,440 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless benchmark of every way common/ can load a mesh. No GL context       |
+| required. For each shape (wavy grid, bumpy sphere, noise terrain) and face   |
+| count it writes a synthetic OBJ, then loads it once per loader, each in its  |
+| own child process so memory numbers don't mix, and prints:                   |
+|   time, MB/s of OBJ text, triangles/s, peak RSS, allocations (count, MB)     |
+| Every loader's vertices, expanded back out to one per corner, are checked    |
+| against load_obj_file()'s. Assimp, as 13_mesh_import uses it, is included    |
+| when CMake finds the library - its floats may round differently, so it is    |
+| only checked for the vertex count.                                           |
+| The OBJ and its cache are written just before the loads, so every loader    |
+| reads them from a warm OS page cache: these are not cold-disk times.         |
+| POSIX only - peak RSS comes from wait4(). Allocations are counted by         |
+| wrapping malloc() on glibc, and show as - elsewhere.                         |
+| Usage: bench_mesh_load [grid|sphere|terrain] [face_count ...]                |
+|   e.g. bench_mesh_load terrain 1000 1000000 50000000                         |
+| The biggest sizes want a lot of memory and disk - 50M faces is a ~5GB OBJ.   |
+\******************************************************************************/
+#include "mesh_cache.h"
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef BENCH_WITH_ASSIMP
+#include <assimp/cimport.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#endif
+
+#define TMP_OBJ_FILE "bench_mesh_load_tmp.obj"
+#define STREAM_BATCH_POINTS 65535
+#define SPHERE_NOISE 0.1f
+#define TERRAIN_AMPLITUDE 8.0f
+
+static const int k_default_face_counts[] = { 1000, 100000, 1000000 };
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+/*---------------------------------ALLOCATIONS--------------------------------*/
+/* glibc lets a program replace malloc() and friends, and exports its own as
+__libc_malloc() etc. to forward to. this counts every call, from any thread,
+including operator new and anything inside Assimp */
+static std::atomic<unsigned long long> g_alloc_count( 0 );
+static std::atomic<unsigned long long> g_alloc_bytes( 0 );
+#if defined( __GLIBC__ )
+#define COUNTS_ALLOCATIONS 1
+extern "C" {
+void* __libc_malloc( size_t size );
+void* __libc_calloc( size_t n, size_t size );
+void* __libc_realloc( void* ptr, size_t size );
+void* malloc( size_t size ) {
+  g_alloc_count.fetch_add( 1, std::memory_order_relaxed );
+  g_alloc_bytes.fetch_add( size, std::memory_order_relaxed );
+  return __libc_malloc( size );
+}
+void* calloc( size_t n, size_t size ) {
+  g_alloc_count.fetch_add( 1, std::memory_order_relaxed );
+  g_alloc_bytes.fetch_add( n * size, std::memory_order_relaxed );
+  return __libc_calloc( n, size );
+}
+void* realloc( void* ptr, size_t size ) {
+  g_alloc_count.fetch_add( 1, std::memory_order_relaxed );
+  g_alloc_bytes.fetch_add( size, std::memory_order_relaxed );
+  return __libc_realloc( ptr, size );
+}
+}
+#else
+#define COUNTS_ALLOCATIONS 0
+#endif
+
+/*-----------------------------------LOADERS----------------------------------*/
+/* every loader hashes its vertices one per corner, in face order, so any that
+read the file the same way give the same hash. one running hash per array */
+struct corner_hash {
+  unsigned int h[3];
+  int point_count;
+};
+
+static unsigned int fnv1a( unsigned int h, const float* f, int count ) {
+  const unsigned char* b = (const unsigned char*)f;
+  for ( size_t i = 0; i < (size_t)count * sizeof( float ); i++ ) { h = ( h ^ b[i] ) * 16777619u; }
+  return h;
+}
+
+static void hash_corners( corner_hash* c, const float* points, const float* tex_coords, const float* normals, int count ) {
+  c->h[0] = fnv1a( c->h[0], points, count * 3 );
+  c->h[1] = fnv1a( c->h[1], tex_coords, count * 2 );
+  c->h[2] = fnv1a( c->h[2], normals, count * 3 );
+  c->point_count += count;
+}
+
+static void hash_indexed( corner_hash* c, const float* points, const float* tex_coords, const float* normals, const void* indices, int index_count,
+  int index_size ) {
+  // no vn in the file: hash zeros, as load_obj_file_indexed_interleaved() stores
+  static const float zero[3] = { 0.0f, 0.0f, 0.0f };
+  for ( int i = 0; i < index_count; i++ ) {
+    size_t v = 2 == index_size ? ( (const unsigned short*)indices )[i] : ( (const unsigned int*)indices )[i];
+    hash_corners( c, &points[v * 3], &tex_coords[v * 2], normals ? &normals[v * 3] : zero, 1 );
+  }
+}
+
+// indices may be NULL, for one vertex per corner
+static void hash_interleaved( corner_hash* c, const void* vertices, const vertex_layout& layout, const void* indices, int count, int index_size ) {
+  int p = find_vertex_attrib( layout, VERTEX_LOCATION_POINTS ), t = find_vertex_attrib( layout, VERTEX_LOCATION_TEX_COORDS );
+  int n = find_vertex_attrib( layout, VERTEX_LOCATION_NORMALS );
+  for ( int i = 0; i < count; i++ ) {
+    size_t v = !indices ? (size_t)i : 2 == index_size ? ( (const unsigned short*)indices )[i] : ( (const unsigned int*)indices )[i];
+    const unsigned char* vert = (const unsigned char*)vertices + v * layout.stride;
+    hash_corners( c, (const float*)( vert + layout.attribs[p].offset ), (const float*)( vert + layout.attribs[t].offset ),
+      (const float*)( vert + layout.attribs[n].offset ), 1 );
+  }
+}
+
+/* each loader loads file_name, and sets ms to the time the load took, not
+counting the hashing */
+typedef bool ( *loader_t )( const char* file_name, corner_hash* c, double* ms );
+
+static bool load_threads( const char* file_name, int n_threads, corner_hash* c, double* ms ) {
+  float *p = NULL, *t = NULL, *n = NULL;
+  int pc    = 0;
+  double t0 = now_ms();
+  bool ok   = load_obj_file_threads( file_name, p, t, n, pc, n_threads );
+  *ms       = now_ms() - t0;
+  if ( ok ) { hash_corners( c, p, t, n, pc ); }
+  free( p );
+  free( t );
+  free( n );
+  return ok;
+}
+
+static bool load_one_thread( const char* file_name, corner_hash* c, double* ms ) { return load_threads( file_name, 1, c, ms ); }
+
+static bool load_all_threads( const char* file_name, corner_hash* c, double* ms ) { return load_threads( file_name, 0, c, ms ); }
+
+static bool load_indexed( const char* file_name, corner_hash* c, double* ms ) {
+  float *p = NULL, *t = NULL, *n = NULL;
+  void* indices    = NULL;
+  int vertex_count = 0, index_count = 0, index_size = 0;
+  double t0        = now_ms();
+  bool ok          = load_obj_file_indexed( file_name, p, t, n, vertex_count, indices, index_count, index_size );
+  *ms              = now_ms() - t0;
+  if ( ok ) { hash_indexed( c, p, t, n, indices, index_count, index_size ); }
+  free( p );
+  free( t );
+  free( n );
+  free( indices );
+  return ok;
+}
+
+static bool load_interleaved( const char* file_name, corner_hash* c, double* ms ) {
+  void* vertices = NULL;
+  vertex_layout layout;
+  int pc    = 0;
+  double t0 = now_ms();
+  bool ok   = load_obj_file_interleaved( file_name, VERTEX_LAYOUT_ALL, 4, vertices, layout, pc );
+  *ms       = now_ms() - t0;
+  if ( ok ) { hash_interleaved( c, vertices, layout, NULL, pc, 0 ); }
+  free( vertices );
+  return ok;
+}
+
+static bool hash_batch( const float* points, const float* tex_coords, const float* normals, int point_count, void* user_data ) {
+  hash_corners( (corner_hash*)user_data, points, tex_coords, normals, point_count );
+  return true;
+}
+
+// the hashing can't be taken out of the time here, since it's what the batches feed
+static bool load_streamed( const char* file_name, corner_hash* c, double* ms ) {
+  int pc    = 0;
+  double t0 = now_ms();
+  bool ok   = load_obj_file_streamed( file_name, STREAM_BATCH_POINTS, hash_batch, c, &pc );
+  *ms       = now_ms() - t0;
+  return ok;
+}
+
+// sum of every 8-byte word in the block, with any tail bytes added on
+static unsigned long long sum_bytes( const void* data, size_t sz ) {
+  const unsigned char* p = (const unsigned char*)data;
+  unsigned long long sum = 0;
+  size_t i               = 0;
+  for ( ; i + 8 <= sz; i += 8 ) {
+    unsigned long long w;
+    memcpy( &w, p + i, 8 );
+    sum += w;
+  }
+  for ( ; i < sz; i++ ) { sum += p[i]; }
+  return sum;
+}
+
+static volatile unsigned long long g_sink;
+
+/* the cache is made before the child starts, so this is always a hit. mapping
+the file alone costs almost nothing - pages come in as the arrays are first
+read - so the time includes one pass over every stream, as glBufferData()
+would make. the file was just written, so that is from the OS page cache */
+static bool load_cached( const char* file_name, corner_hash* c, double* ms ) {
+  mesh_data mesh;
+  bool hit  = false;
+  double t0 = now_ms();
+  bool ok   = load_obj_file_cached( file_name, &mesh, &hit );
+  if ( ok ) {
+    size_t vc = (size_t)mesh.vertex_count;
+    g_sink    = sum_bytes( mesh.points, vc * 12 ) + sum_bytes( mesh.tex_coords, vc * 8 ) + sum_bytes( mesh.normals, vc * 12 ) +
+             sum_bytes( mesh.indices, (size_t)mesh.index_count * mesh.index_size );
+  }
+  *ms = now_ms() - t0;
+  if ( !ok ) { return false; }
+  hash_indexed( c, mesh.points, mesh.tex_coords, mesh.normals, mesh.indices, mesh.index_count, mesh.index_size );
+  free_mesh_data( &mesh );
+  return hit;
+}
+
+// makes the cache for load_cached
+static bool warm_cache( const char* file_name, corner_hash*, double* ) {
+  mesh_data mesh;
+  bool hit = false;
+  if ( !load_obj_file_cached( file_name, &mesh, &hit ) ) { return false; }
+  free_mesh_data( &mesh );
+  return true;
+}
+
+#ifdef BENCH_WITH_ASSIMP
+/* 13_mesh_import's load_mesh(), without the GL: import, then copy out of
+Assimp's structures into plain arrays. with join true, Assimp also merges
+identical vertices and the faces are read as indices */
+static bool load_assimp( const char* file_name, bool join, corner_hash* c, double* ms ) {
+  double t0            = now_ms();
+  unsigned int flags   = aiProcess_Triangulate | ( join ? aiProcess_JoinIdenticalVertices : 0 );
+  const aiScene* scene = aiImportFile( file_name, flags );
+  if ( !scene || scene->mNumMeshes < 1 ) {
+    fprintf( stderr, "ERROR: reading mesh %s\n", file_name );
+    if ( scene ) { aiReleaseImport( scene ); }
+    return false;
+  }
+  const aiMesh* mesh = scene->mMeshes[0];
+  int point_count    = mesh->mNumVertices;
+  float* points      = (float*)malloc( (size_t)point_count * 3 * sizeof( float ) + 1 );
+  float* normals     = (float*)calloc( (size_t)point_count * 3 + 1, sizeof( float ) );
+  float* tex_coords  = (float*)calloc( (size_t)point_count * 2 + 1, sizeof( float ) );
+  for ( int i = 0; i < point_count; i++ ) {
+    const aiVector3D* vp = &( mesh->mVertices[i] );
+    points[i * 3]        = vp->x;
+    points[i * 3 + 1]    = vp->y;
+    points[i * 3 + 2]    = vp->z;
+    if ( mesh->HasNormals() ) {
+      const aiVector3D* vn = &( mesh->mNormals[i] );
+      normals[i * 3]       = vn->x;
+      normals[i * 3 + 1]   = vn->y;
+      normals[i * 3 + 2]   = vn->z;
+    }
+    if ( mesh->HasTextureCoords( 0 ) ) {
+      const aiVector3D* vt = &( mesh->mTextureCoords[0][i] );
+      tex_coords[i * 2]     = vt->x;
+      tex_coords[i * 2 + 1] = vt->y;
+    }
+  }
+  unsigned int* indices = NULL;
+  int index_count       = 0;
+  if ( join ) {
+    indices = (unsigned int*)malloc( (size_t)mesh->mNumFaces * 3 * sizeof( unsigned int ) + 1 );
+    for ( unsigned int f = 0; f < mesh->mNumFaces; f++ ) {
+      for ( unsigned int k = 0; k < 3 && k < mesh->mFaces[f].mNumIndices; k++ ) { indices[index_count++] = mesh->mFaces[f].mIndices[k]; }
+    }
+  }
+  aiReleaseImport( scene );
+  *ms = now_ms() - t0;
+  if ( join ) {
+    hash_indexed( c, points, tex_coords, normals, indices, index_count, 4 );
+  } else {
+    hash_corners( c, points, tex_coords, normals, point_count );
+  }
+  free( points );
+  free( normals );
+  free( tex_coords );
+  free( indices );
+  return true;
+}
+
+static bool load_assimp_13( const char* file_name, corner_hash* c, double* ms ) { return load_assimp( file_name, false, c, ms ); }
+
+static bool load_assimp_joined( const char* file_name, corner_hash* c, double* ms ) { return load_assimp( file_name, true, c, ms ); }
+#endif
+
+struct loader_entry {
+  const char* name;
+  loader_t load;
+  // false if it may round floats differently, so only the vertex count is compared
+  bool exact;
+};
+
+static const loader_entry k_loaders[] = {
+  { "load_obj_file, 1 thread", load_one_thread, true },
+  { "load_obj_file", load_all_threads, true },
+  { "load_obj_file_indexed", load_indexed, true },
+  { "load_obj_file_interleaved", load_interleaved, true },
+  { "load_obj_file_streamed", load_streamed, true },
+  { "load_obj_file_cached (hit)", load_cached, true },
+#ifdef BENCH_WITH_ASSIMP
+  { "assimp, as 13_mesh_import", load_assimp_13, false },
+  { "assimp + join vertices", load_assimp_joined, false },
+#endif
+};
+#define N_LOADERS ( sizeof( k_loaders ) / sizeof( k_loaders[0] ) )
+
+/*------------------------------------CHILD-----------------------------------*/
+struct load_result {
+  corner_hash hash;
+  double ms;
+  unsigned long long allocs;
+  unsigned long long alloc_bytes;
+  long peak_kb;
+};
+
+// runs in the child. writes the result back through fd
+static void child_load( const loader_entry& l, int fd ) {
+  load_result r;
+  memset( &r, 0, sizeof( r ) );
+  for ( int a = 0; a < 3; a++ ) { r.hash.h[a] = 2166136261u; }
+  g_alloc_count = 0;
+  g_alloc_bytes = 0;
+  bool ok       = l.load( TMP_OBJ_FILE, &r.hash, &r.ms );
+  // the hashing doesn't allocate, so these are all the loader's
+  r.allocs      = g_alloc_count;
+  r.alloc_bytes = g_alloc_bytes;
+  if ( write( fd, &r, sizeof( r ) ) != (ssize_t)sizeof( r ) ) { ok = false; }
+  _exit( ok ? 0 : 1 );
+}
+
+static bool run_child( const loader_entry& l, load_result* r ) {
+  int fds[2];
+  if ( pipe( fds ) ) { return false; }
+  fflush( stdout );
+  fflush( stderr );
+  pid_t pid = fork();
+  if ( pid < 0 ) { return false; }
+  if ( 0 == pid ) {
+    close( fds[0] );
+    // the loaders' progress messages would bury the table
+    if ( !freopen( "/dev/null", "w", stdout ) ) { _exit( 1 ); }
+    child_load( l, fds[1] );
+  }
+  close( fds[1] );
+  ssize_t len = read( fds[0], r, sizeof( *r ) );
+  close( fds[0] );
+  int status = 0;
+  struct rusage ru;
+  if ( wait4( pid, &status, 0, &ru ) != pid || !WIFEXITED( status ) || WEXITSTATUS( status ) || len != (ssize_t)sizeof( *r ) ) { return false; }
+  r->peak_kb = ru.ru_maxrss; // kB on Linux
+  return true;
+}
+
+/*-----------------------------------REPORT-----------------------------------*/
+static size_t write_shape( const char* shape, int face_count ) {
+  if ( !strcmp( shape, "sphere" ) ) { return write_sphere_obj( TMP_OBJ_FILE, face_count, SPHERE_NOISE ); }
+  if ( !strcmp( shape, "terrain" ) ) { return write_terrain_obj( TMP_OBJ_FILE, face_count, TERRAIN_AMPLITUDE ); }
+  return write_grid_obj( TMP_OBJ_FILE, face_count, false );
+}
+
+static int bench_size( const char* shape, int face_count ) {
+  size_t sz = write_shape( shape, face_count );
+  if ( !sz ) { return 1; }
+  // make the cache ahead, so load_obj_file_cached is timed on a hit
+  char cache_file[256];
+  snprintf( cache_file, sizeof( cache_file ), "%s%s", TMP_OBJ_FILE, MESH_CACHE_SUFFIX );
+  const loader_entry warm = { "cache warm-up", warm_cache, true };
+  load_result unused;
+  run_child( warm, &unused );
+  double mb = (double)sz / ( 1024.0 * 1024.0 );
+  printf( "%s, %i faces, %.1f MB obj:\n", shape, face_count, mb );
+  printf( "  %-27s %10s %9s %10s %11s %9s %10s\n", "loader", "time", "MB/s", "Mtris/s", "peak RSS", "allocs", "alloc MB" );
+  int failures = 0;
+  load_result ref;
+  memset( &ref, 0, sizeof( ref ) );
+  for ( size_t i = 0; i < N_LOADERS; i++ ) {
+    load_result r;
+    if ( !run_child( k_loaders[i], &r ) ) {
+      fprintf( stderr, "ERROR: %s failed on %s\n", k_loaders[i].name, TMP_OBJ_FILE );
+      failures++;
+      continue;
+    }
+    if ( 0 == i ) { ref = r; }
+    bool same = r.hash.point_count == ref.hash.point_count;
+    if ( k_loaders[i].exact ) { same = same && !memcmp( r.hash.h, ref.hash.h, sizeof( r.hash.h ) ); }
+    double tris = r.hash.point_count / 3.0;
+    printf( "  %-27s %8.1fms %9.1f %10.2f %8.1f MB", k_loaders[i].name, r.ms, mb / ( r.ms / 1000.0 ), tris / ( r.ms * 1000.0 ), r.peak_kb / 1024.0 );
+    if ( COUNTS_ALLOCATIONS ) {
+      printf( " %9llu %10.1f", r.allocs, r.alloc_bytes / ( 1024.0 * 1024.0 ) );
+    } else {
+      printf( " %9s %10s", "-", "-" );
+    }
+    printf( "%s\n", same ? "" : "  DIFFERENT" );
+    if ( !same ) {
+      fprintf( stderr, "ERROR: %s doesn't give load_obj_file()'s vertices\n", k_loaders[i].name );
+      failures++;
+    }
+  }
+  remove( cache_file );
+  remove( TMP_OBJ_FILE );
+  return failures;
+}
+
+int main( int argc, char** argv ) {
+  const char* shapes[3] = { "grid", "sphere", "terrain" };
+  int first_shape = 0, n_shapes = 3, arg = 1;
+  for ( int s = 0; s < 3 && argc > 1; s++ ) {
+    if ( !strcmp( argv[1], shapes[s] ) ) {
+      first_shape = s;
+      n_shapes    = 1;
+      arg         = 2;
+    }
+  }
+#ifndef BENCH_WITH_ASSIMP
+  printf( "built without assimp. the 13_mesh_import loader is skipped\n" );
+#endif
+  int failures = 0;
+  for ( int s = first_shape; s < first_shape + n_shapes; s++ ) {
+    if ( arg < argc ) {
+      for ( int i = arg; i < argc; i++ ) { failures += bench_size( shapes[s], atoi( argv[i] ) ); }
+    } else {
+      for ( size_t i = 0; i < sizeof( k_default_face_counts ) / sizeof( k_default_face_counts[0] ); i++ ) {
+        failures += bench_size( shapes[s], k_default_face_counts[i] );
+      }
+    }
+  }
+  if ( failures ) { fprintf( stderr, "%i mesh load check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,415 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless report for mesh_normals. No GL context required.                    |
+| For the bundled meshes and a big synthetic terrain and sphere, times         |
+| compute_vertex_normals() and compute_vertex_tangents() on 1, 2, 4 and 8      |
+| threads and checks every thread count gives the same bytes. Prints how far   |
+| each normal weighting lands from the file's own normals - on the bundled     |
+| meshes the closest must be near them - checks vertices split along a UV seam |
+| get the same normal, and checks the                                          |
+| tangents are unit length and perpendicular to the normals. On the terrain,   |
+| whose u runs along +x and v along +z, checks the tangents follow u and the   |
+| bitangent signs follow v. Then strips the vn lines from a terrain and checks |
+| load_obj_file_indexed() still reads it, with no normals, and that generated  |
+| ones match. Times Assimp's GenSmoothNormals and CalcTangentSpace steps on    |
+| the same meshes, if built with Assimp.                                       |
+| Usage: bench_mesh_normals [face_count]                                       |
+\******************************************************************************/
+#include "mesh_normals.h"
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef BENCH_WITH_ASSIMP
+#include <assimp/cimport.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#endif
+
+#ifndef COMMON_SOURCE_DIR
+#define COMMON_SOURCE_DIR "."
+#endif
+#define DEFAULT_FACES 1000000
+#define TERRAIN_AMPLITUDE 8.0f
+#define SPHERE_NOISE 0.1f
+#define NO_VN_FACES 20000
+#define TIMING_RUNS 3
+/* how far the closest weighting's normals may be from the bundled meshes'
+vn, which came from a modelling tool's smooth normals, in mean degrees. the
+synthetic meshes' vn are the analytic normals of a surface the triangles only
+approximate, so how close they get depends on face_count - those are printed */
+#define BUNDLED_MAX_MEAN_DEG 1.0
+#define PRINT_ONLY -1.0
+#define TMP_OBJ_FILE "bench_mesh_normals_tmp.obj"
+#define TMP_NO_VN_FILE "bench_mesh_normals_tmp_no_vn.obj"
+
+static const int k_thread_counts[] = { 1, 2, 4, 8 };
+#define N_THREAD_COUNTS ( sizeof( k_thread_counts ) / sizeof( k_thread_counts[0] ) )
+
+static const char* k_weighting_names[] = { "area", "angle", "area*angle" };
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+struct indexed_mesh {
+  float* points;
+  float* tex_coords;
+  float* normals;
+  int vertex_count;
+  unsigned int* indices;
+  int index_count;
+};
+
+static bool load_mesh( const char* file_name, indexed_mesh* m ) {
+  void* raw = NULL;
+  int index_size = 0;
+  memset( m, 0, sizeof( *m ) );
+  if ( !load_obj_file_indexed( file_name, m->points, m->tex_coords, m->normals, m->vertex_count, raw, m->index_count, index_size ) ) { return false; }
+  // mesh_normals wants 32-bit indices
+  m->indices = (unsigned int*)malloc( (size_t)m->index_count * sizeof( unsigned int ) + 1 );
+  for ( int i = 0; i < m->index_count; i++ ) { m->indices[i] = 2 == index_size ? ( (unsigned short*)raw )[i] : ( (unsigned int*)raw )[i]; }
+  free( raw );
+  return true;
+}
+
+static void free_mesh( indexed_mesh* m ) {
+  free( m->points );
+  free( m->tex_coords );
+  free( m->normals );
+  free( m->indices );
+}
+
+static float dot3( const float* a, const float* b ) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+// angle between a and b in degrees
+static double angle_deg( const float* a, const float* b ) {
+  double d = dot3( a, b ) / sqrt( (double)dot3( a, a ) * dot3( b, b ) );
+  if ( d > 1.0 ) { d = 1.0; }
+  if ( d < -1.0 ) { d = -1.0; }
+  return acos( d ) * 180.0 / M_PI;
+}
+
+/*-----------------------------------TIMING-----------------------------------*/
+// which function a timing row runs
+enum generator { GENERATE_NORMALS, GENERATE_TANGENTS };
+
+static bool generate( generator g, const indexed_mesh* m, const float* normals, float* out, int n_threads ) {
+  if ( GENERATE_NORMALS == g ) {
+    return compute_vertex_normals( out, m->indices, m->index_count, m->points, m->vertex_count, NORMAL_WEIGHT_AREA_ANGLE, n_threads );
+  }
+  return compute_vertex_tangents( out, m->indices, m->index_count, m->points, normals, m->tex_coords, m->vertex_count, n_threads );
+}
+
+/* best of TIMING_RUNS at each thread count. every count's output must be the
+same bytes as one thread's. returns the number of failures */
+static int time_generator( const char* name, generator g, const indexed_mesh* m, const float* normals ) {
+  size_t n_floats = (size_t)m->vertex_count * ( GENERATE_NORMALS == g ? 3 : 4 );
+  float* first    = (float*)malloc( n_floats * sizeof( float ) + 1 );
+  float* out      = (float*)malloc( n_floats * sizeof( float ) + 1 );
+  int failures    = 0;
+  double one_ms   = 0.0;
+  for ( size_t c = 0; c < N_THREAD_COUNTS; c++ ) {
+    double best = 0.0;
+    for ( int r = 0; r < TIMING_RUNS; r++ ) {
+      double t0 = now_ms();
+      if ( !generate( g, m, normals, out, k_thread_counts[c] ) ) {
+        failures++;
+        break;
+      }
+      double ms = now_ms() - t0;
+      if ( 0 == r || ms < best ) { best = ms; }
+    }
+    if ( 0 == c ) {
+      memcpy( first, out, n_floats * sizeof( float ) );
+      one_ms = best;
+    }
+    bool same = 0 == memcmp( first, out, n_floats * sizeof( float ) );
+    if ( !same ) {
+      fprintf( stderr, "ERROR: %s on %i threads differs from 1 thread\n", name, k_thread_counts[c] );
+      failures++;
+    }
+    printf( "  %-9s %2i threads %9.2fms %8.1f Mtris/s %5.2fx %s\n", name, k_thread_counts[c], best, m->index_count / 3 / ( best * 1000.0 ), one_ms / best,
+      same ? "identical" : "DIFFERENT" );
+  }
+  free( first );
+  free( out );
+  return failures;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// orders 3 floats by value, for sorting positions
+static int compare_points( const void* a, const void* b ) {
+  const float* pa = (const float*)a;
+  const float* pb = (const float*)b;
+  for ( int k = 0; k < 3; k++ ) {
+    if ( pa[k] != pb[k] ) { return pa[k] < pb[k] ? -1 : 1; }
+  }
+  return 0;
+}
+
+/* mean and worst angle between each weighting's normals and the file's. the
+closest weighting's mean must be within max_mean_deg, unless that's
+PRINT_ONLY, and vertices at the same position must get the same normal.
+returns the number of failures */
+static int compare_weightings( const char* name, const indexed_mesh* m, double max_mean_deg ) {
+  float* normals = (float*)malloc( (size_t)m->vertex_count * 3 * sizeof( float ) + 1 );
+  int failures   = 0;
+  double best    = 180.0;
+  for ( int w = NORMAL_WEIGHT_AREA; w <= NORMAL_WEIGHT_AREA_ANGLE; w++ ) {
+    if ( !compute_vertex_normals( normals, m->indices, m->index_count, m->points, m->vertex_count, (normal_weighting)w, 0 ) ) {
+      failures++;
+      continue;
+    }
+    double sum = 0.0, worst = 0.0;
+    for ( int v = 0; v < m->vertex_count; v++ ) {
+      double a = angle_deg( &normals[v * 3], &m->normals[v * 3] );
+      sum += a;
+      if ( a > worst ) { worst = a; }
+    }
+    printf( "  %-10s normals vs file's: mean %6.3f max %7.3f degrees\n", k_weighting_names[w], sum / m->vertex_count, worst );
+    if ( sum / m->vertex_count < best ) { best = sum / m->vertex_count; }
+    // the copies of a vertex split along a UV seam. sorting (position, normal) puts each position's copies together
+    float* pn = (float*)malloc( (size_t)m->vertex_count * 6 * sizeof( float ) + 1 );
+    for ( int v = 0; v < m->vertex_count; v++ ) {
+      memcpy( &pn[v * 6], &m->points[v * 3], 3 * sizeof( float ) );
+      memcpy( &pn[v * 6 + 3], &normals[v * 3], 3 * sizeof( float ) );
+    }
+    qsort( pn, m->vertex_count, 6 * sizeof( float ), compare_points );
+    int creased = 0;
+    for ( int v = 1; v < m->vertex_count; v++ ) {
+      if ( 0 == compare_points( &pn[v * 6], &pn[( v - 1 ) * 6] ) && memcmp( &pn[v * 6 + 3], &pn[( v - 1 ) * 6 + 3], 3 * sizeof( float ) ) ) { creased++; }
+    }
+    free( pn );
+    if ( creased ) {
+      fprintf( stderr, "ERROR: %s: %i vertices have a different %s normal to another at the same position\n", name, creased, k_weighting_names[w] );
+      failures++;
+    }
+  }
+  free( normals );
+  if ( max_mean_deg != PRINT_ONLY && best > max_mean_deg ) {
+    fprintf( stderr, "ERROR: %s: generated normals are a mean %.3f degrees from the file's at best, over the %.3f allowed\n", name, best, max_mean_deg );
+    failures++;
+  }
+  return failures;
+}
+
+/* tangents unit length, perpendicular to the normals, w +/-1. with expect_u
+set, u should grow along expect_u (the terrain's +x) and v along expect_v
+(+z): on a heightfield that puts the tangent along the surface, straight
+across expect_v, and the bitangent on expect_v's side. returns the number of
+failures */
+static int check_tangents( const char* name, const indexed_mesh* m, const float* expect_u, const float* expect_v ) {
+  float* tangents = (float*)malloc( (size_t)m->vertex_count * 4 * sizeof( float ) + 1 );
+  if ( !compute_vertex_tangents( tangents, m->indices, m->index_count, m->points, m->normals, m->tex_coords, m->vertex_count, 0 ) ) {
+    free( tangents );
+    return 1;
+  }
+  double worst_dot = 0.0, worst_len = 0.0, sum_u = 0.0, worst_u = 0.0;
+  int bad_w = 0, wrong_side = 0;
+  for ( int v = 0; v < m->vertex_count; v++ ) {
+    const float* t = &tangents[v * 4];
+    const float* n = &m->normals[v * 3];
+    double d       = fabs( dot3( t, n ) ) / sqrt( dot3( n, n ) );
+    double l       = fabs( sqrt( dot3( t, t ) ) - 1.0 );
+    if ( d > worst_dot ) { worst_dot = d; }
+    if ( l > worst_len ) { worst_len = l; }
+    if ( t[3] != 1.0f && t[3] != -1.0f ) { bad_w++; }
+    if ( !expect_u ) { continue; }
+    // the direction in the normal's plane at right angles to expect_v, on expect_u's side
+    float u[3] = { n[1] * expect_v[2] - n[2] * expect_v[1], n[2] * expect_v[0] - n[0] * expect_v[2], n[0] * expect_v[1] - n[1] * expect_v[0] };
+    if ( dot3( u, expect_u ) < 0.0f ) { u[0] = -u[0], u[1] = -u[1], u[2] = -u[2]; }
+    double a = angle_deg( t, u );
+    sum_u += a;
+    if ( a > worst_u ) { worst_u = a; }
+    float b[3] = { ( n[1] * t[2] - n[2] * t[1] ) * t[3], ( n[2] * t[0] - n[0] * t[2] ) * t[3], ( n[0] * t[1] - n[1] * t[0] ) * t[3] };
+    if ( dot3( b, expect_v ) <= 0.0f ) { wrong_side++; }
+  }
+  printf( "  tangents: worst |t.n| %.2e, worst |len - 1| %.2e\n", worst_dot, worst_len );
+  int failures = 0;
+  if ( worst_dot > 1e-4 || worst_len > 1e-4 || bad_w ) {
+    fprintf( stderr, "ERROR: %s: tangents not unit length and perpendicular to the normals, or w not +/-1 (%i)\n", name, bad_w );
+    failures++;
+  }
+  if ( expect_u ) {
+    printf( "  tangents vs the surface's x direction: mean %.3f max %.3f degrees. bitangents on the +z side: %i of %i\n", sum_u / m->vertex_count, worst_u,
+      m->vertex_count - wrong_side, m->vertex_count );
+    if ( sum_u / m->vertex_count > 5.0 || wrong_side ) {
+      fprintf( stderr, "ERROR: %s: tangents don't follow the tex coords\n", name );
+      failures++;
+    }
+  }
+  free( tangents );
+  return failures;
+}
+
+/*---------------------------------ASSIMP-------------------------------------*/
+#ifdef BENCH_WITH_ASSIMP
+/* imports file_name with only the steps a fresh load needs, then times
+applying step on its own, as 20_normal_mapping's import does it */
+static void time_assimp_step( const char* label, const char* file_name, unsigned int step ) {
+  const aiScene* scene = aiImportFile( file_name, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices );
+  if ( !scene ) {
+    fprintf( stderr, "ERROR: assimp reading %s\n", file_name );
+    return;
+  }
+  double t0 = now_ms();
+  scene     = aiApplyPostProcessing( scene, step );
+  double ms = now_ms() - t0;
+  if ( !scene ) {
+    fprintf( stderr, "ERROR: assimp %s on %s\n", label, file_name );
+    return;
+  }
+  printf( "  assimp %-19s %9.2fms\n", label, ms );
+  aiReleaseImport( scene );
+}
+#endif
+
+/*------------------------------------MESHES----------------------------------*/
+// times and checks one mesh. returns the number of failures
+static int bench_mesh( const char* name, const indexed_mesh* m, double max_mean_deg, const float* expect_u, const float* expect_v ) {
+  printf( "%s: %i vertices %i triangles\n", name, m->vertex_count, m->index_count / 3 );
+  int failures = compare_weightings( name, m, max_mean_deg );
+  failures += check_tangents( name, m, expect_u, expect_v );
+  failures += time_generator( "normals", GENERATE_NORMALS, m, NULL );
+  failures += time_generator( "tangents", GENERATE_TANGENTS, m, m->normals );
+  return failures;
+}
+
+/* copies src to dst without its vn lines, and its faces as f a/b c/d e/f.
+returns false if a file can't be opened */
+static bool strip_normals( const char* src, const char* dst ) {
+  FILE* in = fopen( src, "r" );
+  if ( !in ) {
+    fprintf( stderr, "ERROR: could not open %s\n", src );
+    return false;
+  }
+  FILE* out = fopen( dst, "w" );
+  if ( !out ) {
+    fprintf( stderr, "ERROR: could not write %s\n", dst );
+    fclose( in );
+    return false;
+  }
+  char line[1024];
+  while ( fgets( line, sizeof( line ), in ) ) {
+    int v[9];
+    if ( 0 == strncmp( line, "vn ", 3 ) ) { continue; }
+    if ( 9 == sscanf( line, "f %i/%i/%i %i/%i/%i %i/%i/%i", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8] ) ) {
+      fprintf( out, "f %i/%i %i/%i %i/%i\n", v[0], v[1], v[3], v[4], v[6], v[7] );
+    } else {
+      fputs( line, out );
+    }
+  }
+  fclose( in );
+  fclose( out );
+  return true;
+}
+
+/* a terrain with and without its vn lines must load as the same vertices and
+triangles, the second with no normals (or zeroed ones, interleaved), so
+normals generated for it are the same bits as for the first. returns the
+number of failures */
+static int check_no_vn_file() {
+  printf( "terrain without vn lines: %i faces\n", NO_VN_FACES );
+  if ( !write_terrain_obj( TMP_OBJ_FILE, NO_VN_FACES, TERRAIN_AMPLITUDE ) || !strip_normals( TMP_OBJ_FILE, TMP_NO_VN_FILE ) ) { return 1; }
+  indexed_mesh with, without;
+  bool ok = load_mesh( TMP_OBJ_FILE, &with );
+  ok      = load_mesh( TMP_NO_VN_FILE, &without ) && ok;
+  // the interleaved loader should leave the normals zeroed
+  void* vertices = NULL;
+  vertex_layout layout;
+  int vertex_count = 0, index_count = 0, index_size = 0;
+  void* indices = NULL;
+  bool zeroed   = false;
+  if ( load_obj_file_indexed_interleaved( TMP_NO_VN_FILE, VERTEX_LAYOUT_ALL, 16, vertices, layout, vertex_count, indices, index_count, index_size ) ) {
+    int a  = find_vertex_attrib( layout, VERTEX_LOCATION_NORMALS );
+    zeroed = a >= 0;
+    for ( int v = 0; v < vertex_count && zeroed; v++ ) {
+      const float* n = (const float*)( (const unsigned char*)vertices + (size_t)v * layout.stride + layout.attribs[a].offset );
+      zeroed         = 0.0f == n[0] && 0.0f == n[1] && 0.0f == n[2];
+    }
+  }
+  free( vertices );
+  free( indices );
+  remove( TMP_OBJ_FILE );
+  remove( TMP_NO_VN_FILE );
+  if ( !ok ) {
+    fprintf( stderr, "ERROR: could not load the terrain with and without vn lines\n" );
+    return 1;
+  }
+  int failures = 0;
+  if ( without.normals || !zeroed || with.vertex_count != without.vertex_count || with.index_count != without.index_count ||
+       memcmp( with.indices, without.indices, (size_t)with.index_count * sizeof( unsigned int ) ) ||
+       memcmp( with.points, without.points, (size_t)with.vertex_count * 3 * sizeof( float ) ) ) {
+    fprintf( stderr, "ERROR: the terrain without vn lines loaded differently\n" );
+    failures++;
+  } else {
+    size_t sz       = (size_t)with.vertex_count * 3 * sizeof( float );
+    float* expected = (float*)malloc( sz + 1 );
+    without.normals = (float*)malloc( sz + 1 );
+    if ( !compute_vertex_normals( without.normals, without.indices, without.index_count, without.points, without.vertex_count, NORMAL_WEIGHT_AREA_ANGLE, 0 ) ||
+         !compute_vertex_normals( expected, with.indices, with.index_count, with.points, with.vertex_count, NORMAL_WEIGHT_AREA_ANGLE, 0 ) ) {
+      failures++;
+    } else {
+      double sum = 0.0;
+      for ( int v = 0; v < with.vertex_count; v++ ) { sum += angle_deg( &without.normals[v * 3], &with.normals[v * 3] ); }
+      bool same = 0 == memcmp( expected, without.normals, sz );
+      printf( "  loads with no normals. generated ones %s, mean %.3f degrees from the file's\n", same ? "identical" : "DIFFERENT", sum / with.vertex_count );
+      if ( !same ) {
+        fprintf( stderr, "ERROR: generated normals for the terrain without vn lines differ\n" );
+        failures++;
+      }
+    }
+    free( expected );
+  }
+  free_mesh( &with );
+  free_mesh( &without );
+  return failures;
+}
+
+int main( int argc, char** argv ) {
+  int face_count = argc > 1 ? atoi( argv[1] ) : DEFAULT_FACES;
+  printf( "normals are area*angle weighted for timing. best of %i runs per thread count\n\n", TIMING_RUNS );
+  int failures          = 0;
+  // all but 13's monkey2 have vertices split along UV seams, which must not show in the normals
+  const char* meshes[4] = { COMMON_SOURCE_DIR "/../07_ray_picking/sphere.obj", COMMON_SOURCE_DIR "/../38_texture_shadows/sphere.obj",
+    COMMON_SOURCE_DIR "/../38_texture_shadows/suzanne.obj", COMMON_SOURCE_DIR "/../13_mesh_import/monkey2.obj" };
+  for ( int i = 0; i < 4; i++ ) {
+    indexed_mesh m;
+    if ( !load_mesh( meshes[i], &m ) ) { return 1; }
+    failures += bench_mesh( strrchr( meshes[i], '/' ) + 1, &m, BUNDLED_MAX_MEAN_DEG, NULL, NULL );
+    free_mesh( &m );
+  }
+
+  const float plus_x[3] = { 1.0f, 0.0f, 0.0f }, plus_z[3] = { 0.0f, 0.0f, 1.0f };
+  for ( int s = 0; s < 2; s++ ) {
+    bool terrain = 0 == s;
+    size_t sz    = terrain ? write_terrain_obj( TMP_OBJ_FILE, face_count, TERRAIN_AMPLITUDE ) : write_sphere_obj( TMP_OBJ_FILE, face_count, SPHERE_NOISE );
+    if ( !sz ) { return 1; }
+    indexed_mesh m;
+    if ( !load_mesh( TMP_OBJ_FILE, &m ) ) { return 1; }
+    failures += bench_mesh( terrain ? "terrain" : "bumpy sphere", &m, PRINT_ONLY, terrain ? plus_x : NULL, terrain ? plus_z : NULL );
+#ifdef BENCH_WITH_ASSIMP
+    // GenSmoothNormals only runs on meshes with no normals
+    if ( strip_normals( TMP_OBJ_FILE, TMP_NO_VN_FILE ) ) {
+      time_assimp_step( "GenSmoothNormals", TMP_NO_VN_FILE, aiProcess_GenSmoothNormals );
+      remove( TMP_NO_VN_FILE );
+    }
+    time_assimp_step( "CalcTangentSpace", TMP_OBJ_FILE, aiProcess_CalcTangentSpace );
+#endif
+    remove( TMP_OBJ_FILE );
+    free_mesh( &m );
+  }
+
+  failures += check_no_vn_file();
+
+  if ( failures ) { fprintf( stderr, "%i normal/tangent check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless report for mesh_optimizer. No GL context required.                  |
+| For the bundled meshes, a synthetic grid, and the same grid with its         |
+| triangles shuffled (the worst an exporter could do), prints ACMR and ATVR    |
+| for FIFO caches of 16 and 32, and CPU-measured overdraw, after each stage:   |
+|   input -> vertex cache -> overdraw -> vertex fetch                          |
+| and how long each stage took. Checks every stage keeps the same triangles,   |
+| with the same winding.                                                       |
+| Usage: bench_mesh_optimizer [overdraw_threshold] [grid_face_count]           |
+\******************************************************************************/
+#include "mesh_optimizer.h"
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef COMMON_SOURCE_DIR
+#define COMMON_SOURCE_DIR "."
+#endif
+#define DEFAULT_THRESHOLD 1.05f
+#define DEFAULT_GRID_FACES 200000
+#define TMP_OBJ_FILE "bench_mesh_optimizer_tmp.obj"
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+struct indexed_mesh {
+  float* points;
+  float* tex_coords;
+  float* normals;
+  int vertex_count;
+  unsigned int* indices;
+  int index_count;
+};
+
+static bool load_mesh( const char* file_name, indexed_mesh* m ) {
+  void* raw = NULL;
+  int index_size = 0;
+  memset( m, 0, sizeof( *m ) );
+  if ( !load_obj_file_indexed( file_name, m->points, m->tex_coords, m->normals, m->vertex_count, raw, m->index_count, index_size ) ) { return false; }
+  // the optimiser wants 32-bit indices
+  m->indices = (unsigned int*)malloc( (size_t)m->index_count * sizeof( unsigned int ) );
+  for ( int i = 0; i < m->index_count; i++ ) { m->indices[i] = 2 == index_size ? ( (unsigned short*)raw )[i] : ( (unsigned int*)raw )[i]; }
+  free( raw );
+  return true;
+}
+
+static void free_mesh( indexed_mesh* m ) {
+  free( m->points );
+  free( m->tex_coords );
+  free( m->normals );
+  free( m->indices );
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// a triangle as its 9 position floats, rotated so the smallest comes first, which keeps the winding
+struct tri_key {
+  float p[9];
+};
+
+static int compare_tri_keys( const void* a, const void* b ) { return memcmp( a, b, sizeof( tri_key ) ); }
+
+static tri_key* sorted_tris( const unsigned int* indices, int index_count, const float* points ) {
+  int tri_count = index_count / 3;
+  tri_key* keys = (tri_key*)malloc( (size_t)tri_count * sizeof( tri_key ) + 1 );
+  for ( int t = 0; t < tri_count; t++ ) {
+    int first = 0;
+    for ( int c = 1; c < 3; c++ ) {
+      if ( memcmp( &points[indices[t * 3 + c] * 3], &points[indices[t * 3 + first] * 3], 3 * sizeof( float ) ) < 0 ) { first = c; }
+    }
+    for ( int c = 0; c < 3; c++ ) { memcpy( &keys[t].p[c * 3], &points[indices[t * 3 + ( first + c ) % 3] * 3], 3 * sizeof( float ) ); }
+  }
+  qsort( keys, tri_count, sizeof( tri_key ), compare_tri_keys );
+  return keys;
+}
+
+static bool same_tris( const tri_key* expected, const unsigned int* indices, int index_count, const float* points ) {
+  tri_key* got = sorted_tris( indices, index_count, points );
+  bool same    = !memcmp( got, expected, (size_t)( index_count / 3 ) * sizeof( tri_key ) );
+  free( got );
+  return same;
+}
+
+/*-----------------------------------REPORT-----------------------------------*/
+static void print_stage( const char* stage, const unsigned int* indices, int index_count, const float* points, int vertex_count, double ms ) {
+  vertex_cache_stats c16 = analyze_vertex_cache( indices, index_count, vertex_count, 16 );
+  vertex_cache_stats c32 = analyze_vertex_cache( indices, index_count, vertex_count, 32 );
+  overdraw_stats od      = analyze_overdraw( indices, index_count, points, vertex_count );
+  printf( "  %-13s ACMR %.3f / %.3f  ATVR %.3f / %.3f  overdraw %.3f", stage, c16.acmr, c32.acmr, c16.atvr, c32.atvr, od.overdraw );
+  if ( ms >= 0.0 ) { printf( "  %8.2fms", ms ); }
+  printf( "\n" );
+}
+
+static int optimize_mesh( const char* name, indexed_mesh* m, float threshold ) {
+  int failures  = 0;
+  int tri_count = m->index_count / 3;
+  printf( "%s: %i vertices %i triangles (cache 16 / 32)\n", name, m->vertex_count, tri_count );
+  tri_key* expected = sorted_tris( m->indices, m->index_count, m->points );
+  unsigned int* tmp = (unsigned int*)malloc( (size_t)m->index_count * sizeof( unsigned int ) + 1 );
+  print_stage( "input", m->indices, m->index_count, m->points, m->vertex_count, -1.0 );
+
+  double t0 = now_ms();
+  optimize_vertex_cache( tmp, m->indices, m->index_count, m->vertex_count );
+  double ms = now_ms() - t0;
+  print_stage( "vertex cache", tmp, m->index_count, m->points, m->vertex_count, ms );
+  if ( !same_tris( expected, tmp, m->index_count, m->points ) ) {
+    fprintf( stderr, "ERROR: %s: optimize_vertex_cache() changed the triangles\n", name );
+    failures++;
+  }
+
+  t0 = now_ms();
+  optimize_overdraw( m->indices, tmp, m->index_count, m->points, m->vertex_count, threshold );
+  ms = now_ms() - t0;
+  print_stage( "overdraw", m->indices, m->index_count, m->points, m->vertex_count, ms );
+  if ( !same_tris( expected, m->indices, m->index_count, m->points ) ) {
+    fprintf( stderr, "ERROR: %s: optimize_overdraw() changed the triangles\n", name );
+    failures++;
+  }
+
+  t0 = now_ms();
+  int used = optimize_vertex_fetch( m->indices, m->index_count, m->points, m->tex_coords, m->normals, m->vertex_count );
+  ms       = now_ms() - t0;
+  print_stage( "vertex fetch", m->indices, m->index_count, m->points, used, ms );
+  // first use order means each new index is exactly one more than the biggest so far
+  unsigned int next = 0;
+  for ( int i = 0; i < m->index_count; i++ ) {
+    if ( m->indices[i] > next ) { next = ~0u; }
+    if ( m->indices[i] == next ) { next++; }
+  }
+  if ( (int)next != used || !same_tris( expected, m->indices, m->index_count, m->points ) ) {
+    fprintf( stderr, "ERROR: %s: optimize_vertex_fetch() broke the mesh\n", name );
+    failures++;
+  }
+  m->vertex_count = used;
+  free( expected );
+  free( tmp );
+  return failures;
+}
+
+// Fisher-Yates over whole triangles, with a fixed seed
+static void shuffle_tris( unsigned int* indices, int index_count ) {
+  unsigned int state = 12345u;
+  for ( int t = index_count / 3 - 1; t > 0; t-- ) {
+    state = state * 1664525u + 1013904223u;
+    int r = (int)( ( state >> 8 ) % (unsigned int)( t + 1 ) );
+    for ( int c = 0; c < 3; c++ ) {
+      unsigned int swap      = indices[t * 3 + c];
+      indices[t * 3 + c]     = indices[r * 3 + c];
+      indices[r * 3 + c]     = swap;
+    }
+  }
+}
+
+int main( int argc, char** argv ) {
+  float threshold = argc > 1 ? (float)atof( argv[1] ) : DEFAULT_THRESHOLD;
+  int grid_faces  = argc > 2 ? atoi( argv[2] ) : DEFAULT_GRID_FACES;
+  printf( "overdraw threshold %.3f, %ix%i overdraw views\n", threshold, OVERDRAW_VIEW_RES, OVERDRAW_VIEW_RES );
+  int failures          = 0;
+  const char* meshes[3] = { COMMON_SOURCE_DIR "/../07_ray_picking/sphere.obj", COMMON_SOURCE_DIR "/../38_texture_shadows/suzanne.obj",
+    COMMON_SOURCE_DIR "/../13_mesh_import/monkey2.obj" };
+  for ( int i = 0; i < 3; i++ ) {
+    indexed_mesh m;
+    if ( !load_mesh( meshes[i], &m ) ) { return 1; }
+    failures += optimize_mesh( strrchr( meshes[i], '/' ) + 1, &m, threshold );
+    free_mesh( &m );
+  }
+
+  // degenerate inputs must come through untouched, and not run off the ends of anything
+  indexed_mesh tiny;
+  memset( &tiny, 0, sizeof( tiny ) );
+  tiny.points     = (float*)calloc( 9, sizeof( float ) );
+  tiny.tex_coords = (float*)calloc( 6, sizeof( float ) );
+  tiny.normals    = (float*)calloc( 9, sizeof( float ) );
+  tiny.indices    = (unsigned int*)malloc( 3 * sizeof( unsigned int ) );
+  failures += optimize_mesh( "empty mesh", &tiny, threshold );
+  tiny.points[3] = tiny.points[7] = 1.0f;
+  tiny.vertex_count                = 3;
+  tiny.index_count                 = 3;
+  for ( int i = 0; i < 3; i++ ) { tiny.indices[i] = 2 - i; }
+  failures += optimize_mesh( "one triangle", &tiny, threshold );
+  free_mesh( &tiny );
+
+  if ( !write_grid_obj( TMP_OBJ_FILE, grid_faces, false ) ) { return 1; }
+  indexed_mesh grid, shuffled;
+  bool ok = load_mesh( TMP_OBJ_FILE, &grid ) && load_mesh( TMP_OBJ_FILE, &shuffled );
+  remove( TMP_OBJ_FILE );
+  if ( !ok ) { return 1; }
+  shuffle_tris( shuffled.indices, shuffled.index_count );
+  failures += optimize_mesh( "grid", &grid, threshold );
+  failures += optimize_mesh( "shuffled grid", &shuffled, threshold );
+  free_mesh( &shuffled );
+  free_mesh( &grid );
+
+  if ( failures ) { fprintf( stderr, "%i mesh optimizer check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,325 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless report for meshlet. No GL context required.                         |
+| Cuts the bundled meshes and a synthetic bumpy sphere into meshlets, checks   |
+| every triangle lands in exactly one, and prints build time and how full the  |
+| meshlets are. Then flies cameras round each mesh (orbits near and far, and a |
+| pass close over one side) and prints how many triangles cull_meshlets()      |
+| skips by frustum and by normal cone, against how many actually face away.    |
+| Checks no culled meshlet had a triangle that could be seen.                  |
+| Usage: bench_meshlets [sphere_face_count] [sphere_noise]                     |
+\******************************************************************************/
+#include "meshlet.h"
+#include "mesh_optimizer.h"
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef COMMON_SOURCE_DIR
+#define COMMON_SOURCE_DIR "."
+#endif
+#define DEFAULT_SPHERE_FACES 500000
+#define DEFAULT_SPHERE_NOISE 0.1f
+#define CAMERA_STEPS 72
+#define TMP_OBJ_FILE "bench_meshlets_tmp.obj"
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+struct indexed_mesh {
+  float* points;
+  float* tex_coords;
+  float* normals;
+  int vertex_count;
+  unsigned int* indices;
+  int index_count;
+};
+
+static bool load_mesh( const char* file_name, indexed_mesh* m ) {
+  void* raw = NULL;
+  int index_size = 0;
+  memset( m, 0, sizeof( *m ) );
+  if ( !load_obj_file_indexed( file_name, m->points, m->tex_coords, m->normals, m->vertex_count, raw, m->index_count, index_size ) ) { return false; }
+  // the builder wants 32-bit indices
+  m->indices = (unsigned int*)malloc( (size_t)m->index_count * sizeof( unsigned int ) );
+  for ( int i = 0; i < m->index_count; i++ ) { m->indices[i] = 2 == index_size ? ( (unsigned short*)raw )[i] : ( (unsigned int*)raw )[i]; }
+  free( raw );
+  return true;
+}
+
+static void free_mesh( indexed_mesh* m ) {
+  free( m->points );
+  free( m->tex_coords );
+  free( m->normals );
+  free( m->indices );
+}
+
+struct meshlet_set {
+  meshlet* meshlets;
+  unsigned int* vertices;
+  unsigned char* triangles;
+  meshlet_bounds* bounds;
+  size_t count;
+};
+
+static void free_meshlet_set( meshlet_set* s ) {
+  free( s->meshlets );
+  free( s->vertices );
+  free( s->triangles );
+  free( s->bounds );
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// a triangle's 3 indices rotated so the smallest comes first, which keeps the winding
+struct tri_key {
+  unsigned int v[3];
+};
+
+static tri_key make_tri_key( unsigned int a, unsigned int b, unsigned int c ) {
+  tri_key k;
+  if ( a <= b && a <= c ) {
+    k.v[0] = a, k.v[1] = b, k.v[2] = c;
+  } else if ( b <= a && b <= c ) {
+    k.v[0] = b, k.v[1] = c, k.v[2] = a;
+  } else {
+    k.v[0] = c, k.v[1] = a, k.v[2] = b;
+  }
+  return k;
+}
+
+static int compare_tri_keys( const void* a, const void* b ) { return memcmp( a, b, sizeof( tri_key ) ); }
+
+// every triangle of the mesh in exactly one meshlet, same winding, and every meshlet in its limits
+static bool check_meshlets( const meshlet_set* s, const indexed_mesh* m ) {
+  int tri_count = m->index_count / 3;
+  if ( s->count > meshlet_count_bound( m->index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES ) ) { return false; }
+  tri_key* expected = (tri_key*)malloc( (size_t)tri_count * sizeof( tri_key ) + 1 );
+  tri_key* got      = (tri_key*)malloc( (size_t)tri_count * sizeof( tri_key ) + 1 );
+  for ( int t = 0; t < tri_count; t++ ) { expected[t] = make_tri_key( m->indices[t * 3], m->indices[t * 3 + 1], m->indices[t * 3 + 2] ); }
+  int n   = 0;
+  bool ok = true;
+  for ( size_t i = 0; i < s->count && ok; i++ ) {
+    const meshlet& ml = s->meshlets[i];
+    ok                = ml.vertex_count <= MESHLET_MAX_VERTICES && ml.triangle_count <= MESHLET_MAX_TRIANGLES && n + (int)ml.triangle_count <= tri_count;
+    for ( unsigned int t = 0; t < ml.triangle_count && ok; t++ ) {
+      const unsigned char* tri = &s->triangles[ml.triangle_offset + t * 3];
+      ok                       = tri[0] < ml.vertex_count && tri[1] < ml.vertex_count && tri[2] < ml.vertex_count;
+      if ( ok ) {
+        const unsigned int* v = &s->vertices[ml.vertex_offset];
+        got[n++]              = make_tri_key( v[tri[0]], v[tri[1]], v[tri[2]] );
+      }
+    }
+  }
+  if ( ok && n == tri_count ) {
+    qsort( expected, tri_count, sizeof( tri_key ), compare_tri_keys );
+    qsort( got, tri_count, sizeof( tri_key ), compare_tri_keys );
+    ok = !memcmp( expected, got, (size_t)tri_count * sizeof( tri_key ) );
+  } else {
+    ok = false;
+  }
+  free( expected );
+  free( got );
+  return ok;
+}
+
+// > 0 if the triangle's front can be seen from cam, with a little slack for rounding
+static bool tri_front_facing( const float* p0, const float* p1, const float* p2, const vec3& cam ) {
+  float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] }, e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+  float n[3]  = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+  float d[3]  = { cam.v[0] - p0[0], cam.v[1] - p0[1], cam.v[2] - p0[2] };
+  float nd    = n[0] * d[0] + n[1] * d[1] + n[2] * d[2];
+  float scale = sqrtf( ( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] ) * ( d[0] * d[0] + d[1] * d[1] + d[2] * d[2] ) );
+  return nd > scale * 1e-5f;
+}
+
+// all of the meshlet's vertices behind one frustum plane
+static bool outside_frustum( const frustum& f, const meshlet& ml, const unsigned int* vertices, const float* points ) {
+  for ( int p = 0; p < 6; p++ ) {
+    bool all_out = true;
+    for ( unsigned int i = 0; i < ml.vertex_count && all_out; i++ ) {
+      const float* v = &points[vertices[ml.vertex_offset + i] * 3];
+      all_out        = f.planes[p][0] * v[0] + f.planes[p][1] * v[1] + f.planes[p][2] * v[2] + f.planes[p][3] < 0.0f;
+    }
+    if ( all_out ) { return true; }
+  }
+  return false;
+}
+
+/*-----------------------------------CAMERAS----------------------------------*/
+enum camera_path { ORBIT_NEAR, ORBIT_FAR, FLY_BY, CAMERA_PATH_COUNT };
+static const char* camera_path_names[CAMERA_PATH_COUNT] = { "orbit 1.5r", "orbit 4r", "fly-by" };
+
+// camera position and target for step i of a path round a mesh with bounding sphere (c, r)
+static void camera_at( camera_path path, int i, const vec3& c, float r, vec3* cam, vec3* targ ) {
+  float a = 2.0f * 3.14159265f * i / CAMERA_STEPS;
+  switch ( path ) {
+  case ORBIT_NEAR:
+  case ORBIT_FAR: {
+    float d = ORBIT_NEAR == path ? 1.5f * r : 4.0f * r;
+    *cam    = vec3( c.v[0] + cosf( a ) * d, c.v[1] + 0.3f * r, c.v[2] + sinf( a ) * d );
+    *targ   = c;
+  } break;
+  default: {
+    // sliding past one side, looking a little ahead, so most of the mesh is off screen
+    float x = -2.0f * r + 4.0f * r * i / ( CAMERA_STEPS - 1 );
+    *cam    = vec3( c.v[0] + x, c.v[1] + 0.2f * r, c.v[2] + 1.2f * r );
+    *targ   = vec3( c.v[0] + x + 0.5f * r, c.v[1], c.v[2] );
+  } break;
+  }
+}
+
+/*-----------------------------------REPORT-----------------------------------*/
+static int bench_mesh( const char* name, indexed_mesh* m ) {
+  int failures  = 0;
+  int tri_count = m->index_count / 3;
+  printf( "%s: %i vertices %i triangles\n", name, m->vertex_count, tri_count );
+  // straight-from-the-exporter order makes ragged clusters. this is what a loader would do anyway
+  unsigned int* tmp = (unsigned int*)malloc( (size_t)m->index_count * sizeof( unsigned int ) + 1 );
+  optimize_vertex_cache( tmp, m->indices, m->index_count, m->vertex_count );
+  memcpy( m->indices, tmp, (size_t)m->index_count * sizeof( unsigned int ) );
+  free( tmp );
+
+  meshlet_set s;
+  size_t max_meshlets = meshlet_count_bound( m->index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES );
+  s.meshlets          = (meshlet*)malloc( max_meshlets * sizeof( meshlet ) );
+  s.vertices          = (unsigned int*)malloc( max_meshlets * MESHLET_MAX_VERTICES * sizeof( unsigned int ) );
+  s.triangles         = (unsigned char*)malloc( max_meshlets * MESHLET_MAX_TRIANGLES * 3 );
+  s.bounds            = (meshlet_bounds*)malloc( max_meshlets * sizeof( meshlet_bounds ) );
+  double t0           = now_ms();
+  s.count = build_meshlets( s.meshlets, s.vertices, s.triangles, m->indices, m->index_count, m->points, m->vertex_count, MESHLET_MAX_VERTICES,
+    MESHLET_MAX_TRIANGLES );
+  double build_ms = now_ms() - t0;
+  t0              = now_ms();
+  for ( size_t i = 0; i < s.count; i++ ) { s.bounds[i] = compute_meshlet_bounds( s.meshlets[i], s.vertices, s.triangles, m->points ); }
+  double bounds_ms = now_ms() - t0;
+  if ( !check_meshlets( &s, m ) ) {
+    fprintf( stderr, "ERROR: %s: meshlets don't hold the mesh's triangles\n", name );
+    free_meshlet_set( &s );
+    return 1;
+  }
+  size_t total_verts = 0, cullable = 0;
+  for ( size_t i = 0; i < s.count; i++ ) {
+    total_verts += s.meshlets[i].vertex_count;
+    cullable += s.bounds[i].cone_cos > 0.0f;
+  }
+  printf( "  %zu meshlets (bound %zu), %.1f%% triangles %.1f%% vertices full, %.2f vertices per triangle, %.0f%% with a cone\n", s.count,
+    max_meshlets, 100.0 * tri_count / ( (double)s.count * MESHLET_MAX_TRIANGLES ), 100.0 * total_verts / ( (double)s.count * MESHLET_MAX_VERTICES ),
+    (double)total_verts / tri_count, 100.0 * cullable / s.count );
+  printf( "  build %.2fms, bounds %.2fms\n", build_ms, bounds_ms );
+
+  // the mesh's own bounding sphere for placing cameras
+  float mn[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for ( int i = 0; i < m->vertex_count; i++ ) {
+    for ( int k = 0; k < 3; k++ ) {
+      mn[k] = fminf( mn[k], m->points[i * 3 + k] );
+      mx[k] = fmaxf( mx[k], m->points[i * 3 + k] );
+    }
+  }
+  vec3 c( ( mn[0] + mx[0] ) * 0.5f, ( mn[1] + mx[1] ) * 0.5f, ( mn[2] + mx[2] ) * 0.5f );
+  float r = 0.5f * sqrtf( ( mx[0] - mn[0] ) * ( mx[0] - mn[0] ) + ( mx[1] - mn[1] ) * ( mx[1] - mn[1] ) + ( mx[2] - mn[2] ) * ( mx[2] - mn[2] ) );
+  mat4 P  = perspective( 67.0f, 16.0f / 9.0f, 0.01f * r, 100.0f * r );
+
+  // the same bounds with no cones, to split frustum culls from cone culls
+  meshlet_bounds* spheres_only = (meshlet_bounds*)malloc( s.count * sizeof( meshlet_bounds ) + 1 );
+  for ( size_t i = 0; i < s.count; i++ ) {
+    spheres_only[i]          = s.bounds[i];
+    spheres_only[i].cone_cos = 0.0f;
+  }
+  unsigned int* visible        = (unsigned int*)malloc( s.count * sizeof( unsigned int ) + 1 );
+  unsigned int* in_frustum     = (unsigned int*)malloc( s.count * sizeof( unsigned int ) + 1 );
+  char* drawn                  = (char*)malloc( s.count + 1 );
+  char* passed_frustum         = (char*)malloc( s.count + 1 );
+  printf( "  %-11s %9s %9s %9s %12s %10s\n", "camera", "frustum", "cone", "drawn", "faces away", "cull" );
+  for ( int path = 0; path < CAMERA_PATH_COUNT; path++ ) {
+    double frustum_tris = 0.0, cone_tris = 0.0, drawn_tris = 0.0, away_tris = 0.0, cull_ms = 0.0;
+    for ( int step = 0; step < CAMERA_STEPS; step++ ) {
+      vec3 cam, targ;
+      camera_at( (camera_path)path, step, c, r, &cam, &targ );
+      mat4 V    = look_at( cam, targ, vec3( 0.0f, 1.0f, 0.0f ) );
+      frustum f = frustum_from_mat4( P * V );
+      t0        = now_ms();
+      size_t n  = cull_meshlets( f, cam, s.bounds, s.count, visible );
+      cull_ms += now_ms() - t0;
+      size_t nf = cull_meshlets( f, cam, spheres_only, s.count, in_frustum );
+      memset( drawn, 0, s.count );
+      memset( passed_frustum, 0, s.count );
+      for ( size_t i = 0; i < n; i++ ) { drawn[visible[i]] = 1; }
+      for ( size_t i = 0; i < nf; i++ ) { passed_frustum[in_frustum[i]] = 1; }
+
+      for ( size_t i = 0; i < s.count; i++ ) {
+        const meshlet& ml     = s.meshlets[i];
+        const unsigned int* v = &s.vertices[ml.vertex_offset];
+        int front             = 0;
+        for ( unsigned int t = 0; t < ml.triangle_count; t++ ) {
+          const unsigned char* tri = &s.triangles[ml.triangle_offset + t * 3];
+          front += tri_front_facing( &m->points[v[tri[0]] * 3], &m->points[v[tri[1]] * 3], &m->points[v[tri[2]] * 3], cam );
+        }
+        away_tris += ml.triangle_count - front;
+        if ( drawn[i] ) {
+          drawn_tris += ml.triangle_count;
+        } else if ( !passed_frustum[i] ) {
+          frustum_tris += ml.triangle_count;
+          if ( !outside_frustum( f, ml, s.vertices, m->points ) ) {
+            fprintf( stderr, "ERROR: %s: %s step %i: meshlet %zu culled by frustum but inside it\n", name, camera_path_names[path], step, i );
+            failures++;
+          }
+        } else {
+          cone_tris += ml.triangle_count;
+          if ( front > 0 ) {
+            fprintf( stderr, "ERROR: %s: %s step %i: meshlet %zu culled by cone with %i triangles facing the camera\n", name, camera_path_names[path],
+              step, i, front );
+            failures++;
+          }
+        }
+      }
+    }
+    double all = (double)tri_count * CAMERA_STEPS;
+    printf( "  %-11s %8.1f%% %8.1f%% %8.1f%% %11.1f%% %8.2fus\n", camera_path_names[path], 100.0 * frustum_tris / all, 100.0 * cone_tris / all,
+      100.0 * drawn_tris / all, 100.0 * away_tris / all, 1000.0 * cull_ms / CAMERA_STEPS );
+  }
+  free( spheres_only );
+  free( visible );
+  free( in_frustum );
+  free( drawn );
+  free( passed_frustum );
+  free_meshlet_set( &s );
+  return failures;
+}
+
+int main( int argc, char** argv ) {
+  int sphere_faces   = argc > 1 ? atoi( argv[1] ) : DEFAULT_SPHERE_FACES;
+  float sphere_noise = argc > 2 ? (float)atof( argv[2] ) : DEFAULT_SPHERE_NOISE;
+  printf( "meshlets of up to %i vertices and %i triangles, %i camera steps per path.\n", MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, CAMERA_STEPS );
+  printf( "%% of triangles over all steps culled by frustum, then by cone, and drawn. faces away is every triangle facing\n" );
+  printf( "away from the camera, the most a per-triangle backface test could skip. cull is the time per cull_meshlets() call\n\n" );
+  int failures          = 0;
+  const char* meshes[3] = { COMMON_SOURCE_DIR "/../07_ray_picking/sphere.obj", COMMON_SOURCE_DIR "/../38_texture_shadows/suzanne.obj",
+    COMMON_SOURCE_DIR "/../13_mesh_import/monkey2.obj" };
+  for ( int i = 0; i < 3; i++ ) {
+    indexed_mesh m;
+    if ( !load_mesh( meshes[i], &m ) ) { return 1; }
+    failures += bench_mesh( strrchr( meshes[i], '/' ) + 1, &m );
+    free_mesh( &m );
+  }
+
+  if ( !write_sphere_obj( TMP_OBJ_FILE, sphere_faces, sphere_noise ) ) { return 1; }
+  indexed_mesh sphere;
+  bool ok = load_mesh( TMP_OBJ_FILE, &sphere );
+  remove( TMP_OBJ_FILE );
+  if ( !ok ) { return 1; }
+  failures += bench_mesh( "bumpy sphere", &sphere );
+  free_mesh( &sphere );
+
+  if ( failures ) { fprintf( stderr, "%i meshlet check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,324 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless throughput benchmark for load_obj_file. No GL context required.     |
+| Writes a synthetic triangulated grid mesh for each face count given, then    |
+| parses it with the original two-pass fgets/sscanf parser, the current one on |
+| one thread, and on 2-16 threads. Checks the arrays are byte-for-byte         |
+| identical and prints MB/s. Also checks the bundled meshes parse identically, |
+| and that a mesh with negative indices gives the same bytes on any thread     |
+| count. load_obj_file_indexed is checked against the same arrays, and its     |
+| vertex dedup ratio printed, and so are the interleaved loaders.              |
+| Usage: bench_obj_parser [face_count ...]   e.g. 1000000 10000000 50000000    |
+| The file and both sets of arrays must fit in memory - 50M faces needs ~15GB. |
+\******************************************************************************/
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FACE_COUNT 1000000
+#define TMP_OBJ_FILE "bench_obj_parser_tmp.obj"
+// CMake passes in the path to common/ so this runs from any build directory
+#ifndef COMMON_SOURCE_DIR
+#define COMMON_SOURCE_DIR "."
+#endif
+
+static const char* k_bundled_meshes[] = { COMMON_SOURCE_DIR "/../07_ray_picking/sphere.obj", COMMON_SOURCE_DIR "/../38_texture_shadows/suzanne.obj",
+  COMMON_SOURCE_DIR "/../13_mesh_import/monkey2.obj" };
+
+static double now_s() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1e6;
+}
+
+/*----------------------------ORIGINAL IMPLEMENTATION-------------------------*/
+// the 7 Nov 2013 parser, minus its printf()s, to compare results and timings against
+static bool ref_load_obj_file( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& point_count ) {
+  FILE* fp = fopen( file_name, "r" );
+  if ( !fp ) { return false; }
+  point_count           = 0;
+  int unsorted_vp_count = 0, unsorted_vt_count = 0, unsorted_vn_count = 0, face_count = 0;
+  char line[1024];
+  while ( fgets( line, 1024, fp ) ) {
+    if ( line[0] == 'v' ) {
+      if ( line[1] == ' ' ) {
+        unsorted_vp_count++;
+      } else if ( line[1] == 't' ) {
+        unsorted_vt_count++;
+      } else if ( line[1] == 'n' ) {
+        unsorted_vn_count++;
+      }
+    } else if ( line[0] == 'f' ) {
+      face_count++;
+    }
+  }
+  float* unsorted_vp_array = (float*)malloc( unsorted_vp_count * 3 * sizeof( float ) );
+  float* unsorted_vt_array = (float*)malloc( unsorted_vt_count * 2 * sizeof( float ) );
+  float* unsorted_vn_array = (float*)malloc( unsorted_vn_count * 3 * sizeof( float ) );
+  points                   = (float*)malloc( 3 * face_count * 3 * sizeof( float ) );
+  tex_coords               = (float*)malloc( 3 * face_count * 2 * sizeof( float ) );
+  normals                  = (float*)malloc( 3 * face_count * 3 * sizeof( float ) );
+  int current_unsorted_vp = 0, current_unsorted_vt = 0, current_unsorted_vn = 0;
+  bool ok = true;
+  rewind( fp );
+  while ( ok && fgets( line, 1024, fp ) ) {
+    if ( line[0] == 'v' ) {
+      if ( line[1] == ' ' ) {
+        float x = 0.0f, y = 0.0f, z = 0.0f;
+        sscanf( line, "v %f %f %f", &x, &y, &z );
+        unsorted_vp_array[current_unsorted_vp * 3]     = x;
+        unsorted_vp_array[current_unsorted_vp * 3 + 1] = y;
+        unsorted_vp_array[current_unsorted_vp * 3 + 2] = z;
+        current_unsorted_vp++;
+      } else if ( line[1] == 't' ) {
+        float s = 0.0f, t = 0.0f;
+        sscanf( line, "vt %f %f", &s, &t );
+        unsorted_vt_array[current_unsorted_vt * 2]     = s;
+        unsorted_vt_array[current_unsorted_vt * 2 + 1] = t;
+        current_unsorted_vt++;
+      } else if ( line[1] == 'n' ) {
+        float x = 0.0f, y = 0.0f, z = 0.0f;
+        sscanf( line, "vn %f %f %f", &x, &y, &z );
+        unsorted_vn_array[current_unsorted_vn * 3]     = x;
+        unsorted_vn_array[current_unsorted_vn * 3 + 1] = y;
+        unsorted_vn_array[current_unsorted_vn * 3 + 2] = z;
+        current_unsorted_vn++;
+      }
+    } else if ( line[0] == 'f' ) {
+      int slashCount = 0;
+      int len        = strlen( line );
+      for ( int i = 0; i < len; i++ ) {
+        if ( line[i] == '/' ) { slashCount++; }
+      }
+      if ( slashCount != 6 ) {
+        ok = false;
+        break;
+      }
+      int vp[3], vt[3], vn[3];
+      sscanf( line, "f %i/%i/%i %i/%i/%i %i/%i/%i", &vp[0], &vt[0], &vn[0], &vp[1], &vt[1], &vn[1], &vp[2], &vt[2], &vn[2] );
+      for ( int i = 0; i < 3; i++ ) {
+        if ( ( vp[i] - 1 < 0 ) || ( vp[i] - 1 >= unsorted_vp_count ) || ( vt[i] - 1 < 0 ) || ( vt[i] - 1 >= unsorted_vt_count ) || ( vn[i] - 1 < 0 ) ||
+             ( vn[i] - 1 >= unsorted_vn_count ) ) {
+          ok = false;
+          break;
+        }
+        memcpy( &points[point_count * 3], &unsorted_vp_array[( vp[i] - 1 ) * 3], 3 * sizeof( float ) );
+        memcpy( &tex_coords[point_count * 2], &unsorted_vt_array[( vt[i] - 1 ) * 2], 2 * sizeof( float ) );
+        memcpy( &normals[point_count * 3], &unsorted_vn_array[( vn[i] - 1 ) * 3], 3 * sizeof( float ) );
+        point_count++;
+      }
+    }
+  }
+  fclose( fp );
+  free( unsorted_vp_array );
+  free( unsorted_vn_array );
+  free( unsorted_vt_array );
+  return ok;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+struct obj_arrays {
+  float *points, *tex_coords, *normals;
+  int point_count;
+  bool ok;
+};
+
+// n_threads -1 is the original parser. time taken goes in secs
+static obj_arrays load_with( const char* file_name, int n_threads, double* secs ) {
+  obj_arrays a;
+  memset( &a, 0, sizeof( a ) );
+  double t0 = now_s();
+  if ( n_threads < 0 ) {
+    a.ok = ref_load_obj_file( file_name, a.points, a.tex_coords, a.normals, a.point_count );
+  } else {
+    a.ok = load_obj_file_threads( file_name, a.points, a.tex_coords, a.normals, a.point_count, n_threads );
+  }
+  if ( secs ) { *secs = now_s() - t0; }
+  return a;
+}
+
+static void free_arrays( obj_arrays& a ) {
+  free( a.points );
+  free( a.tex_coords );
+  free( a.normals );
+  memset( &a, 0, sizeof( a ) );
+}
+
+// byte-for-byte, so -0.0 vs 0.0 or a different NaN would show up
+static bool same_arrays( const obj_arrays& a, const obj_arrays& b ) {
+  if ( !a.ok || !b.ok || a.point_count != b.point_count ) { return false; }
+  size_t n = (size_t)a.point_count;
+  return !memcmp( a.points, b.points, n * 3 * sizeof( float ) ) && !memcmp( a.tex_coords, b.tex_coords, n * 2 * sizeof( float ) ) &&
+         !memcmp( a.normals, b.normals, n * 3 * sizeof( float ) );
+}
+
+/* load_obj_file_indexed must give back exactly load_obj_file's arrays when the
+indices are expanded. prints how much smaller the indexed mesh is */
+static int check_indexed( const char* file_name, const obj_arrays& expanded, const char* label ) {
+  float *p = NULL, *t = NULL, *n = NULL;
+  void* indices = NULL;
+  int vertex_count = 0, index_count = 0, index_size = 0;
+  double t0 = now_s();
+  bool ok   = load_obj_file_indexed( file_name, p, t, n, vertex_count, indices, index_count, index_size );
+  double secs = now_s() - t0;
+  // load_obj_file always gives normals, so an indexed load without them can't match
+  bool same   = ok && n && expanded.ok && index_count == expanded.point_count;
+  for ( int i = 0; same && i < index_count; i++ ) {
+    size_t v = 2 == index_size ? ( (unsigned short*)indices )[i] : ( (unsigned int*)indices )[i];
+    same     = v < (size_t)vertex_count && !memcmp( &p[v * 3], &expanded.points[i * 3], 3 * sizeof( float ) ) &&
+           !memcmp( &t[v * 2], &expanded.tex_coords[i * 2], 2 * sizeof( float ) ) && !memcmp( &n[v * 3], &expanded.normals[i * 3], 3 * sizeof( float ) );
+  }
+  if ( same ) {
+    double flat_bytes    = (double)index_count * 8 * sizeof( float );
+    double indexed_bytes = (double)vertex_count * 8 * sizeof( float ) + (double)index_count * index_size;
+    printf( "%s indexed: %i corners -> %i vertices (%.2fx dedup), %i-bit indices, %.0f KB -> %.0f KB (%.1f%%) in %.3fs\n", label, index_count, vertex_count,
+      (double)index_count / ( vertex_count ? vertex_count : 1 ), index_size * 8, flat_bytes / 1024.0, indexed_bytes / 1024.0,
+      100.0 * indexed_bytes / ( flat_bytes > 0.0 ? flat_bytes : 1.0 ), secs );
+  } else {
+    fprintf( stderr, "ERROR: %s: indexed mesh doesn't expand to the load_obj_file arrays\n", file_name );
+  }
+  free( p );
+  free( t );
+  free( n );
+  free( indices );
+  return same ? 0 : 1;
+}
+
+/* load_obj_file_interleaved and load_obj_file_indexed_interleaved must hold the
+same vertices as the separate arrays, for each layout, with zeroed padding */
+static int check_interleaved( const char* file_name, const obj_arrays& expanded, const char* label ) {
+  static const unsigned int flags[3] = { VERTEX_LAYOUT_ALL, VERTEX_LAYOUT_NORMALS, 0 };
+  bool same = expanded.ok;
+  double secs = 0.0, indexed_secs = 0.0;
+  for ( int f = 0; f < 3 && same; f++ ) {
+    vertex_layout layout;
+    void *vertices = NULL, *indices = NULL;
+    int point_count = 0, vertex_count = 0, index_count = 0, index_size = 0;
+    double t0 = now_s();
+    same      = load_obj_file_interleaved( file_name, flags[f], 16, vertices, layout, point_count ) && point_count == expanded.point_count;
+    if ( 0 == f ) { secs = now_s() - t0; }
+    // 0 = points, 1 = tex coords, 2 = normals, as in obj_arrays
+    const float* arrays[3]          = { expanded.points, expanded.tex_coords, expanded.normals };
+    static const unsigned int loc[3] = { VERTEX_LOCATION_POINTS, VERTEX_LOCATION_TEX_COORDS, VERTEX_LOCATION_NORMALS };
+    static const int comps[3]       = { 3, 2, 3 };
+    unsigned char zero[64];
+    memset( zero, 0, sizeof( zero ) );
+    unsigned int used = 0;
+    for ( int a = 0; a < 3; a++ ) {
+      int i = find_vertex_attrib( layout, loc[a] );
+      if ( i >= 0 ) { used += comps[a] * sizeof( float ); }
+    }
+    same = same && 0 == layout.stride % 16 && layout.stride - used < sizeof( zero );
+    for ( int v = 0; same && v < point_count; v++ ) {
+      const unsigned char* vert = (const unsigned char*)vertices + (size_t)v * layout.stride;
+      for ( int a = 0; a < 3 && same; a++ ) {
+        int i = find_vertex_attrib( layout, loc[a] );
+        if ( i >= 0 ) { same = !memcmp( vert + layout.attribs[i].offset, &arrays[a][(size_t)v * comps[a]], comps[a] * sizeof( float ) ); }
+      }
+      // attributes are packed at the front, then padding
+      same = same && !memcmp( vert + used, zero, layout.stride - used );
+    }
+    free( vertices );
+    vertices = NULL;
+
+    // indexed, expanded back out
+    t0   = now_s();
+    same = same && load_obj_file_indexed_interleaved( file_name, flags[f], 16, vertices, layout, vertex_count, indices, index_count, index_size ) &&
+           index_count == expanded.point_count;
+    if ( 0 == f ) { indexed_secs = now_s() - t0; }
+    for ( int c = 0; same && c < index_count; c++ ) {
+      size_t v                  = 2 == index_size ? ( (unsigned short*)indices )[c] : ( (unsigned int*)indices )[c];
+      const unsigned char* vert = (const unsigned char*)vertices + v * layout.stride;
+      same                      = v < (size_t)vertex_count && !memcmp( vert + used, zero, layout.stride - used );
+      for ( int a = 0; a < 3 && same; a++ ) {
+        int i = find_vertex_attrib( layout, loc[a] );
+        if ( i >= 0 ) { same = !memcmp( vert + layout.attribs[i].offset, &arrays[a][(size_t)c * comps[a]], comps[a] * sizeof( float ) ); }
+      }
+    }
+    free( vertices );
+    free( indices );
+  }
+  if ( same ) {
+    printf( "%s interleaved: identical, %.3fs, indexed %.3fs\n", label, secs, indexed_secs );
+  } else {
+    fprintf( stderr, "ERROR: %s: interleaved vertices don't match the load_obj_file arrays\n", file_name );
+  }
+  return same ? 0 : 1;
+}
+
+static const int k_thread_counts[] = { 2, 3, 4, 8, 16 };
+#define N_THREAD_COUNTS ( sizeof( k_thread_counts ) / sizeof( k_thread_counts[0] ) )
+
+int main( int argc, char** argv ) {
+  int failures = 0;
+  for ( size_t i = 0; i < sizeof( k_bundled_meshes ) / sizeof( k_bundled_meshes[0] ); i++ ) {
+    obj_arrays ref = load_with( k_bundled_meshes[i], -1, NULL );
+    obj_arrays ser = load_with( k_bundled_meshes[i], 1, NULL );
+    obj_arrays thr = load_with( k_bundled_meshes[i], 4, NULL );
+    bool same      = same_arrays( ref, ser ) && same_arrays( ref, thr );
+    printf( "%s: %s\n", k_bundled_meshes[i], same ? "identical" : "DIFFERENT" );
+    failures += same ? 0 : 1;
+    const char* base_name = strrchr( k_bundled_meshes[i], '/' ) + 1;
+    failures += check_indexed( k_bundled_meshes[i], ser, base_name );
+    failures += check_interleaved( k_bundled_meshes[i], ser, base_name );
+    free_arrays( ref );
+    free_arrays( ser );
+    free_arrays( thr );
+  }
+
+  // determinism. negative indices and chunk boundaries are where a threaded parse could go wrong
+  {
+    size_t sz = write_grid_obj( TMP_OBJ_FILE, 300000, true );
+    if ( !sz ) { return 1; }
+    obj_arrays ser = load_with( TMP_OBJ_FILE, 1, NULL );
+    bool same      = ser.ok;
+    for ( size_t t = 0; t < N_THREAD_COUNTS; t++ ) {
+      obj_arrays thr = load_with( TMP_OBJ_FILE, k_thread_counts[t], NULL );
+      same           = same && same_arrays( ser, thr );
+      free_arrays( thr );
+    }
+    printf( "relative indices, 1-16 threads: %s\n", same ? "identical" : "DIFFERENT" );
+    failures += same ? 0 : 1;
+    free_arrays( ser );
+    remove( TMP_OBJ_FILE );
+  }
+
+  int n_sizes = argc > 1 ? argc - 1 : 1;
+  for ( int i = 0; i < n_sizes; i++ ) {
+    int face_count = argc > 1 ? atoi( argv[i + 1] ) : DEFAULT_FACE_COUNT;
+    size_t sz      = write_grid_obj( TMP_OBJ_FILE, face_count, false );
+    if ( !sz ) { return 1; }
+    double mb    = (double)sz / ( 1024.0 * 1024.0 );
+    double ref_s = 0.0, ser_s = 0.0;
+    obj_arrays ref = load_with( TMP_OBJ_FILE, -1, &ref_s );
+    printf( "%i faces, %.1f MB:\n  original           %.3fs %7.1f MB/s\n", face_count, mb, ref_s, mb / ref_s );
+    {
+      obj_arrays ser = load_with( TMP_OBJ_FILE, 1, &ser_s );
+      bool same      = same_arrays( ref, ser );
+      printf( "  single-pass mmap   %.3fs %7.1f MB/s %5.2fx %s\n", ser_s, mb / ser_s, ref_s / ser_s, same ? "identical" : "DIFFERENT" );
+      failures += same ? 0 : 1;
+      free_arrays( ser );
+    }
+    failures += check_indexed( TMP_OBJ_FILE, ref, "  grid" );
+    failures += check_interleaved( TMP_OBJ_FILE, ref, "  grid" );
+    for ( size_t t = 0; t < N_THREAD_COUNTS; t++ ) {
+      double thr_s   = 0.0;
+      obj_arrays thr = load_with( TMP_OBJ_FILE, k_thread_counts[t], &thr_s );
+      bool same      = same_arrays( ref, thr );
+      printf( "  %2i threads         %.3fs %7.1f MB/s %5.2fx (%.2fx single-pass) %s\n", k_thread_counts[t], thr_s, mb / thr_s, ref_s / thr_s, ser_s / thr_s,
+        same ? "identical" : "DIFFERENT" );
+      failures += same ? 0 : 1;
+      free_arrays( thr );
+    }
+    free_arrays( ref );
+    remove( TMP_OBJ_FILE );
+  }
+  if ( failures ) { fprintf( stderr, "%i parser check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,198 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless benchmark for load_obj_file_streamed(). No GL context required.     |
+| First checks that the batches, joined up, are byte-for-byte what             |
+| load_obj_file() returns, for a few batch sizes and the bundled meshes. Then, |
+| for each face count, loads a synthetic OBJ both ways in a child process and  |
+| reports time and the child's peak RSS, so the numbers don't mix. The stream  |
+| callback only checksums the batches, standing in for glBufferSubData() or    |
+| fwrite(). POSIX only - peak RSS comes from wait4().                          |
+| Usage: bench_obj_stream [face_count ...]                                     |
+\******************************************************************************/
+#include "obj_parser.h"
+#include "synthetic_obj.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef COMMON_SOURCE_DIR
+#define COMMON_SOURCE_DIR "."
+#endif
+#define DEFAULT_FACE_COUNT 2000000
+#define BATCH_POINTS 65535
+#define TMP_OBJ_FILE "bench_obj_stream_tmp.obj"
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+/*---------------------------------CORRECTNESS--------------------------------*/
+// batches appended back into whole arrays, to compare with load_obj_file()
+struct joined_arrays {
+  float* points;
+  float* tex_coords;
+  float* normals;
+  int count;
+  int cap;
+  int batches;
+  int max_batch;
+};
+
+static bool join_batch( const float* points, const float* tex_coords, const float* normals, int point_count, void* user_data ) {
+  joined_arrays* j = (joined_arrays*)user_data;
+  if ( j->count + point_count > j->cap ) { return false; }
+  memcpy( &j->points[j->count * 3], points, point_count * 3 * sizeof( float ) );
+  memcpy( &j->tex_coords[j->count * 2], tex_coords, point_count * 2 * sizeof( float ) );
+  memcpy( &j->normals[j->count * 3], normals, point_count * 3 * sizeof( float ) );
+  j->count += point_count;
+  j->batches++;
+  if ( point_count > j->max_batch ) { j->max_batch = point_count; }
+  return true;
+}
+
+static int check_file( const char* file_name ) {
+  float *p = NULL, *t = NULL, *n = NULL;
+  int pc = 0;
+  if ( !load_obj_file( file_name, p, t, n, pc ) ) { return 1; }
+  int failures         = 0;
+  const int batches[4] = { 3, 100, 3000, 1 << 20 };
+  for ( int b = 0; b < 4; b++ ) {
+    joined_arrays j;
+    memset( &j, 0, sizeof( j ) );
+    j.cap        = pc;
+    j.points     = (float*)malloc( (size_t)pc * 3 * sizeof( float ) + 1 );
+    j.tex_coords = (float*)malloc( (size_t)pc * 2 * sizeof( float ) + 1 );
+    j.normals    = (float*)malloc( (size_t)pc * 3 * sizeof( float ) + 1 );
+    int total    = -1;
+    bool ok      = load_obj_file_streamed( file_name, batches[b], join_batch, &j, &total );
+    int whole_tris = batches[b] - batches[b] % 3;
+    int expected   = ( pc + whole_tris - 1 ) / whole_tris;
+    if ( !ok || total != pc || j.count != pc || j.batches != expected || j.max_batch > whole_tris ||
+         memcmp( j.points, p, (size_t)pc * 3 * sizeof( float ) ) || memcmp( j.tex_coords, t, (size_t)pc * 2 * sizeof( float ) ) ||
+         memcmp( j.normals, n, (size_t)pc * 3 * sizeof( float ) ) ) {
+      fprintf( stderr, "ERROR: %s streamed in batches of %i doesn't match load_obj_file()\n", file_name, batches[b] );
+      failures++;
+    }
+    free( j.points );
+    free( j.tex_coords );
+    free( j.normals );
+  }
+  printf( "%s: %i points, streamed == load_obj_file() %s\n", file_name, pc, failures ? "FAILED" : "ok" );
+  free( p );
+  free( t );
+  free( n );
+  return failures;
+}
+
+/*------------------------------------MEMORY----------------------------------*/
+static unsigned int fnv1a( unsigned int h, const float* f, int count ) {
+  const unsigned char* b = (const unsigned char*)f;
+  for ( size_t i = 0; i < (size_t)count * sizeof( float ); i++ ) { h = ( h ^ b[i] ) * 16777619u; }
+  return h;
+}
+
+// one running hash per array, so the result doesn't depend on where batches split
+struct stream_hash {
+  unsigned int h[3];
+};
+
+static bool hash_batch( const float* points, const float* tex_coords, const float* normals, int point_count, void* user_data ) {
+  stream_hash* s = (stream_hash*)user_data;
+  s->h[0]        = fnv1a( s->h[0], points, point_count * 3 );
+  s->h[1]        = fnv1a( s->h[1], tex_coords, point_count * 2 );
+  s->h[2]        = fnv1a( s->h[2], normals, point_count * 3 );
+  return true;
+}
+
+// runs in the child. writes the checksum and time back through fd
+static void child_load( bool streamed, int fd ) {
+  stream_hash s  = { { 2166136261u, 2166136261u, 2166136261u } };
+  int pc         = 0;
+  double t0      = now_ms();
+  bool ok        = false;
+  if ( streamed ) {
+    ok = load_obj_file_streamed( TMP_OBJ_FILE, BATCH_POINTS, hash_batch, &s, &pc );
+  } else {
+    float *p = NULL, *t = NULL, *n = NULL;
+    ok = load_obj_file( TMP_OBJ_FILE, p, t, n, pc );
+    if ( ok ) { hash_batch( p, t, n, pc, &s ); }
+    free( p );
+    free( t );
+    free( n );
+  }
+  double ms          = now_ms() - t0;
+  unsigned int hash  = s.h[0] ^ ( s.h[1] * 31u ) ^ ( s.h[2] * 961u );
+  char msg[64];
+  int len = snprintf( msg, sizeof( msg ), "%u %f %i", hash, ms, pc );
+  if ( write( fd, msg, len ) != len ) { ok = false; }
+  _exit( ok ? 0 : 1 );
+}
+
+struct load_result {
+  unsigned int hash;
+  double ms;
+  int point_count;
+  long peak_kb;
+};
+
+static bool run_child( bool streamed, load_result* r ) {
+  int fds[2];
+  if ( pipe( fds ) ) { return false; }
+  fflush( stdout );
+  pid_t pid = fork();
+  if ( pid < 0 ) { return false; }
+  if ( 0 == pid ) {
+    close( fds[0] );
+    child_load( streamed, fds[1] );
+  }
+  close( fds[1] );
+  char msg[64];
+  ssize_t len = read( fds[0], msg, sizeof( msg ) - 1 );
+  close( fds[0] );
+  int status = 0;
+  struct rusage ru;
+  if ( wait4( pid, &status, 0, &ru ) != pid || !WIFEXITED( status ) || WEXITSTATUS( status ) || len <= 0 ) { return false; }
+  msg[len]   = '\0';
+  r->peak_kb = ru.ru_maxrss; // kB on Linux
+  return 3 == sscanf( msg, "%u %lf %i", &r->hash, &r->ms, &r->point_count );
+}
+
+static int bench_size( int face_count ) {
+  size_t sz = write_grid_obj( TMP_OBJ_FILE, face_count, false );
+  if ( !sz ) { return 1; }
+  load_result whole, streamed;
+  bool ok = run_child( false, &whole ) && run_child( true, &streamed );
+  remove( TMP_OBJ_FILE );
+  if ( !ok || whole.hash != streamed.hash || whole.point_count != streamed.point_count ) {
+    fprintf( stderr, "ERROR: streamed load of %i faces doesn't match load_obj_file()\n", face_count );
+    return 1;
+  }
+  double mb = (double)sz / ( 1024.0 * 1024.0 );
+  printf( "%i faces, %.1f MB obj: load_obj_file %.1fms peak %.1f MB | streamed %.1fms peak %.1f MB | %.1fx less memory\n", face_count, mb, whole.ms,
+    whole.peak_kb / 1024.0, streamed.ms, streamed.peak_kb / 1024.0, (double)whole.peak_kb / streamed.peak_kb );
+  return 0;
+}
+
+int main( int argc, char** argv ) {
+  int failures          = 0;
+  const char* meshes[3] = { COMMON_SOURCE_DIR "/../07_ray_picking/sphere.obj", COMMON_SOURCE_DIR "/../38_texture_shadows/suzanne.obj",
+    COMMON_SOURCE_DIR "/../13_mesh_import/monkey2.obj" };
+  for ( int i = 0; i < 3; i++ ) { failures += check_file( meshes[i] ); }
+  write_grid_obj( TMP_OBJ_FILE, 20000, true );
+  failures += check_file( TMP_OBJ_FILE );
+  remove( TMP_OBJ_FILE );
+
+  printf( "batches of %i points\n", BATCH_POINTS );
+  int n_sizes = argc > 1 ? argc - 1 : 1;
+  for ( int i = 0; i < n_sizes; i++ ) { failures += bench_size( argc > 1 ? atoi( argv[i + 1] ) : DEFAULT_FACE_COUNT ); }
+  if ( failures ) { fprintf( stderr, "%i streaming check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless check of vertex_packing. No GL context required.                    |
+| Packs a generated UV sphere plus random normals, then prints the error of    |
+| each format, the bytes saved, and the packing speed. Exits non-zero if any   |
+| error is outside the bound that format promises.                             |
+| Usage: bench_packing [rings]                                                 |
+\******************************************************************************/
+#include "vertex_packing.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_RINGS 512
+#define NUM_RANDOM_NORMALS 1000000
+// bounds the formats should stay inside
+#define MAX_NORMAL_ERR_DEG 0.005f
+#define MAX_HALF_REL_ERR ( 1.0f / 2048.0f )
+
+static float rand_float( float min, float max ) { return min + ( max - min ) * ( (float)rand() / (float)RAND_MAX ); }
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+/* triangle-soup UV sphere, unindexed like load_obj_file() output. radius 3,
+centred off the origin so the bounding box isn't symmetric */
+static size_t make_sphere( int rings, float** points, float** normals, float** tex_coords ) {
+  int segments = rings * 2;
+  size_t n     = (size_t)rings * segments * 6;
+  *points      = (float*)malloc( n * 3 * sizeof( float ) );
+  *normals     = (float*)malloc( n * 3 * sizeof( float ) );
+  *tex_coords  = (float*)malloc( n * 2 * sizeof( float ) );
+  size_t v     = 0;
+  for ( int r = 0; r < rings; r++ ) {
+    for ( int s = 0; s < segments; s++ ) {
+      // two triangles per quad, corners as (ring, segment) offsets
+      static const int corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+      for ( int c = 0; c < 6; c++ ) {
+        float tu            = (float)( s + corners[c][1] ) / (float)segments;
+        float tv            = (float)( r + corners[c][0] ) / (float)rings;
+        float theta         = tv * (float)M_PI;
+        float phi           = tu * 2.0f * (float)M_PI;
+        float nx            = sinf( theta ) * cosf( phi );
+        float ny            = cosf( theta );
+        float nz            = sinf( theta ) * sinf( phi );
+        ( *normals )[v * 3]     = nx;
+        ( *normals )[v * 3 + 1] = ny;
+        ( *normals )[v * 3 + 2] = nz;
+        ( *points )[v * 3]      = 10.0f + 3.0f * nx;
+        ( *points )[v * 3 + 1]  = -2.0f + 3.0f * ny;
+        ( *points )[v * 3 + 2]  = 0.5f + 3.0f * nz;
+        // tile the texture 3.7 times so half floats get values above 1, and off a power of 2 grid
+        ( *tex_coords )[v * 2]     = tu * 3.7f;
+        ( *tex_coords )[v * 2 + 1] = tv;
+        v++;
+      }
+    }
+  }
+  return n;
+}
+
+// every finite half must survive half -> float -> half unchanged
+static int check_half_round_trip() {
+  int failures = 0;
+  for ( unsigned int h = 0; h < 0x10000; h++ ) {
+    if ( ( h & 0x7c00 ) == 0x7c00 && ( h & 0x3ff ) ) { continue; } // NaN payloads aren't kept
+    unsigned short back = float_to_half( half_to_float( (unsigned short)h ) );
+    if ( back != h ) {
+      if ( failures < 4 ) { fprintf( stderr, "ERROR: half 0x%04x round-trips to 0x%04x\n", h, back ); }
+      failures++;
+    }
+  }
+  printf( "half round trip: %s\n", failures ? "FAILED" : "ok (all 63486 finite+inf values)" );
+  return failures;
+}
+
+static int check_normals( const char* label, const float* normals, size_t n ) {
+  short* packed    = (short*)malloc( n * 2 * sizeof( short ) );
+  float* unpacked  = (float*)malloc( n * 3 * sizeof( float ) );
+  double t0        = now_ms();
+  pack_normals_oct16( normals, n, packed );
+  double t1        = now_ms();
+  unpack_normals_oct16( packed, n, unpacked );
+  double t2        = now_ms();
+  packing_error e  = measure_normal_error_deg( normals, unpacked, n );
+  bool ok          = e.max_err <= MAX_NORMAL_ERR_DEG;
+  printf( "normals oct16 (%s): max %.5f deg rms %.5f deg | pack %.1f M/s unpack %.1f M/s %s\n", label, e.max_err, e.rms_err, n / ( ( t1 - t0 ) * 1e3 ),
+    n / ( ( t2 - t1 ) * 1e3 ), ok ? "" : "FAILED" );
+  free( packed );
+  free( unpacked );
+  return ok ? 0 : 1;
+}
+
+int main( int argc, char** argv ) {
+  int rings = argc > 1 ? atoi( argv[1] ) : DEFAULT_RINGS;
+  if ( rings < 2 ) { rings = DEFAULT_RINGS; }
+  int failures = check_half_round_trip();
+
+  float *points, *normals, *tex_coords;
+  size_t n = make_sphere( rings, &points, &normals, &tex_coords );
+  printf( "sphere: %i rings, %lu vertices\n", rings, (unsigned long)n );
+
+  // positions
+  {
+    float mn[3], mx[3];
+    points_aabb( points, n, 3, mn, mx );
+    unsigned short* packed = (unsigned short*)malloc( n * 3 * sizeof( unsigned short ) );
+    float* unpacked        = (float*)malloc( n * 3 * sizeof( float ) );
+    pack_positions_unorm16( points, n, mn, mx, packed );
+    unpack_positions_unorm16( packed, n, mn, mx, unpacked );
+    packing_error e = measure_error( points, unpacked, n * 3 );
+    float bound     = positions_unorm16_max_error( mn, mx );
+    bool ok         = e.max_err <= bound;
+    printf( "positions unorm16: max %g rms %g (bound %g) %s\n", e.max_err, e.rms_err, bound, ok ? "" : "FAILED" );
+    // the matrix must agree with the unpack function
+    mat4 dq    = quantised_to_mesh_mat4( mn, mx );
+    vec4 p     = dq * vec4( packed[3] / 65535.0f, packed[4] / 65535.0f, packed[5] / 65535.0f, 1.0f );
+    float diff = fabsf( p.v[0] - unpacked[3] ) + fabsf( p.v[1] - unpacked[4] ) + fabsf( p.v[2] - unpacked[5] );
+    if ( diff > 1e-5f ) {
+      fprintf( stderr, "ERROR: quantised_to_mesh_mat4 disagrees with unpack by %g\n", diff );
+      ok = false;
+    }
+    failures += ok ? 0 : 1;
+    free( packed );
+    free( unpacked );
+  }
+
+  // normals - the sphere's, plus random directions including the folded lower half
+  failures += check_normals( "sphere", normals, n );
+  {
+    float* random_normals = (float*)malloc( NUM_RANDOM_NORMALS * 3 * sizeof( float ) );
+    for ( int i = 0; i < NUM_RANDOM_NORMALS; i++ ) {
+      vec3 d = normalise( vec3( rand_float( -1.0f, 1.0f ), rand_float( -1.0f, 1.0f ), rand_float( -1.0f, 1.0f ) ) );
+      memcpy( &random_normals[i * 3], d.v, sizeof( d.v ) );
+    }
+    // exact axes and diagonals are the edge cases of the fold
+    static const float edge_cases[8][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0.7071f, 0, -0.7071f },
+      { -0.5774f, -0.5774f, -0.5774f } };
+    memcpy( random_normals, edge_cases, sizeof( edge_cases ) );
+    failures += check_normals( "random", random_normals, NUM_RANDOM_NORMALS );
+    free( random_normals );
+  }
+
+  // tex coords
+  {
+    unsigned short* packed = (unsigned short*)malloc( n * 2 * sizeof( unsigned short ) );
+    float* unpacked        = (float*)malloc( n * 2 * sizeof( float ) );
+    pack_halfs( tex_coords, n * 2, packed );
+    unpack_halfs( packed, n * 2, unpacked );
+    packing_error e = measure_error( tex_coords, unpacked, n * 2 );
+    // relative to the largest value, 3.7
+    bool ok = e.max_err <= 3.7f * MAX_HALF_REL_ERR;
+    printf( "tex coords half (0 to 3.7): max %g rms %g %s\n", e.max_err, e.rms_err, ok ? "" : "FAILED" );
+    failures += ok ? 0 : 1;
+
+    // unorm16 only covers 0 to 1, so divide the tiling back out
+    float* unit = (float*)malloc( n * 2 * sizeof( float ) );
+    for ( size_t i = 0; i < n * 2; i++ ) { unit[i] = ( i & 1 ) ? tex_coords[i] : tex_coords[i] / 3.7f; }
+    pack_unorm16( unit, n * 2, packed );
+    unpack_unorm16( packed, n * 2, unpacked );
+    e  = measure_error( unit, unpacked, n * 2 );
+    ok = e.max_err <= 0.5f / 65535.0f + 1e-7f;
+    printf( "tex coords unorm16 (0 to 1): max %g rms %g %s\n", e.max_err, e.rms_err, ok ? "" : "FAILED" );
+    failures += ok ? 0 : 1;
+    free( unit );
+    free( packed );
+    free( unpacked );
+  }
+
+  // whole mesh
+  {
+    packed_vertex* packed = (packed_vertex*)malloc( n * sizeof( packed_vertex ) );
+    float mn[3], mx[3];
+    double t0 = now_ms();
+    pack_mesh( points, normals, tex_coords, n, packed, mn, mx );
+    double t1       = now_ms();
+    size_t f_bytes  = n * 8 * sizeof( float );
+    size_t pk_bytes = n * sizeof( packed_vertex );
+    printf( "pack_mesh: %.1f M vertices/s | %lu bytes -> %lu bytes (%.0f%% saved)\n", n / ( ( t1 - t0 ) * 1e3 ), (unsigned long)f_bytes,
+      (unsigned long)pk_bytes, 100.0 * ( 1.0 - (double)pk_bytes / (double)f_bytes ) );
+
+    // every field must be what the stream's own packer gives
+    unsigned short* pos = (unsigned short*)malloc( n * 3 * sizeof( unsigned short ) );
+    short* nrm          = (short*)malloc( n * 2 * sizeof( short ) );
+    unsigned short* tc  = (unsigned short*)malloc( n * 2 * sizeof( unsigned short ) );
+    pack_positions_unorm16( points, n, mn, mx, pos );
+    pack_normals_oct16( normals, n, nrm );
+    pack_halfs( tex_coords, n * 2, tc );
+    bool ok = true;
+    for ( size_t i = 0; ok && i < n; i++ ) {
+      ok = !memcmp( packed[i].pos, &pos[i * 3], 3 * sizeof( unsigned short ) ) && 0 == packed[i].pos[3] &&
+           !memcmp( packed[i].normal, &nrm[i * 2], 2 * sizeof( short ) ) && !memcmp( packed[i].tex_coord, &tc[i * 2], 2 * sizeof( unsigned short ) );
+    }
+    // and without normals or tex coords, as from an OBJ with no vn, those fields are zeroed
+    pack_mesh( points, NULL, NULL, n, packed, mn, mx );
+    for ( size_t i = 0; ok && i < n; i++ ) {
+      ok = !memcmp( packed[i].pos, &pos[i * 3], 3 * sizeof( unsigned short ) ) && 0 == packed[i].normal[0] && 0 == packed[i].normal[1] &&
+           0 == packed[i].tex_coord[0] && 0 == packed[i].tex_coord[1];
+    }
+    printf( "pack_mesh matches the per-stream packers, with and without normals/tex coords %s\n", ok ? "" : "FAILED" );
+    failures += ok ? 0 : 1;
+    free( pos );
+    free( nrm );
+    free( tc );
+    free( packed );
+  }
+
+  free( points );
+  free( normals );
+  free( tex_coords );
+  if ( failures ) { fprintf( stderr, "%i packing check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,372 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Start-up time with and without the program binary cache, on whatever GL      |
+| driver EGL finds with no display - Mesa's llvmpipe on a build machine.       |
+| Writes synthetic shader pairs, then each run is a fresh child process that   |
+| makes a headless context and creates every programme with                    |
+| create_programme_from_files(): from source, with an empty cache, and with    |
+| a full one. Each programme then draws once into an FBO, and the pixels must  |
+| match the ones drawn by programmes compiled from source.                     |
+| Then checks the fallbacks: an edited source is a miss, and corrupt           |
+| binaries, an unknown binary format and a different driver are rejected,      |
+| compiled from source and replaced.                                           |
+| Mesa only offers program binaries with its own shader cache on, so each run  |
+| gets an empty one, and "from source" really compiles.                        |
+| Usage: bench_program_cache [programme_count]                                 |
+\******************************************************************************/
+#include "gl_headless.h"
+#include "gl_utils.h"
+#include "program_cache.h"
+#include <chrono>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEFAULT_PROGRAMMES 16
+#define MAX_PROGRAMMES 256
+// source and warm runs are repeated and the fastest kept
+#define REPEATS 3
+#define TMP_DIR "bench_program_cache_tmp"
+#define CACHE_DIR TMP_DIR "/cache"
+// Mesa's own cache, emptied before every run
+#define MESA_CACHE_DIR TMP_DIR "/mesa_cache"
+#define FBO_SIZE 32
+
+struct run_result {
+  bool ok;
+  double context_ms;
+  double create_ms;
+  double first_draw_ms;
+  program_cache_stats stats;
+  unsigned long long pixel_hash[MAX_PROGRAMMES];
+  char renderer[128];
+};
+
+static int g_programmes = DEFAULT_PROGRAMMES;
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+/*-----------------------------------SHADERS----------------------------------*/
+static void shader_file_name( int i, const char* ext, char* name, size_t len ) { snprintf( name, len, TMP_DIR "/p%03i.%s", i, ext ); }
+
+/* a full-screen triangle, and a fragment shader with a few dozen lighting-ish
+terms, more for some programmes than others, and different constants in each */
+static bool write_shaders( int i ) {
+  char name[256];
+  shader_file_name( i, "vert", name, sizeof( name ) );
+  FILE* f = fopen( name, "wb" );
+  if ( !f ) {
+    fprintf( stderr, "ERROR: could not write %s\n", name );
+    return false;
+  }
+  fprintf( f,
+    "#version 410 core\n"
+    "out vec2 uv;\n"
+    "void main() {\n"
+    "  uv = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );\n"
+    "  gl_Position = vec4( uv * 2.0 - 1.0, 0.0, 1.0 );\n"
+    "}\n" );
+  fclose( f );
+
+  shader_file_name( i, "frag", name, sizeof( name ) );
+  f = fopen( name, "wb" );
+  if ( !f ) {
+    fprintf( stderr, "ERROR: could not write %s\n", name );
+    return false;
+  }
+  fprintf( f,
+    "#version 410 core\n"
+    "in vec2 uv;\n"
+    "out vec4 frag_colour;\n"
+    "vec3 light( vec3 n, vec3 l, vec3 c, float k ) {\n"
+    "  vec3 h = normalize( l + vec3( 0.0, 0.0, 1.0 ) );\n"
+    "  return c * ( max( dot( n, l ), 0.0 ) + pow( max( dot( n, h ), 0.0 ), k ) );\n"
+    "}\n"
+    "void main() {\n"
+    "  vec3 n = normalize( vec3( uv * 2.0 - 1.0, 1.0 ) );\n"
+    "  vec3 c = vec3( 0.0 );\n" );
+  int terms = 12 + 6 * ( i % 4 );
+  for ( int t = 0; t < terms; t++ ) {
+    float a = 1.0f + (float)( ( i * 31 + t * 7 ) % 23 ), b = (float)( ( i * 17 + t * 13 ) % 11 ) * 0.1f;
+    fprintf( f, "  c += light( n, normalize( vec3( sin( %.1f ), cos( %.1f ), 1.0 ) ), vec3( %.2f, %.2f, %.2f ), %.1f ) * 0.02;\n", a, a * b, b, 1.0f - b, 0.5f, 4.0f + a );
+    if ( t % 4 == 3 ) { fprintf( f, "  c = mix( c, c.zxy * sin( uv.x * %.1f + uv.y ), %.2f );\n", a, b * 0.5f ); }
+  }
+  fprintf( f, "  frag_colour = vec4( clamp( c, 0.0, 1.0 ), 1.0 );\n}\n" );
+  fclose( f );
+  return true;
+}
+
+static unsigned long long hash_pixels( const unsigned char* p, size_t sz ) {
+  unsigned long long h = 0xcbf29ce484222325ull;
+  for ( size_t i = 0; i < sz; i++ ) { h = ( h ^ p[i] ) * 0x100000001b3ull; }
+  return h;
+}
+
+/*-------------------------------------RUN------------------------------------*/
+// one start-up, in the child process
+static void run( bool use_cache, run_result* r ) {
+  memset( r, 0, sizeof( run_result ) );
+  restart_gl_log_file( TMP_DIR "/gl.log" );
+  double t0 = now_ms();
+  if ( !start_gl_headless() ) { return; }
+  snprintf( r->renderer, sizeof( r->renderer ), "%s | %s", glGetString( GL_RENDERER ), glGetString( GL_VERSION ) );
+  if ( use_cache && !init_program_cache( CACHE_DIR ) ) {
+    stop_gl_headless();
+    return;
+  }
+  double t1       = now_ms();
+  r->context_ms   = t1 - t0;
+  GLuint* handles = (GLuint*)calloc( g_programmes, sizeof( GLuint ) );
+  r->ok           = true;
+  for ( int i = 0; i < g_programmes; i++ ) {
+    char vert[256], frag[256];
+    shader_file_name( i, "vert", vert, sizeof( vert ) );
+    shader_file_name( i, "frag", frag, sizeof( frag ) );
+    handles[i] = create_programme_from_files( vert, frag );
+    if ( !handles[i] ) { r->ok = false; }
+  }
+  double t2    = now_ms();
+  r->create_ms = t2 - t1;
+  r->stats     = get_program_cache_stats();
+
+  // the first draw is where some drivers (llvmpipe included) generate the actual machine code
+  GLuint fb, tex, vao;
+  glGenTextures( 1, &tex );
+  glBindTexture( GL_TEXTURE_2D, tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, FBO_SIZE, FBO_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+  glGenFramebuffers( 1, &fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, fb );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0 );
+  glGenVertexArrays( 1, &vao );
+  glBindVertexArray( vao );
+  glViewport( 0, 0, FBO_SIZE, FBO_SIZE );
+  unsigned char pixels[FBO_SIZE * FBO_SIZE * 4];
+  for ( int i = 0; i < g_programmes && r->ok; i++ ) {
+    glClear( GL_COLOR_BUFFER_BIT );
+    glUseProgram( handles[i] );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+    glReadPixels( 0, 0, FBO_SIZE, FBO_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+    r->pixel_hash[i] = hash_pixels( pixels, sizeof( pixels ) );
+  }
+  r->first_draw_ms = now_ms() - t2;
+  if ( GL_NO_ERROR != glGetError() ) {
+    fprintf( stderr, "ERROR: GL error while drawing\n" );
+    r->ok = false;
+  }
+  for ( int i = 0; i < g_programmes; i++ ) { glDeleteProgram( handles[i] ); }
+  free( handles );
+  log_program_cache_stats();
+  stop_program_cache();
+  stop_gl_headless();
+}
+
+// deletes dir and everything in it
+static void remove_tree( const char* dir ) {
+  DIR* d = opendir( dir );
+  if ( !d ) { return; }
+  while ( struct dirent* e = readdir( d ) ) {
+    if ( 0 == strcmp( e->d_name, "." ) || 0 == strcmp( e->d_name, ".." ) ) { continue; }
+    char name[512];
+    snprintf( name, sizeof( name ), "%s/%s", dir, e->d_name );
+    struct stat st;
+    if ( 0 == lstat( name, &st ) && S_ISDIR( st.st_mode ) ) {
+      remove_tree( name );
+    } else {
+      remove( name );
+    }
+  }
+  closedir( d );
+  rmdir( dir );
+}
+
+// runs one start-up in a child process, so every run gets a new context and driver
+static bool run_child( bool use_cache, run_result* r ) {
+  remove_tree( MESA_CACHE_DIR );
+  int fds[2];
+  if ( 0 != pipe( fds ) ) { return false; }
+  fflush( stdout );
+  pid_t pid = fork();
+  if ( pid < 0 ) { return false; }
+  if ( 0 == pid ) {
+    close( fds[0] );
+    run_result* mine = (run_result*)malloc( sizeof( run_result ) );
+    run( use_cache, mine );
+    size_t done = 0;
+    while ( done < sizeof( run_result ) ) {
+      ssize_t n = write( fds[1], (const char*)mine + done, sizeof( run_result ) - done );
+      if ( n <= 0 ) { break; }
+      done += (size_t)n;
+    }
+    close( fds[1] );
+    // exit() rather than _exit() so the log is flushed
+    exit( 0 );
+  }
+  close( fds[1] );
+  size_t done = 0;
+  while ( done < sizeof( run_result ) ) {
+    ssize_t n = read( fds[0], (char*)r + done, sizeof( run_result ) - done );
+    if ( n <= 0 ) { break; }
+    done += (size_t)n;
+  }
+  close( fds[0] );
+  int status = 0;
+  waitpid( pid, &status, 0 );
+  return done == sizeof( run_result ) && WIFEXITED( status ) && 0 == WEXITSTATUS( status ) && r->ok;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// every .pbin file in the cache, changed by edit. returns how many
+static int edit_cache_files( void ( *edit )( program_cache_header* h, char* binary ) ) {
+  DIR* d = opendir( CACHE_DIR );
+  if ( !d ) { return 0; }
+  int count = 0;
+  while ( struct dirent* e = readdir( d ) ) {
+    size_t len = strlen( e->d_name );
+    if ( len < strlen( PROGRAM_CACHE_SUFFIX ) || strcmp( e->d_name + len - strlen( PROGRAM_CACHE_SUFFIX ), PROGRAM_CACHE_SUFFIX ) ) { continue; }
+    char name[512];
+    snprintf( name, sizeof( name ), CACHE_DIR "/%s", e->d_name );
+    FILE* f = fopen( name, "r+b" );
+    if ( !f ) { continue; }
+    program_cache_header h;
+    if ( 1 == fread( &h, sizeof( h ), 1, f ) && h.binary_size > 0 ) {
+      char* binary = (char*)malloc( (size_t)h.binary_size );
+      if ( binary && h.binary_size == fread( binary, 1, (size_t)h.binary_size, f ) ) {
+        edit( &h, binary );
+        fseek( f, 0, SEEK_SET );
+        fwrite( &h, sizeof( h ), 1, f );
+        fwrite( binary, 1, (size_t)h.binary_size, f );
+        count++;
+      }
+      free( binary );
+    }
+    fclose( f );
+  }
+  closedir( d );
+  return count;
+}
+
+static void flip_bytes( program_cache_header* h, char* binary ) {
+  for ( unsigned long long i = h->binary_size / 2; i < h->binary_size; i += 7 ) { binary[i] ^= 0x5a; }
+}
+static void bad_format( program_cache_header* h, char* ) { h->binary_format = 0xdeadbeefu; }
+static void other_driver( program_cache_header* h, char* ) { h->driver_hash ^= 1; }
+
+static void print_run( const char* label, const run_result& r ) {
+  printf( "%-26s %10.1f %10.1f %12.1f %6i %6i %8i %6i\n", label, r.context_ms, r.create_ms, r.first_draw_ms, r.stats.hits, r.stats.misses, r.stats.rejected,
+    r.stats.stored );
+}
+
+/* one run expecting these counts, drawing the same pixels as from source.
+returns the number of failures */
+static int check_run( const char* label, const run_result& reference, int hits, int misses, int rejected ) {
+  run_result r;
+  bool ok = run_child( true, &r );
+  print_run( label, r );
+  if ( !ok ) {
+    fprintf( stderr, "ERROR: %s: the run failed\n", label );
+    return 1;
+  }
+  int failures = 0;
+  if ( r.stats.hits != hits || r.stats.misses != misses || r.stats.rejected != rejected || r.stats.stored != misses + rejected ) {
+    fprintf( stderr, "ERROR: %s: expected %i hits, %i misses, %i rejected and %i stored\n", label, hits, misses, rejected, misses + rejected );
+    failures++;
+  }
+  if ( memcmp( r.pixel_hash, reference.pixel_hash, g_programmes * sizeof( unsigned long long ) ) ) {
+    fprintf( stderr, "ERROR: %s: programmes drew different pixels to ones compiled from source\n", label );
+    failures++;
+  }
+  return failures;
+}
+
+int main( int argc, char** argv ) {
+  g_programmes = argc > 1 ? atoi( argv[1] ) : DEFAULT_PROGRAMMES;
+  if ( g_programmes < 1 || g_programmes > MAX_PROGRAMMES ) {
+    fprintf( stderr, "usage: bench_program_cache [programme_count 1-%i]\n", MAX_PROGRAMMES );
+    return 1;
+  }
+  // or Mesa hides compile time behind its own disk cache, which run_child() empties. older versions call it GLSL_CACHE
+  setenv( "MESA_SHADER_CACHE_DIR", MESA_CACHE_DIR, 1 );
+  setenv( "MESA_GLSL_CACHE_DIR", MESA_CACHE_DIR, 1 );
+  remove_tree( TMP_DIR );
+  mkdir( TMP_DIR, 0755 );
+  for ( int i = 0; i < g_programmes; i++ ) {
+    if ( !write_shaders( i ) ) { return 1; }
+  }
+
+  // nothing GL happens in this process, so every child starts cold
+  run_result source, r;
+  if ( !run_child( false, &source ) ) {
+    fprintf( stderr, "ERROR: could not compile from source with a headless context - is there an EGL driver?\n" );
+    return 1;
+  }
+  printf( "%s\n%i programmes, %ix%i FBO. milliseconds, best of %i for the source and warm runs\n", source.renderer, g_programmes, FBO_SIZE, FBO_SIZE, REPEATS );
+  printf( "%-26s %10s %10s %12s %6s %6s %8s %6s\n", "run", "context", "create", "first draw", "hits", "misses", "rejected", "stored" );
+  int failures = 0;
+  for ( int i = 1; i < REPEATS; i++ ) {
+    if ( run_child( false, &r ) && r.create_ms < source.create_ms ) { source = r; }
+  }
+  print_run( "from source, no cache", source );
+  failures += check_run( "cold cache", source, 0, g_programmes, 0 );
+  run_result warm;
+  memset( &warm, 0, sizeof( warm ) );
+  warm.create_ms = 1e30;
+  for ( int i = 0; i < REPEATS; i++ ) {
+    bool ok = run_child( true, &r );
+    if ( !ok || r.stats.hits != g_programmes || memcmp( r.pixel_hash, source.pixel_hash, g_programmes * sizeof( unsigned long long ) ) ) {
+      fprintf( stderr, "ERROR: warm cache run %i: expected %i hits and the same pixels as from source\n", i, g_programmes );
+      failures++;
+    }
+    if ( r.create_ms < warm.create_ms ) { warm = r; }
+  }
+  print_run( "warm cache", warm );
+
+  // a comment changes the hash but not the pixels
+  char name[256];
+  shader_file_name( 0, "frag", name, sizeof( name ) );
+  FILE* f = fopen( name, "ab" );
+  if ( f ) {
+    fprintf( f, "// edited\n" );
+    fclose( f );
+  }
+  failures += check_run( "one source edited", source, g_programmes - 1, 1, 0 );
+  remove_tree( CACHE_DIR );
+  write_shaders( 0 );
+  failures += check_run( "cache cleared", source, 0, g_programmes, 0 );
+
+  int n = edit_cache_files( flip_bytes );
+  failures += check_run( "corrupt binaries", source, g_programmes - n, 0, n );
+  n = edit_cache_files( bad_format );
+  failures += check_run( "unknown binary format", source, g_programmes - n, 0, n );
+  n = edit_cache_files( other_driver );
+  failures += check_run( "different driver", source, g_programmes - n, 0, n );
+  failures += check_run( "all replaced", source, g_programmes, 0, 0 );
+
+  // a file where the cache directory should be must turn the cache off. fails before any GL call, so fine here
+  const char* not_a_dir = TMP_DIR "/not_a_dir";
+  f                     = fopen( not_a_dir, "wb" );
+  if ( f ) { fclose( f ); }
+  if ( init_program_cache( not_a_dir ) ) {
+    fprintf( stderr, "ERROR: init_program_cache() accepted a file as its directory\n" );
+    failures++;
+    stop_program_cache();
+  }
+
+  printf( "creating %i programmes: %.1fms from source, %.1fms from the cache (%.1fx)\n", g_programmes, source.create_ms, warm.create_ms,
+    source.create_ms / ( warm.create_ms > 0.0 ? warm.create_ms : 1e-3 ) );
+  printf( "start-up to first frame: %.1fms from source, %.1fms from the cache\n", source.context_ms + source.create_ms + source.first_draw_ms,
+    warm.context_ms + warm.create_ms + warm.first_draw_ms );
+
+  remove_tree( TMP_DIR );
+  if ( failures ) { fprintf( stderr, "%i program cache check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,356 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Time to first frame creating shader programmes one at a time, as the demos   |
+| do, and in a batch (programme_batch.h), on whatever GL driver EGL finds with |
+| no display - Mesa's llvmpipe on a build machine. Uses the programmes of      |
+| 37_deferred_shading and 38_texture_shadows, and a set of synthetic ones.     |
+| Every run is a fresh child process with its own headless context; the same   |
+| create_programme_from_files() calls are made each time, the batch just goes  |
+| round them. Each programme then draws once into an FBO - the pixels must     |
+| match the one-at-a-time run - and each programme's compile and link times    |
+| from the batch are printed. Also checks a batch with a broken shader         |
+| reports just that one, and that a batch fills and then uses the program      |
+| binary cache.                                                                |
+| Mesa's own shader cache is pointed at an empty directory for every run.      |
+| Usage: bench_programme_batch [synthetic_count]                               |
+\******************************************************************************/
+#include "gl_headless.h"
+#include "gl_utils.h"
+#include "program_cache.h"
+#include "programme_batch.h"
+#include <chrono>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEFAULT_SYNTHETIC 12
+#define MAX_PROGRAMMES 64
+// runs are repeated and the fastest kept
+#define REPEATS 3
+#define TMP_DIR "bench_programme_batch_tmp"
+#define CACHE_DIR TMP_DIR "/cache"
+#define MESA_CACHE_DIR TMP_DIR "/mesa_cache"
+#define FBO_SIZE 32
+
+enum run_mode { RUN_ONE_AT_A_TIME, RUN_BATCHED, RUN_BATCHED_CACHED };
+
+struct programme_files {
+  char vert[256];
+  char frag[256];
+};
+
+struct programme_set {
+  const char* name;
+  programme_files files[MAX_PROGRAMMES];
+  int count;
+};
+
+struct run_result {
+  bool ok;
+  bool parallel;
+  double ready_ms;       // every programme created and checked
+  double first_frame_ms; // and each drawn once
+  unsigned long long pixel_hash[MAX_PROGRAMMES];
+  programme_timing timings[MAX_PROGRAMMES];
+  int timing_count;
+  bool linked[MAX_PROGRAMMES]; // programme_batch_linked() for each handle create_programme_from_files() gave
+  program_cache_stats stats;
+  char renderer[128];
+};
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+static unsigned long long hash_pixels( const unsigned char* p, size_t sz ) {
+  unsigned long long h = 0xcbf29ce484222325ull;
+  for ( size_t i = 0; i < sz; i++ ) { h = ( h ^ p[i] ) * 0x100000001b3ull; }
+  return h;
+}
+
+/*-----------------------------------SHADERS----------------------------------*/
+static void add_pair( programme_set* set, const char* dir, const char* vert, const char* frag ) {
+  programme_files* f = &set->files[set->count++];
+  snprintf( f->vert, sizeof( f->vert ), "%s/%s", dir, vert );
+  snprintf( f->frag, sizeof( f->frag ), "%s/%s", dir, frag );
+}
+
+/* a full-screen triangle, and a fragment shader of lighting-ish terms, more
+for some programmes than others. broken gives a fragment shader that doesn't
+compile */
+static bool write_synthetic( programme_set* set, int i, bool broken ) {
+  char vert[64], frag[64];
+  snprintf( vert, sizeof( vert ), "s%03i.vert", i );
+  snprintf( frag, sizeof( frag ), "s%03i.frag", i );
+  add_pair( set, TMP_DIR, vert, frag );
+  FILE* f = fopen( set->files[set->count - 1].vert, "wb" );
+  if ( !f ) {
+    fprintf( stderr, "ERROR: could not write %s\n", set->files[set->count - 1].vert );
+    return false;
+  }
+  fprintf( f,
+    "#version 410 core\n"
+    "out vec2 uv;\n"
+    "void main() {\n"
+    "  uv = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );\n"
+    "  gl_Position = vec4( uv * 2.0 - 1.0, 0.0, 1.0 );\n"
+    "}\n" );
+  fclose( f );
+  f = fopen( set->files[set->count - 1].frag, "wb" );
+  if ( !f ) {
+    fprintf( stderr, "ERROR: could not write %s\n", set->files[set->count - 1].frag );
+    return false;
+  }
+  fprintf( f,
+    "#version 410 core\n"
+    "in vec2 uv;\n"
+    "out vec4 frag_colour;\n"
+    "vec3 light( vec3 n, vec3 l, vec3 c, float k ) {\n"
+    "  vec3 h = normalize( l + vec3( 0.0, 0.0, 1.0 ) );\n"
+    "  return c * ( max( dot( n, l ), 0.0 ) + pow( max( dot( n, h ), 0.0 ), k ) );\n"
+    "}\n"
+    "void main() {\n"
+    "  vec3 n = normalize( vec3( uv * 2.0 - 1.0, 1.0 ) );\n"
+    "  vec3 c = vec3( 0.0 );\n" );
+  int terms = 12 + 6 * ( i % 4 );
+  for ( int t = 0; t < terms; t++ ) {
+    float a = 1.0f + (float)( ( i * 31 + t * 7 ) % 23 ), b = (float)( ( i * 17 + t * 13 ) % 11 ) * 0.1f;
+    fprintf( f, "  c += light( n, normalize( vec3( sin( %.1f ), cos( %.1f ), 1.0 ) ), vec3( %.2f, %.2f, %.2f ), %.1f ) * 0.02;\n", a, a * b, b, 1.0f - b, 0.5f, 4.0f + a );
+  }
+  fprintf( f, "  frag_colour = vec4( clamp( c, 0.0, 1.0 ), 1.0 )%s\n}\n", broken ? "" : ";" );
+  fclose( f );
+  return true;
+}
+
+/*-------------------------------------RUN------------------------------------*/
+// one start-up, in the child process
+static void run( const programme_set* set, run_mode mode, run_result* r ) {
+  memset( r, 0, sizeof( run_result ) );
+  restart_gl_log_file( TMP_DIR "/gl.log" );
+  if ( !start_gl_headless() ) { return; }
+  snprintf( r->renderer, sizeof( r->renderer ), "%s | %s", glGetString( GL_RENDERER ), glGetString( GL_VERSION ) );
+  r->parallel = parallel_shader_compile_available();
+  if ( RUN_BATCHED_CACHED == mode && !init_program_cache( CACHE_DIR ) ) {
+    stop_gl_headless();
+    return;
+  }
+  GLuint handles[MAX_PROGRAMMES];
+  r->ok     = true;
+  double t0 = now_ms();
+  if ( RUN_ONE_AT_A_TIME != mode ) { begin_programme_batch(); }
+  // the same calls either way
+  for ( int i = 0; i < set->count; i++ ) {
+    handles[i] = create_programme_from_files( set->files[i].vert, set->files[i].frag );
+    if ( !handles[i] ) { r->ok = false; }
+  }
+  if ( RUN_ONE_AT_A_TIME != mode ) {
+    if ( !end_programme_batch() ) { r->ok = false; }
+    const programme_timing* timings = programme_batch_timings( &r->timing_count );
+    memcpy( r->timings, timings, r->timing_count * sizeof( programme_timing ) );
+    for ( int i = 0; i < set->count; i++ ) { r->linked[i] = programme_batch_linked( handles[i] ); }
+  }
+  r->ready_ms = now_ms() - t0;
+  r->stats    = get_program_cache_stats();
+
+  // the first draw is where some drivers (llvmpipe included) generate the actual machine code
+  GLuint fb, tex, vao;
+  glGenTextures( 1, &tex );
+  glBindTexture( GL_TEXTURE_2D, tex );
+  glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, FBO_SIZE, FBO_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+  glGenFramebuffers( 1, &fb );
+  glBindFramebuffer( GL_FRAMEBUFFER, fb );
+  glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0 );
+  glGenVertexArrays( 1, &vao );
+  glBindVertexArray( vao );
+  glViewport( 0, 0, FBO_SIZE, FBO_SIZE );
+  unsigned char pixels[FBO_SIZE * FBO_SIZE * 4];
+  for ( int i = 0; i < set->count && r->ok; i++ ) {
+    glClear( GL_COLOR_BUFFER_BIT );
+    glUseProgram( handles[i] );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+    glReadPixels( 0, 0, FBO_SIZE, FBO_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+    r->pixel_hash[i] = hash_pixels( pixels, sizeof( pixels ) );
+  }
+  r->first_frame_ms = now_ms() - t0;
+  for ( int i = 0; i < set->count; i++ ) { glDeleteProgram( handles[i] ); }
+  stop_program_cache();
+  stop_gl_headless();
+}
+
+// deletes dir and everything in it
+static void remove_tree( const char* dir ) {
+  DIR* d = opendir( dir );
+  if ( !d ) { return; }
+  while ( struct dirent* e = readdir( d ) ) {
+    if ( 0 == strcmp( e->d_name, "." ) || 0 == strcmp( e->d_name, ".." ) ) { continue; }
+    char name[512];
+    snprintf( name, sizeof( name ), "%s/%s", dir, e->d_name );
+    struct stat st;
+    if ( 0 == lstat( name, &st ) && S_ISDIR( st.st_mode ) ) {
+      remove_tree( name );
+    } else {
+      remove( name );
+    }
+  }
+  closedir( d );
+  rmdir( dir );
+}
+
+/* runs one start-up in a child process, so every run gets a new context and
+driver. returns false if it crashed. r->ok says if every programme worked */
+static bool run_child( const programme_set* set, run_mode mode, run_result* r ) {
+  remove_tree( MESA_CACHE_DIR );
+  int fds[2];
+  if ( 0 != pipe( fds ) ) { return false; }
+  fflush( stdout );
+  pid_t pid = fork();
+  if ( pid < 0 ) { return false; }
+  if ( 0 == pid ) {
+    close( fds[0] );
+    run_result* mine = (run_result*)malloc( sizeof( run_result ) );
+    run( set, mode, mine );
+    size_t done = 0;
+    while ( done < sizeof( run_result ) ) {
+      ssize_t n = write( fds[1], (const char*)mine + done, sizeof( run_result ) - done );
+      if ( n <= 0 ) { break; }
+      done += (size_t)n;
+    }
+    close( fds[1] );
+    // exit() rather than _exit() so the log is flushed
+    exit( 0 );
+  }
+  close( fds[1] );
+  size_t done = 0;
+  while ( done < sizeof( run_result ) ) {
+    ssize_t n = read( fds[0], (char*)r + done, sizeof( run_result ) - done );
+    if ( n <= 0 ) { break; }
+    done += (size_t)n;
+  }
+  close( fds[0] );
+  int status = 0;
+  waitpid( pid, &status, 0 );
+  return done == sizeof( run_result ) && WIFEXITED( status ) && 0 == WEXITSTATUS( status );
+}
+
+// the fastest of REPEATS runs. returns false if any failed
+static bool best_run( const programme_set* set, run_mode mode, run_result* best ) {
+  run_result r;
+  bool ok = true;
+  for ( int i = 0; i < REPEATS; i++ ) {
+    ok = run_child( set, mode, &r ) && r.ok && ok;
+    if ( 0 == i || r.first_frame_ms < best->first_frame_ms ) { *best = r; }
+  }
+  return ok;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// times one set each way. returns the number of failures
+static int time_set( const programme_set* set ) {
+  run_result one, batched;
+  int failures = 0;
+  if ( !best_run( set, RUN_ONE_AT_A_TIME, &one ) || !best_run( set, RUN_BATCHED, &batched ) ) {
+    fprintf( stderr, "ERROR: %s: a run failed\n", set->name );
+    return 1;
+  }
+  if ( memcmp( one.pixel_hash, batched.pixel_hash, set->count * sizeof( unsigned long long ) ) ) {
+    fprintf( stderr, "ERROR: %s: batched programmes drew different pixels\n", set->name );
+    failures++;
+  }
+  printf( "%-22s %3i programmes. ready %8.1fms one at a time, %8.1fms batched. first frame %8.1fms, %8.1fms\n", set->name, set->count, one.ready_ms, batched.ready_ms,
+    one.first_frame_ms, batched.first_frame_ms );
+  for ( int i = 0; i < batched.timing_count; i++ ) {
+    const programme_timing& t = batched.timings[i];
+    // just the file names
+    const char* name = strrchr( t.name, '/' );
+    printf( "    %-40s %7.2fms to submit, compiled %7.2fms and linked %7.2fms after starting\n", name ? name + 1 : t.name, t.submit_ms, t.compile_ms, t.link_ms );
+  }
+  return failures;
+}
+
+/* a batch where one fragment shader doesn't compile must say so, for that
+programme only. returns the number of failures */
+static int check_broken( const programme_set* set, int broken ) {
+  run_result r;
+  if ( !run_child( set, RUN_BATCHED, &r ) ) {
+    fprintf( stderr, "ERROR: the run with a broken shader crashed\n" );
+    return 1;
+  }
+  bool ok = !r.ok && r.timing_count == set->count;
+  for ( int i = 0; ok && i < set->count; i++ ) { ok = r.timings[i].ok == ( i != broken ) && r.linked[i] == ( i != broken ) && r.timings[i].programme != 0; }
+  printf( "a broken shader in a batch is reported: %s\n", ok ? "ok" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+// a batch fills the program cache, then the next one uses it. returns the number of failures
+static int check_cache( const programme_set* set, const run_result& reference ) {
+  remove_tree( CACHE_DIR );
+  run_result cold, warm;
+  bool ok = run_child( set, RUN_BATCHED_CACHED, &cold ) && cold.ok && run_child( set, RUN_BATCHED_CACHED, &warm ) && warm.ok;
+  ok      = ok && cold.stats.misses == set->count && cold.stats.stored == set->count && warm.stats.hits == set->count;
+  ok      = ok && 0 == memcmp( warm.pixel_hash, reference.pixel_hash, set->count * sizeof( unsigned long long ) );
+  printf( "batched with the program binary cache: ready %.1fms cold, %.1fms warm. %i stored, %i hits: %s\n", cold.ready_ms, warm.ready_ms, cold.stats.stored,
+    warm.stats.hits, ok ? "ok" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+int main( int argc, char** argv ) {
+  int n_synthetic = argc > 1 ? atoi( argv[1] ) : DEFAULT_SYNTHETIC;
+  if ( n_synthetic < 2 || n_synthetic > MAX_PROGRAMMES ) {
+    fprintf( stderr, "usage: bench_programme_batch [synthetic_count 2-%i]\n", MAX_PROGRAMMES );
+    return 1;
+  }
+  setenv( "MESA_SHADER_CACHE_DIR", MESA_CACHE_DIR, 1 );
+  setenv( "MESA_GLSL_CACHE_DIR", MESA_CACHE_DIR, 1 );
+  remove_tree( TMP_DIR );
+  mkdir( TMP_DIR, 0755 );
+
+  static programme_set deferred, shadows, synthetic, broken;
+  deferred.name = "37_deferred_shading";
+  add_pair( &deferred, COMMON_SOURCE_DIR "/../37_deferred_shading", "first_pass.vert", "first_pass.frag" );
+  add_pair( &deferred, COMMON_SOURCE_DIR "/../37_deferred_shading", "second_pass.vert", "second_pass.frag" );
+  shadows.name = "38_texture_shadows";
+  add_pair( &shadows, COMMON_SOURCE_DIR "/../38_texture_shadows", "plain.vert", "plain.frag" );
+  add_pair( &shadows, COMMON_SOURCE_DIR "/../38_texture_shadows", "ss_quad.vert", "ss_quad.frag" );
+  add_pair( &shadows, COMMON_SOURCE_DIR "/../38_texture_shadows", "depth.vert", "depth.frag" );
+  synthetic.name = "synthetic";
+  for ( int i = 0; i < n_synthetic; i++ ) {
+    if ( !write_synthetic( &synthetic, i, false ) ) { return 1; }
+  }
+
+  // nothing GL happens in this process, so every child starts cold
+  run_result first;
+  if ( !run_child( &deferred, RUN_ONE_AT_A_TIME, &first ) || !first.ok ) {
+    fprintf( stderr, "ERROR: could not create programmes with a headless context - is there an EGL driver?\n" );
+    return 1;
+  }
+  printf( "%s. parallel_shader_compile: %s. best of %i runs each\n", first.renderer, first.parallel ? "yes" : "no", REPEATS );
+  int failures = 0;
+  failures += time_set( &deferred );
+  failures += time_set( &shadows );
+  failures += time_set( &synthetic );
+
+  // the middle one of three is broken
+  broken.name = "broken";
+  for ( int i = 0; i < 3; i++ ) {
+    if ( !write_synthetic( &broken, MAX_PROGRAMMES + i, 1 == i ) ) { return 1; }
+  }
+  failures += check_broken( &broken, 1 );
+  run_result reference;
+  if ( run_child( &synthetic, RUN_ONE_AT_A_TIME, &reference ) && reference.ok ) {
+    failures += check_cache( &synthetic, reference );
+  } else {
+    failures++;
+  }
+
+  remove_tree( TMP_DIR );
+  if ( failures ) { fprintf( stderr, "%i programme batch check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Checks programme_reflection.h on a headless context, with a programme laid   |
+| out like 30_skinning_part_one's (model, view and proj matrices and 64 bone   |
+| matrices) plus a sampler, a uniform block, a uniform with an initialiser     |
+| and one the compiler removes. Then times a skinned frame's uniform uploads   |
+| three ways: looking every location up by string each frame, keeping int      |
+| locations and uploading every matrix (the demo's way), and set_uniform()     |
+| with set_uniform_array(), which upload only what changed. Only a couple of   |
+| bones move per frame, as when one part of a model is animated. Also times    |
+| a single lookup by string, by interned id, and with glGetUniformLocation().  |
+| Usage: bench_programme_reflection [frame_count]                              |
+\******************************************************************************/
+#include "gl_headless.h"
+#include "gl_utils.h"
+#include "programme_reflection.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FRAMES 2000
+#define MAX_BONES 64
+// bones that move each frame
+#define MOVING_BONES 2
+#define LOOKUPS 200000
+#define LOG_FILE "bench_programme_reflection.log"
+
+static const char* g_vert = "#version 410\n"
+                            "uniform mat4 model, view, proj;\n"
+                            "uniform mat4 bone_matrices[64];\n"
+                            "out vec2 st;\n"
+                            "void main() {\n"
+                            "  vec2 p = vec2( float( ( gl_VertexID & 1 ) * 4 - 1 ), float( ( gl_VertexID >> 1 ) * 4 - 1 ) );\n"
+                            "  st = p * 0.5 + 0.5;\n"
+                            "  gl_Position = proj * view * model * bone_matrices[gl_VertexID % 64] * vec4( p, 0.0, 1.0 );\n"
+                            "}\n";
+static const char* g_frag = "#version 410\n"
+                            "in vec2 st;\n"
+                            "uniform sampler2D diffuse_map;\n"
+                            "layout(std140) uniform material {\n"
+                            "  vec4 tint;\n"
+                            "  float roughness;\n"
+                            "};\n"
+                            "uniform float gloss = 8.0;\n"
+                            "uniform vec3 unused_colour;\n"
+                            "out vec4 frag_colour;\n"
+                            "void main() {\n"
+                            "  frag_colour = texture( diffuse_map, st ) * tint * gloss * roughness;\n"
+                            "}\n";
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+static int check( bool ok, const char* what ) {
+  printf( "  %-62s %s\n", what, ok ? "ok" : "FAILED" );
+  return ok ? 0 : 1;
+}
+
+// what glGetUniformfv() gives for a location equals m
+static bool gl_has( GLuint programme, GLint location, const float* m, int n ) {
+  float got[16];
+  glGetUniformfv( programme, location, got );
+  return 0 == memcmp( got, m, n * sizeof( float ) );
+}
+
+/*----------------------------------CHECKS------------------------------------*/
+static int check_reflection( GLuint programme, programme_reflection* r ) {
+  int failures = 0;
+  printf( "reflection checks:\n" );
+  GLint n_active = 0;
+  glGetProgramiv( programme, GL_ACTIVE_UNIFORMS, &n_active );
+  failures += check( r->uniform_count == n_active, "every active uniform is reflected" );
+  int bones = find_uniform( r, "bone_matrices" );
+  failures += check( bones >= 0 && bones == find_uniform( r, "bone_matrices[0]" ), "an array is found with and without [0]" );
+  failures += check( bones >= 0 && MAX_BONES == r->uniforms[bones].array_size && GL_FLOAT_MAT4 == r->uniforms[bones].type, "bone_matrices is a mat4[64]" );
+  failures += check( bones == find_uniform_id( r, intern_name( "bone_matrices" ) ), "lookup by interned id matches lookup by string" );
+  failures += check( intern_name( "bone_matrices" ) == intern_name( "bone_matrices" ) &&
+                       0 == strcmp( interned_name( intern_name( "gloss" ) ), "gloss" ),
+    "interning gives one id per string" );
+  failures += check( -1 == find_uniform( r, "unused_colour" ) && -1 == find_uniform( r, "no_such_uniform" ), "a removed or unknown uniform is -1" );
+
+  int gloss = find_uniform( r, "gloss" );
+  failures += check( gloss >= 0 && 8.0f == *(float*)( r->values + r->uniforms[gloss].value_offset ), "the initialiser's value is read at reflection" );
+  int before = r->uploads;
+  failures += check( set_uniform( r, gloss, 8.0f ) && r->uploads == before && r->skipped > 0, "setting the value GL already has is skipped" );
+
+  // every element must have the location GL gives its own name
+  bool locations_ok = bones >= 0;
+  for ( int i = 0; locations_ok && i < MAX_BONES; i++ ) {
+    char name[64];
+    snprintf( name, sizeof( name ), "bone_matrices[%i]", i );
+    locations_ok = r->locations[r->uniforms[bones].first_location + i] == glGetUniformLocation( programme, name );
+  }
+  failures += check( locations_ok, "every bone's location matches glGetUniformLocation()" );
+
+  mat4 mats[MAX_BONES];
+  for ( int i = 0; i < MAX_BONES; i++ ) { mats[i] = identity_mat4(); }
+  set_uniform_array( r, bones, 0, MAX_BONES, mats );
+  mats[3]  = translate( identity_mat4(), vec3( 1.0f, 2.0f, 3.0f ) );
+  mats[10] = rotate_z_deg( identity_mat4(), 30.0f );
+  before   = r->uploads;
+  bool ok  = set_uniform_array( r, bones, 0, MAX_BONES, mats );
+  GLint* locs = r->locations + r->uniforms[bones].first_location;
+  failures += check( ok && r->uploads == before + 1, "two changed bones go up in one call" );
+  failures += check( gl_has( programme, locs[3], mats[3].m, 16 ) && gl_has( programme, locs[10], mats[10].m, 16 ) &&
+                       gl_has( programme, locs[7], mats[7].m, 16 ),
+    "GL has the changed bones, and the ones between are untouched" );
+  mat4 m = translate( identity_mat4(), vec3( 4.0f, 5.0f, 6.0f ) );
+  ok     = set_uniform( r, find_uniform( r, "model" ), m );
+  failures += check( ok && gl_has( programme, glGetUniformLocation( programme, "model" ), m.m, 16 ), "set_uniform() on a mat4 reaches GL" );
+  failures += check( set_uniform( r, find_uniform( r, "diffuse_map" ), 2 ) && 2 == *(int*)( r->values + r->uniforms[find_uniform( r, "diffuse_map" )].value_offset ),
+    "a sampler takes an int" );
+
+  printf( "  (the next lines of ERROR output are expected)\n" );
+  fflush( stdout );
+  failures += check( !set_uniform( r, find_uniform( r, "model" ), 1.0f ), "a float into a mat4 is refused" );
+  failures += check( !set_uniform( r, find_uniform( r, "tint" ), vec4( 1.0f, 1.0f, 1.0f, 1.0f ) ), "a uniform in a block is refused" );
+  failures += check( !set_uniform( r, -1, 1.0f ), "handle -1 is refused" );
+  failures += check( !set_uniform_array( r, bones, 60, 8, mats ), "elements past the end are refused" );
+  flush_gl_log();
+
+  int block = find_uniform_block( r, "material" );
+  failures += check( block >= 0 && r->blocks[block].data_size >= 20, "the block is found, with its data size" );
+  int tint = find_uniform( r, "tint" );
+  failures += check( tint >= 0 && r->uniforms[tint].block == block && 0 == r->uniforms[tint].block_offset, "its members have offsets, not locations" );
+  before = r->uploads;
+  bind_uniform_block( r, block, 3 );
+  bind_uniform_block( r, block, 3 );
+  GLint binding = -1;
+  glGetActiveUniformBlockiv( programme, r->blocks[block].index, GL_UNIFORM_BLOCK_BINDING, &binding );
+  failures += check( 3 == binding && r->uploads == before + 1, "binding the block twice calls GL once" );
+  failures += check( GL_NO_ERROR == glGetError(), "no GL errors" );
+  return failures;
+}
+
+/*---------------------------------TIMINGS------------------------------------*/
+// moves a couple of bones per frame, like 30_skinning_part_one's ear
+static void animate( mat4* bones, int frame ) {
+  for ( int i = 0; i < MOVING_BONES; i++ ) {
+    int b    = ( i * 17 + 1 ) % MAX_BONES;
+    bones[b] = rotate_z_deg( identity_mat4(), sinf( frame * 0.01f + i ) * 45.0f );
+  }
+}
+
+static void time_uploads( GLuint programme, programme_reflection* r, int frames ) {
+  mat4 bones[MAX_BONES];
+  mat4 model = identity_mat4(), view = look_at( vec3( 0.0f, 0.0f, 5.0f ), vec3( 0.0f, 0.0f, 0.0f ), vec3( 0.0f, 1.0f, 0.0f ) );
+  mat4 proj = perspective( 67.0f, 1.0f, 0.1f, 100.0f );
+  char name[64];
+  glUseProgram( programme );
+
+  for ( int i = 0; i < MAX_BONES; i++ ) { bones[i] = identity_mat4(); }
+  glFinish();
+  double t0 = now_ms();
+  for ( int f = 0; f < frames; f++ ) {
+    animate( bones, f );
+    glUniformMatrix4fv( glGetUniformLocation( programme, "model" ), 1, GL_FALSE, model.m );
+    glUniformMatrix4fv( glGetUniformLocation( programme, "view" ), 1, GL_FALSE, view.m );
+    glUniformMatrix4fv( glGetUniformLocation( programme, "proj" ), 1, GL_FALSE, proj.m );
+    for ( int i = 0; i < MAX_BONES; i++ ) {
+      snprintf( name, sizeof( name ), "bone_matrices[%i]", i );
+      glUniformMatrix4fv( glGetUniformLocation( programme, name ), 1, GL_FALSE, bones[i].m );
+    }
+  }
+  glFinish();
+  double by_string_ms = now_ms() - t0;
+
+  GLint model_loc = glGetUniformLocation( programme, "model" ), view_loc = glGetUniformLocation( programme, "view" );
+  GLint proj_loc = glGetUniformLocation( programme, "proj" );
+  GLint bone_locs[MAX_BONES];
+  for ( int i = 0; i < MAX_BONES; i++ ) {
+    snprintf( name, sizeof( name ), "bone_matrices[%i]", i );
+    bone_locs[i] = glGetUniformLocation( programme, name );
+  }
+  for ( int i = 0; i < MAX_BONES; i++ ) { bones[i] = identity_mat4(); }
+  glFinish();
+  t0 = now_ms();
+  for ( int f = 0; f < frames; f++ ) {
+    animate( bones, f );
+    glUniformMatrix4fv( model_loc, 1, GL_FALSE, model.m );
+    glUniformMatrix4fv( view_loc, 1, GL_FALSE, view.m );
+    glUniformMatrix4fv( proj_loc, 1, GL_FALSE, proj.m );
+    for ( int i = 0; i < MAX_BONES; i++ ) { glUniformMatrix4fv( bone_locs[i], 1, GL_FALSE, bones[i].m ); }
+  }
+  glFinish();
+  double cached_ms = now_ms() - t0;
+
+  int model_u = find_uniform( r, "model" ), view_u = find_uniform( r, "view" ), proj_u = find_uniform( r, "proj" );
+  int bones_u = find_uniform( r, "bone_matrices" );
+  for ( int i = 0; i < MAX_BONES; i++ ) { bones[i] = identity_mat4(); }
+  refresh_uniform_values( r );
+  r->uploads = r->skipped = 0;
+  glFinish();
+  t0 = now_ms();
+  for ( int f = 0; f < frames; f++ ) {
+    animate( bones, f );
+    set_uniform( r, model_u, model );
+    set_uniform( r, view_u, view );
+    set_uniform( r, proj_u, proj );
+    set_uniform_array( r, bones_u, 0, MAX_BONES, bones );
+  }
+  glFinish();
+  double reflected_ms = now_ms() - t0;
+
+  printf( "\nuniform uploads, %i frames of 3 matrices + %i bones (%i moving):\n", frames, MAX_BONES, MOVING_BONES );
+  printf( "  %-44s %9.3f us/frame\n", "glGetUniformLocation() by string per frame", by_string_ms * 1000.0 / frames );
+  printf( "  %-44s %9.3f us/frame\n", "int locations, every matrix uploaded", cached_ms * 1000.0 / frames );
+  printf( "  %-44s %9.3f us/frame (%.1f GL calls/frame, %.1f skipped)\n", "set_uniform()/set_uniform_array()", reflected_ms * 1000.0 / frames,
+    (double)r->uploads / frames, (double)r->skipped / frames );
+}
+
+static void time_lookups( GLuint programme, programme_reflection* r ) {
+  volatile int sink = 0;
+  double t0         = now_ms();
+  for ( int i = 0; i < LOOKUPS; i++ ) { sink = sink + glGetUniformLocation( programme, "bone_matrices[0]" ); }
+  double gl_ms = now_ms() - t0;
+  t0           = now_ms();
+  for ( int i = 0; i < LOOKUPS; i++ ) { sink = sink + find_uniform( r, "bone_matrices" ); }
+  double string_ms = now_ms() - t0;
+  int id           = intern_name( "bone_matrices" );
+  t0               = now_ms();
+  for ( int i = 0; i < LOOKUPS; i++ ) { sink = sink + find_uniform_id( r, id ); }
+  double id_ms = now_ms() - t0;
+  printf( "\none lookup, %i times:\n", LOOKUPS );
+  printf( "  %-44s %9.1f ns\n", "glGetUniformLocation()", gl_ms * 1e6 / LOOKUPS );
+  printf( "  %-44s %9.1f ns\n", "find_uniform() by string", string_ms * 1e6 / LOOKUPS );
+  printf( "  %-44s %9.1f ns\n", "find_uniform_id() by interned id", id_ms * 1e6 / LOOKUPS );
+}
+
+int main( int argc, char** argv ) {
+  int frames = argc > 1 ? atoi( argv[1] ) : DEFAULT_FRAMES;
+  if ( frames < 1 ) {
+    fprintf( stderr, "usage: bench_programme_reflection [frame_count]\n" );
+    return 1;
+  }
+  restart_gl_log_file( LOG_FILE );
+  if ( !start_gl_headless() ) {
+    fprintf( stderr, "ERROR: could not start a headless context - is there an EGL driver?\n" );
+    return 1;
+  }
+  printf( "%s | %s\n", glGetString( GL_RENDERER ), glGetString( GL_VERSION ) );
+  GLuint programme = create_programme_from_strings( g_vert, -1, g_frag, -1 );
+  programme_reflection r;
+  if ( !programme || !reflect_programme( programme, &r ) ) {
+    fprintf( stderr, "ERROR: could not create and reflect the test programme\n" );
+    stop_gl_headless();
+    return 1;
+  }
+  int failures = check_reflection( programme, &r );
+  time_uploads( programme, &r, frames );
+  time_lookups( programme, &r );
+
+  free_programme_reflection( &r );
+  glDeleteProgram( programme );
+  stop_gl_headless();
+  close_gl_log();
+  remove( LOG_FILE );
+  if ( failures ) { fprintf( stderr, "%i reflection check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless report for shader_source. No GL context required.                   |
+| Writes synthetic shader files from 2KB to 8MB and times loading each with    |
+| the demos' parse_file_into_str() (fgets() and strcat() a line at a time),    |
+| 41_shader_hot_reload's single fread() into a fixed buffer, and               |
+| load_shader_source(). Checks all give the file's exact bytes, that the pool  |
+| hands the same buffer back on every reload, that more sources than the pool  |
+| holds can be loaded at once, and that an empty file loads.                   |
+| Usage: bench_shader_source                                                   |
+\******************************************************************************/
+#include "shader_source.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TMP_SHADER_FILE "bench_shader_source_tmp.glsl"
+// the demos' loader is quadratic in lines, so it's only timed up to this size
+#define OLD_LOADER_MAX_BYTES ( 160 * 1024 )
+// as 41_shader_hot_reload had it
+#define MAX_SHADER_SZ 100000
+// each size is loaded enough times to read this much in all
+#define BYTES_PER_SIZE ( 64 << 20 )
+
+static const int k_sizes[] = { 2 * 1024, 16 * 1024, 128 * 1024, 1024 * 1024, 8 * 1024 * 1024 };
+#define N_SIZES ( sizeof( k_sizes ) / sizeof( k_sizes[0] ) )
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+// a fragment shader of about sz bytes, padded out with lines of maths
+static bool write_shader( const char* file_name, int sz, char** expected, int* len ) {
+  FILE* f = fopen( file_name, "wb" );
+  if ( !f ) {
+    fprintf( stderr, "ERROR: could not write %s\n", file_name );
+    return false;
+  }
+  int n = fprintf( f, "#version 410\nin vec3 p;\nout vec4 frag_colour;\nvoid main() {\n  float v = 0.0;\n" );
+  for ( int i = 0; n < sz - 64; i++ ) { n += fprintf( f, "  v += sin( p.x * %i.0 + p.y ) * 0.5; // term %i\n", i % 97, i ); }
+  n += fprintf( f, "  frag_colour = vec4( v, v, v, 1.0 );\n}\n" );
+  fclose( f );
+  // read back the way a test of the loaders can't get wrong
+  f         = fopen( file_name, "rb" );
+  *expected = (char*)malloc( n + 1 );
+  *len      = (int)fread( *expected, 1, n, f );
+  fclose( f );
+  return *len == n;
+}
+
+/*---------------------------------OLD LOADERS--------------------------------*/
+// the demos' gl_utils.cpp version
+static bool old_parse_file_into_str( const char* file_name, char* shader_str, int max_len ) {
+  shader_str[0] = '\0'; // reset string
+  FILE* file    = fopen( file_name, "r" );
+  if ( !file ) { return false; }
+  int current_len = 0;
+  char line[2048];
+  strcpy( line, "" );
+  while ( !feof( file ) ) {
+    if ( NULL != fgets( line, 2048, file ) ) {
+      current_len += strlen( line );
+      if ( current_len >= max_len ) { break; }
+      strcat( shader_str, line );
+    }
+  }
+  fclose( file );
+  return true;
+}
+
+// 41_shader_hot_reload's version, into a caller's buffer
+static int fixed_fread( const char* file_name, char* buffer, int max_len ) {
+  FILE* fp = fopen( file_name, "r" );
+  if ( !fp ) { return -1; }
+  size_t count  = fread( buffer, 1, max_len - 1, fp );
+  buffer[count] = '\0';
+  fclose( fp );
+  return (int)count;
+}
+
+/*-----------------------------------CHECKS-----------------------------------*/
+// reloading must give back the same pooled buffer, and sources beyond the pool still load. returns the number of failures
+static int check_pool( const char* expected, int len ) {
+  int failures = 0;
+  shader_source a, b;
+  if ( !load_shader_source( TMP_SHADER_FILE, &a ) ) { return 1; }
+  const char* first = a.text;
+  free_shader_source( &a );
+  if ( !load_shader_source( TMP_SHADER_FILE, &b ) ) { return 1; }
+  if ( b.text != first || b.pool_index < 0 ) {
+    fprintf( stderr, "ERROR: reloading didn't reuse the pooled buffer\n" );
+    failures++;
+  }
+  free_shader_source( &b );
+
+  shader_source many[SHADER_SOURCE_POOL_BUFFERS + 2];
+  int malloced = 0;
+  for ( int i = 0; i < SHADER_SOURCE_POOL_BUFFERS + 2; i++ ) {
+    if ( !load_shader_source( TMP_SHADER_FILE, &many[i] ) ) { return failures + 1; }
+    if ( many[i].is_malloced ) { malloced++; }
+    if ( many[i].len != len || memcmp( many[i].text, expected, len ) ) {
+      fprintf( stderr, "ERROR: source %i of %i loaded at once is wrong\n", i, SHADER_SOURCE_POOL_BUFFERS + 2 );
+      failures++;
+    }
+  }
+  for ( int i = 0; i < SHADER_SOURCE_POOL_BUFFERS + 2; i++ ) { free_shader_source( &many[i] ); }
+  if ( malloced != 2 ) {
+    fprintf( stderr, "ERROR: expected 2 of %i sources loaded at once outside the pool, got %i\n", SHADER_SOURCE_POOL_BUFFERS + 2, malloced );
+    failures++;
+  }
+
+  FILE* f = fopen( TMP_SHADER_FILE, "wb" );
+  fclose( f );
+  if ( !load_shader_source( TMP_SHADER_FILE, &a ) || a.len != 0 ) {
+    fprintf( stderr, "ERROR: an empty shader file didn't load\n" );
+    failures++;
+  }
+  free_shader_source( &a );
+  printf( "pool reuse, %i sources at once, empty file: %s\n", SHADER_SOURCE_POOL_BUFFERS + 2, failures ? "FAILED" : "ok" );
+  return failures;
+}
+
+int main() {
+  int failures = 0;
+  printf( "microseconds per load. files of %i bytes and up are mapped, smaller ones read into the pool\n", SHADER_SOURCE_MAP_MIN );
+  printf( "%10s %14s %14s %14s %8s\n", "bytes", "fgets+strcat", "fixed fread", "shader_source", "how" );
+  char* expected = NULL;
+  int len        = 0;
+  for ( size_t s = 0; s < N_SIZES; s++ ) {
+    if ( !write_shader( TMP_SHADER_FILE, k_sizes[s], &expected, &len ) ) { return 1; }
+    int reps     = BYTES_PER_SIZE / len > 3 ? BYTES_PER_SIZE / len : 3;
+    char* buffer = (char*)malloc( len + 1 );
+
+    char old_us[32] = "-";
+    if ( len <= OLD_LOADER_MAX_BYTES ) {
+      int old_reps = reps > 200 ? 200 : reps;
+      double t0    = now_ms();
+      for ( int r = 0; r < old_reps; r++ ) { old_parse_file_into_str( TMP_SHADER_FILE, buffer, len + 1 ); }
+      snprintf( old_us, sizeof( old_us ), "%.1f", ( now_ms() - t0 ) * 1000.0 / old_reps );
+      if ( memcmp( buffer, expected, len ) ) {
+        fprintf( stderr, "ERROR: fgets+strcat gave different bytes\n" );
+        failures++;
+      }
+    }
+
+    char fread_us[32] = "-";
+    if ( len < MAX_SHADER_SZ - 1 ) {
+      double t0 = now_ms();
+      for ( int r = 0; r < reps; r++ ) { fixed_fread( TMP_SHADER_FILE, buffer, MAX_SHADER_SZ < len + 1 ? MAX_SHADER_SZ : len + 1 ); }
+      snprintf( fread_us, sizeof( fread_us ), "%.1f", ( now_ms() - t0 ) * 1000.0 / reps );
+    } else {
+      // 41_shader_hot_reload used to assert here
+      snprintf( fread_us, sizeof( fread_us ), "too big" );
+    }
+
+    bool mapped = false, same = true;
+    double t0   = now_ms();
+    for ( int r = 0; r < reps; r++ ) {
+      shader_source src;
+      if ( !load_shader_source( TMP_SHADER_FILE, &src ) ) {
+        same = false;
+        break;
+      }
+      mapped = src.mf.is_mapped;
+      // touch the text as glShaderSource() would, or mapped files would look free
+      unsigned int sum = 0;
+      for ( int i = 0; i < src.len; i += 64 ) { sum += (unsigned char)src.text[i]; }
+      buffer[0] = (char)sum;
+      if ( 0 == r ) { same = src.len == len && 0 == memcmp( src.text, expected, len ); }
+      free_shader_source( &src );
+    }
+    double new_ms = now_ms() - t0;
+    if ( !same ) {
+      fprintf( stderr, "ERROR: load_shader_source gave different bytes for %i bytes\n", len );
+      failures++;
+    }
+    printf( "%10i %14s %14s %14.1f %8s\n", len, old_us, fread_us, new_ms * 1000.0 / reps, mapped ? "mapped" : "pooled" );
+    free( buffer );
+    free( expected );
+  }
+  // a typical shader, small enough for the pool
+  if ( !write_shader( TMP_SHADER_FILE, 4096, &expected, &len ) ) { return 1; }
+  failures += check_pool( expected, len );
+  free( expected );
+  remove( TMP_SHADER_FILE );
+
+  if ( failures ) { fprintf( stderr, "%i shader source check(s) FAILED\n", failures ); }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Checks maths_funcs gives bit-for-bit the same results whether it's linked    |
+| from maths_funcs.cpp or built with MATHS_HEADER_ONLY. No GL context needed.  |
+| This file is compiled twice into the one program: normally, where it holds   |
+| main(), and from check_maths_modes_inline.cpp, where the header-only         |
+| maths_funcs lives in its own namespace so the two copies of every function   |
+| can't be merged by the linker.                                               |
+| Usage: check_maths_modes [n_cases]. Exits 1 on any mismatch.                 |
+\******************************************************************************/
+#ifdef MATHS_HEADER_ONLY
+// everything maths_funcs.cpp includes, so none of it ends up in the namespace
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#include <immintrin.h>
+#endif
+#if !defined( MATHS_NO_THREADS )
+#include <thread>
+#endif
+namespace header_only {
+#include "maths_funcs.h"
+#define RUN_OPS run_ops_header_only
+#else
+#include "maths_funcs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define RUN_OPS run_ops_linked
+#endif
+
+// floats read from the inputs and written to the outputs by one RUN_OPS call
+#define OPS_IN 48
+#define OPS_OUT 512
+
+static int put( float* out, int n, const float* v, int count ) {
+  for ( int i = 0; i < count; i++ ) { out[n + i] = v[i]; }
+  return n + count;
+}
+
+/* runs every public scalar function on the inputs and writes all the results
+out one after another. returns the number of floats written */
+int RUN_OPS( const float* in, float* out ) {
+  int n = 0;
+  vec3 a( in[0], in[1], in[2] ), b( in[3], in[4], in[5] );
+  float s = in[6];
+  mat4 m, k;
+  for ( int i = 0; i < 16; i++ ) {
+    m.m[i] = in[8 + i];
+    k.m[i] = in[24 + i];
+  }
+  vec4 v( in[40], in[41], in[42], in[43] );
+
+  // vec3
+  vec3 r = a + b;
+  n      = put( out, n, r.v, 3 );
+  r      = a - b;
+  n      = put( out, n, r.v, 3 );
+  r      = a + s;
+  n      = put( out, n, r.v, 3 );
+  r      = a - s;
+  n      = put( out, n, r.v, 3 );
+  r      = a * s;
+  n      = put( out, n, r.v, 3 );
+  r      = a / s;
+  n      = put( out, n, r.v, 3 );
+  r      = a;
+  r += b;
+  r -= a * 0.5f;
+  r *= s;
+  n           = put( out, n, r.v, 3 );
+  float f[10] = { length( a ), length2( a ), dot( a, b ), get_squared_dist( a, b ), direction_to_heading( a ), 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+  n           = put( out, n, f, 5 );
+  r           = normalise( a );
+  n           = put( out, n, r.v, 3 );
+  r           = cross( a, b );
+  n           = put( out, n, r.v, 3 );
+  r           = heading_to_direction( s * 57.0f );
+  n           = put( out, n, r.v, 3 );
+
+  // mat4
+  mat4 p = m * k;
+  n      = put( out, n, p.m, 16 );
+  vec4 w = m * v;
+  n      = put( out, n, w.v, 4 );
+  f[0]   = determinant( m );
+  n      = put( out, n, f, 1 );
+  p      = inverse( m );
+  n      = put( out, n, p.m, 16 );
+  p      = transpose( m );
+  n      = put( out, n, p.m, 16 );
+  p      = translate( m, a );
+  n      = put( out, n, p.m, 16 );
+  p      = rotate_x_deg( m, s * 57.0f );
+  n      = put( out, n, p.m, 16 );
+  p      = rotate_y_deg( m, s * 57.0f );
+  n      = put( out, n, p.m, 16 );
+  p      = rotate_z_deg( m, s * 57.0f );
+  n      = put( out, n, p.m, 16 );
+  p      = scale( m, b );
+  n      = put( out, n, p.m, 16 );
+  mat4 V = look_at( a, b, vec3( 0.0f, 1.0f, 0.0f ) );
+  n      = put( out, n, V.m, 16 );
+  p      = inverse_rigid( V );
+  n      = put( out, n, p.m, 16 );
+  p      = inverse_affine( translate( rotate_y_deg( identity_mat4(), s * 57.0f ), b ) );
+  n      = put( out, n, p.m, 16 );
+  p      = inverse_auto( V );
+  n      = put( out, n, p.m, 16 );
+  p      = perspective( 30.0f + fabsf( s ) * 20.0f, 1.333f, 0.1f, 100.0f );
+  n      = put( out, n, p.m, 16 );
+  p      = p * V * m;
+  n      = put( out, n, p.m, 16 );
+
+  // versor
+  versor q = quat_from_axis_deg( s * 57.0f, a.v[0], a.v[1], a.v[2] );
+  versor t = quat_from_axis_rad( in[7], b.v[0], b.v[1], b.v[2] );
+  n        = put( out, n, q.q, 4 );
+  n        = put( out, n, t.q, 4 );
+  q        = normalise( q );
+  t        = normalise( t );
+  versor u = q * t;
+  n        = put( out, n, u.q, 4 );
+  u        = q + t;
+  n        = put( out, n, u.q, 4 );
+  u        = q * s;
+  n        = put( out, n, u.q, 4 );
+  u        = q / s;
+  n        = put( out, n, u.q, 4 );
+  f[0]     = dot( q, t );
+  n        = put( out, n, f, 1 );
+  p        = quat_to_mat4( q );
+  n        = put( out, n, p.m, 16 );
+  float tt = in[44];
+  u        = slerp( q, t, tt );
+  n        = put( out, n, u.q, 4 );
+  u        = nlerp( q, t, tt );
+  n        = put( out, n, u.q, 4 );
+  versor qs[4] = { q, t, u, q }, rs[4] = { t, q, q, u }, outs[4];
+  float ts[4]  = { tt, 1.0f - tt, 0.5f, in[45] };
+  slerp_n( qs, rs, ts, outs, 4, SLERP_ACCURATE );
+  for ( int i = 0; i < 4; i++ ) { n = put( out, n, outs[i].q, 4 ); }
+  slerp_n( qs, rs, ts, outs, 4, SLERP_FAST );
+  for ( int i = 0; i < 4; i++ ) { n = put( out, n, outs[i].q, 4 ); }
+  nlerp_n( qs, rs, ts, outs, 4 );
+  for ( int i = 0; i < 4; i++ ) { n = put( out, n, outs[i].q, 4 ); }
+  return n;
+}
+
+#ifdef MATHS_HEADER_ONLY
+} // namespace header_only
+#else
+
+namespace header_only {
+int run_ops_header_only( const float* in, float* out );
+}
+
+static float rand_float( float min, float max ) { return min + ( max - min ) * ( (float)rand() / (float)RAND_MAX ); }
+
+int main( int argc, char** argv ) {
+  int n_cases = argc > 1 ? atoi( argv[1] ) : 100000;
+  srand( 1234 );
+  printf( "maths_funcs SIMD path: %s\n", maths_simd_path() );
+  int mismatched_cases = 0, n_out = 0;
+  for ( int c = 0; c < n_cases; c++ ) {
+    float in[OPS_IN];
+    for ( int i = 0; i < OPS_IN; i++ ) { in[i] = rand_float( -10.0f, 10.0f ); }
+    // mostly affine model matrices, like the demos use, with the odd general one
+    if ( c % 4 != 0 ) {
+      in[11] = in[15] = in[19] = 0.0f;
+      in[23]                   = 1.0f;
+    }
+    in[44] = rand_float( 0.0f, 1.0f );
+    in[45] = rand_float( 0.0f, 1.0f );
+    if ( c % 16 == 0 ) { in[3] = -0.0f; }
+    float linked[OPS_OUT], inlined[OPS_OUT];
+    int n_linked = run_ops_linked( in, linked );
+    int n_inline = header_only::run_ops_header_only( in, inlined );
+    n_out        = n_linked;
+    if ( n_linked != n_inline || n_linked > OPS_OUT ) {
+      fprintf( stderr, "ERROR: %i results from the linked maths_funcs but %i header-only\n", n_linked, n_inline );
+      return 1;
+    }
+    if ( 0 != memcmp( linked, inlined, n_linked * sizeof( float ) ) ) {
+      if ( mismatched_cases < 8 ) {
+        for ( int i = 0; i < n_linked; i++ ) {
+          if ( 0 != memcmp( &linked[i], &inlined[i], sizeof( float ) ) ) {
+            fprintf( stderr, "ERROR: case %i, result %i: linked %.9g, header-only %.9g\n", c, i, linked[i], inlined[i] );
+            break;
+          }
+        }
+      }
+      mismatched_cases++;
+    }
+  }
+  printf( "linked vs header-only maths_funcs: %i of %i cases differ (%i results each)\n", mismatched_cases, n_cases, n_out );
+  return mismatched_cases ? 1 : 0;
+}
+#endif
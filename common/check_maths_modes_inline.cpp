@@ -0,0 +1,3 @@
+// the header-only half of check_maths_modes. see check_maths_modes.cpp
+#define MATHS_HEADER_ONLY
+#include "check_maths_modes.cpp"
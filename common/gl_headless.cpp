@@ -0,0 +1,70 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Headless GL context - see gl_headless.h.                                     |
+\******************************************************************************/
+#include "gl_headless.h"
+#include "gl_log.h"
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+
+static EGLDisplay g_display = EGL_NO_DISPLAY;
+static EGLContext g_context = EGL_NO_CONTEXT;
+
+bool start_gl_headless() {
+  // surfaceless needs no X or GBM device. fall back on the default display where it's missing
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+  g_display = get_platform_display ? get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL ) : EGL_NO_DISPLAY;
+  if ( EGL_NO_DISPLAY == g_display ) { g_display = eglGetDisplay( EGL_DEFAULT_DISPLAY ); }
+  EGLint major = 0, minor = 0;
+  if ( EGL_NO_DISPLAY == g_display || !eglInitialize( g_display, &major, &minor ) ) {
+    fprintf( stderr, "ERROR: could not start EGL (0x%x)\n", eglGetError() );
+    return false;
+  }
+  gl_log( "starting EGL %i.%i headless\n", major, minor );
+  if ( !eglBindAPI( EGL_OPENGL_API ) ) {
+    fprintf( stderr, "ERROR: EGL has no desktop OpenGL\n" );
+    stop_gl_headless();
+    return false;
+  }
+
+  // no config and no surface, so nothing is drawn anywhere but FBOs
+  const EGLint attribs[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 1, EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE, EGL_NONE };
+  g_context = eglCreateContext( g_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs );
+  if ( EGL_NO_CONTEXT == g_context || !eglMakeCurrent( g_display, EGL_NO_SURFACE, EGL_NO_SURFACE, g_context ) ) {
+    fprintf( stderr, "ERROR: could not make a headless GL 4.1 context (0x%x)\n", eglGetError() );
+    stop_gl_headless();
+    return false;
+  }
+
+  // start GLEW extension handler. its GLX half fails without an X display, which doesn't matter here, so check the GL entry points instead
+  glewExperimental = GL_TRUE;
+  glewInit();
+  if ( !glCreateShader || !glProgramBinary ) {
+    fprintf( stderr, "ERROR: GLEW could not find GL 4.1 functions\n" );
+    stop_gl_headless();
+    return false;
+  }
+  // GLEW can leave an error behind from probing a core context
+  while ( GL_NO_ERROR != glGetError() ) {}
+
+  const GLubyte* renderer = glGetString( GL_RENDERER );
+  const GLubyte* version  = glGetString( GL_VERSION );
+  gl_log( "renderer: %s\nversion: %s\n", renderer, version );
+  return true;
+}
+
+void stop_gl_headless() {
+  if ( EGL_NO_DISPLAY == g_display ) { return; }
+  eglMakeCurrent( g_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+  if ( EGL_NO_CONTEXT != g_context ) { eglDestroyContext( g_display, g_context ); }
+  eglTerminate( g_display );
+  g_display = EGL_NO_DISPLAY;
+  g_context = EGL_NO_CONTEXT;
+}
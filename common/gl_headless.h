@@ -0,0 +1,21 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| A GL 4.1 core context with no window, for the benchmarks that need a real    |
+| driver - e.g. Mesa's llvmpipe on a build machine with no display. Uses       |
+| EGL's surfaceless platform, so there is no default framebuffer: draw into    |
+| an FBO. Link EGL and GL (and build GL/glew.c with GLEW_STATIC), and build    |
+| gl_utils.cpp with GL_UTILS_NO_GLFW if it's used too.                         |
+\******************************************************************************/
+#ifndef _GL_HEADLESS_H_
+#define _GL_HEADLESS_H_
+
+/* creates the context, makes it current and starts GLEW. prints to stderr and
+returns false if there's no EGL display or it can't make a 4.1 context */
+bool start_gl_headless();
+void stop_gl_headless();
+
+#endif
@@ -0,0 +1,413 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Buffered gl.log - see gl_log.h.                                              |
+| The ring is a bounded queue in the style of Dmitry Vyukov's: every slot has  |
+| a sequence number saying whose turn it is. Slot i is free for the message at |
+| position p when its number is p, full when it's p + 1, and the writer hands  |
+| it back for the next lap by setting it to p + GL_LOG_SLOTS. A message longer |
+| than a slot takes several in a row, all claimed by the same compare-and-     |
+| swap. Since the writer frees slots in order, the last of them being free     |
+| means they all are.                                                          |
+\******************************************************************************/
+#include "gl_log.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+// messages up to this long are formatted on the stack
+#define GL_LOG_LINE 512
+// stdio buffer for the log file
+#define GL_LOG_FILE_BUFFER ( 64 * 1024 )
+// longest "[    0.013204] I " prefix
+#define GL_LOG_PREFIX 32
+// how many times a crashing thread checks whether the writer has finished an fflush()
+#define GL_LOG_CRASH_SPINS ( 1 << 20 )
+
+struct log_slot {
+  std::atomic<unsigned long long> seq;
+  double seconds;
+  unsigned short len;
+  unsigned char level;
+  // nonzero if the message carries on in the next slot
+  unsigned char more;
+  char text[GL_LOG_SLOT_BYTES - 2 * sizeof( unsigned long long ) - 4];
+};
+
+/*------------------------------GLOBAL VARIABLES------------------------------*/
+static log_slot g_slots[GL_LOG_SLOTS];
+static bool g_slots_ready = false;
+// next position a message goes in, and next the writer takes out
+static std::atomic<unsigned long long> g_enqueue_pos( 0 );
+static unsigned long long g_dequeue_pos = 0;
+// positions before these are in the FILE, and fflush()ed to the OS
+static std::atomic<unsigned long long> g_written_pos( 0 );
+static std::atomic<unsigned long long> g_flushed_pos( 0 );
+// true if the slot at g_flushed_pos starts a message, rather than carrying one on
+static std::atomic<bool> g_flushed_at_start( true );
+// bytes fwrite()n since the last fflush(). kept under the stdio buffer, so only the writer's own fflush() reaches the file
+static size_t g_unflushed_bytes = 0;
+// a flush_gl_log() caller wants everything before this flushed
+static std::atomic<unsigned long long> g_flush_request( 0 );
+static bool g_at_message_start = true;
+
+static std::atomic<bool> g_running( false );
+static std::atomic<bool> g_stop( false );
+static std::atomic<int> g_min_level( GL_LOG_DEBUG );
+static std::atomic<long long> g_start_ns( 0 );
+// starting and stopping the writer, never held while logging
+static std::mutex g_control;
+static std::thread* g_writer = NULL;
+static FILE* g_file = NULL;
+static char g_file_name[1024] = GL_LOG_FILE;
+// g_file's descriptor, for the crash handler, or -1
+static std::atomic<int> g_fd( -1 );
+/* the crash handler sets crashing, then writes the ring itself. the writer
+sets flushing around each fflush(), and won't start one once crashing is set */
+static std::atomic<bool> g_crashing( false );
+static std::atomic<bool> g_flushing( false );
+// set once the log has been closed by exit(). later messages are written straight to the file
+static std::atomic<bool> g_closed_at_exit( false );
+// where the crash handler formats the ring. big enough for every slot and a prefix each
+static char g_crash_buffer[GL_LOG_SLOTS * ( GL_LOG_SLOT_BYTES + GL_LOG_PREFIX )];
+
+static const int k_crash_signals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+#define N_CRASH_SIGNALS ( sizeof( k_crash_signals ) / sizeof( k_crash_signals[0] ) )
+static void ( *g_prev_handlers[N_CRASH_SIGNALS] )( int );
+
+static long long now_ns() { return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count(); }
+
+/* "[    0.013204] I " into out, which must hold GL_LOG_PREFIX. no stdio, so
+the crash handler can use it too. returns the length */
+static size_t format_prefix( char* out, double seconds, unsigned char level ) {
+  unsigned long long us = seconds > 0.0 ? (unsigned long long)( seconds * 1e6 + 0.5 ) : 0;
+  char digits[24];
+  int n = 0;
+  // the 6 decimals, the point, then at least one whole digit, backwards
+  for ( int i = 0; i < 6; i++, us /= 10 ) { digits[n++] = (char)( '0' + us % 10 ); }
+  digits[n++] = '.';
+  do {
+    digits[n++] = (char)( '0' + us % 10 );
+    us /= 10;
+  } while ( us && n < (int)sizeof( digits ) );
+  size_t len   = 0;
+  out[len++]   = '[';
+  for ( int i = n; i < 12; i++ ) { out[len++] = ' '; }
+  while ( n ) { out[len++] = digits[--n]; }
+  out[len++] = ']';
+  out[len++] = ' ';
+  out[len++] = "DIWE"[level & 3];
+  out[len++] = ' ';
+  return len;
+}
+
+// returns false, without flushing, once the crash handler has taken the file over
+static bool flush_file() {
+  g_flushing.store( true );
+  if ( g_crashing.load() ) {
+    g_flushing.store( false );
+    return false;
+  }
+  fflush( g_file );
+  g_unflushed_bytes = 0;
+  g_flushed_at_start.store( g_at_message_start, std::memory_order_relaxed );
+  g_flushed_pos.store( g_dequeue_pos, std::memory_order_release );
+  g_flushing.store( false );
+  return true;
+}
+
+/*-----------------------------------WRITER-----------------------------------*/
+static void writer_main() {
+  bool dirty = false;
+  int idle   = 0;
+  for ( ;; ) {
+    if ( g_crashing.load() ) { return; }
+    log_slot& s = g_slots[g_dequeue_pos & ( GL_LOG_SLOTS - 1 )];
+    if ( s.seq.load( std::memory_order_acquire ) != g_dequeue_pos + 1 ) {
+      // nothing ready. push what's been written to the OS while waiting
+      if ( dirty ) {
+        if ( !flush_file() ) { return; }
+        dirty = false;
+      }
+      if ( g_stop.load( std::memory_order_acquire ) && g_enqueue_pos.load( std::memory_order_acquire ) == g_dequeue_pos ) { break; }
+      // spin briefly for bursts, then sleep so an idle log costs nothing
+      if ( ++idle < 64 ) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+      }
+      continue;
+    }
+    idle = 0;
+    // flush before stdio would do it by itself, so g_flushed_pos stays exact
+    if ( g_unflushed_bytes + GL_LOG_PREFIX + s.len > GL_LOG_FILE_BUFFER && !flush_file() ) { return; }
+    if ( g_at_message_start ) {
+      char prefix[GL_LOG_PREFIX];
+      size_t len = format_prefix( prefix, s.seconds, s.level );
+      fwrite( prefix, 1, len, g_file );
+      g_unflushed_bytes += len;
+    }
+    fwrite( s.text, 1, s.len, g_file );
+    g_unflushed_bytes += s.len;
+    g_at_message_start = !s.more;
+    s.seq.store( g_dequeue_pos + GL_LOG_SLOTS, std::memory_order_release );
+    g_dequeue_pos++;
+    g_written_pos.store( g_dequeue_pos, std::memory_order_release );
+    dirty = true;
+    // someone's waiting in flush_gl_log() - don't make them wait for a lull
+    unsigned long long want = g_flush_request.load( std::memory_order_acquire );
+    if ( want > g_flushed_pos.load( std::memory_order_relaxed ) && g_dequeue_pos >= want ) {
+      if ( !flush_file() ) { return; }
+      dirty = false;
+    }
+  }
+}
+
+/* waits until everything before target is flushed, or timeout_ms passes (-1
+to wait forever). returns false on timeout */
+static bool wait_for_flush( unsigned long long target, int timeout_ms ) {
+  unsigned long long want = g_flush_request.load( std::memory_order_relaxed );
+  while ( want < target && !g_flush_request.compare_exchange_weak( want, target ) ) {}
+  long long give_up = now_ns() + (long long)timeout_ms * 1000000;
+  while ( g_flushed_pos.load( std::memory_order_acquire ) < target ) {
+    if ( !g_running.load( std::memory_order_acquire ) ) { return false; }
+    if ( timeout_ms >= 0 && now_ns() > give_up ) { return false; }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+/* best effort, and async-signal-safe: stop the writer, then write() every
+message it hasn't flushed straight from the ring, in one call, and let the
+signal do whatever it would have done. the slots the writer has already taken
+still hold their text until a logger reuses them, so the ones in the stdio
+buffer are written from there. a slot that's half-filled, or already reused,
+ends what's written */
+static void crash_handler( int sig ) {
+  for ( size_t i = 0; i < N_CRASH_SIGNALS; i++ ) {
+    if ( k_crash_signals[i] == sig ) { signal( sig, g_prev_handlers[i] == SIG_ERR ? SIG_DFL : g_prev_handlers[i] ); }
+  }
+  int fd = g_fd.load();
+  if ( fd >= 0 && !g_crashing.exchange( true ) ) {
+    // an fflush() that had already started has to finish, or its bytes would be written twice. bounded, in case the writer is what crashed
+    for ( int i = 0; i < GL_LOG_CRASH_SPINS && g_flushing.load(); i++ ) {}
+    unsigned long long pos = g_flushed_pos.load( std::memory_order_acquire );
+    unsigned long long end = g_enqueue_pos.load( std::memory_order_acquire );
+    bool at_start          = g_flushed_at_start.load( std::memory_order_relaxed );
+    unsigned long long last = pos + GL_LOG_SLOTS;
+    size_t len              = 0;
+    for ( ; pos < end && pos < last; pos++ ) {
+      const log_slot& s      = g_slots[pos & ( GL_LOG_SLOTS - 1 )];
+      unsigned long long seq = s.seq.load( std::memory_order_acquire );
+      // committed and waiting, or taken by the writer and not yet reused
+      if ( seq != pos + 1 && seq != pos + GL_LOG_SLOTS ) { break; }
+      size_t slot_start = len;
+      if ( at_start ) { len += format_prefix( &g_crash_buffer[len], s.seconds, s.level ); }
+      size_t n = s.len < sizeof( s.text ) ? s.len : sizeof( s.text );
+      memcpy( &g_crash_buffer[len], s.text, n );
+      len += n;
+      // another thread may have claimed the slot while it was copied
+      if ( s.seq.load( std::memory_order_acquire ) != seq ) {
+        len = slot_start;
+        break;
+      }
+      at_start = !s.more;
+    }
+    if ( len > 0 && write( fd, g_crash_buffer, (unsigned int)len ) < 0 ) {}
+  }
+  raise( sig );
+}
+
+static void close_gl_log_at_exit() {
+  close_gl_log();
+  // static objects may be gone from here on, so no new writer thread: later messages go straight to the file
+  g_closed_at_exit.store( true );
+}
+
+// with g_control held
+static void stop_writer() {
+  if ( !g_running.load() ) { return; }
+  g_running.store( false, std::memory_order_release );
+  g_stop.store( true, std::memory_order_release );
+  g_writer->join();
+  delete g_writer;
+  g_writer = NULL;
+  g_fd.store( -1 );
+  fclose( g_file );
+  g_file = NULL;
+}
+
+// with g_control held. truncate starts the file again, with a header
+static bool start_writer( const char* file_name, bool truncate ) {
+  stop_writer();
+  FILE* file = fopen( file_name, truncate ? "w" : "a" );
+  if ( !file ) {
+    fprintf( stderr, "ERROR: could not open GL_LOG_FILE log file %s for %s\n", file_name, truncate ? "writing" : "appending" );
+    return false;
+  }
+  setvbuf( file, NULL, _IOFBF, GL_LOG_FILE_BUFFER );
+  if ( file_name != g_file_name ) {
+    strncpy( g_file_name, file_name, sizeof( g_file_name ) - 1 );
+    g_file_name[sizeof( g_file_name ) - 1] = '\0';
+  }
+  if ( truncate || 0 == g_start_ns.load() ) { g_start_ns.store( now_ns() ); }
+  if ( truncate ) {
+    time_t now = time( NULL );
+    char* date = ctime( &now );
+    fprintf( file, "GL_LOG_FILE log. local time %s\n", date );
+    // so nothing the crash handler writes can end up in front of it
+    fflush( file );
+  }
+  if ( !g_slots_ready ) {
+    for ( unsigned long long i = 0; i < GL_LOG_SLOTS; i++ ) { g_slots[i].seq.store( i, std::memory_order_relaxed ); }
+    for ( size_t i = 0; i < N_CRASH_SIGNALS; i++ ) { g_prev_handlers[i] = signal( k_crash_signals[i], crash_handler ); }
+    atexit( close_gl_log_at_exit );
+    g_slots_ready = true;
+  }
+  g_file            = file;
+  g_unflushed_bytes = 0;
+  g_fd.store( fileno( file ) );
+  g_stop.store( false );
+  g_writer = new std::thread( writer_main );
+  g_running.store( true, std::memory_order_release );
+  return true;
+}
+
+/*-----------------------------------QUEUEING---------------------------------*/
+// copies a formatted message into the ring, waiting for room if it's full
+static void enqueue( gl_log_level level, const char* text, size_t len ) {
+  const size_t slot_text = sizeof( g_slots[0].text );
+  unsigned long long k   = len ? ( len + slot_text - 1 ) / slot_text : 1;
+  double seconds         = (double)( now_ns() - g_start_ns.load( std::memory_order_relaxed ) ) / 1e9;
+  unsigned long long pos = g_enqueue_pos.load( std::memory_order_relaxed );
+  for ( ;; ) {
+    unsigned long long last = pos + k - 1;
+    unsigned long long seq  = g_slots[last & ( GL_LOG_SLOTS - 1 )].seq.load( std::memory_order_acquire );
+    if ( seq == last ) {
+      if ( g_enqueue_pos.compare_exchange_weak( pos, pos + k, std::memory_order_relaxed ) ) { break; }
+    } else {
+      // behind means the writer hasn't freed the slot yet: the ring is full
+      if ( (long long)( seq - last ) < 0 ) { std::this_thread::yield(); }
+      pos = g_enqueue_pos.load( std::memory_order_relaxed );
+    }
+  }
+  for ( unsigned long long i = 0; i < k; i++ ) {
+    log_slot& s = g_slots[( pos + i ) & ( GL_LOG_SLOTS - 1 )];
+    size_t n    = len > slot_text ? slot_text : len;
+    s.seconds   = seconds;
+    s.level     = (unsigned char)level;
+    s.more      = i + 1 < k;
+    s.len       = (unsigned short)n;
+    memcpy( s.text, text, n );
+    text += n;
+    len -= n;
+    s.seq.store( pos + i + 1, std::memory_order_release );
+  }
+}
+
+/* after exit() has closed the log: open, append and close for every message,
+as the demos' gl_log does */
+static bool log_sync( gl_log_level level, const char* text, size_t len ) {
+  FILE* file = fopen( g_file_name, "a" );
+  if ( !file ) {
+    fprintf( stderr, "ERROR: could not open GL_LOG_FILE %s file for appending\n", g_file_name );
+    return false;
+  }
+  char prefix[GL_LOG_PREFIX];
+  size_t prefix_len = format_prefix( prefix, (double)( now_ns() - g_start_ns.load() ) / 1e9, (unsigned char)level );
+  bool ok           = prefix_len == fwrite( prefix, 1, prefix_len, file ) && len == fwrite( text, 1, len, file );
+  return 0 == fclose( file ) && ok;
+}
+
+static bool log_v( gl_log_level level, bool to_stderr, const char* message, va_list args ) {
+  if ( (int)level < g_min_level.load( std::memory_order_relaxed ) ) { return true; }
+  bool sync = g_closed_at_exit.load();
+  if ( !sync && !g_running.load( std::memory_order_acquire ) ) {
+    std::lock_guard<std::mutex> lock( g_control );
+    if ( !g_running.load() && !start_writer( g_file_name, false ) ) { return false; }
+  }
+  char line[GL_LOG_LINE];
+  va_list copy;
+  va_copy( copy, args );
+  int n = vsnprintf( line, sizeof( line ), message, copy );
+  va_end( copy );
+  if ( n < 0 ) { return false; }
+  char* text = line;
+  if ( n >= (int)sizeof( line ) ) {
+    if ( n > GL_LOG_MAX_MESSAGE ) { n = GL_LOG_MAX_MESSAGE; }
+    text = (char*)malloc( (size_t)n + 1 );
+    if ( !text ) { return false; }
+    vsnprintf( text, (size_t)n + 1, message, args );
+  }
+  if ( to_stderr ) { fputs( text, stderr ); }
+  bool ok = true;
+  if ( sync ) {
+    ok = log_sync( level, text, (size_t)n );
+  } else {
+    enqueue( level, text, (size_t)n );
+  }
+  if ( text != line ) { free( text ); }
+  return ok;
+}
+
+/*--------------------------------LOG FUNCTIONS-------------------------------*/
+bool restart_gl_log() { return restart_gl_log_file( GL_LOG_FILE ); }
+
+bool restart_gl_log_file( const char* file_name ) {
+  std::lock_guard<std::mutex> lock( g_control );
+  return start_writer( file_name, true );
+}
+
+bool gl_log( const char* message, ... ) {
+  va_list argptr;
+  va_start( argptr, message );
+  bool ok = log_v( GL_LOG_INFO, false, message, argptr );
+  va_end( argptr );
+  return ok;
+}
+
+/* same as gl_log except also prints to stderr */
+bool gl_log_err( const char* message, ... ) {
+  va_list argptr;
+  va_start( argptr, message );
+  bool ok = log_v( GL_LOG_ERROR, true, message, argptr );
+  va_end( argptr );
+  return ok;
+}
+
+bool gl_log_at( gl_log_level level, const char* message, ... ) {
+  va_list argptr;
+  va_start( argptr, message );
+  bool ok = log_v( level, level >= GL_LOG_ERROR, message, argptr );
+  va_end( argptr );
+  return ok;
+}
+
+bool gl_log_at_v( gl_log_level level, const char* message, va_list args ) { return log_v( level, level >= GL_LOG_ERROR, message, args ); }
+
+void set_gl_log_level( gl_log_level min_level ) { g_min_level.store( min_level ); }
+
+void flush_gl_log() {
+  if ( !g_running.load( std::memory_order_acquire ) ) { return; }
+  wait_for_flush( g_enqueue_pos.load(), -1 );
+}
+
+void close_gl_log() {
+  std::lock_guard<std::mutex> lock( g_control );
+  stop_writer();
+}
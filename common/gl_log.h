@@ -0,0 +1,55 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| The gl.log functions from gl_utils, made cheap enough to call every frame.   |
+| The demos' versions open and close the log file for every message, which is  |
+| fine for a few lines at start-up, but not for logging GL errors or params    |
+| each frame. Here gl_log() just formats the message into a fixed-size ring    |
+| of slots in memory and returns; a background thread writes the slots to the  |
+| file, buffered, and hands them back. Any number of threads can log at once - |
+| a slot is claimed with one compare-and-swap, no locks. If the ring fills up, |
+| callers wait for the writer rather than drop messages or grow the ring.      |
+| Each message gets a timestamp (seconds since the log started) and a level:   |
+|   [    0.013204] I renderer: llvmpipe ...                                    |
+| The log is flushed at exit, and, as far as a signal handler can, on a crash  |
+| (SIGSEGV, SIGABRT, SIGFPE, SIGILL): the handler write()s whatever the writer |
+| hasn't flushed straight from the ring, in one call, without waiting. Once    |
+| exit() has closed the log, later messages (e.g. from static destructors) are |
+| appended to the file one at a time, with no writer thread. No GL in here.    |
+\******************************************************************************/
+#ifndef _GL_LOG_H_
+#define _GL_LOG_H_
+
+#include <stdarg.h> // used by log functions to have variable number of args
+
+#define GL_LOG_FILE "gl.log"
+// slots in the ring - must be a power of 2. each is GL_LOG_SLOT_BYTES, so the ring is 1MB
+#define GL_LOG_SLOTS 4096
+#define GL_LOG_SLOT_BYTES 256
+// longer messages are cut short
+#define GL_LOG_MAX_MESSAGE 65536
+
+enum gl_log_level { GL_LOG_DEBUG, GL_LOG_INFO, GL_LOG_WARNING, GL_LOG_ERROR };
+
+// truncates GL_LOG_FILE and writes a header with the date
+bool restart_gl_log();
+// as restart_gl_log, to another file. messages still queued for the old one are written to it first
+bool restart_gl_log_file( const char* file_name );
+// logs at GL_LOG_INFO
+bool gl_log( const char* message, ... );
+/* same as gl_log except also prints to stderr, and logs at GL_LOG_ERROR */
+bool gl_log_err( const char* message, ... );
+// logs at level. GL_LOG_ERROR messages also go to stderr, as gl_log_err's
+bool gl_log_at( gl_log_level level, const char* message, ... );
+bool gl_log_at_v( gl_log_level level, const char* message, va_list args );
+// messages below min_level are thrown away before they're formatted. GL_LOG_DEBUG keeps everything
+void set_gl_log_level( gl_log_level min_level );
+// waits until everything logged so far is in the file
+void flush_gl_log();
+// flushes, stops the writer thread and closes the file. the next message opens it again, appending
+void close_gl_log();
+
+#endif
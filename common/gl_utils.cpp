@@ -0,0 +1,308 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 27 Jan 2014                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries separate legal notices                              |
+|******************************************************************************|
+| This is just a file holding some commonly-used "utility" functions to keep   |
+| the main file a bit easier to read. You can might build up something like    |
+| this as learn more GL. Note that you don't need much code here to do good GL.|
+| If you have a big object-oriented engine then maybe you can ask yourself if  |
+| it is really making life easier.                                             |
+| Shared copy - see gl_utils.h.                                                |
+\******************************************************************************/
+#include "gl_utils.h"
+#include "program_cache.h"
+#include "programme_batch.h"
+#include "shader_source.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/*------------------------------GLOBAL VARIABLES------------------------------*/
+int g_gl_width       = 640;
+int g_gl_height      = 480;
+#ifndef GL_UTILS_NO_GLFW
+GLFWwindow* g_window = NULL;
+#endif
+
+/*--------------------------------GLFW3 and GLEW------------------------------*/
+#ifndef GL_UTILS_NO_GLFW
+bool start_gl() {
+  gl_log( "starting GLFW %s\n", glfwGetVersionString() );
+
+  glfwSetErrorCallback( glfw_error_callback );
+  if ( !glfwInit() ) {
+    fprintf( stderr, "ERROR: could not start GLFW3\n" );
+    return false;
+  }
+
+  glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
+  glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 1 );
+  glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
+  glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+  glfwWindowHint( GLFW_SAMPLES, 16 );
+
+  /*GLFWmonitor* mon = glfwGetPrimaryMonitor ();
+  const GLFWvidmode* vmode = glfwGetVideoMode (mon);
+  g_window = glfwCreateWindow (
+    vmode->width, vmode->height, "Extended GL Init", mon, NULL
+  );*/
+
+
+  g_window = glfwCreateWindow( g_gl_width, g_gl_height, "Extended Init.", NULL, NULL );
+  if ( !g_window ) {
+    fprintf( stderr, "ERROR: could not open window with GLFW3\n" );
+    glfwTerminate();
+    return false;
+  }
+  glfwSetFramebufferSizeCallback( g_window, glfw_framebuffer_size_callback );
+  glfwMakeContextCurrent( g_window );
+
+  // start GLEW extension handler
+  glewExperimental = GL_TRUE;
+  glewInit();
+
+  // get version info
+  const GLubyte* renderer = glGetString( GL_RENDERER ); // get renderer string
+  const GLubyte* version  = glGetString( GL_VERSION );  // version as a string
+  printf( "Renderer: %s\n", renderer );
+  printf( "OpenGL version supported %s\n", version );
+  gl_log( "renderer: %s\nversion: %s\n", renderer, version );
+
+  return true;
+}
+
+void glfw_error_callback( int error, const char* description ) {
+  fputs( description, stderr );
+  gl_log_err( "%s\n", description );
+}
+// a call-back function
+void glfw_framebuffer_size_callback( GLFWwindow* window, int width, int height ) {
+  g_gl_width  = width;
+  g_gl_height = height;
+  glfwGetFramebufferSize( window, &g_gl_width, &g_gl_height );
+  printf( "width %i height %i\n", width, height );
+  /* update any perspective matrices used here */
+}
+
+void _update_fps_counter( GLFWwindow* window ) {
+  static double previous_seconds = glfwGetTime();
+  static int frame_count;
+  double current_seconds = glfwGetTime();
+  double elapsed_seconds = current_seconds - previous_seconds;
+  if ( elapsed_seconds > 0.25 ) {
+    previous_seconds = current_seconds;
+    double fps       = (double)frame_count / elapsed_seconds;
+    char tmp[128];
+    sprintf( tmp, "opengl @ fps: %.2f", fps );
+    glfwSetWindowTitle( window, tmp );
+    frame_count = 0;
+  }
+  frame_count++;
+}
+#endif
+
+/*-----------------------------------SHADERS----------------------------------*/
+bool parse_file_into_str( const char* file_name, char* shader_str, int max_len ) {
+  shader_str[0] = '\0'; // reset string
+  shader_source src;
+  if ( !load_shader_source( file_name, &src ) ) {
+    gl_log_err( "ERROR: opening file for reading: %s\n", file_name );
+    return false;
+  }
+  // +1 for the null at the end
+  if ( src.len + 1 > max_len ) {
+    gl_log_err( "ERROR: shader length is longer than string buffer length %i\n", max_len );
+    free_shader_source( &src );
+    return false;
+  }
+  memcpy( shader_str, src.text, src.len );
+  shader_str[src.len] = '\0';
+  free_shader_source( &src );
+  return true;
+}
+
+void print_shader_info_log( GLuint shader_index ) {
+  int max_length    = 2048;
+  int actual_length = 0;
+  char log[2048];
+  glGetShaderInfoLog( shader_index, max_length, &actual_length, log );
+  printf( "shader info log for GL index %i:\n%s\n", shader_index, log );
+  gl_log( "shader info log for GL index %i:\n%s\n", shader_index, log );
+}
+
+bool create_shader_from_string( const char* name, const char* source, int len, GLuint* shader, GLenum type ) {
+  *shader         = glCreateShader( type );
+  const GLchar* p = (const GLchar*)source;
+  // with a length GL doesn't need the source null-terminated, so a mapped file can go straight in
+  glShaderSource( *shader, 1, &p, len < 0 ? NULL : &len );
+  glCompileShader( *shader );
+  // check for compile errors
+  int params = -1;
+  glGetShaderiv( *shader, GL_COMPILE_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    gl_log_err( "ERROR: GL shader index %i did not compile (%s)\n", *shader, name );
+    print_shader_info_log( *shader );
+    return false; // or exit or something
+  }
+  gl_log( "shader compiled. index %i\n", *shader );
+  return true;
+}
+
+bool create_shader( const char* file_name, GLuint* shader, GLenum type ) {
+  gl_log( "creating shader from %s...\n", file_name );
+  shader_source src;
+  if ( !load_shader_source( file_name, &src ) ) {
+    gl_log_err( "ERROR: opening file for reading: %s\n", file_name );
+    return false;
+  }
+  bool ok = create_shader_from_string( file_name, src.text, src.len, shader, type );
+  free_shader_source( &src );
+  return ok;
+}
+
+void print_programme_info_log( GLuint sp ) {
+  int max_length    = 2048;
+  int actual_length = 0;
+  char log[2048];
+  glGetProgramInfoLog( sp, max_length, &actual_length, log );
+  printf( "program info log for GL index %u:\n%s", sp, log );
+  gl_log( "program info log for GL index %u:\n%s", sp, log );
+}
+
+bool is_programme_valid( GLuint sp ) {
+  glValidateProgram( sp );
+  GLint params = -1;
+  glGetProgramiv( sp, GL_VALIDATE_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    gl_log_err( "program %i GL_VALIDATE_STATUS = GL_FALSE\n", sp );
+    print_programme_info_log( sp );
+    return false;
+  }
+  gl_log( "program %i GL_VALIDATE_STATUS = GL_TRUE\n", sp );
+  return true;
+}
+
+bool create_programme( GLuint vert, GLuint frag, GLuint* programme ) {
+  *programme = glCreateProgram();
+  gl_log( "created programme %u. attaching shaders %u and %u...\n", *programme, vert, frag );
+  glAttachShader( *programme, vert );
+  glAttachShader( *programme, frag );
+  // link the shader programme. if binding input attributes do that before link
+  glLinkProgram( *programme );
+  GLint params = -1;
+  glGetProgramiv( *programme, GL_LINK_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    gl_log_err( "ERROR: could not link shader programme GL index %u\n", *programme );
+    print_programme_info_log( *programme );
+    return false;
+  }
+  ( is_programme_valid( *programme ) );
+  // delete shaders here to free memory
+  glDeleteShader( vert );
+  glDeleteShader( frag );
+  return true;
+}
+
+GLuint create_programme_from_files( const char* vert_file_name, const char* frag_file_name ) {
+  GLuint vert, frag, programme;
+  if ( program_cache_enabled() || programme_batch_open() ) {
+    // the cache is keyed by the sources' text, and the batch needs them in memory, so load both first
+    shader_source vert_src, frag_src;
+    if ( !load_shader_source( vert_file_name, &vert_src ) ) {
+      gl_log_err( "ERROR: opening file for reading: %s\n", vert_file_name );
+      return 0;
+    }
+    if ( !load_shader_source( frag_file_name, &frag_src ) ) {
+      gl_log_err( "ERROR: opening file for reading: %s\n", frag_file_name );
+      free_shader_source( &vert_src );
+      return 0;
+    }
+    gl_log( "creating programme from %s and %s...\n", vert_file_name, frag_file_name );
+    if ( programme_batch_open() ) {
+      char name[PROGRAMME_BATCH_NAME_LEN];
+      snprintf( name, sizeof( name ), "%s %s", vert_file_name, frag_file_name );
+      // checked in end_programme_batch()
+      programme = submit_programme( name, vert_src.text, vert_src.len, frag_src.text, frag_src.len );
+    } else {
+      programme = create_programme_from_strings_cached( vert_src.text, vert_src.len, frag_src.text, frag_src.len );
+    }
+    free_shader_source( &vert_src );
+    free_shader_source( &frag_src );
+    if ( !programme ) { gl_log_err( "ERROR: creating shader program from file\n" ); }
+    return programme;
+  }
+  if ( !create_shader( vert_file_name, &vert, GL_VERTEX_SHADER ) ) {
+    gl_log_err( "ERROR: creating vertex shader from file\n" );
+    return 0;
+  }
+  if ( !create_shader( frag_file_name, &frag, GL_FRAGMENT_SHADER ) ) {
+    gl_log_err( "ERROR: creating frag shader from file\n" );
+    return 0;
+  }
+  if ( !create_programme( vert, frag, &programme ) ) {
+    gl_log_err( "ERROR: creating shader program from file\n" );
+    return 0;
+  }
+  return programme;
+}
+
+GLuint create_programme_from_strings( const char* vert_str, int vert_len, const char* frag_str, int frag_len ) {
+  if ( programme_batch_open() ) { return submit_programme( "strings", vert_str, vert_len, frag_str, frag_len ); }
+  if ( program_cache_enabled() ) { return create_programme_from_strings_cached( vert_str, vert_len, frag_str, frag_len ); }
+  GLuint vert, frag, programme;
+  if ( !create_shader_from_string( "vertex shader string", vert_str, vert_len, &vert, GL_VERTEX_SHADER ) ) { return 0; }
+  if ( !create_shader_from_string( "fragment shader string", frag_str, frag_len, &frag, GL_FRAGMENT_SHADER ) ) {
+    glDeleteShader( vert );
+    return 0;
+  }
+  if ( !create_programme( vert, frag, &programme ) ) {
+    gl_log_err( "ERROR: creating shader program from strings\n" );
+    return 0;
+  }
+  return programme;
+}
+
+/*-------------------------------VERTEX BUFFERS-------------------------------*/
+GLuint create_vao_from_layout( const vertex_layout& layout, const void* vertices, int vertex_count, const void* indices, int index_count, int index_size,
+  GLuint* vbo, GLuint* ibo ) {
+  GLuint vao = 0, vertex_buffer = 0, index_buffer = 0;
+  glGenVertexArrays( 1, &vao );
+  glBindVertexArray( vao );
+  glGenBuffers( 1, &vertex_buffer );
+  glBindBuffer( GL_ARRAY_BUFFER, vertex_buffer );
+  glBufferData( GL_ARRAY_BUFFER, (GLsizeiptr)vertex_count * layout.stride, vertices, GL_STATIC_DRAW );
+  for ( int i = 0; i < layout.attrib_count; i++ ) {
+    const vertex_attrib& a = layout.attribs[i];
+    GLenum type            = GL_FLOAT;
+    GLboolean normalised   = GL_FALSE;
+    switch ( a.type ) {
+    case VERTEX_ATTRIB_HALF: type = GL_HALF_FLOAT; break;
+    case VERTEX_ATTRIB_UNORM16:
+      type       = GL_UNSIGNED_SHORT;
+      normalised = GL_TRUE;
+      break;
+    case VERTEX_ATTRIB_SNORM16:
+      type       = GL_SHORT;
+      normalised = GL_TRUE;
+      break;
+    default: break;
+    }
+    // the "pointer" is the byte offset into the bound VBO
+    glVertexAttribPointer( a.location, a.components, type, normalised, layout.stride, (const GLvoid*)(size_t)a.offset );
+    glEnableVertexAttribArray( a.location );
+  }
+  // the element buffer binding is part of the VAO's state, so bind it while the VAO is
+  if ( indices ) {
+    glGenBuffers( 1, &index_buffer );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, index_buffer );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)index_count * index_size, indices, GL_STATIC_DRAW );
+  }
+  gl_log( "created VAO %u: %i vertices of %u bytes, %i attributes, %i indices\n", vao, vertex_count, layout.stride, layout.attrib_count, index_count );
+  if ( vbo ) { *vbo = vertex_buffer; }
+  if ( ibo ) { *ibo = index_buffer; }
+  return vao;
+}
@@ -0,0 +1,74 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 27 Jan 2014                                                    |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| This is just a file holding some commonly-used "utility" functions to keep   |
+| the main file a bit easier to read. You can might build up something like    |
+| this as learn more GL. Note that you don't need much code here to do good GL.|
+| If you have a big object-oriented engine then maybe you can ask yourself if  |
+| it is really making life easier.                                             |
+| This is the shared copy in common/, built up from the demos' ones, for new   |
+| code that also uses the common/ mesh and maths code.                         |
+\******************************************************************************/
+#ifndef _GL_UTILS_H_
+#define _GL_UTILS_H_
+
+#include <GL/glew.h> // include GLEW and new version of GL on Windows
+#ifndef GL_UTILS_NO_GLFW
+#include <GLFW/glfw3.h> // GLFW helper library
+#endif
+#include "gl_log.h"
+#include "vertex_layout.h"
+
+/*------------------------------GLOBAL VARIABLES------------------------------*/
+extern int g_gl_width;
+extern int g_gl_height;
+#ifndef GL_UTILS_NO_GLFW
+extern GLFWwindow* g_window;
+#endif
+/*--------------------------------LOG FUNCTIONS-------------------------------*/
+// restart_gl_log(), gl_log() and gl_log_err() are in gl_log.h, buffered on a background thread
+/*--------------------------------GLFW3 and GLEW------------------------------*/
+/* build with GL_UTILS_NO_GLFW to leave these out, for tools that make their
+own context - e.g. a headless one from gl_headless.h */
+#ifndef GL_UTILS_NO_GLFW
+bool start_gl();
+void glfw_error_callback( int error, const char* description );
+void glfw_framebuffer_size_callback( GLFWwindow* window, int width, int height );
+void _update_fps_counter( GLFWwindow* window );
+#endif
+/*-----------------------------------SHADERS----------------------------------*/
+/* copies a whole shader file into shader_str, null-terminated. returns false
+if it doesn't fit in max_len bytes - create_shader() has no such limit */
+bool parse_file_into_str( const char* file_name, char* shader_str, int max_len );
+void print_shader_info_log( GLuint shader_index );
+/* compiles len bytes of source, which needn't be null-terminated (len -1 if it
+is). name is only for the error message */
+bool create_shader_from_string( const char* name, const char* source, int len, GLuint* shader, GLenum type );
+// loads the file with load_shader_source() (shader_source.h), so any length works
+bool create_shader( const char* file_name, GLuint* shader, GLenum type );
+void print_programme_info_log( GLuint sp );
+bool is_programme_valid( GLuint sp );
+bool create_programme( GLuint vert, GLuint frag, GLuint* programme );
+/* just use this func to create most shaders; give it vertex and frag files.
+after init_program_cache() (program_cache.h) this and
+create_programme_from_strings() use binaries from the cache where they can.
+between begin_programme_batch() and end_programme_batch() (programme_batch.h)
+they don't wait for the compile, and errors are reported at the end. NB: so in
+a batch a shader that doesn't compile or link still gets a non-zero handle.
+ask programme_batch_linked( handle ) after end_programme_batch() before using it */
+GLuint create_programme_from_files( const char* vert_file_name, const char* frag_file_name );
+// as create_programme_from_files, from strings in memory. lengths as create_shader_from_string
+GLuint create_programme_from_strings( const char* vert_str, int vert_len, const char* frag_str, int frag_len );
+/*-------------------------------VERTEX BUFFERS-------------------------------*/
+/* creates a VAO with all the vertex attributes in one VBO, as layout says,
+e.g. from load_obj_file_interleaved(). if indices is not NULL it goes in an
+element buffer attached to the VAO, with index_size 2 (GL_UNSIGNED_SHORT) or 4
+(GL_UNSIGNED_INT). the VAO is left bound. vbo and ibo may be NULL */
+GLuint create_vao_from_layout( const vertex_layout& layout, const void* vertices, int vertex_count, const void* indices, int index_count, int index_size,
+  GLuint* vbo, GLuint* ibo );
+#endif
@@ -0,0 +1,33 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| 64-bit hashes for the on-disk caches. See hash64.h                           |
+\******************************************************************************/
+#include "hash64.h"
+#include <string.h>
+
+unsigned long long hash_bytes64( const void* data, size_t sz ) {
+  const unsigned char* p = (const unsigned char*)data;
+  unsigned long long h   = 0x9e3779b97f4a7c15ull ^ sz;
+  size_t i               = 0;
+  for ( ; i + 8 <= sz; i += 8 ) {
+    unsigned long long w;
+    memcpy( &w, p + i, 8 );
+    h = ( h ^ w ) * 0xff51afd7ed558ccdull;
+    h ^= h >> 29;
+  }
+  for ( ; i < sz; i++ ) {
+    h = ( h ^ p[i] ) * 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 29;
+  }
+  h ^= h >> 32;
+  return h;
+}
+
+unsigned long long hash_combine64( unsigned long long h, unsigned long long v ) {
+  h = ( h ^ v ) * 0xff51afd7ed558ccdull;
+  return h ^ ( h >> 32 );
+}
@@ -0,0 +1,22 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| 64-bit hashes used to key the on-disk caches (mesh_cache, program_cache).    |
+| Not cryptographic, just fast enough to run over a big source file. Changing  |
+| them changes every key, so bump both caches' versions if you do.             |
+\******************************************************************************/
+#ifndef _HASH64_H_
+#define _HASH64_H_
+
+#include <stddef.h>
+
+// multiply-xorshift over 8-byte words
+unsigned long long hash_bytes64( const void* data, size_t sz );
+
+// mixes v into h. order matters: combine(combine(h,a),b) != combine(combine(h,b),a)
+unsigned long long hash_combine64( unsigned long long h, unsigned long long v );
+
+#endif
@@ -0,0 +1,41 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Synthetic OBJ tool. Writes the meshes the benchmarks use, so other loaders   |
+| and tools can be timed on exactly the same files.                            |
+| Usage: make_obj grid|sphere|terrain face_count file.obj [noise]              |
+|   grid    - wavy grid, numbers in many formats. noise is ignored             |
+|   sphere  - closed UV sphere, noise is displacement (default 0.1)            |
+|   terrain - heightfield, noise is the height amplitude (default 8)           |
+\******************************************************************************/
+#include "synthetic_obj.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main( int argc, char** argv ) {
+  if ( argc < 4 ) {
+    printf( "usage: make_obj grid|sphere|terrain face_count file.obj [noise]\n" );
+    return 0;
+  }
+  const char* shape = argv[1];
+  int face_count    = atoi( argv[2] );
+  const char* file  = argv[3];
+  size_t sz         = 0;
+  if ( !strcmp( shape, "grid" ) ) {
+    sz = write_grid_obj( file, face_count, false );
+  } else if ( !strcmp( shape, "sphere" ) ) {
+    sz = write_sphere_obj( file, face_count, argc > 4 ? (float)atof( argv[4] ) : 0.1f );
+  } else if ( !strcmp( shape, "terrain" ) ) {
+    sz = write_terrain_obj( file, face_count, argc > 4 ? (float)atof( argv[4] ) : 8.0f );
+  } else {
+    fprintf( stderr, "ERROR: unknown shape %s\n", shape );
+    return 1;
+  }
+  if ( !sz ) { return 1; }
+  printf( "wrote %s, %.1f MB\n", file, sz / ( 1024.0 * 1024.0 ) );
+  return 0;
+}
@@ -0,0 +1,92 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Read-only whole-file access for the loaders. See mapped_file.h               |
+\******************************************************************************/
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+bool map_file( const char* file_name, mapped_file* mf ) {
+  memset( mf, 0, sizeof( mapped_file ) );
+  FILE* fp = fopen( file_name, "rb" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not open file %s\n", file_name );
+    return false;
+  }
+  fseek( fp, 0, SEEK_END );
+  long sz = ftell( fp );
+  rewind( fp );
+  if ( sz < 0 ) {
+    fprintf( stderr, "ERROR: could not get size of file %s\n", file_name );
+    fclose( fp );
+    return false;
+  }
+  if ( sz > 0 ) {
+    char* buffer = (char*)malloc( (size_t)sz );
+    if ( !buffer || fread( buffer, 1, (size_t)sz, fp ) != (size_t)sz ) {
+      fprintf( stderr, "ERROR: could not read file %s\n", file_name );
+      free( buffer );
+      fclose( fp );
+      return false;
+    }
+    mf->data = buffer;
+    mf->sz   = (size_t)sz;
+  }
+  fclose( fp );
+  return true;
+}
+
+void unmap_file( mapped_file* mf ) {
+  free( (void*)mf->data );
+  memset( mf, 0, sizeof( mapped_file ) );
+}
+#else
+bool map_file( const char* file_name, mapped_file* mf ) {
+  memset( mf, 0, sizeof( mapped_file ) );
+  int fd = open( file_name, O_RDONLY );
+  if ( fd < 0 ) {
+    fprintf( stderr, "ERROR: could not open file %s\n", file_name );
+    return false;
+  }
+  struct stat st;
+  if ( fstat( fd, &st ) != 0 ) {
+    fprintf( stderr, "ERROR: could not stat file %s\n", file_name );
+    close( fd );
+    return false;
+  }
+  // mmap() refuses a length of 0
+  if ( st.st_size > 0 ) {
+    void* ptr = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( MAP_FAILED == ptr ) {
+      fprintf( stderr, "ERROR: could not mmap file %s\n", file_name );
+      close( fd );
+      return false;
+    }
+    // the loaders read front to back
+    madvise( ptr, (size_t)st.st_size, MADV_SEQUENTIAL );
+    mf->data      = (const char*)ptr;
+    mf->sz        = (size_t)st.st_size;
+    mf->is_mapped = true;
+  }
+  // the mapping keeps its own reference to the file
+  close( fd );
+  return true;
+}
+
+void unmap_file( mapped_file* mf ) {
+  if ( mf->is_mapped ) { munmap( (void*)mf->data, mf->sz ); }
+  memset( mf, 0, sizeof( mapped_file ) );
+}
+#endif
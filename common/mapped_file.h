@@ -0,0 +1,27 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Read-only whole-file access for the loaders. Uses mmap() on Linux/OS X, so   |
+| big files aren't copied into the heap. On Windows the file is read into one  |
+| malloc'd buffer instead. Either way "data" is NOT null-terminated.           |
+\******************************************************************************/
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <stddef.h>
+
+struct mapped_file {
+  const char* data;
+  size_t sz;
+  bool is_mapped; // false if data is a malloc'd copy
+};
+
+/* on failure prints to stderr and returns false. an empty file is valid and
+gives data == NULL, sz == 0 */
+bool map_file( const char* file_name, mapped_file* mf );
+void unmap_file( mapped_file* mf );
+
+#endif
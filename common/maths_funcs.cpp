@@ -7,119 +7,115 @@
 | See individual libraries' separate legal notices                             |
 |******************************************************************************|
 | Commonly-used maths structures and functions                                 |
-| Simple-as-possible. No templates. Not optimised.                             |
+| Simple-as-possible. No templates. The mat4 products use SSE2/AVX when the    |
+| compiler targets them, otherwise the plain scalar loops are used.            |
 | Structs vec3, mat4, versor. just hold arrays of floats called "v","m","q",   |
 | respectively. So, for example, to get values from a mat4 do: my_mat.m        |
 | A versor is the proper name for a unit quaternion.                           |
 \******************************************************************************/
 #include "maths_funcs.h"
 #include <stdio.h>
+#include <stdlib.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#if defined( MATHS_USE_AVX )
+#include <immintrin.h>
+#elif defined( MATHS_USE_SSE2 )
+#include <emmintrin.h>
+#endif
+#if !defined( MATHS_NO_THREADS )
+#include <thread>
+#endif
+
+MATHS_INLINE const char* maths_simd_path() {
+#if defined( MATHS_USE_AVX )
+  return "avx";
+#elif defined( MATHS_USE_SSE2 )
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
 
 /*--------------------------------CONSTRUCTORS--------------------------------*/
-vec2::vec2() {}
+MATHS_INLINE vec2::vec2() {}
 
-vec2::vec2( float x, float y ) {
+MATHS_INLINE vec2::vec2( float x, float y ) {
   v[0] = x;
   v[1] = y;
 }
 
-vec3::vec3() {}
+MATHS_INLINE vec3::vec3() {}
 
-vec3::vec3( float x, float y, float z ) {
+MATHS_INLINE vec3::vec3( float x, float y, float z ) {
   v[0] = x;
   v[1] = y;
   v[2] = z;
 }
 
-vec3::vec3( const vec2& vv, float z ) {
+MATHS_INLINE vec3::vec3( const vec2& vv, float z ) {
   v[0] = vv.v[0];
   v[1] = vv.v[1];
   v[2] = z;
 }
 
-vec3::vec3( const vec4& vv ) {
+MATHS_INLINE vec3::vec3( const vec4& vv ) {
   v[0] = vv.v[0];
   v[1] = vv.v[1];
   v[2] = vv.v[2];
 }
 
-vec4::vec4() {}
+MATHS_INLINE vec4::vec4() {}
 
-vec4::vec4( float x, float y, float z, float w ) {
+MATHS_INLINE vec4::vec4( float x, float y, float z, float w ) {
   v[0] = x;
   v[1] = y;
   v[2] = z;
   v[3] = w;
 }
 
-vec4::vec4( const vec2& vv, float z, float w ) {
+MATHS_INLINE vec4::vec4( const vec2& vv, float z, float w ) {
   v[0] = vv.v[0];
   v[1] = vv.v[1];
   v[2] = z;
   v[3] = w;
 }
 
-vec4::vec4( const vec3& vv, float w ) {
+MATHS_INLINE vec4::vec4( const vec3& vv, float w ) {
   v[0] = vv.v[0];
   v[1] = vv.v[1];
   v[2] = vv.v[2];
   v[3] = w;
 }
 
-mat3::mat3() {}
+MATHS_INLINE vec3_soa::vec3_soa() : x( NULL ), y( NULL ), z( NULL ), n( 0 ) {}
+
+MATHS_INLINE mat3::mat3() {}
 
 /* note: entered in COLUMNS */
-mat3::mat3( float a, float b, float c, float d, float e, float f, float g, float h, float i ) {
-  m[0] = a;
-  m[1] = b;
-  m[2] = c;
-  m[3] = d;
-  m[4] = e;
-  m[5] = f;
-  m[6] = g;
-  m[7] = h;
-  m[8] = i;
-}
+MATHS_CONSTEXPR mat3::mat3( float a, float b, float c, float d, float e, float f, float g, float h, float i ) : m{ a, b, c, d, e, f, g, h, i } {}
 
-mat4::mat4() {}
+MATHS_INLINE mat4::mat4() {}
 
 /* note: entered in COLUMNS */
-mat4::mat4( float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float mm, float n, float o, float p ) {
-  m[0]  = a;
-  m[1]  = b;
-  m[2]  = c;
-  m[3]  = d;
-  m[4]  = e;
-  m[5]  = f;
-  m[6]  = g;
-  m[7]  = h;
-  m[8]  = i;
-  m[9]  = j;
-  m[10] = k;
-  m[11] = l;
-  m[12] = mm;
-  m[13] = n;
-  m[14] = o;
-  m[15] = p;
-}
+MATHS_CONSTEXPR mat4::mat4( float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float mm, float n, float o, float p )
+  : m{ a, b, c, d, e, f, g, h, i, j, k, l, mm, n, o, p } {}
 
 /*-----------------------------PRINT FUNCTIONS--------------------------------*/
-void print( const vec2& v ) { printf( "[%.2f, %.2f]\n", v.v[0], v.v[1] ); }
+MATHS_INLINE void print( const vec2& v ) { printf( "[%.2f, %.2f]\n", v.v[0], v.v[1] ); }
 
-void print( const vec3& v ) { printf( "[%.2f, %.2f, %.2f]\n", v.v[0], v.v[1], v.v[2] ); }
+MATHS_INLINE void print( const vec3& v ) { printf( "[%.2f, %.2f, %.2f]\n", v.v[0], v.v[1], v.v[2] ); }
 
-void print( const vec4& v ) { printf( "[%.2f, %.2f, %.2f, %.2f]\n", v.v[0], v.v[1], v.v[2], v.v[3] ); }
+MATHS_INLINE void print( const vec4& v ) { printf( "[%.2f, %.2f, %.2f, %.2f]\n", v.v[0], v.v[1], v.v[2], v.v[3] ); }
 
-void print( const mat3& m ) {
+MATHS_INLINE void print( const mat3& m ) {
   printf( "\n" );
   printf( "[%.2f][%.2f][%.2f]\n", m.m[0], m.m[3], m.m[6] );
   printf( "[%.2f][%.2f][%.2f]\n", m.m[1], m.m[4], m.m[7] );
   printf( "[%.2f][%.2f][%.2f]\n", m.m[2], m.m[5], m.m[8] );
 }
 
-void print( const mat4& m ) {
+MATHS_INLINE void print( const mat4& m ) {
   printf( "\n" );
   printf( "[%.2f][%.2f][%.2f][%.2f]\n", m.m[0], m.m[4], m.m[8], m.m[12] );
   printf( "[%.2f][%.2f][%.2f][%.2f]\n", m.m[1], m.m[5], m.m[9], m.m[13] );
@@ -128,13 +124,13 @@ void print( const mat4& m ) {
 }
 
 /*------------------------------VECTOR FUNCTIONS------------------------------*/
-float length( const vec3& v ) { return sqrt( v.v[0] * v.v[0] + v.v[1] * v.v[1] + v.v[2] * v.v[2] ); }
+MATHS_INLINE float length( const vec3& v ) { return sqrt( v.v[0] * v.v[0] + v.v[1] * v.v[1] + v.v[2] * v.v[2] ); }
 
 // squared length
-float length2( const vec3& v ) { return v.v[0] * v.v[0] + v.v[1] * v.v[1] + v.v[2] * v.v[2]; }
+MATHS_INLINE float length2( const vec3& v ) { return v.v[0] * v.v[0] + v.v[1] * v.v[1] + v.v[2] * v.v[2]; }
 
 // note: proper spelling (hehe)
-vec3 normalise( const vec3& v ) {
+MATHS_INLINE vec3 normalise( const vec3& v ) {
   vec3 vb;
   float l = length( v );
   if ( 0.0f == l ) { return vec3( 0.0f, 0.0f, 0.0f ); }
@@ -144,7 +140,7 @@ vec3 normalise( const vec3& v ) {
   return vb;
 }
 
-vec3 vec3::operator+( const vec3& rhs ) {
+MATHS_INLINE vec3 vec3::operator+( const vec3& rhs ) {
   vec3 vc;
   vc.v[0] = v[0] + rhs.v[0];
   vc.v[1] = v[1] + rhs.v[1];
@@ -152,14 +148,14 @@ vec3 vec3::operator+( const vec3& rhs ) {
   return vc;
 }
 
-vec3& vec3::operator+=( const vec3& rhs ) {
+MATHS_INLINE vec3& vec3::operator+=( const vec3& rhs ) {
   v[0] += rhs.v[0];
   v[1] += rhs.v[1];
   v[2] += rhs.v[2];
   return *this; // return self
 }
 
-vec3 vec3::operator-( const vec3& rhs ) {
+MATHS_INLINE vec3 vec3::operator-( const vec3& rhs ) {
   vec3 vc;
   vc.v[0] = v[0] - rhs.v[0];
   vc.v[1] = v[1] - rhs.v[1];
@@ -167,14 +163,14 @@ vec3 vec3::operator-( const vec3& rhs ) {
   return vc;
 }
 
-vec3& vec3::operator-=( const vec3& rhs ) {
+MATHS_INLINE vec3& vec3::operator-=( const vec3& rhs ) {
   v[0] -= rhs.v[0];
   v[1] -= rhs.v[1];
   v[2] -= rhs.v[2];
   return *this;
 }
 
-vec3 vec3::operator+( float rhs ) {
+MATHS_INLINE vec3 vec3::operator+( float rhs ) {
   vec3 vc;
   vc.v[0] = v[0] + rhs;
   vc.v[1] = v[1] + rhs;
@@ -182,7 +178,7 @@ vec3 vec3::operator+( float rhs ) {
   return vc;
 }
 
-vec3 vec3::operator-( float rhs ) {
+MATHS_INLINE vec3 vec3::operator-( float rhs ) {
   vec3 vc;
   vc.v[0] = v[0] - rhs;
   vc.v[1] = v[1] - rhs;
@@ -190,7 +186,7 @@ vec3 vec3::operator-( float rhs ) {
   return vc;
 }
 
-vec3 vec3::operator*( float rhs ) {
+MATHS_INLINE vec3 vec3::operator*( float rhs ) {
   vec3 vc;
   vc.v[0] = v[0] * rhs;
   vc.v[1] = v[1] * rhs;
@@ -198,7 +194,7 @@ vec3 vec3::operator*( float rhs ) {
   return vc;
 }
 
-vec3 vec3::operator/( float rhs ) {
+MATHS_INLINE vec3 vec3::operator/( float rhs ) {
   vec3 vc;
   vc.v[0] = v[0] / rhs;
   vc.v[1] = v[1] / rhs;
@@ -206,30 +202,30 @@ vec3 vec3::operator/( float rhs ) {
   return vc;
 }
 
-vec3& vec3::operator*=( float rhs ) {
+MATHS_INLINE vec3& vec3::operator*=( float rhs ) {
   v[0] = v[0] * rhs;
   v[1] = v[1] * rhs;
   v[2] = v[2] * rhs;
   return *this;
 }
 
-vec3& vec3::operator=( const vec3& rhs ) {
+MATHS_INLINE vec3& vec3::operator=( const vec3& rhs ) {
   v[0] = rhs.v[0];
   v[1] = rhs.v[1];
   v[2] = rhs.v[2];
   return *this;
 }
 
-float dot( const vec3& a, const vec3& b ) { return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]; }
+MATHS_INLINE float dot( const vec3& a, const vec3& b ) { return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]; }
 
-vec3 cross( const vec3& a, const vec3& b ) {
+MATHS_INLINE vec3 cross( const vec3& a, const vec3& b ) {
   float x = a.v[1] * b.v[2] - a.v[2] * b.v[1];
   float y = a.v[2] * b.v[0] - a.v[0] * b.v[2];
   float z = a.v[0] * b.v[1] - a.v[1] * b.v[0];
   return vec3( x, y, z );
 }
 
-float get_squared_dist( vec3 from, vec3 to ) {
+MATHS_INLINE float get_squared_dist( vec3 from, vec3 to ) {
   float x = ( to.v[0] - from.v[0] ) * ( to.v[0] - from.v[0] );
   float y = ( to.v[1] - from.v[1] ) * ( to.v[1] - from.v[1] );
   float z = ( to.v[2] - from.v[2] ) * ( to.v[2] - from.v[2] );
@@ -239,21 +235,21 @@ float get_squared_dist( vec3 from, vec3 to ) {
 /* converts an un-normalised direction into a heading in degrees
 NB i suspect that the z is backwards here but i've used in in
 several places like this. d'oh! */
-float direction_to_heading( vec3 d ) { return atan2( -d.v[0], -d.v[2] ) * ONE_RAD_IN_DEG; }
+MATHS_INLINE float direction_to_heading( vec3 d ) { return atan2( -d.v[0], -d.v[2] ) * ONE_RAD_IN_DEG; }
 
-vec3 heading_to_direction( float degrees ) {
+MATHS_INLINE vec3 heading_to_direction( float degrees ) {
   float rad = degrees * ONE_DEG_IN_RAD;
   return vec3( -sinf( rad ), 0.0f, -cosf( rad ) );
 }
 
 /*-----------------------------MATRIX FUNCTIONS-------------------------------*/
-mat3 zero_mat3() { return mat3( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ); }
+MATHS_CONSTEXPR mat3 zero_mat3() { return mat3( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ); }
 
-mat3 identity_mat3() { return mat3( 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f ); }
+MATHS_CONSTEXPR mat3 identity_mat3() { return mat3( 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f ); }
 
-mat4 zero_mat4() { return mat4( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ); }
+MATHS_CONSTEXPR mat4 zero_mat4() { return mat4( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f ); }
 
-mat4 identity_mat4() { return mat4( 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f ); }
+MATHS_CONSTEXPR mat4 identity_mat4() { return mat4( 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f ); }
 
 /* mat4 array layout
  0  4  8 12
@@ -262,7 +258,22 @@ mat4 identity_mat4() { return mat4( 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.
  3  7 11 15
 */
 
-vec4 mat4::operator*( const vec4& rhs ) {
+/* the SIMD versions below do the same multiplies and adds, in the same order,
+as the scalar code so results are bit-for-bit identical. no FMA is used since
+fusing would change the rounding. NB: this only holds if the scalar build isn't
+itself contracted into FMAs - with -mfma or -march=native, also pass
+-ffp-contract=off, as common/CMakeLists.txt does */
+MATHS_INLINE vec4 mat4::operator*( const vec4& rhs ) {
+#if defined( MATHS_USE_SSE2 )
+  // sum of the matrix columns each scaled by one component of the vector
+  __m128 r = _mm_mul_ps( _mm_loadu_ps( &m[0] ), _mm_set1_ps( rhs.v[0] ) );
+  r        = _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &m[4] ), _mm_set1_ps( rhs.v[1] ) ) );
+  r        = _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &m[8] ), _mm_set1_ps( rhs.v[2] ) ) );
+  r        = _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &m[12] ), _mm_set1_ps( rhs.v[3] ) ) );
+  vec4 result;
+  _mm_storeu_ps( result.v, r );
+  return result;
+#else
   // 0x + 4y + 8z + 12w
   float x = m[0] * rhs.v[0] + m[4] * rhs.v[1] + m[8] * rhs.v[2] + m[12] * rhs.v[3];
   // 1x + 5y + 9z + 13w
@@ -272,9 +283,45 @@ vec4 mat4::operator*( const vec4& rhs ) {
   // 3x + 7y + 11z + 15w
   float w = m[3] * rhs.v[0] + m[7] * rhs.v[1] + m[11] * rhs.v[2] + m[15] * rhs.v[3];
   return vec4( x, y, z, w );
+#endif
 }
 
-mat4 mat4::operator*( const mat4& rhs ) {
+MATHS_INLINE mat4 mat4::operator*( const mat4& rhs ) {
+#if defined( MATHS_USE_AVX )
+  // two result columns per 256-bit register. each lane pair holds a copy of one of our columns
+  __m256 c0 = _mm256_broadcast_ps( (const __m128*)&m[0] );
+  __m256 c1 = _mm256_broadcast_ps( (const __m128*)&m[4] );
+  __m256 c2 = _mm256_broadcast_ps( (const __m128*)&m[8] );
+  __m256 c3 = _mm256_broadcast_ps( (const __m128*)&m[12] );
+  mat4 r;
+  for ( int col = 0; col < 4; col += 2 ) {
+    __m256 b = _mm256_loadu_ps( &rhs.m[col * 4] );
+    // start from +0 like the scalar sum so a -0 product comes out as +0 too
+    __m256 s = _mm256_add_ps( _mm256_setzero_ps(), _mm256_mul_ps( c0, _mm256_shuffle_ps( b, b, 0x00 ) ) );
+    s        = _mm256_add_ps( s, _mm256_mul_ps( c1, _mm256_shuffle_ps( b, b, 0x55 ) ) );
+    s        = _mm256_add_ps( s, _mm256_mul_ps( c2, _mm256_shuffle_ps( b, b, 0xAA ) ) );
+    s        = _mm256_add_ps( s, _mm256_mul_ps( c3, _mm256_shuffle_ps( b, b, 0xFF ) ) );
+    _mm256_storeu_ps( &r.m[col * 4], s );
+  }
+  return r;
+#elif defined( MATHS_USE_SSE2 )
+  __m128 c0 = _mm_loadu_ps( &m[0] );
+  __m128 c1 = _mm_loadu_ps( &m[4] );
+  __m128 c2 = _mm_loadu_ps( &m[8] );
+  __m128 c3 = _mm_loadu_ps( &m[12] );
+  mat4 r;
+  for ( int col = 0; col < 4; col++ ) {
+    // one load per rhs column then splat each lane, rather than 4 scalar loads
+    __m128 b = _mm_loadu_ps( &rhs.m[col * 4] );
+    // start from +0 like the scalar sum so a -0 product comes out as +0 too
+    __m128 s = _mm_add_ps( _mm_setzero_ps(), _mm_mul_ps( c0, _mm_shuffle_ps( b, b, 0x00 ) ) );
+    s        = _mm_add_ps( s, _mm_mul_ps( c1, _mm_shuffle_ps( b, b, 0x55 ) ) );
+    s        = _mm_add_ps( s, _mm_mul_ps( c2, _mm_shuffle_ps( b, b, 0xAA ) ) );
+    s        = _mm_add_ps( s, _mm_mul_ps( c3, _mm_shuffle_ps( b, b, 0xFF ) ) );
+    _mm_storeu_ps( &r.m[col * 4], s );
+  }
+  return r;
+#else
   mat4 r      = zero_mat4();
   int r_index = 0;
   for ( int col = 0; col < 4; col++ ) {
@@ -286,9 +333,10 @@ mat4 mat4::operator*( const mat4& rhs ) {
     }
   }
   return r;
+#endif
 }
 
-mat4& mat4::operator=( const mat4& rhs ) {
+MATHS_INLINE mat4& mat4::operator=( const mat4& rhs ) {
   for ( int i = 0; i < 16; i++ ) { m[i] = rhs.m[i]; }
   return *this;
 }
@@ -296,7 +344,7 @@ mat4& mat4::operator=( const mat4& rhs ) {
 // returns a scalar value with the determinant for a 4x4 matrix
 // see
 // http://www.euclideanspace.com/maths/algebra/matrix/functions/determinant/fourD/index.htm
-float determinant( const mat4& mm ) {
+MATHS_INLINE float determinant( const mat4& mm ) {
   return mm.m[12] * mm.m[9] * mm.m[6] * mm.m[3] - mm.m[8] * mm.m[13] * mm.m[6] * mm.m[3] - mm.m[12] * mm.m[5] * mm.m[10] * mm.m[3] + mm.m[4] * mm.m[13] * mm.m[10] * mm.m[3] +
          mm.m[8] * mm.m[5] * mm.m[14] * mm.m[3] - mm.m[4] * mm.m[9] * mm.m[14] * mm.m[3] - mm.m[12] * mm.m[9] * mm.m[2] * mm.m[7] + mm.m[8] * mm.m[13] * mm.m[2] * mm.m[7] +
          mm.m[12] * mm.m[1] * mm.m[10] * mm.m[7] - mm.m[0] * mm.m[13] * mm.m[10] * mm.m[7] - mm.m[8] * mm.m[1] * mm.m[14] * mm.m[7] + mm.m[0] * mm.m[9] * mm.m[14] * mm.m[7] +
@@ -309,7 +357,7 @@ float determinant( const mat4& mm ) {
 matrix). see
 http://www.euclideanspace.com/maths/algebra/matrix/functions/inverse/fourD/index.htm
 */
-mat4 inverse( const mat4& mm ) {
+MATHS_INLINE mat4 inverse( const mat4& mm ) {
   float det = determinant( mm );
   /* there is no inverse if determinant is zero (not likely unless scale is
   broken) */
@@ -338,14 +386,61 @@ mat4 inverse( const mat4& mm ) {
     inv_det * ( mm.m[4] * mm.m[9] * mm.m[2] - mm.m[8] * mm.m[5] * mm.m[2] + mm.m[8] * mm.m[1] * mm.m[6] - mm.m[0] * mm.m[9] * mm.m[6] - mm.m[4] * mm.m[1] * mm.m[10] + mm.m[0] * mm.m[5] * mm.m[10] ) );
 }
 
+/* inverse of [A t] where A is the upper 3x3 and t the translation is
+[A^-1 -A^-1*t]. A^-1 is the rows cross(c1,c2), cross(c2,c0), cross(c0,c1) of
+A's columns c0..c2, over the determinant */
+MATHS_INLINE mat4 inverse_affine( const mat4& mm ) {
+  vec3 c0( mm.m[0], mm.m[1], mm.m[2] );
+  vec3 c1( mm.m[4], mm.m[5], mm.m[6] );
+  vec3 c2( mm.m[8], mm.m[9], mm.m[10] );
+  vec3 t( mm.m[12], mm.m[13], mm.m[14] );
+  vec3 r0   = cross( c1, c2 );
+  vec3 r1   = cross( c2, c0 );
+  vec3 r2   = cross( c0, c1 );
+  float det = dot( c0, r0 );
+  if ( 0.0f == det ) {
+    fprintf( stderr, "WARNING. matrix has no determinant. can not invert\n" );
+    return mm;
+  }
+  float inv_det = 1.0f / det;
+  r0 *= inv_det;
+  r1 *= inv_det;
+  r2 *= inv_det;
+  return mat4( r0.v[0], r1.v[0], r2.v[0], 0.0f, r0.v[1], r1.v[1], r2.v[1], 0.0f, r0.v[2], r1.v[2], r2.v[2], 0.0f, -dot( r0, t ), -dot( r1, t ), -dot( r2, t ), 1.0f );
+}
+
+// as above but A is a pure rotation so A^-1 is just its transpose
+MATHS_INLINE mat4 inverse_rigid( const mat4& mm ) {
+  vec3 c0( mm.m[0], mm.m[1], mm.m[2] );
+  vec3 c1( mm.m[4], mm.m[5], mm.m[6] );
+  vec3 c2( mm.m[8], mm.m[9], mm.m[10] );
+  vec3 t( mm.m[12], mm.m[13], mm.m[14] );
+  return mat4( mm.m[0], mm.m[4], mm.m[8], 0.0f, mm.m[1], mm.m[5], mm.m[9], 0.0f, mm.m[2], mm.m[6], mm.m[10], 0.0f, -dot( c0, t ), -dot( c1, t ), -dot( c2, t ), 1.0f );
+}
+
+MATHS_INLINE mat4 inverse_auto( const mat4& mm ) {
+  // matrices from translate/rotate/scale have exactly these values here
+  if ( mm.m[3] != 0.0f || mm.m[7] != 0.0f || mm.m[11] != 0.0f || mm.m[15] != 1.0f ) { return inverse( mm ); }
+  // rigid if the columns are unit length and at right angles to each other
+  vec3 c0( mm.m[0], mm.m[1], mm.m[2] );
+  vec3 c1( mm.m[4], mm.m[5], mm.m[6] );
+  vec3 c2( mm.m[8], mm.m[9], mm.m[10] );
+  const float thresh = 0.00001f;
+  if ( fabs( length2( c0 ) - 1.0f ) < thresh && fabs( length2( c1 ) - 1.0f ) < thresh && fabs( length2( c2 ) - 1.0f ) < thresh && fabs( dot( c0, c1 ) ) < thresh &&
+       fabs( dot( c0, c2 ) ) < thresh && fabs( dot( c1, c2 ) ) < thresh ) {
+    return inverse_rigid( mm );
+  }
+  return inverse_affine( mm );
+}
+
 // returns a 16-element array flipped on the main diagonal
-mat4 transpose( const mat4& mm ) {
+MATHS_INLINE mat4 transpose( const mat4& mm ) {
   return mat4( mm.m[0], mm.m[4], mm.m[8], mm.m[12], mm.m[1], mm.m[5], mm.m[9], mm.m[13], mm.m[2], mm.m[6], mm.m[10], mm.m[14], mm.m[3], mm.m[7], mm.m[11], mm.m[15] );
 }
 
 /*--------------------------AFFINE MATRIX FUNCTIONS---------------------------*/
 // translate a 4d matrix with xyz array
-mat4 translate( const mat4& m, const vec3& v ) {
+MATHS_INLINE mat4 translate( const mat4& m, const vec3& v ) {
   mat4 m_t  = identity_mat4();
   m_t.m[12] = v.v[0];
   m_t.m[13] = v.v[1];
@@ -354,7 +449,7 @@ mat4 translate( const mat4& m, const vec3& v ) {
 }
 
 // rotate around x axis by an angle in degrees
-mat4 rotate_x_deg( const mat4& m, float deg ) {
+MATHS_INLINE mat4 rotate_x_deg( const mat4& m, float deg ) {
   // convert to radians
   float rad = deg * ONE_DEG_IN_RAD;
   mat4 m_r  = identity_mat4();
@@ -366,7 +461,7 @@ mat4 rotate_x_deg( const mat4& m, float deg ) {
 }
 
 // rotate around y axis by an angle in degrees
-mat4 rotate_y_deg( const mat4& m, float deg ) {
+MATHS_INLINE mat4 rotate_y_deg( const mat4& m, float deg ) {
   // convert to radians
   float rad = deg * ONE_DEG_IN_RAD;
   mat4 m_r  = identity_mat4();
@@ -378,7 +473,7 @@ mat4 rotate_y_deg( const mat4& m, float deg ) {
 }
 
 // rotate around z axis by an angle in degrees
-mat4 rotate_z_deg( const mat4& m, float deg ) {
+MATHS_INLINE mat4 rotate_z_deg( const mat4& m, float deg ) {
   // convert to radians
   float rad = deg * ONE_DEG_IN_RAD;
   mat4 m_r  = identity_mat4();
@@ -390,7 +485,7 @@ mat4 rotate_z_deg( const mat4& m, float deg ) {
 }
 
 // scale a matrix by [x, y, z]
-mat4 scale( const mat4& m, const vec3& v ) {
+MATHS_INLINE mat4 scale( const mat4& m, const vec3& v ) {
   mat4 a  = identity_mat4();
   a.m[0]  = v.v[0];
   a.m[5]  = v.v[1];
@@ -400,7 +495,7 @@ mat4 scale( const mat4& m, const vec3& v ) {
 
 /*-----------------------VIRTUAL CAMERA MATRIX FUNCTIONS----------------------*/
 // returns a view matrix using the opengl lookAt style. COLUMN ORDER.
-mat4 look_at( const vec3& cam_pos, vec3 targ_pos, const vec3& up ) {
+MATHS_INLINE mat4 look_at( const vec3& cam_pos, vec3 targ_pos, const vec3& up ) {
   // inverse translation
   mat4 p = identity_mat4();
   p      = translate( p, vec3( -cam_pos.v[0], -cam_pos.v[1], -cam_pos.v[2] ) );
@@ -427,7 +522,7 @@ mat4 look_at( const vec3& cam_pos, vec3 targ_pos, const vec3& up ) {
 }
 
 // returns a perspective function mimicking the opengl projection style.
-mat4 perspective( float fovy, float aspect, float near, float far ) {
+MATHS_INLINE mat4 perspective( float fovy, float aspect, float near, float far ) {
   float fov_rad       = fovy * ONE_DEG_IN_RAD;
   float inverse_range = 1.0f / tan( fov_rad / 2.0f );
   float sx            = inverse_range / aspect;
@@ -443,10 +538,304 @@ mat4 perspective( float fovy, float aspect, float near, float far ) {
   return m;
 }
 
+/*-------------------------------BATCH FUNCTIONS------------------------------*/
+// signature shared by the per-range kernels so they can be split across threads
+typedef void ( *batch_kernel )( const mat4& m, const float* in, float* out, size_t n, size_t stride );
+
+/* w is 1 for points and 0 for normals. each element is computed with the same
+operations, in the same order, as mat4 * vec4 so results match it */
+static void transform_range( const mat4& m, const float* in, float* out, size_t n, size_t stride, bool w_is_one ) {
+#if defined( MATHS_USE_SSE2 )
+  __m128 c0 = _mm_loadu_ps( &m.m[0] );
+  __m128 c1 = _mm_loadu_ps( &m.m[4] );
+  __m128 c2 = _mm_loadu_ps( &m.m[8] );
+  __m128 c3 = w_is_one ? _mm_loadu_ps( &m.m[12] ) : _mm_setzero_ps();
+  for ( size_t i = 0; i < n; i++ ) {
+    const float* p = &in[i * stride];
+    __m128 r       = _mm_mul_ps( c0, _mm_set1_ps( p[0] ) );
+    r              = _mm_add_ps( r, _mm_mul_ps( c1, _mm_set1_ps( p[1] ) ) );
+    r              = _mm_add_ps( r, _mm_mul_ps( c2, _mm_set1_ps( p[2] ) ) );
+    r              = _mm_add_ps( r, c3 );
+    // only write x,y,z - a 4-wide store would stomp on the next element
+    float* o = &out[i * stride];
+    _mm_storel_pi( (__m64*)o, r );
+    _mm_store_ss( &o[2], _mm_movehl_ps( r, r ) );
+  }
+#else
+  float w = w_is_one ? 1.0f : 0.0f;
+  for ( size_t i = 0; i < n; i++ ) {
+    const float* p = &in[i * stride];
+    float x        = m.m[0] * p[0] + m.m[4] * p[1] + m.m[8] * p[2] + m.m[12] * w;
+    float y        = m.m[1] * p[0] + m.m[5] * p[1] + m.m[9] * p[2] + m.m[13] * w;
+    float z        = m.m[2] * p[0] + m.m[6] * p[1] + m.m[10] * p[2] + m.m[14] * w;
+    float* o       = &out[i * stride];
+    o[0]           = x;
+    o[1]           = y;
+    o[2]           = z;
+  }
+#endif
+}
+
+static void transform_points_range( const mat4& m, const float* in, float* out, size_t n, size_t stride ) { transform_range( m, in, out, n, stride, true ); }
+
+static void transform_normals_range( const mat4& m, const float* in, float* out, size_t n, size_t stride ) { transform_range( m, in, out, n, stride, false ); }
+
+// runs kernel over n elements, in contiguous chunks on several threads if n is big enough
+static void run_batch( batch_kernel kernel, const mat4& m, const float* in, float* out, size_t n, size_t stride ) {
+  if ( 0 == stride ) { stride = 3; }
+#if !defined( MATHS_NO_THREADS )
+  const int max_threads = 64;
+  int n_threads         = (int)std::thread::hardware_concurrency();
+  if ( n_threads > max_threads ) { n_threads = max_threads; }
+  if ( n >= MATHS_BATCH_THREAD_MIN && n_threads > 1 ) {
+    std::thread threads[max_threads];
+    size_t chunk = n / n_threads;
+    // this thread does the last chunk, plus any remainder, itself
+    for ( int t = 0; t < n_threads - 1; t++ ) {
+      size_t first = t * chunk;
+      threads[t]   = std::thread( kernel, std::cref( m ), in + first * stride, out + first * stride, chunk, stride );
+    }
+    size_t first = ( n_threads - 1 ) * chunk;
+    kernel( m, in + first * stride, out + first * stride, n - first, stride );
+    for ( int t = 0; t < n_threads - 1; t++ ) { threads[t].join(); }
+    return;
+  }
+#endif
+  kernel( m, in, out, n, stride );
+}
+
+MATHS_INLINE void transform_points( const mat4& m, const float* in, float* out, size_t n, size_t stride ) { run_batch( transform_points_range, m, in, out, n, stride ); }
+
+MATHS_INLINE void transform_normals( const mat4& m, const float* in, float* out, size_t n, size_t stride ) { run_batch( transform_normals_range, m, in, out, n, stride ); }
+
+/*------------------------STRUCTURE-OF-ARRAYS FUNCTIONS-----------------------*/
+/* the SIMD loops do 4 vectors at a time and then finish any left-over ones
+with the scalar code. both do the same operations as the single-vec3 versions
+of the functions so give the same results */
+
+MATHS_INLINE bool vec3_soa_alloc( vec3_soa& s, size_t n ) {
+  // one block for all 3 arrays
+  float* block = (float*)malloc( 3 * n * sizeof( float ) );
+  if ( !block && n > 0 ) {
+    fprintf( stderr, "ERROR: could not allocate vec3_soa of %u elements\n", (unsigned int)n );
+    return false;
+  }
+  s.x = block;
+  s.y = block + n;
+  s.z = block + 2 * n;
+  s.n = n;
+  return true;
+}
+
+MATHS_INLINE void vec3_soa_free( vec3_soa& s ) {
+  free( s.x );
+  s = vec3_soa();
+}
+
+MATHS_INLINE void vec3_soa_from_interleaved( const float* in, size_t stride, vec3_soa& out ) {
+  if ( 0 == stride ) { stride = 3; }
+  for ( size_t i = 0; i < out.n; i++ ) {
+    out.x[i] = in[i * stride];
+    out.y[i] = in[i * stride + 1];
+    out.z[i] = in[i * stride + 2];
+  }
+}
+
+MATHS_INLINE void vec3_soa_to_interleaved( const vec3_soa& in, float* out, size_t stride ) {
+  if ( 0 == stride ) { stride = 3; }
+  for ( size_t i = 0; i < in.n; i++ ) {
+    out[i * stride]     = in.x[i];
+    out[i * stride + 1] = in.y[i];
+    out[i * stride + 2] = in.z[i];
+  }
+}
+
+MATHS_INLINE void dot( const vec3_soa& a, const vec3_soa& b, float* out ) {
+  size_t i = 0;
+#if defined( MATHS_USE_SSE2 )
+  for ( ; i + 4 <= a.n; i += 4 ) {
+    __m128 d = _mm_mul_ps( _mm_loadu_ps( &a.x[i] ), _mm_loadu_ps( &b.x[i] ) );
+    d        = _mm_add_ps( d, _mm_mul_ps( _mm_loadu_ps( &a.y[i] ), _mm_loadu_ps( &b.y[i] ) ) );
+    d        = _mm_add_ps( d, _mm_mul_ps( _mm_loadu_ps( &a.z[i] ), _mm_loadu_ps( &b.z[i] ) ) );
+    _mm_storeu_ps( &out[i], d );
+  }
+#endif
+  for ( ; i < a.n; i++ ) { out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i]; }
+}
+
+MATHS_INLINE void cross( const vec3_soa& a, const vec3_soa& b, vec3_soa& out ) {
+  size_t i = 0;
+#if defined( MATHS_USE_SSE2 )
+  for ( ; i + 4 <= a.n; i += 4 ) {
+    __m128 ax = _mm_loadu_ps( &a.x[i] ), ay = _mm_loadu_ps( &a.y[i] ), az = _mm_loadu_ps( &a.z[i] );
+    __m128 bx = _mm_loadu_ps( &b.x[i] ), by = _mm_loadu_ps( &b.y[i] ), bz = _mm_loadu_ps( &b.z[i] );
+    _mm_storeu_ps( &out.x[i], _mm_sub_ps( _mm_mul_ps( ay, bz ), _mm_mul_ps( az, by ) ) );
+    _mm_storeu_ps( &out.y[i], _mm_sub_ps( _mm_mul_ps( az, bx ), _mm_mul_ps( ax, bz ) ) );
+    _mm_storeu_ps( &out.z[i], _mm_sub_ps( _mm_mul_ps( ax, by ), _mm_mul_ps( ay, bx ) ) );
+  }
+#endif
+  for ( ; i < a.n; i++ ) {
+    // temporaries in case out is also a or b
+    float x  = a.y[i] * b.z[i] - a.z[i] * b.y[i];
+    float y  = a.z[i] * b.x[i] - a.x[i] * b.z[i];
+    float z  = a.x[i] * b.y[i] - a.y[i] * b.x[i];
+    out.x[i] = x;
+    out.y[i] = y;
+    out.z[i] = z;
+  }
+}
+
+MATHS_INLINE void length( const vec3_soa& a, float* out ) {
+  size_t i = 0;
+#if defined( MATHS_USE_SSE2 )
+  for ( ; i + 4 <= a.n; i += 4 ) {
+    __m128 x = _mm_loadu_ps( &a.x[i] ), y = _mm_loadu_ps( &a.y[i] ), z = _mm_loadu_ps( &a.z[i] );
+    __m128 l2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+    _mm_storeu_ps( &out[i], _mm_sqrt_ps( l2 ) );
+  }
+#endif
+  for ( ; i < a.n; i++ ) { out[i] = sqrtf( a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i] ); }
+}
+
+MATHS_INLINE void normalise( const vec3_soa& a, vec3_soa& out ) {
+  size_t i = 0;
+#if defined( MATHS_USE_SSE2 )
+  for ( ; i + 4 <= a.n; i += 4 ) {
+    __m128 x = _mm_loadu_ps( &a.x[i] ), y = _mm_loadu_ps( &a.y[i] ), z = _mm_loadu_ps( &a.z[i] );
+    __m128 l = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) ) );
+    // zero-length vectors come out as zero, not NaN
+    __m128 nonzero = _mm_cmpneq_ps( l, _mm_setzero_ps() );
+    _mm_storeu_ps( &out.x[i], _mm_and_ps( _mm_div_ps( x, l ), nonzero ) );
+    _mm_storeu_ps( &out.y[i], _mm_and_ps( _mm_div_ps( y, l ), nonzero ) );
+    _mm_storeu_ps( &out.z[i], _mm_and_ps( _mm_div_ps( z, l ), nonzero ) );
+  }
+#endif
+  for ( ; i < a.n; i++ ) {
+    float l = sqrtf( a.x[i] * a.x[i] + a.y[i] * a.y[i] + a.z[i] * a.z[i] );
+    if ( 0.0f == l ) {
+      out.x[i] = out.y[i] = out.z[i] = 0.0f;
+      continue;
+    }
+    out.x[i] = a.x[i] / l;
+    out.y[i] = a.y[i] / l;
+    out.z[i] = a.z[i] / l;
+  }
+}
+
+MATHS_INLINE void lerp( const vec3_soa& a, const vec3_soa& b, float t, vec3_soa& out ) {
+  const float* src_a[3] = { a.x, a.y, a.z };
+  const float* src_b[3] = { b.x, b.y, b.z };
+  float* dst[3]         = { out.x, out.y, out.z };
+  for ( int c = 0; c < 3; c++ ) {
+    size_t i = 0;
+#if defined( MATHS_USE_SSE2 )
+    __m128 s = _mm_set1_ps( 1.0f - t ), tt = _mm_set1_ps( t );
+    for ( ; i + 4 <= a.n; i += 4 ) {
+      __m128 r = _mm_add_ps( _mm_mul_ps( s, _mm_loadu_ps( &src_a[c][i] ) ), _mm_mul_ps( tt, _mm_loadu_ps( &src_b[c][i] ) ) );
+      _mm_storeu_ps( &dst[c][i], r );
+    }
+#endif
+    for ( ; i < a.n; i++ ) { dst[c][i] = ( 1.0f - t ) * src_a[c][i] + t * src_b[c][i]; }
+  }
+}
+
+/*-----------------------------CULLING FUNCTIONS------------------------------*/
+/* planes from the rows of the matrix, after Gribb & Hartmann "Fast Extraction
+of Viewing Frustum Planes from the World-View-Projection Matrix" */
+MATHS_INLINE frustum frustum_from_mat4( const mat4& m ) {
+  frustum f;
+  for ( int i = 0; i < 3; i++ ) {
+    for ( int c = 0; c < 4; c++ ) {
+      // row 3 + row i, and row 3 - row i
+      f.planes[i * 2][c]     = m.m[c * 4 + 3] + m.m[c * 4 + i];
+      f.planes[i * 2 + 1][c] = m.m[c * 4 + 3] - m.m[c * 4 + i];
+    }
+  }
+  for ( int p = 0; p < 6; p++ ) {
+    float l = sqrtf( f.planes[p][0] * f.planes[p][0] + f.planes[p][1] * f.planes[p][1] + f.planes[p][2] * f.planes[p][2] );
+    for ( int c = 0; c < 4; c++ ) { f.planes[p][c] /= l; }
+  }
+  return f;
+}
+
+/* write i to visible[count] regardless, but only step count on if i is visible,
+so there are no unpredictable branches. visible has room for all n anyway */
+static inline void append_if( unsigned int* visible, size_t& count, size_t i, bool is_visible ) {
+  visible[count] = (unsigned int)i;
+  count += is_visible ? 1 : 0;
+}
+
+MATHS_INLINE size_t cull_spheres( const frustum& f, const vec3_soa& centres, const float* radii, unsigned int* visible ) {
+  size_t count = 0, i = 0;
+#if defined( MATHS_USE_SSE2 )
+  for ( ; i + 4 <= centres.n; i += 4 ) {
+    __m128 x = _mm_loadu_ps( &centres.x[i] ), y = _mm_loadu_ps( &centres.y[i] ), z = _mm_loadu_ps( &centres.z[i] );
+    __m128 neg_r  = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( &radii[i] ) );
+    __m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+    for ( int p = 0; p < 6; p++ ) {
+      __m128 d = _mm_mul_ps( _mm_set1_ps( f.planes[p][0] ), x );
+      d        = _mm_add_ps( d, _mm_mul_ps( _mm_set1_ps( f.planes[p][1] ), y ) );
+      d        = _mm_add_ps( d, _mm_mul_ps( _mm_set1_ps( f.planes[p][2] ), z ) );
+      d        = _mm_add_ps( d, _mm_set1_ps( f.planes[p][3] ) );
+      inside   = _mm_and_ps( inside, _mm_cmpge_ps( d, neg_r ) );
+    }
+    int bits = _mm_movemask_ps( inside );
+    for ( int k = 0; k < 4; k++ ) { append_if( visible, count, i + k, ( bits & ( 1 << k ) ) != 0 ); }
+  }
+#endif
+  for ( ; i < centres.n; i++ ) {
+    bool inside = true;
+    for ( int p = 0; p < 6; p++ ) {
+      float d = f.planes[p][0] * centres.x[i] + f.planes[p][1] * centres.y[i] + f.planes[p][2] * centres.z[i] + f.planes[p][3];
+      inside  = inside && d >= -radii[i];
+    }
+    append_if( visible, count, i, inside );
+  }
+  return count;
+}
+
+/* an AABB is outside if its corner furthest along a plane's normal (the
+"positive vertex") is behind that plane */
+MATHS_INLINE size_t cull_aabbs( const frustum& f, const vec3_soa& mins, const vec3_soa& maxs, unsigned int* visible ) {
+  // which of min/max each plane's positive vertex uses is the same for every box
+  const float* px[6];
+  const float* py[6];
+  const float* pz[6];
+  for ( int p = 0; p < 6; p++ ) {
+    px[p] = f.planes[p][0] >= 0.0f ? maxs.x : mins.x;
+    py[p] = f.planes[p][1] >= 0.0f ? maxs.y : mins.y;
+    pz[p] = f.planes[p][2] >= 0.0f ? maxs.z : mins.z;
+  }
+  size_t count = 0, i = 0;
+#if defined( MATHS_USE_SSE2 )
+  for ( ; i + 4 <= mins.n; i += 4 ) {
+    __m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+    for ( int p = 0; p < 6; p++ ) {
+      __m128 d = _mm_mul_ps( _mm_set1_ps( f.planes[p][0] ), _mm_loadu_ps( &px[p][i] ) );
+      d        = _mm_add_ps( d, _mm_mul_ps( _mm_set1_ps( f.planes[p][1] ), _mm_loadu_ps( &py[p][i] ) ) );
+      d        = _mm_add_ps( d, _mm_mul_ps( _mm_set1_ps( f.planes[p][2] ), _mm_loadu_ps( &pz[p][i] ) ) );
+      d        = _mm_add_ps( d, _mm_set1_ps( f.planes[p][3] ) );
+      inside   = _mm_and_ps( inside, _mm_cmpge_ps( d, _mm_setzero_ps() ) );
+    }
+    int bits = _mm_movemask_ps( inside );
+    for ( int k = 0; k < 4; k++ ) { append_if( visible, count, i + k, ( bits & ( 1 << k ) ) != 0 ); }
+  }
+#endif
+  for ( ; i < mins.n; i++ ) {
+    bool inside = true;
+    for ( int p = 0; p < 6; p++ ) {
+      float d = f.planes[p][0] * px[p][i] + f.planes[p][1] * py[p][i] + f.planes[p][2] * pz[p][i] + f.planes[p][3];
+      inside  = inside && d >= 0.0f;
+    }
+    append_if( visible, count, i, inside );
+  }
+  return count;
+}
+
 /*----------------------------HAMILTON IN DA HOUSE!---------------------------*/
-versor::versor() {}
+MATHS_INLINE versor::versor() {}
 
-versor versor::operator/( float rhs ) {
+MATHS_INLINE versor versor::operator/( float rhs ) {
   versor result;
   result.q[0] = q[0] / rhs;
   result.q[1] = q[1] / rhs;
@@ -455,7 +844,7 @@ versor versor::operator/( float rhs ) {
   return result;
 }
 
-versor versor::operator*( float rhs ) {
+MATHS_INLINE versor versor::operator*( float rhs ) {
   versor result;
   result.q[0] = q[0] * rhs;
   result.q[1] = q[1] * rhs;
@@ -464,9 +853,9 @@ versor versor::operator*( float rhs ) {
   return result;
 }
 
-void print( const versor& q ) { printf( "[%.2f ,%.2f, %.2f, %.2f]\n", q.q[0], q.q[1], q.q[2], q.q[3] ); }
+MATHS_INLINE void print( const versor& q ) { printf( "[%.2f ,%.2f, %.2f, %.2f]\n", q.q[0], q.q[1], q.q[2], q.q[3] ); }
 
-versor versor::operator*( const versor& rhs ) {
+MATHS_INLINE versor versor::operator*( const versor& rhs ) {
   versor result;
   result.q[0] = rhs.q[0] * q[0] - rhs.q[1] * q[1] - rhs.q[2] * q[2] - rhs.q[3] * q[3];
   result.q[1] = rhs.q[0] * q[1] + rhs.q[1] * q[0] - rhs.q[2] * q[3] + rhs.q[3] * q[2];
@@ -476,7 +865,7 @@ versor versor::operator*( const versor& rhs ) {
   return normalise( result );
 }
 
-versor versor::operator+( const versor& rhs ) {
+MATHS_INLINE versor versor::operator+( const versor& rhs ) {
   versor result;
   result.q[0] = rhs.q[0] + q[0];
   result.q[1] = rhs.q[1] + q[1];
@@ -486,7 +875,7 @@ versor versor::operator+( const versor& rhs ) {
   return normalise( result );
 }
 
-versor quat_from_axis_rad( float radians, float x, float y, float z ) {
+MATHS_INLINE versor quat_from_axis_rad( float radians, float x, float y, float z ) {
   versor result;
   result.q[0] = cos( radians / 2.0 );
   result.q[1] = sin( radians / 2.0 ) * x;
@@ -495,9 +884,9 @@ versor quat_from_axis_rad( float radians, float x, float y, float z ) {
   return result;
 }
 
-versor quat_from_axis_deg( float degrees, float x, float y, float z ) { return quat_from_axis_rad( ONE_DEG_IN_RAD * degrees, x, y, z ); }
+MATHS_INLINE versor quat_from_axis_deg( float degrees, float x, float y, float z ) { return quat_from_axis_rad( ONE_DEG_IN_RAD * degrees, x, y, z ); }
 
-mat4 quat_to_mat4( const versor& q ) {
+MATHS_INLINE mat4 quat_to_mat4( const versor& q ) {
   float w = q.q[0];
   float x = q.q[1];
   float y = q.q[2];
@@ -506,7 +895,7 @@ mat4 quat_to_mat4( const versor& q ) {
     2.0f * y * z + 2.0f * w * x, 0.0f, 2.0f * x * z + 2.0f * w * y, 2.0f * y * z - 2.0f * w * x, 1.0f - 2.0f * x * x - 2.0f * y * y, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f );
 }
 
-versor normalise( versor& q ) {
+MATHS_INLINE versor normalise( versor& q ) {
   // norm(q) = q / magnitude (q)
   // magnitude (q) = sqrt (w*w + x*x...)
   // only compute sqrt if interior sum != 1.0
@@ -518,9 +907,11 @@ versor normalise( versor& q ) {
   return q / mag;
 }
 
-float dot( const versor& q, const versor& r ) { return q.q[0] * r.q[0] + q.q[1] * r.q[1] + q.q[2] * r.q[2] + q.q[3] * r.q[3]; }
+MATHS_INLINE float dot( const versor& q, const versor& r ) { return q.q[0] * r.q[0] + q.q[1] * r.q[1] + q.q[2] * r.q[2] + q.q[3] * r.q[3]; }
 
-versor slerp( versor& q, versor& r, float t ) {
+MATHS_INLINE versor slerp( const versor& q_in, const versor& r, float t ) {
+  // local copy as q may get negated below
+  versor q = q_in;
   // angle between q0-q1
   float cos_half_theta = dot( q, r );
   // as found here
@@ -549,3 +940,98 @@ versor slerp( versor& q, versor& r, float t ) {
   for ( int i = 0; i < 4; i++ ) { result.q[i] = q.q[i] * a + r.q[i] * b; }
   return result;
 }
+
+MATHS_INLINE versor nlerp( const versor& q, const versor& r, float t ) {
+  // same short-way-around flip as slerp
+  float a = dot( q, r ) < 0.0f ? -( 1.0f - t ) : 1.0f - t;
+  versor result;
+  for ( int i = 0; i < 4; i++ ) { result.q[i] = q.q[i] * a + r.q[i] * t; }
+  float mag = sqrtf( dot( result, result ) );
+  for ( int i = 0; i < 4; i++ ) { result.q[i] = result.q[i] / mag; }
+  return result;
+}
+
+/* nlerp with t nudged so that the speed along the arc is close to constant,
+which gets it very close to slerp without any trig. the correction polynomial
+is a fit to the slerp error over the angle between q and r, from
+https://zeux.io/2015/07/23/approximating-slerp/ */
+static float fast_slerp_t( float cos_half_theta, float t ) {
+  float d = fabsf( cos_half_theta );
+  float A = 1.0904f + d * ( -3.2452f + d * ( 3.55645f - d * 1.43519f ) );
+  float B = 0.848013f + d * ( -1.06021f + d * 0.215638f );
+  float k = A * ( t - 0.5f ) * ( t - 0.5f ) + B;
+  return t + t * ( t - 0.5f ) * ( t - 1.0f ) * k;
+}
+
+#if defined( MATHS_USE_SSE2 )
+/* 4 nlerps (or fast slerps if correct_t) at once. the versors are transposed
+so each register holds one component of all 4. same operations, in the same
+order, as the scalar code */
+static void nlerp_4_sse2( const versor* q, const versor* r, const float* t, versor* out, bool correct_t ) {
+  __m128 qw = _mm_loadu_ps( q[0].q ), qx = _mm_loadu_ps( q[1].q ), qy = _mm_loadu_ps( q[2].q ), qz = _mm_loadu_ps( q[3].q );
+  __m128 rw = _mm_loadu_ps( r[0].q ), rx = _mm_loadu_ps( r[1].q ), ry = _mm_loadu_ps( r[2].q ), rz = _mm_loadu_ps( r[3].q );
+  _MM_TRANSPOSE4_PS( qw, qx, qy, qz );
+  _MM_TRANSPOSE4_PS( rw, rx, ry, rz );
+  __m128 tt = _mm_loadu_ps( t );
+  __m128 d  = _mm_mul_ps( qw, rw );
+  d         = _mm_add_ps( d, _mm_mul_ps( qx, rx ) );
+  d         = _mm_add_ps( d, _mm_mul_ps( qy, ry ) );
+  d         = _mm_add_ps( d, _mm_mul_ps( qz, rz ) );
+  __m128 one = _mm_set1_ps( 1.0f );
+  if ( correct_t ) {
+    __m128 half = _mm_set1_ps( 0.5f );
+    __m128 ad   = _mm_andnot_ps( _mm_set1_ps( -0.0f ), d ); // fabs
+    __m128 A    = _mm_sub_ps( _mm_set1_ps( 3.55645f ), _mm_mul_ps( ad, _mm_set1_ps( 1.43519f ) ) );
+    A           = _mm_add_ps( _mm_set1_ps( -3.2452f ), _mm_mul_ps( ad, A ) );
+    A           = _mm_add_ps( _mm_set1_ps( 1.0904f ), _mm_mul_ps( ad, A ) );
+    __m128 B    = _mm_add_ps( _mm_set1_ps( -1.06021f ), _mm_mul_ps( ad, _mm_set1_ps( 0.215638f ) ) );
+    B           = _mm_add_ps( _mm_set1_ps( 0.848013f ), _mm_mul_ps( ad, B ) );
+    __m128 th   = _mm_sub_ps( tt, half );
+    __m128 k    = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( A, th ), th ), B );
+    tt          = _mm_add_ps( tt, _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( tt, th ), _mm_sub_ps( tt, one ) ), k ) );
+  }
+  // weight for q is -(1-t) if the dot product is negative, to go the short way around
+  __m128 a   = _mm_sub_ps( one, tt );
+  a          = _mm_xor_ps( a, _mm_and_ps( _mm_cmplt_ps( d, _mm_setzero_ps() ), _mm_set1_ps( -0.0f ) ) );
+  __m128 ow  = _mm_add_ps( _mm_mul_ps( qw, a ), _mm_mul_ps( rw, tt ) );
+  __m128 ox  = _mm_add_ps( _mm_mul_ps( qx, a ), _mm_mul_ps( rx, tt ) );
+  __m128 oy  = _mm_add_ps( _mm_mul_ps( qy, a ), _mm_mul_ps( ry, tt ) );
+  __m128 oz  = _mm_add_ps( _mm_mul_ps( qz, a ), _mm_mul_ps( rz, tt ) );
+  __m128 mag = _mm_mul_ps( ow, ow );
+  mag        = _mm_add_ps( mag, _mm_mul_ps( ox, ox ) );
+  mag        = _mm_add_ps( mag, _mm_mul_ps( oy, oy ) );
+  mag        = _mm_sqrt_ps( _mm_add_ps( mag, _mm_mul_ps( oz, oz ) ) );
+  ow         = _mm_div_ps( ow, mag );
+  ox         = _mm_div_ps( ox, mag );
+  oy         = _mm_div_ps( oy, mag );
+  oz         = _mm_div_ps( oz, mag );
+  _MM_TRANSPOSE4_PS( ow, ox, oy, oz );
+  _mm_storeu_ps( out[0].q, ow );
+  _mm_storeu_ps( out[1].q, ox );
+  _mm_storeu_ps( out[2].q, oy );
+  _mm_storeu_ps( out[3].q, oz );
+}
+#endif
+
+// shared by nlerp_n and the fast slerp_n
+static void nlerp_n_impl( const versor* q, const versor* r, const float* t, versor* out, size_t n, bool correct_t ) {
+  size_t first_left_over = 0;
+#if defined( MATHS_USE_SSE2 )
+  first_left_over = n - n % 4;
+  for ( size_t i = 0; i < first_left_over; i += 4 ) { nlerp_4_sse2( &q[i], &r[i], &t[i], &out[i], correct_t ); }
+#endif
+  for ( size_t i = first_left_over; i < n; i++ ) {
+    float ti = correct_t ? fast_slerp_t( dot( q[i], r[i] ), t[i] ) : t[i];
+    out[i]   = nlerp( q[i], r[i], ti );
+  }
+}
+
+MATHS_INLINE void slerp_n( const versor* q, const versor* r, const float* t, versor* out, size_t n, slerp_mode_t mode ) {
+  if ( SLERP_FAST == mode ) {
+    nlerp_n_impl( q, r, t, out, n, true );
+    return;
+  }
+  for ( size_t i = 0; i < n; i++ ) { out[i] = slerp( q[i], r[i], t[i] ); }
+}
+
+MATHS_INLINE void nlerp_n( const versor* q, const versor* r, const float* t, versor* out, size_t n ) { nlerp_n_impl( q, r, t, out, n, false ); }
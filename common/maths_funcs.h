@@ -7,7 +7,8 @@
 | See individual libraries' separate legal notices                             |
 |******************************************************************************|
 | Commonly-used maths structures and functions                                 |
-| Simple-as-possible. No templates. Not optimised.                             |
+| Simple-as-possible. No templates. The mat4 products use SSE2/AVX when the    |
+| compiler targets them, otherwise the plain scalar loops are used.            |
 | Structs vec3, mat4, versor. just hold arrays of floats called "v","m","q",   |
 | respectively. So, for example, to get values from a mat4 do: my_mat.m        |
 | A versor is the proper name for a unit quaternion.                           |
@@ -16,11 +17,53 @@
 #ifndef _MATHS_FUNCS_H_
 #define _MATHS_FUNCS_H_
 
+#include <stddef.h> // size_t for the batch functions
+
+/* header-only mode: #define MATHS_HEADER_ONLY before including this file and
+don't compile/link maths_funcs.cpp. every function then becomes inline so the
+small ones (vec3 operators, dot etc.) can be inlined into the calling loop
+without needing link-time optimisation, and zero/identity matrices become
+constexpr, so can be computed at compile time. the same code is used in both
+modes - maths_funcs.cpp is just #included at the bottom of this file. */
+#ifdef MATHS_HEADER_ONLY
+#define MATHS_INLINE inline
+#define MATHS_CONSTEXPR constexpr
+#else
+#define MATHS_INLINE
+#define MATHS_CONSTEXPR
+#endif
+
 // const used to convert degrees into radians
 #define TAU 2.0 * M_PI
 #define ONE_DEG_IN_RAD ( 2.0 * M_PI ) / 360.0 // 0.017444444
 #define ONE_RAD_IN_DEG 360.0 / ( 2.0 * M_PI ) // 57.2957795
 
+/* SIMD path is picked at compile time from the compiler's target flags.
+define MATHS_NO_SIMD to force the scalar code (e.g. to compare results).
+anything that isn't x86 (ARM/NEON included) gets the scalar code.
+bench_maths' scene transform (P * V * M * vec4 per object), gcc -O3, SSE2:
+  linked maths_funcs.cpp: scalar ~35 ns, SSE2 ~20 ns per object (~1.7x)
+  MATHS_HEADER_ONLY:      scalar ~7 ns,  SSE2 ~8 ns per object (~0.9x)
+the header-only "regression" isn't the kernel: once everything is inlined the
+compiler hoists P * V out of the loop and auto-vectorises the scalar loops
+into the same instructions as the intrinsics, so there is no scalar left to
+beat. header-only is still 2-4x faster than either linked time. */
+#if !defined( MATHS_NO_SIMD )
+#if defined( __AVX__ )
+#define MATHS_USE_AVX
+#define MATHS_USE_SSE2
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define MATHS_USE_SSE2
+#endif
+#endif
+
+/* batch functions split work over threads once there are at least this many
+elements. needs -pthread (or equivalent) when linking. define MATHS_NO_THREADS
+to always run on the calling thread instead */
+#ifndef MATHS_BATCH_THREAD_MIN
+#define MATHS_BATCH_THREAD_MIN 65536
+#endif
+
 struct vec2;
 struct vec3;
 struct vec4;
@@ -80,7 +123,7 @@ struct vec4 {
 struct mat3 {
   mat3();
   // note! this is entering components in ROW-major order
-  mat3( float a, float b, float c, float d, float e, float f, float g, float h, float i );
+  MATHS_CONSTEXPR mat3( float a, float b, float c, float d, float e, float f, float g, float h, float i );
   float m[9];
 };
 
@@ -92,13 +135,31 @@ struct mat3 {
 struct mat4 {
   mat4();
   // note! this is entering components in ROW-major order
-  mat4( float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float mm, float n, float o, float p );
+  MATHS_CONSTEXPR mat4( float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float mm, float n, float o, float p );
   vec4 operator*( const vec4& rhs );
   mat4 operator*( const mat4& rhs );
   mat4& operator=( const mat4& rhs );
   float m[16];
 };
 
+/* structure-of-arrays batch of vec3s for running one operation over many
+vectors at once. x, y, and z are separate arrays of n floats each.
+allocate with vec3_soa_alloc() and release with vec3_soa_free() */
+struct vec3_soa {
+  vec3_soa();
+  float* x;
+  float* y;
+  float* z;
+  size_t n;
+};
+
+/* 6 planes of a view frustum, in the order left, right, bottom, top, near,
+far. each plane is a,b,c,d where a*x + b*y + c*z + d is the distance from the
+plane. (a,b,c) is unit length and points into the frustum */
+struct frustum {
+  float planes[6][4];
+};
+
 struct versor {
   versor();
   versor operator/( float rhs );
@@ -108,6 +169,8 @@ struct versor {
   float q[4];
 };
 
+// name of the SIMD path compiled in: "avx", "sse2", or "scalar"
+const char* maths_simd_path();
 void print( const vec2& v );
 void print( const vec3& v );
 void print( const vec4& v );
@@ -123,12 +186,20 @@ float get_squared_dist( vec3 from, vec3 to );
 float direction_to_heading( vec3 d );
 vec3 heading_to_direction( float degrees );
 // matrix functions
-mat3 zero_mat3();
-mat3 identity_mat3();
-mat4 zero_mat4();
-mat4 identity_mat4();
+MATHS_CONSTEXPR mat3 zero_mat3();
+MATHS_CONSTEXPR mat3 identity_mat3();
+MATHS_CONSTEXPR mat4 zero_mat4();
+MATHS_CONSTEXPR mat4 identity_mat4();
 float determinant( const mat4& mm );
 mat4 inverse( const mat4& mm );
+/* faster inverses for common special cases. affine: bottom row is 0,0,0,1
+(anything built from translate/rotate/scale). rigid: affine with no scale or
+shear, i.e. only rotate and translate (view matrices from look_at, or
+inverse(R) * inverse(T)). these assume, and don't check, their case holds */
+mat4 inverse_affine( const mat4& mm );
+mat4 inverse_rigid( const mat4& mm );
+// checks which of the above cases mm is, and picks the fastest inverse that works
+mat4 inverse_auto( const mat4& mm );
 mat4 transpose( const mat4& mm );
 // affine functions
 mat4 translate( const mat4& m, const vec3& v );
@@ -139,6 +210,34 @@ mat4 scale( const mat4& m, const vec3& v );
 // camera functions
 mat4 look_at( const vec3& cam_pos, vec3 targ_pos, const vec3& up );
 mat4 perspective( float fovy, float aspect, float near, float far );
+/* batch functions. work on plain float arrays such as the ones from
+load_obj_file. each element is 3 floats (x,y,z), starting every "stride"
+floats, so interleaved vertex buffers work too. a stride of 0 means tightly
+packed (3). the same stride is used for in and out. out may be the same
+array as in */
+// out = m * (x,y,z,1). no divide by w, so use for model/view, not projection
+void transform_points( const mat4& m, const float* in, float* out, size_t n, size_t stride );
+// out = m * (x,y,z,0). not re-normalised. pass the inverse-transpose of m if it scales non-uniformly
+void transform_normals( const mat4& m, const float* in, float* out, size_t n, size_t stride );
+// structure-of-arrays functions. out arrays must hold a.n elements. out may be an input
+bool vec3_soa_alloc( vec3_soa& s, size_t n );
+void vec3_soa_free( vec3_soa& s );
+// copy n xyz elements, each starting every "stride" floats (0 = 3), e.g. from load_obj_file
+void vec3_soa_from_interleaved( const float* in, size_t stride, vec3_soa& out );
+void vec3_soa_to_interleaved( const vec3_soa& in, float* out, size_t stride );
+void dot( const vec3_soa& a, const vec3_soa& b, float* out );
+void cross( const vec3_soa& a, const vec3_soa& b, vec3_soa& out );
+void length( const vec3_soa& a, float* out );
+void normalise( const vec3_soa& a, vec3_soa& out );
+void lerp( const vec3_soa& a, const vec3_soa& b, float t, vec3_soa& out );
+/* culling functions. get the frustum from P * V for world-space bounds, or
+from P * V * M for bounds in M's local space. the cull functions write the
+indices of the visible (inside or intersecting) volumes to visible, which must
+have room for all of them, and return how many there were. tests are
+conservative - a few volumes just outside the frustum corners pass too */
+frustum frustum_from_mat4( const mat4& m );
+size_t cull_spheres( const frustum& f, const vec3_soa& centres, const float* radii, unsigned int* visible );
+size_t cull_aabbs( const frustum& f, const vec3_soa& mins, const vec3_soa& maxs, unsigned int* visible );
 // quaternion functions
 versor quat_from_axis_rad( float radians, float x, float y, float z );
 versor quat_from_axis_deg( float degrees, float x, float y, float z );
@@ -148,5 +247,19 @@ versor slerp( const versor& q, const versor& r );
 // overloading wouldn't let me use const
 versor normalise( versor& q );
 void print( const versor& q );
-versor slerp( versor& q, versor& r, float t );
+versor slerp( const versor& q, const versor& r, float t );
+// normalised linear interpolation. cheaper than slerp but not constant speed
+versor nlerp( const versor& q, const versor& r, float t );
+/* batch interpolation of n pairs of versors e.g. all the bones in a skeleton
+for one frame: out[i] = slerp( q[i], r[i], t[i] ). out may be q or r.
+SLERP_ACCURATE gives the same results as slerp(). SLERP_FAST uses a polynomial
+correction to nlerp instead of acos/sin, and is within ~0.002 degrees of an
+exact slerp for keys up to 60 degrees apart (see bench_maths) */
+enum slerp_mode_t { SLERP_ACCURATE, SLERP_FAST };
+void slerp_n( const versor* q, const versor* r, const float* t, versor* out, size_t n, slerp_mode_t mode );
+void nlerp_n( const versor* q, const versor* r, const float* t, versor* out, size_t n );
+
+#ifdef MATHS_HEADER_ONLY
+#include "maths_funcs.cpp"
+#endif
 #endif
@@ -0,0 +1,262 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Binary mesh cache. See mesh_cache.h for the file layout and when a cache is  |
+| considered up to date.                                                       |
+\******************************************************************************/
+#include "mesh_cache.h"
+#include "hash64.h"
+#include "obj_parser.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define STREAM_ALIGN 16
+
+/*----------------------------------HELPERS-----------------------------------*/
+// size and modification time, in nanoseconds where the platform has them
+static bool stat_source( const char* file_name, unsigned long long* sz, long long* mtime ) {
+  struct stat st;
+  if ( stat( file_name, &st ) != 0 ) { return false; }
+  *sz = (unsigned long long)st.st_size;
+#if defined( __linux__ )
+  *mtime = (long long)st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+#elif defined( __APPLE__ )
+  *mtime = (long long)st.st_mtimespec.tv_sec * 1000000000ll + st.st_mtimespec.tv_nsec;
+#else
+  *mtime = (long long)st.st_mtime * 1000000000ll;
+#endif
+  return true;
+}
+
+static bool hash_source( const char* file_name, unsigned long long* hash ) {
+  mapped_file mf;
+  if ( !map_file( file_name, &mf ) ) { return false; }
+  *hash = hash_bytes64( mf.data, mf.sz );
+  unmap_file( &mf );
+  return true;
+}
+
+static void compute_bounds( const float* points, int vertex_count, float* aabb_min, float* aabb_max ) {
+  for ( int c = 0; c < 3; c++ ) {
+    aabb_min[c] = vertex_count > 0 ? points[c] : 0.0f;
+    aabb_max[c] = aabb_min[c];
+  }
+  for ( int i = 0; i < vertex_count; i++ ) {
+    for ( int c = 0; c < 3; c++ ) {
+      float v = points[i * 3 + c];
+      if ( v < aabb_min[c] ) { aabb_min[c] = v; }
+      if ( v > aabb_max[c] ) { aabb_max[c] = v; }
+    }
+  }
+}
+
+// the arrays in stream order, and their sizes in bytes
+static void mesh_streams( const mesh_data* mesh, const void** ptrs, unsigned long long* sizes ) {
+  size_t vc                        = (size_t)mesh->vertex_count;
+  ptrs[MESH_STREAM_POINTS]         = mesh->points;
+  ptrs[MESH_STREAM_TEX_COORDS]     = mesh->tex_coords;
+  ptrs[MESH_STREAM_NORMALS]        = mesh->normals;
+  ptrs[MESH_STREAM_BONE_IDS]       = mesh->bone_ids;
+  ptrs[MESH_STREAM_BONE_MATS]      = mesh->bone_offset_mats;
+  ptrs[MESH_STREAM_INDICES]        = mesh->indices;
+  sizes[MESH_STREAM_POINTS]        = mesh->points ? vc * 3 * sizeof( float ) : 0;
+  sizes[MESH_STREAM_TEX_COORDS]    = mesh->tex_coords ? vc * 2 * sizeof( float ) : 0;
+  sizes[MESH_STREAM_NORMALS]       = mesh->normals ? vc * 3 * sizeof( float ) : 0;
+  sizes[MESH_STREAM_BONE_IDS]      = mesh->bone_ids ? vc * sizeof( int ) : 0;
+  sizes[MESH_STREAM_BONE_MATS]     = mesh->bone_offset_mats ? (size_t)mesh->bone_count * 16 * sizeof( float ) : 0;
+  sizes[MESH_STREAM_INDICES]       = mesh->indices ? (size_t)mesh->index_count * mesh->index_size : 0;
+}
+
+/* the sizes each stream must have if present, from the counts in h. false if
+index_size isn't 0, 2 or 4, or is 0 with an index stream */
+static bool expected_stream_sizes( const mesh_cache_header* h, unsigned long long* sizes ) {
+  unsigned long long vc           = h->vertex_count;
+  sizes[MESH_STREAM_POINTS]       = vc * 3 * sizeof( float );
+  sizes[MESH_STREAM_TEX_COORDS]   = vc * 2 * sizeof( float );
+  sizes[MESH_STREAM_NORMALS]      = vc * 3 * sizeof( float );
+  sizes[MESH_STREAM_BONE_IDS]     = vc * sizeof( int );
+  sizes[MESH_STREAM_BONE_MATS]    = (unsigned long long)h->bone_count * 16 * sizeof( float );
+  sizes[MESH_STREAM_INDICES]      = (unsigned long long)h->index_count * h->index_size;
+  if ( 2 == h->index_size || 4 == h->index_size ) { return true; }
+  return 0 == h->index_size && 0 == h->stream_size[MESH_STREAM_INDICES];
+}
+
+/* writes h and the streams it lists from ptrs to a temporary file, then
+renames it over cache_file, so a reader only ever maps a whole cache */
+static bool write_cache_file( const char* cache_file, const mesh_cache_header* h, const void* const* ptrs ) {
+  size_t tmp_len = strlen( cache_file ) + 5;
+  char* tmp_file = (char*)malloc( tmp_len );
+  if ( !tmp_file ) { return false; }
+  snprintf( tmp_file, tmp_len, "%s.tmp", cache_file );
+  FILE* fp = fopen( tmp_file, "wb" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not write mesh cache %s\n", tmp_file );
+    free( tmp_file );
+    return false;
+  }
+  bool ok                    = 1 == fwrite( h, sizeof( mesh_cache_header ), 1, fp );
+  unsigned long long written = sizeof( mesh_cache_header );
+  static const char zeros[STREAM_ALIGN] = { 0 };
+  for ( int i = 0; ok && i < MESH_STREAM_COUNT; i++ ) {
+    if ( !h->stream_size[i] ) { continue; }
+    size_t pad = (size_t)( h->stream_offset[i] - written );
+    ok         = fwrite( zeros, 1, pad, fp ) == pad && fwrite( ptrs[i], 1, (size_t)h->stream_size[i], fp ) == h->stream_size[i];
+    written    = h->stream_offset[i] + h->stream_size[i];
+  }
+  ok = ( 0 == fclose( fp ) ) && ok;
+#ifdef _WIN32
+  // rename() won't replace an existing file on Windows
+  if ( ok ) { remove( cache_file ); }
+#endif
+  ok = ok && 0 == rename( tmp_file, cache_file );
+  if ( !ok ) {
+    fprintf( stderr, "ERROR: could not write mesh cache %s\n", cache_file );
+    remove( tmp_file );
+  }
+  free( tmp_file );
+  return ok;
+}
+
+/*-----------------------------------WRITE------------------------------------*/
+bool mesh_cache_write( const char* cache_file, const char* source_file, const mesh_data* mesh ) {
+  mesh_cache_header h;
+  memset( &h, 0, sizeof( h ) );
+  h.magic            = MESH_CACHE_MAGIC;
+  h.version          = MESH_CACHE_VERSION;
+  h.header_size      = sizeof( mesh_cache_header );
+  h.vertex_count     = (unsigned int)mesh->vertex_count;
+  h.index_count      = (unsigned int)mesh->index_count;
+  h.index_size       = mesh->indices ? (unsigned int)mesh->index_size : 0;
+  h.bone_count       = (unsigned int)mesh->bone_count;
+  h.source_path_hash = hash_bytes64( source_file, strlen( source_file ) );
+  if ( !stat_source( source_file, &h.source_size, &h.source_mtime ) || !hash_source( source_file, &h.source_hash ) ) {
+    fprintf( stderr, "ERROR: could not read mesh cache source %s\n", source_file );
+    return false;
+  }
+  if ( mesh->points ) { compute_bounds( mesh->points, mesh->vertex_count, h.aabb_min, h.aabb_max ); }
+
+  const void* ptrs[MESH_STREAM_COUNT];
+  mesh_streams( mesh, ptrs, h.stream_size );
+  unsigned long long offset = sizeof( mesh_cache_header );
+  for ( int i = 0; i < MESH_STREAM_COUNT; i++ ) {
+    if ( !h.stream_size[i] ) { continue; }
+    offset             = ( offset + STREAM_ALIGN - 1 ) & ~(unsigned long long)( STREAM_ALIGN - 1 );
+    h.stream_offset[i] = offset;
+    offset += h.stream_size[i];
+  }
+  return write_cache_file( cache_file, &h, ptrs );
+}
+
+/*------------------------------------READ------------------------------------*/
+bool mesh_cache_read( const char* cache_file, const char* source_file, mesh_data* mesh ) {
+  memset( mesh, 0, sizeof( mesh_data ) );
+  unsigned long long src_size = 0;
+  long long src_mtime         = 0;
+  // no source, no way to tell if the cache is current
+  if ( !stat_source( source_file, &src_size, &src_mtime ) ) { return false; }
+  struct stat st;
+  if ( stat( cache_file, &st ) != 0 ) { return false; }
+
+  mapped_file mf;
+  if ( !map_file( cache_file, &mf ) ) { return false; }
+  mesh_cache_header h;
+  bool ok = mf.sz >= sizeof( h );
+  if ( ok ) { memcpy( &h, mf.data, sizeof( h ) ); }
+  ok = ok && MESH_CACHE_MAGIC == h.magic && MESH_CACHE_VERSION == h.version && sizeof( h ) == h.header_size;
+  ok = ok && h.source_path_hash == hash_bytes64( source_file, strlen( source_file ) ) && h.source_size == src_size;
+  // counts the rest of the code keeps in an int, and streams exactly the size those counts say
+  unsigned long long expected[MESH_STREAM_COUNT];
+  ok = ok && h.vertex_count <= INT_MAX && h.index_count <= INT_MAX && h.bone_count <= INT_MAX && expected_stream_sizes( &h, expected );
+  // every stream has to be inside the file and aligned
+  for ( int i = 0; ok && i < MESH_STREAM_COUNT; i++ ) {
+    if ( !h.stream_size[i] ) { continue; }
+    ok = h.stream_size[i] == expected[i] && h.stream_offset[i] % STREAM_ALIGN == 0 && h.stream_offset[i] <= mf.sz &&
+         h.stream_size[i] <= mf.sz - h.stream_offset[i];
+  }
+  const char* base[MESH_STREAM_COUNT];
+  for ( int i = 0; i < MESH_STREAM_COUNT; i++ ) { base[i] = ok && h.stream_size[i] ? mf.data + h.stream_offset[i] : NULL; }
+  if ( ok && h.source_mtime != src_mtime ) {
+    // touched but maybe not changed. hashing is still far cheaper than parsing
+    unsigned long long src_hash = 0;
+    ok                          = hash_source( source_file, &src_hash ) && src_hash == h.source_hash;
+    if ( ok ) {
+      /* remember the new mtime so the next start-up doesn't hash again. a new
+      file renamed into place, not a write into this one, so nothing mapping the
+      old one sees it change. this mapping stays valid either way */
+      h.source_mtime = src_mtime;
+      write_cache_file( cache_file, &h, (const void* const*)base );
+    }
+  }
+  if ( !ok ) {
+    unmap_file( &mf );
+    return false;
+  }
+
+  mesh->points           = (const float*)base[MESH_STREAM_POINTS];
+  mesh->tex_coords       = (const float*)base[MESH_STREAM_TEX_COORDS];
+  mesh->normals          = (const float*)base[MESH_STREAM_NORMALS];
+  mesh->bone_ids         = (const int*)base[MESH_STREAM_BONE_IDS];
+  mesh->bone_offset_mats = (const float*)base[MESH_STREAM_BONE_MATS];
+  mesh->indices          = base[MESH_STREAM_INDICES];
+  mesh->vertex_count     = (int)h.vertex_count;
+  mesh->index_count      = mesh->indices ? (int)h.index_count : 0;
+  mesh->index_size       = mesh->indices ? (int)h.index_size : 0;
+  mesh->bone_count       = (int)h.bone_count;
+  memcpy( mesh->aabb_min, h.aabb_min, sizeof( h.aabb_min ) );
+  memcpy( mesh->aabb_max, h.aabb_max, sizeof( h.aabb_max ) );
+  mesh->backing = mf;
+  return true;
+}
+
+/*------------------------------------OBJ-------------------------------------*/
+bool load_obj_file_cached( const char* file_name, mesh_data* mesh, bool* hit ) {
+  memset( mesh, 0, sizeof( mesh_data ) );
+  if ( hit ) { *hit = false; }
+  size_t len       = strlen( file_name ) + strlen( MESH_CACHE_SUFFIX ) + 1;
+  char* cache_file = (char*)malloc( len );
+  if ( !cache_file ) { return false; }
+  snprintf( cache_file, len, "%s%s", file_name, MESH_CACHE_SUFFIX );
+
+  if ( mesh_cache_read( cache_file, file_name, mesh ) ) {
+    if ( hit ) { *hit = true; }
+    free( cache_file );
+    return true;
+  }
+
+  float *points = NULL, *tex_coords = NULL, *normals = NULL;
+  void* indices = NULL;
+  int vertex_count = 0, index_count = 0, index_size = 0;
+  if ( !load_obj_file_indexed( file_name, points, tex_coords, normals, vertex_count, indices, index_count, index_size ) ) {
+    free( cache_file );
+    return false;
+  }
+  mesh->points                          = points;
+  mesh->tex_coords                      = tex_coords;
+  mesh->normals                         = normals;
+  mesh->indices                         = indices;
+  mesh->vertex_count                    = vertex_count;
+  mesh->index_count                     = index_count;
+  mesh->index_size                      = index_size;
+  mesh->owned[MESH_STREAM_POINTS]       = points;
+  mesh->owned[MESH_STREAM_TEX_COORDS]   = tex_coords;
+  mesh->owned[MESH_STREAM_NORMALS]      = normals;
+  mesh->owned[MESH_STREAM_INDICES]      = indices;
+  compute_bounds( points, vertex_count, mesh->aabb_min, mesh->aabb_max );
+  // not fatal. the mesh is loaded, it just won't be quicker next time
+  if ( !mesh_cache_write( cache_file, file_name, mesh ) ) { fprintf( stderr, "WARNING: continuing without a mesh cache for %s\n", file_name ); }
+  free( cache_file );
+  return true;
+}
+
+void free_mesh_data( mesh_data* mesh ) {
+  unmap_file( &mesh->backing );
+  for ( int i = 0; i < MESH_STREAM_COUNT; i++ ) { free( mesh->owned[i] ); }
+  memset( mesh, 0, sizeof( mesh_data ) );
+}
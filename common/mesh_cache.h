@@ -0,0 +1,97 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Binary mesh cache. Parsing a text OBJ (or running Assimp) at every start-up  |
+| is slow, so the result is written once to a binary file next to the source.  |
+| Later loads mmap() that file and point straight into it - the arrays can go  |
+| to glBufferData() without being copied or converted.                         |
+| File layout, all in the machine's native byte order:                         |
+|   mesh_cache_header                                                          |
+|   streams: points, tex coords, normals, bone ids, bone offset matrices,      |
+|   indices - each optional, each starting on a 16-byte boundary               |
+| A cache file is used only if its header matches the source path and the      |
+| source file's size and mtime. If just the mtime has changed (a fresh git     |
+| checkout, say) the source is hashed and the cache kept if the hash matches.  |
+| Anything else - a different version, a different source, stream sizes that   |
+| don't match the header's counts - and it's rebuilt.                          |
+\******************************************************************************/
+#ifndef _MESH_CACHE_H_
+#define _MESH_CACHE_H_
+
+#include "mapped_file.h"
+#include <stddef.h>
+
+// "AGMC" read as a little-endian uint32. reads as something else on a big-endian machine, so those caches just get rebuilt
+#define MESH_CACHE_MAGIC 0x434d4741u
+// bump whenever mesh_cache_header or the stream layout changes
+#define MESH_CACHE_VERSION 1u
+// appended to the source file name
+#define MESH_CACHE_SUFFIX ".mcache"
+
+enum mesh_stream_t { MESH_STREAM_POINTS = 0, MESH_STREAM_TEX_COORDS, MESH_STREAM_NORMALS, MESH_STREAM_BONE_IDS, MESH_STREAM_BONE_MATS, MESH_STREAM_INDICES, MESH_STREAM_COUNT };
+
+struct mesh_cache_header {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int header_size;
+  unsigned int vertex_count;
+  unsigned int index_count;
+  unsigned int index_size; // 0 (not indexed), 2 or 4
+  unsigned int bone_count;
+  unsigned int pad;
+  // key. a hash of the source path, not the path itself, to keep the header fixed-size
+  unsigned long long source_path_hash;
+  unsigned long long source_size;
+  long long source_mtime;
+  unsigned long long source_hash;
+  float aabb_min[3];
+  float aabb_max[3];
+  // byte offset from the start of the file and size of each stream. 0 size means absent
+  unsigned long long stream_offset[MESH_STREAM_COUNT];
+  unsigned long long stream_size[MESH_STREAM_COUNT];
+};
+
+/* a mesh as stored in the cache. every array may be NULL. from a cache hit they
+point into the mapped file, so they're read-only and only valid until
+free_mesh_data(). bone_ids is one int per vertex; bone_offset_mats is 16
+floats per bone, column-major like mat4 */
+struct mesh_data {
+  const float* points;
+  const float* tex_coords;
+  const float* normals;
+  int vertex_count;
+  const void* indices;
+  int index_count;
+  int index_size;
+  const int* bone_ids;
+  const float* bone_offset_mats;
+  int bone_count;
+  float aabb_min[3];
+  float aabb_max[3];
+  // where the arrays live. either a mapped cache file, or malloc'd blocks
+  mapped_file backing;
+  void* owned[MESH_STREAM_COUNT];
+};
+
+/* writes mesh to cache_file, keyed to source_file, which must exist. writes a
+temporary file and renames it, so a crash can't leave half a cache behind.
+bounds are worked out from the points */
+bool mesh_cache_write( const char* cache_file, const char* source_file, const mesh_data* mesh );
+
+/* maps cache_file into mesh if it's an up-to-date cache of source_file. false,
+quietly, if there's no cache or it's stale. */
+bool mesh_cache_read( const char* cache_file, const char* source_file, mesh_data* mesh );
+
+/* loads an OBJ through the cache. maps file_name + MESH_CACHE_SUFFIX if it's up
+to date, otherwise parses with load_obj_file_indexed() and writes the cache for
+next time. hit is set to whether the cache was used. the mesh stays usable even
+if the cache can't be written (read-only folder etc.) */
+bool load_obj_file_cached( const char* file_name, mesh_data* mesh, bool* hit );
+
+// unmaps or frees whatever mesh points to
+void free_mesh_data( mesh_data* mesh );
+
+#endif
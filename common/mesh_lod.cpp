@@ -0,0 +1,137 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| LOD chain tool. Loads an OBJ, builds a chain of simplified versions with     |
+| build_lod_chain(), and prints each level's triangle count and error. With    |
+| out_prefix, also writes each level as <out_prefix>_lod<N>.obj, keeping       |
+| only the vertices that level uses.                                           |
+| Usage: mesh_lod [-weld] file.obj [levels] [ratio] [max_error] [out_prefix]   |
+|   -weld     - SIMPLIFY_WELD_SEAMS: let UV/normal seams move. used anyway,    |
+|               with a warning, when the seams lock every vertex (e.g. a       |
+|               placeholder vt per face corner) so no level 1 could be made    |
+|   levels    - most levels including the original (default 6)                 |
+|   ratio     - triangles kept from one level to the next (default 0.5)        |
+|   max_error - largest error, as a fraction of the mesh's size (default 0.1)  |
+\******************************************************************************/
+#include "mesh_simplify.h"
+#include "obj_parser.h"
+#include <chrono>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_LEVELS 6
+#define DEFAULT_RATIO 0.5f
+#define DEFAULT_MAX_ERROR 0.1f
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+// writes the vertices lod uses, renumbered in order of first use, and its faces.
+// tex_coords and normals may be NULL, and their vt/vn are then left out
+static bool write_lod_obj( const char* file_name, const mesh_lod* lod, const float* points, const float* tex_coords, const float* normals, int vertex_count ) {
+  int* new_index = (int*)calloc( (size_t)vertex_count + 1, sizeof( int ) );
+  if ( !new_index ) {
+    fprintf( stderr, "ERROR: out of memory writing %s\n", file_name );
+    return false;
+  }
+  FILE* fp = fopen( file_name, "w" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not open %s for writing\n", file_name );
+    free( new_index );
+    return false;
+  }
+  int used = 0;
+  fprintf( fp, "# %i triangles, error %g\n", lod->index_count / 3, lod->error );
+  for ( int i = 0; i < lod->index_count; i++ ) {
+    unsigned int v = lod->indices[i];
+    if ( new_index[v] ) { continue; }
+    new_index[v] = ++used;
+    fprintf( fp, "v %f %f %f\n", points[v * 3], points[v * 3 + 1], points[v * 3 + 2] );
+    if ( tex_coords ) { fprintf( fp, "vt %f %f\n", tex_coords[v * 2], tex_coords[v * 2 + 1] ); }
+    if ( normals ) { fprintf( fp, "vn %f %f %f\n", normals[v * 3], normals[v * 3 + 1], normals[v * 3 + 2] ); }
+  }
+  // f v/vt/vn, v/vt, v//vn or v, depending on which streams there are
+  const char* corner = tex_coords && normals ? " %i/%i/%i" : tex_coords ? " %i/%i" : normals ? " %i//%i" : " %i";
+  for ( int i = 0; i < lod->index_count; i += 3 ) {
+    fprintf( fp, "f" );
+    for ( int k = 0; k < 3; k++ ) {
+      int a = new_index[lod->indices[i + k]];
+      fprintf( fp, corner, a, a, a );
+    }
+    fprintf( fp, "\n" );
+  }
+  free( new_index );
+  bool ok = !ferror( fp );
+  fclose( fp );
+  return ok;
+}
+
+int main( int argc, char** argv ) {
+  unsigned int flags = 0;
+  if ( argc > 1 && 0 == strcmp( argv[1], "-weld" ) ) {
+    flags = SIMPLIFY_WELD_SEAMS;
+    argv++;
+    argc--;
+  }
+  if ( argc < 2 ) {
+    fprintf( stderr, "usage: mesh_lod [-weld] file.obj [levels] [ratio] [max_error] [out_prefix]\n" );
+    return 1;
+  }
+  int levels         = argc > 2 ? atoi( argv[2] ) : DEFAULT_LEVELS;
+  float ratio        = argc > 3 ? (float)atof( argv[3] ) : DEFAULT_RATIO;
+  float max_error    = argc > 4 ? (float)atof( argv[4] ) : DEFAULT_MAX_ERROR;
+  const char* prefix = argc > 5 ? argv[5] : NULL;
+
+  float *points = NULL, *tex_coords = NULL, *normals = NULL;
+  void* raw     = NULL;
+  int vertex_count = 0, index_count = 0, index_size = 0;
+  if ( !load_obj_file_indexed( argv[1], points, tex_coords, normals, vertex_count, raw, index_count, index_size ) ) { return 1; }
+  unsigned int* indices = (unsigned int*)malloc( (size_t)index_count * sizeof( unsigned int ) + 1 );
+  if ( !indices ) {
+    fprintf( stderr, "ERROR: out of memory for %i indices\n", index_count );
+    return 1;
+  }
+  for ( int i = 0; i < index_count; i++ ) { indices[i] = 2 == index_size ? ( (unsigned short*)raw )[i] : ( (unsigned int*)raw )[i]; }
+  free( raw );
+
+  mesh_lod lods[MAX_MESH_LODS];
+  double t0 = now_ms();
+  int count = build_lod_chain( indices, index_count, points, normals, vertex_count, levels, ratio, max_error, flags, lods );
+  // no level 1, not even one with no error limit, means every vertex is locked:
+  // typically a placeholder vt per face corner splitting every position apart
+  if ( count < 2 && levels > 1 && !( flags & SIMPLIFY_WELD_SEAMS ) && index_count > 3 ) {
+    unsigned int* probe = (unsigned int*)malloc( (size_t)index_count * sizeof( unsigned int ) );
+    int probe_count     = probe ? simplify_mesh( probe, indices, index_count, points, normals, vertex_count, index_count - 3, FLT_MAX, flags, NULL ) : index_count;
+    free( probe );
+    if ( probe_count >= index_count ) {
+      fprintf( stderr, "WARNING: %s: every vertex is locked by its UV/normal seams, so nothing can be simplified. retrying as with -weld\n", argv[1] );
+      free_lod_chain( lods, count );
+      flags = SIMPLIFY_WELD_SEAMS;
+      count = build_lod_chain( indices, index_count, points, normals, vertex_count, levels, ratio, max_error, flags, lods );
+    }
+  }
+  double ms = now_ms() - t0;
+  printf( "%s: %i vertices, %i levels in %.1fms. error is relative to the mesh's size\n", argv[1], vertex_count, count, ms );
+  printf( "level  triangles  %% of lod0  error\n" );
+  int failures = 0;
+  for ( int l = 0; l < count; l++ ) {
+    printf( "%5i  %9i  %8.1f%%  %.5f\n", l, lods[l].index_count / 3, 100.0 * lods[l].index_count / lods[0].index_count, lods[l].error );
+    if ( prefix ) {
+      char file_name[1024];
+      snprintf( file_name, sizeof( file_name ), "%s_lod%i.obj", prefix, l );
+      if ( !write_lod_obj( file_name, &lods[l], points, tex_coords, normals, vertex_count ) ) { failures++; }
+    }
+  }
+  free_lod_chain( lods, count );
+  free( indices );
+  free( points );
+  free( tex_coords );
+  free( normals );
+  return failures || 0 == count ? 1 : 0;
+}
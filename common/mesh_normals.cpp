@@ -0,0 +1,355 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Vertex normal and tangent generation - see mesh_normals.h.                   |
+\******************************************************************************/
+#include "mesh_normals.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined( MESH_NORMALS_NO_THREADS )
+#include <functional>
+#include <thread>
+#endif
+
+// floats each corner gets in pass 1: a normal, or a tangent and a bitangent direction
+#define NORMAL_CORNER_FLOATS 3
+#define TANGENT_CORNER_FLOATS 6
+
+// everything a pass needs, shared read-only by its threads. each thread writes only its own range of corners or out
+struct normals_job {
+  const unsigned int* indices;
+  const float* points;
+  const float* normals;
+  const float* tex_coords;
+  normal_weighting weighting;
+  // normals only: the first vertex at each vertex's position, whose corners it sums
+  const unsigned int* remap;
+  // pass 1 output, indexed by corner (index into indices)
+  float* corners;
+  // vertex v's corners are vertex_corners[vertex_first[v]] to vertex_corners[vertex_first[v + 1] - 1], in triangle order
+  const int* vertex_first;
+  const int* vertex_corners;
+  float* out;
+};
+
+// signature shared by the per-range passes so they can be split across threads
+typedef void ( *range_kernel )( const normals_job& job, size_t first, size_t last );
+
+// runs kernel over n triangles or vertices, in contiguous chunks on several threads if n is big enough
+static void run_parallel( range_kernel kernel, const normals_job& job, size_t n, int n_threads ) {
+#if !defined( MESH_NORMALS_NO_THREADS )
+  const int max_threads = 64;
+  if ( n_threads <= 0 ) { n_threads = (int)std::thread::hardware_concurrency(); }
+  if ( n_threads > max_threads ) { n_threads = max_threads; }
+  if ( n >= MESH_NORMALS_THREAD_MIN && n_threads > 1 ) {
+    std::thread threads[max_threads];
+    size_t chunk = n / n_threads;
+    // this thread does the last chunk, plus any remainder, itself
+    for ( int t = 0; t < n_threads - 1; t++ ) { threads[t] = std::thread( kernel, std::cref( job ), t * chunk, ( t + 1 ) * chunk ); }
+    kernel( job, ( n_threads - 1 ) * chunk, n );
+    for ( int t = 0; t < n_threads - 1; t++ ) { threads[t].join(); }
+    return;
+  }
+#else
+  (void)n_threads;
+#endif
+  kernel( job, 0, n );
+}
+
+/*-----------------------------------VECTORS----------------------------------*/
+static inline void sub3( float* r, const float* a, const float* b ) {
+  r[0] = a[0] - b[0];
+  r[1] = a[1] - b[1];
+  r[2] = a[2] - b[2];
+}
+
+static inline void cross3( float* r, const float* a, const float* b ) {
+  r[0] = a[1] * b[2] - a[2] * b[1];
+  r[1] = a[2] * b[0] - a[0] * b[2];
+  r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static inline float dot3( const float* a, const float* b ) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+// removes v's component along unit vector n
+static inline void reject3( float* v, const float* n ) {
+  float d = dot3( v, n );
+  v[0] -= n[0] * d;
+  v[1] -= n[1] * d;
+  v[2] -= n[2] * d;
+}
+
+// normalises v in place, or returns false and leaves it alone if it's (nearly) zero
+static inline bool normalise3( float* v ) {
+  float l = sqrtf( dot3( v, v ) );
+  if ( !( l > 1e-20f ) ) { return false; }
+  v[0] /= l;
+  v[1] /= l;
+  v[2] /= l;
+  return true;
+}
+
+// angle between a and b in radians. atan2 rather than acos stays accurate for thin triangles
+static inline float angle3( const float* a, const float* b ) {
+  float c[3];
+  cross3( c, a, b );
+  return atan2f( sqrtf( dot3( c, c ) ), dot3( a, b ) );
+}
+
+/*-------------------------------VERTEX CORNERS-------------------------------*/
+// -0.0f is added to 0.0f first so both zeroes hash alike, as == compares them
+static unsigned int hash_position( const float* p ) {
+  float q[3] = { p[0] + 0.0f, p[1] + 0.0f, p[2] + 0.0f };
+  unsigned int bits[3];
+  memcpy( bits, q, sizeof( bits ) );
+  unsigned int h = bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u;
+  return h ^ ( h >> 16 );
+}
+
+/* remap[v] is the first vertex with v's position. load_obj_file_indexed()
+splits a vertex wherever its vt or vn differ, so this welds the copies along
+UV seams back together for summing normals, as mesh_simplify.cpp does */
+static unsigned int* build_position_remap( const float* points, int vertex_count ) {
+  unsigned int cap = 16;
+  while ( cap < (unsigned int)vertex_count * 2 ) { cap *= 2; }
+  unsigned int* table = (unsigned int*)malloc( cap * sizeof( unsigned int ) );
+  unsigned int* remap = (unsigned int*)malloc( (size_t)vertex_count * sizeof( unsigned int ) + 1 );
+  if ( !table || !remap ) {
+    fprintf( stderr, "ERROR: out of memory welding %i vertices\n", vertex_count );
+    free( table );
+    free( remap );
+    return NULL;
+  }
+  memset( table, 0xff, cap * sizeof( unsigned int ) );
+  for ( int v = 0; v < vertex_count; v++ ) {
+    const float* p    = &points[v * 3];
+    unsigned int slot = hash_position( p ) & ( cap - 1 );
+    while ( table[slot] != ~0u ) {
+      const float* q = &points[table[slot] * 3];
+      if ( p[0] == q[0] && p[1] == q[1] && p[2] == q[2] ) { break; }
+      slot = ( slot + 1 ) & ( cap - 1 );
+    }
+    if ( table[slot] == ~0u ) { table[slot] = v; }
+    remap[v] = table[slot];
+  }
+  free( table );
+  return remap;
+}
+
+/* counting sort of the corners by vertex, or by remap[vertex] if remap isn't
+NULL. corners go in in increasing order, so each vertex's list is in triangle
+order, which is what keeps the sums the same for any number of threads */
+static bool build_vertex_corners( const unsigned int* indices, int index_count, int vertex_count, const unsigned int* remap, int** first_out, int** corners_out ) {
+  *first_out   = NULL;
+  *corners_out = NULL;
+  if ( index_count < 0 || index_count % 3 ) {
+    fprintf( stderr, "ERROR: index count %i is not a whole number of triangles\n", index_count );
+    return false;
+  }
+  int* first   = (int*)calloc( (size_t)vertex_count + 1, sizeof( int ) );
+  int* corners = (int*)malloc( (size_t)index_count * sizeof( int ) + 1 );
+  if ( !first || !corners ) {
+    fprintf( stderr, "ERROR: out of memory listing vertex corners\n" );
+    free( first );
+    free( corners );
+    return false;
+  }
+  for ( int i = 0; i < index_count; i++ ) {
+    if ( indices[i] >= (unsigned int)vertex_count ) {
+      fprintf( stderr, "ERROR: index %u at %i out of range for %i vertices\n", indices[i], i, vertex_count );
+      free( first );
+      free( corners );
+      return false;
+    }
+  }
+  for ( int i = 0; i < index_count; i++ ) { first[( remap ? remap[indices[i]] : indices[i] ) + 1]++; }
+  for ( int v = 0; v < vertex_count; v++ ) { first[v + 1] += first[v]; }
+  // first[v] is used as vertex v's write cursor, which leaves it at vertex v + 1's start
+  for ( int i = 0; i < index_count; i++ ) { corners[first[remap ? remap[indices[i]] : indices[i]]++] = i; }
+  for ( int v = vertex_count; v > 0; v-- ) { first[v] = first[v - 1]; }
+  first[0]     = 0;
+  *first_out   = first;
+  *corners_out = corners;
+  return true;
+}
+
+// the 3 passes from mesh_normals.h, with corner_floats per corner in between
+static bool run_passes( range_kernel triangle_kernel, range_kernel vertex_kernel, normals_job& job, int index_count, int vertex_count, int corner_floats,
+  int n_threads ) {
+  int *first = NULL, *corners = NULL;
+  if ( !build_vertex_corners( job.indices, index_count, vertex_count, job.remap, &first, &corners ) ) { return false; }
+  job.corners = (float*)malloc( (size_t)index_count * corner_floats * sizeof( float ) + 1 );
+  if ( !job.corners ) {
+    fprintf( stderr, "ERROR: out of memory for %i corners\n", index_count );
+    free( first );
+    free( corners );
+    return false;
+  }
+  job.vertex_first   = first;
+  job.vertex_corners = corners;
+  run_parallel( triangle_kernel, job, (size_t)index_count / 3, n_threads );
+  run_parallel( vertex_kernel, job, (size_t)vertex_count, n_threads );
+  free( job.corners );
+  free( first );
+  free( corners );
+  return true;
+}
+
+/*-----------------------------------NORMALS----------------------------------*/
+static void normal_triangles( const normals_job& job, size_t first, size_t last ) {
+  for ( size_t t = first; t < last; t++ ) {
+    const unsigned int* tri = &job.indices[t * 3];
+    const float* p[3]       = { &job.points[tri[0] * 3], &job.points[tri[1] * 3], &job.points[tri[2] * 3] };
+    float e1[3], e2[3], n[3];
+    sub3( e1, p[1], p[0] );
+    sub3( e2, p[2], p[0] );
+    // as long as twice the triangle's area
+    cross3( n, e1, e2 );
+    float len = sqrtf( dot3( n, n ) );
+    for ( int c = 0; c < 3; c++ ) {
+      float* out = &job.corners[( t * 3 + c ) * NORMAL_CORNER_FLOATS];
+      float w    = 1.0f;
+      if ( !( len > 0.0f ) ) {
+        w = 0.0f;
+      } else if ( job.weighting != NORMAL_WEIGHT_AREA ) {
+        float a[3], b[3];
+        sub3( a, p[( c + 1 ) % 3], p[c] );
+        sub3( b, p[( c + 2 ) % 3], p[c] );
+        w = angle3( a, b );
+        if ( NORMAL_WEIGHT_ANGLE == job.weighting ) { w /= len; }
+      }
+      out[0] = n[0] * w;
+      out[1] = n[1] * w;
+      out[2] = n[2] * w;
+    }
+  }
+}
+
+// every copy of a position sums the same corners in the same order, so they all get the same bits
+static void normal_vertices( const normals_job& job, size_t first, size_t last ) {
+  for ( size_t v = first; v < last; v++ ) {
+    float n[3]   = { 0.0f, 0.0f, 0.0f };
+    size_t welded = job.remap[v];
+    for ( int i = job.vertex_first[welded]; i < job.vertex_first[welded + 1]; i++ ) {
+      const float* c = &job.corners[(size_t)job.vertex_corners[i] * NORMAL_CORNER_FLOATS];
+      n[0] += c[0];
+      n[1] += c[1];
+      n[2] += c[2];
+    }
+    if ( !normalise3( n ) ) { n[0] = 0.0f, n[1] = 0.0f, n[2] = 1.0f; }
+    memcpy( &job.out[v * 3], n, sizeof( n ) );
+  }
+}
+
+bool compute_vertex_normals( float* normals, const unsigned int* indices, int index_count, const float* points, int vertex_count, normal_weighting weighting,
+  int n_threads ) {
+  normals_job job;
+  memset( &job, 0, sizeof( job ) );
+  job.indices   = indices;
+  job.points    = points;
+  job.weighting = weighting;
+  job.out       = normals;
+  unsigned int* remap = build_position_remap( points, vertex_count );
+  if ( !remap ) { return false; }
+  job.remap = remap;
+  bool ok   = run_passes( normal_triangles, normal_vertices, job, index_count, vertex_count, NORMAL_CORNER_FLOATS, n_threads );
+  free( remap );
+  return ok;
+}
+
+/*----------------------------------TANGENTS----------------------------------*/
+/* per corner, as MikkTSpace: the triangle's directions of increasing u and v,
+projected onto the plane of the corner's vertex normal, times the corner's
+angle in that plane */
+static void tangent_triangles( const normals_job& job, size_t first, size_t last ) {
+  for ( size_t t = first; t < last; t++ ) {
+    const unsigned int* tri = &job.indices[t * 3];
+    const float* p[3]       = { &job.points[tri[0] * 3], &job.points[tri[1] * 3], &job.points[tri[2] * 3] };
+    const float* uv[3]      = { &job.tex_coords[tri[0] * 2], &job.tex_coords[tri[1] * 2], &job.tex_coords[tri[2] * 2] };
+    float e1[3], e2[3];
+    sub3( e1, p[1], p[0] );
+    sub3( e2, p[2], p[0] );
+    float du1 = uv[1][0] - uv[0][0], dv1 = uv[1][1] - uv[0][1];
+    float du2 = uv[2][0] - uv[0][0], dv2 = uv[2][1] - uv[0][1];
+    // twice the signed area in UV space. negative means the UVs are mirrored
+    float uv_area = du1 * dv2 - du2 * dv1;
+    float s[3], tv[3];
+    for ( int k = 0; k < 3; k++ ) {
+      s[k]  = e1[k] * dv2 - e2[k] * dv1;
+      tv[k] = e2[k] * du1 - e1[k] * du2;
+    }
+    // zero-area UVs give no direction; they're left out of the sums
+    bool usable = fabsf( uv_area ) > 1e-20f && normalise3( s ) && normalise3( tv );
+    float sign  = uv_area < 0.0f ? -1.0f : 1.0f;
+    for ( int c = 0; c < 3; c++ ) {
+      float* out = &job.corners[( t * 3 + c ) * TANGENT_CORNER_FLOATS];
+      memset( out, 0, TANGENT_CORNER_FLOATS * sizeof( float ) );
+      if ( !usable ) { continue; }
+      const float* n = &job.normals[tri[c] * 3];
+      float a[3], b[3], cs[3], ct[3];
+      sub3( a, p[( c + 1 ) % 3], p[c] );
+      sub3( b, p[( c + 2 ) % 3], p[c] );
+      reject3( a, n );
+      reject3( b, n );
+      if ( !normalise3( a ) || !normalise3( b ) ) { continue; }
+      float w = angle3( a, b ) * sign;
+      memcpy( cs, s, sizeof( cs ) );
+      memcpy( ct, tv, sizeof( ct ) );
+      reject3( cs, n );
+      reject3( ct, n );
+      if ( !normalise3( cs ) || !normalise3( ct ) ) { continue; }
+      for ( int k = 0; k < 3; k++ ) {
+        out[k]     = cs[k] * w;
+        out[3 + k] = ct[k] * w;
+      }
+    }
+  }
+}
+
+static void tangent_vertices( const normals_job& job, size_t first, size_t last ) {
+  for ( size_t v = first; v < last; v++ ) {
+    const float* n = &job.normals[v * 3];
+    float s[3] = { 0.0f, 0.0f, 0.0f }, tv[3] = { 0.0f, 0.0f, 0.0f };
+    for ( int i = job.vertex_first[v]; i < job.vertex_first[v + 1]; i++ ) {
+      const float* c = &job.corners[(size_t)job.vertex_corners[i] * TANGENT_CORNER_FLOATS];
+      for ( int k = 0; k < 3; k++ ) {
+        s[k] += c[k];
+        tv[k] += c[3 + k];
+      }
+    }
+    // Gram-Schmidt, in case the corners' normals weren't all quite this one
+    reject3( s, n );
+    if ( !normalise3( s ) ) {
+      // no usable triangle: any direction in the normal's plane, from the axis least like the normal
+      float ax = fabsf( n[0] ), ay = fabsf( n[1] ), az = fabsf( n[2] );
+      s[0] = ( ax <= ay && ax <= az ) ? 1.0f : 0.0f;
+      s[1] = ( s[0] == 0.0f && ay <= az ) ? 1.0f : 0.0f;
+      s[2] = ( s[0] == 0.0f && s[1] == 0.0f ) ? 1.0f : 0.0f;
+      reject3( s, n );
+      if ( !normalise3( s ) ) { s[0] = 1.0f, s[1] = 0.0f, s[2] = 0.0f; }
+    }
+    float b[3];
+    cross3( b, n, s );
+    float* out = &job.out[v * 4];
+    memcpy( out, s, sizeof( s ) );
+    // w says which side of the tangent the summed direction of increasing v is on
+    out[3] = dot3( b, tv ) < 0.0f ? -1.0f : 1.0f;
+  }
+}
+
+bool compute_vertex_tangents( float* tangents, const unsigned int* indices, int index_count, const float* points, const float* normals, const float* tex_coords,
+  int vertex_count, int n_threads ) {
+  normals_job job;
+  memset( &job, 0, sizeof( job ) );
+  job.indices    = indices;
+  job.points     = points;
+  job.normals    = normals;
+  job.tex_coords = tex_coords;
+  job.out        = tangents;
+  return run_passes( tangent_triangles, tangent_vertices, job, index_count, vertex_count, TANGENT_CORNER_FLOATS, n_threads );
+}
@@ -0,0 +1,64 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Smooth vertex normals and normal-mapping tangents for indexed triangle       |
+| lists, e.g. from load_obj_file_indexed(), without Assimp's                   |
+| aiProcess_GenSmoothNormals / aiProcess_CalcTangentSpace. For OBJ files with  |
+| no vn lines, and for redoing a mesh's normals after editing it.              |
+| Normals are summed per position, not per vertex: load_obj_file_indexed()     |
+| splits a vertex wherever its vt differs, and summing each copy's own side of |
+| a UV seam would put a lighting crease along every seam. Every vertex at a    |
+| position gets the same normal, so meshes meant to have hard edges need them  |
+| from the file.                                                               |
+| Both run in 3 passes:                                                        |
+| 1. each triangle works out what it adds to each of its 3 corners (parallel)  |
+| 2. a list of every position's (normals) or vertex's (tangents) corners, in   |
+|    triangle order (serial)                                                   |
+| 3. each vertex sums its corners in that order and normalises (parallel)      |
+| so no two threads ever add to the same vertex, and the sums happen in the    |
+| same order however many threads there are - the output is bit-identical      |
+| for any n_threads.                                                           |
+| Tangents follow MikkTSpace's conventions (what Blender, Substance and most   |
+| normal map bakers use): per-corner UV directions projected onto the normal's |
+| plane, weighted by corner angle, then Gram-Schmidt against the normal. They  |
+| come out as vec4s, with w the sign to give the bitangent:                    |
+|   bitangent = cross( normal, tangent.xyz ) * tangent.w                       |
+| as 20_normal_mapping's shader has it. Unlike MikkTSpace, vertices aren't     |
+| split where mirrored UVs meet - each vertex gets one tangent, so a UV seam   |
+| needs its own vertices already (OBJ files give it them: a seam is            |
+| different vt indices).                                                       |
+| Indices are 32-bit. points and normals are 3 floats a vertex, tex coords 2.  |
+\******************************************************************************/
+#ifndef _MESH_NORMALS_H_
+#define _MESH_NORMALS_H_
+
+// fewer triangles than this and the passes run on one thread. define MESH_NORMALS_NO_THREADS to always use one
+#define MESH_NORMALS_THREAD_MIN 16384
+
+/* how much each triangle adds to the normals of its 3 corners.
+area       - bigger triangles count more. cheapest, but a fan of thin triangles
+             drags the normal towards itself
+angle      - weighted by the angle at the corner, so how a surface was split
+             into triangles hardly matters (Thurmer and Wuthrich 1998)
+area_angle - both. what Assimp's GenSmoothNormals comes closest to */
+enum normal_weighting { NORMAL_WEIGHT_AREA, NORMAL_WEIGHT_ANGLE, NORMAL_WEIGHT_AREA_ANGLE };
+
+/* writes vertex_count smooth normals into normals from the triangles in
+indices. vertices no triangle uses, or only degenerate ones, get (0,0,1).
+n_threads 0 uses every core. returns false if an index is out of range or
+memory runs out */
+bool compute_vertex_normals( float* normals, const unsigned int* indices, int index_count, const float* points, int vertex_count, normal_weighting weighting,
+  int n_threads );
+
+/* writes vertex_count tangents, 4 floats each, into tangents. normals are
+the vertex normals (from the file, or compute_vertex_normals()) and should be
+unit length. triangles with degenerate tex coords are left out; a vertex with
+no usable triangle gets some tangent perpendicular to its normal. n_threads 0
+uses every core. returns false if an index is out of range or memory runs out */
+bool compute_vertex_tangents( float* tangents, const unsigned int* indices, int index_count, const float* points, const float* normals, const float* tex_coords,
+  int vertex_count, int n_threads );
+
+#endif
@@ -0,0 +1,442 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Mesh optimisation - see mesh_optimizer.h.                                    |
+| References:                                                                  |
+| T. Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006                   |
+| P. Sander, D. Nehab, J. Barczak, "Fast Triangle Reordering for Vertex        |
+| Locality and Reduced Overdraw", SIGGRAPH 2007                                |
+\******************************************************************************/
+#include "mesh_optimizer.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Forsyth's tuned constants
+#define FORSYTH_LAST_TRI_SCORE 0.75f
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+// valences above this all score the same as this
+#define FORSYTH_MAX_VALENCE 64
+// FIFO size optimize_overdraw() simulates when choosing cluster boundaries
+#define OVERDRAW_CACHE_SIZE 16
+
+/*----------------------------------VERTEX CACHE------------------------------*/
+static float g_cache_pos_score[VERTEX_CACHE_OPT_SIZE];
+static float g_valence_score[FORSYTH_MAX_VALENCE + 1];
+
+static void init_forsyth_tables() {
+  for ( int i = 0; i < VERTEX_CACHE_OPT_SIZE; i++ ) {
+    if ( i < 3 ) {
+      // the last triangle's own vertices. scored lower so the strip doesn't double back on itself
+      g_cache_pos_score[i] = FORSYTH_LAST_TRI_SCORE;
+    } else {
+      float scaler         = 1.0f / ( VERTEX_CACHE_OPT_SIZE - 3 );
+      g_cache_pos_score[i] = powf( 1.0f - ( i - 3 ) * scaler, FORSYTH_CACHE_DECAY_POWER );
+    }
+  }
+  // fewer triangles left on a vertex - finish it off before it leaves the cache
+  g_valence_score[0] = 0.0f;
+  for ( int i = 1; i <= FORSYTH_MAX_VALENCE; i++ ) { g_valence_score[i] = FORSYTH_VALENCE_BOOST_SCALE * powf( (float)i, -FORSYTH_VALENCE_BOOST_POWER ); }
+}
+
+static float vertex_score( int cache_pos, int live_tris ) {
+  if ( 0 == live_tris ) { return -1.0f; }
+  float score = cache_pos >= 0 ? g_cache_pos_score[cache_pos] : 0.0f;
+  return score + g_valence_score[live_tris < FORSYTH_MAX_VALENCE ? live_tris : FORSYTH_MAX_VALENCE];
+}
+
+void optimize_vertex_cache( unsigned int* dst, const unsigned int* indices, int index_count, int vertex_count ) {
+  int tri_count = index_count / 3;
+  // per vertex: triangles still to draw, as a slice of adj starting at adj_start
+  int* live      = (int*)calloc( vertex_count + 1, sizeof( int ) );
+  int* adj_start = (int*)malloc( ( vertex_count + 1 ) * sizeof( int ) );
+  int* adj       = (int*)malloc( (size_t)tri_count * 3 * sizeof( int ) + 1 );
+  int* cache_pos = (int*)malloc( ( vertex_count + 1 ) * sizeof( int ) );
+  float* vscore  = (float*)malloc( ( vertex_count + 1 ) * sizeof( float ) );
+  float* tscore  = (float*)malloc( (size_t)tri_count * sizeof( float ) + 1 );
+  char* emitted  = (char*)calloc( tri_count + 1, 1 );
+  if ( !live || !adj_start || !adj || !cache_pos || !vscore || !tscore || !emitted ) {
+    fprintf( stderr, "ERROR: out of memory optimising vertex cache. order unchanged\n" );
+    memcpy( dst, indices, (size_t)tri_count * 3 * sizeof( unsigned int ) );
+    free( live );
+    free( adj_start );
+    free( adj );
+    free( cache_pos );
+    free( vscore );
+    free( tscore );
+    free( emitted );
+    return;
+  }
+  init_forsyth_tables();
+
+  for ( int i = 0; i < tri_count * 3; i++ ) { live[indices[i]]++; }
+  int offset = 0;
+  for ( int v = 0; v < vertex_count; v++ ) {
+    adj_start[v] = offset;
+    offset += live[v];
+    live[v]      = 0;
+    cache_pos[v] = -1;
+  }
+  for ( int i = 0; i < tri_count * 3; i++ ) {
+    unsigned int v                = indices[i];
+    adj[adj_start[v] + live[v]++] = i / 3;
+  }
+  for ( int v = 0; v < vertex_count; v++ ) { vscore[v] = vertex_score( -1, live[v] ); }
+  int best_tri     = -1;
+  float best_score = -1.0f;
+  for ( int t = 0; t < tri_count; t++ ) {
+    tscore[t] = vscore[indices[t * 3]] + vscore[indices[t * 3 + 1]] + vscore[indices[t * 3 + 2]];
+    if ( tscore[t] > best_score ) {
+      best_score = tscore[t];
+      best_tri   = t;
+    }
+  }
+
+  // room for the 3 vertices pushed out by the last triangle, so their scores get updated too
+  unsigned int cache[VERTEX_CACHE_OPT_SIZE + 3], new_cache[VERTEX_CACHE_OPT_SIZE + 3];
+  int cache_count = 0, scan_from = 0;
+  for ( int out = 0; out < tri_count; out++ ) {
+    if ( best_tri < 0 ) {
+      // nothing in the cache has triangles left. start again from the next unused triangle
+      while ( emitted[scan_from] ) { scan_from++; }
+      best_tri = scan_from;
+    }
+    const unsigned int* tri = &indices[best_tri * 3];
+    memcpy( &dst[out * 3], tri, 3 * sizeof( unsigned int ) );
+    emitted[best_tri] = 1;
+
+    // take the triangle off each of its vertices' lists
+    for ( int c = 0; c < 3; c++ ) {
+      unsigned int v = tri[c];
+      int* list      = &adj[adj_start[v]];
+      for ( int i = 0; i < live[v]; i++ ) {
+        if ( list[i] == best_tri ) {
+          list[i] = list[--live[v]];
+          break;
+        }
+      }
+    }
+    // the triangle's vertices move to the front of the cache
+    int new_count = 0;
+    for ( int c = 0; c < 3; c++ ) {
+      if ( 0 == c || ( tri[c] != tri[0] && ( c < 2 || tri[c] != tri[1] ) ) ) { new_cache[new_count++] = tri[c]; }
+    }
+    for ( int i = 0; i < cache_count; i++ ) {
+      unsigned int v = cache[i];
+      if ( v != tri[0] && v != tri[1] && v != tri[2] ) { new_cache[new_count++] = v; }
+    }
+    for ( int i = 0; i < new_count; i++ ) {
+      unsigned int v = new_cache[i];
+      cache_pos[v]   = i < VERTEX_CACHE_OPT_SIZE ? i : -1;
+      vscore[v]      = vertex_score( cache_pos[v], live[v] );
+    }
+    cache_count = new_count < VERTEX_CACHE_OPT_SIZE ? new_count : VERTEX_CACHE_OPT_SIZE;
+    memcpy( cache, new_cache, cache_count * sizeof( unsigned int ) );
+
+    // only triangles touching the cache changed score, and the best next one is among them
+    best_tri   = -1;
+    best_score = -1.0f;
+    for ( int i = 0; i < new_count; i++ ) {
+      unsigned int v  = new_cache[i];
+      const int* list = &adj[adj_start[v]];
+      for ( int j = 0; j < live[v]; j++ ) {
+        int t     = list[j];
+        tscore[t] = vscore[indices[t * 3]] + vscore[indices[t * 3 + 1]] + vscore[indices[t * 3 + 2]];
+        if ( i < cache_count && tscore[t] > best_score ) {
+          best_score = tscore[t];
+          best_tri   = t;
+        }
+      }
+    }
+  }
+  free( live );
+  free( adj_start );
+  free( adj );
+  free( cache_pos );
+  free( vscore );
+  free( tscore );
+  free( emitted );
+}
+
+/*------------------------------------OVERDRAW--------------------------------*/
+/* FIFO cache simulated with timestamps: a vertex is cached if it was last
+missed fewer than cache_size misses ago. bumping the clock by cache_size
+empties it */
+struct fifo_cache {
+  unsigned int* stamp;
+  unsigned int time;
+  int size;
+};
+
+static int fifo_misses( fifo_cache* fc, const unsigned int* tri ) {
+  int misses = 0;
+  for ( int c = 0; c < 3; c++ ) {
+    if ( fc->time - fc->stamp[tri[c]] >= (unsigned int)fc->size ) {
+      fc->stamp[tri[c]] = ++fc->time;
+      misses++;
+    }
+  }
+  return misses;
+}
+
+static void fifo_flush( fifo_cache* fc ) { fc->time += fc->size + 1; }
+
+struct cluster_key {
+  float key;
+  int cluster;
+};
+
+// largest key first. ties keep the original order, so the result doesn't depend on qsort
+static int compare_cluster_keys( const void* a, const void* b ) {
+  const cluster_key* ka = (const cluster_key*)a;
+  const cluster_key* kb = (const cluster_key*)b;
+  if ( ka->key != kb->key ) { return ka->key > kb->key ? -1 : 1; }
+  return ka->cluster - kb->cluster;
+}
+
+void optimize_overdraw( unsigned int* dst, const unsigned int* indices, int index_count, const float* points, int vertex_count, float threshold ) {
+  int tri_count     = index_count / 3;
+  if ( 0 == tri_count ) { return; }
+  // cluster i is triangles [cluster_start[i], cluster_start[i + 1]). +2: the end marker, and room to shift in a 0 boundary
+  int* cluster_start = (int*)malloc( ( tri_count + 2 ) * sizeof( int ) );
+  int* hard          = (int*)malloc( ( tri_count + 2 ) * sizeof( int ) );
+  cluster_key* keys  = (cluster_key*)malloc( ( tri_count + 1 ) * sizeof( cluster_key ) );
+  fifo_cache fc      = { (unsigned int*)malloc( ( vertex_count + 1 ) * sizeof( unsigned int ) ), 0, OVERDRAW_CACHE_SIZE };
+  if ( !cluster_start || !hard || !keys || !fc.stamp ) {
+    fprintf( stderr, "ERROR: out of memory optimising overdraw. order unchanged\n" );
+    memcpy( dst, indices, (size_t)tri_count * 3 * sizeof( unsigned int ) );
+    free( cluster_start );
+    free( hard );
+    free( keys );
+    free( fc.stamp );
+    return;
+  }
+  // every vertex starts out of the cache
+  for ( int v = 0; v < vertex_count; v++ ) { fc.stamp[v] = 0; }
+  fc.time = OVERDRAW_CACHE_SIZE;
+
+  // hard boundaries: triangles where all 3 vertices miss. the cache was cold anyway, so splitting there is free
+  int n_hard = 0;
+  for ( int t = 0; t < tri_count; t++ ) {
+    if ( 3 == fifo_misses( &fc, &indices[t * 3] ) ) { hard[n_hard++] = t; }
+  }
+  hard[n_hard] = tri_count;
+  if ( 0 == n_hard || hard[0] != 0 ) {
+    memmove( hard + 1, hard, ( n_hard + 1 ) * sizeof( int ) );
+    hard[0] = 0;
+    n_hard++;
+  }
+
+  // soft boundaries: split a hard cluster wherever its ACMR so far is within threshold of the whole cluster's
+  int n_clusters = 0;
+  for ( int h = 0; h < n_hard; h++ ) {
+    int start = hard[h], end = hard[h + 1];
+    fifo_flush( &fc );
+    int misses = 0;
+    for ( int t = start; t < end; t++ ) { misses += fifo_misses( &fc, &indices[t * 3] ); }
+    float target = threshold * (float)misses / (float)( end - start );
+
+    fifo_flush( &fc );
+    cluster_start[n_clusters++] = start;
+    int run_start = start, run_misses = 0;
+    for ( int t = start; t < end - 1; t++ ) {
+      run_misses += fifo_misses( &fc, &indices[t * 3] );
+      if ( (float)run_misses <= target * (float)( t + 1 - run_start ) ) {
+        run_start                   = t + 1;
+        run_misses                  = 0;
+        cluster_start[n_clusters++] = run_start;
+        fifo_flush( &fc );
+      }
+    }
+  }
+  cluster_start[n_clusters] = tri_count;
+
+  // sort key: how far the cluster faces out from the middle of the mesh. outer parts hide inner ones, so draw them first
+  double mesh_centre[3] = { 0.0, 0.0, 0.0 };
+  for ( int v = 0; v < vertex_count; v++ ) {
+    for ( int k = 0; k < 3; k++ ) { mesh_centre[k] += points[v * 3 + k]; }
+  }
+  for ( int k = 0; k < 3; k++ ) { mesh_centre[k] /= vertex_count > 0 ? vertex_count : 1; }
+  for ( int c = 0; c < n_clusters; c++ ) {
+    double centre[3] = { 0.0, 0.0, 0.0 }, normal[3] = { 0.0, 0.0, 0.0 }, area_sum = 0.0;
+    for ( int t = cluster_start[c]; t < cluster_start[c + 1]; t++ ) {
+      const float* p0 = &points[indices[t * 3] * 3];
+      const float* p1 = &points[indices[t * 3 + 1] * 3];
+      const float* p2 = &points[indices[t * 3 + 2] * 3];
+      double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      double n[3]  = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+      double area  = sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+      // area-weighted: the cross product's length is twice the area already
+      for ( int k = 0; k < 3; k++ ) {
+        centre[k] += ( p0[k] + p1[k] + p2[k] ) * area / 3.0;
+        normal[k] += n[k];
+      }
+      area_sum += area;
+    }
+    double len = sqrt( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+    double key = 0.0;
+    if ( area_sum > 0.0 && len > 0.0 ) {
+      for ( int k = 0; k < 3; k++ ) { key += ( centre[k] / area_sum - mesh_centre[k] ) * normal[k] / len; }
+    }
+    keys[c].key     = (float)key;
+    keys[c].cluster = c;
+  }
+  qsort( keys, n_clusters, sizeof( cluster_key ), compare_cluster_keys );
+
+  int out = 0;
+  for ( int i = 0; i < n_clusters; i++ ) {
+    int c     = keys[i].cluster;
+    int count = ( cluster_start[c + 1] - cluster_start[c] ) * 3;
+    memcpy( &dst[out], &indices[cluster_start[c] * 3], count * sizeof( unsigned int ) );
+    out += count;
+  }
+  free( cluster_start );
+  free( hard );
+  free( keys );
+  free( fc.stamp );
+}
+
+/*------------------------------------FETCH-----------------------------------*/
+// scratch holds at least vertex_count * comps floats
+static void remap_attrib( float* data, int comps, const unsigned int* remap, int vertex_count, float* scratch ) {
+  if ( !data ) { return; }
+  memcpy( scratch, data, (size_t)vertex_count * comps * sizeof( float ) );
+  for ( int v = 0; v < vertex_count; v++ ) {
+    if ( remap[v] != ~0u ) { memcpy( &data[(size_t)remap[v] * comps], &scratch[(size_t)v * comps], comps * sizeof( float ) ); }
+  }
+}
+
+int optimize_vertex_fetch( unsigned int* indices, int index_count, float* points, float* tex_coords, float* normals, int vertex_count ) {
+  // everything is allocated before any array is touched, so a failure changes nothing
+  unsigned int* remap = (unsigned int*)malloc( ( vertex_count + 1 ) * sizeof( unsigned int ) );
+  float* scratch      = (float*)malloc( (size_t)vertex_count * 3 * sizeof( float ) + 1 );
+  if ( !remap || !scratch ) {
+    fprintf( stderr, "ERROR: out of memory optimising vertex fetch. order unchanged\n" );
+    free( remap );
+    free( scratch );
+    return vertex_count;
+  }
+  memset( remap, 0xff, ( vertex_count + 1 ) * sizeof( unsigned int ) );
+  unsigned int next = 0;
+  for ( int i = 0; i < index_count; i++ ) {
+    if ( remap[indices[i]] == ~0u ) { remap[indices[i]] = next++; }
+  }
+  remap_attrib( points, 3, remap, vertex_count, scratch );
+  remap_attrib( tex_coords, 2, remap, vertex_count, scratch );
+  remap_attrib( normals, 3, remap, vertex_count, scratch );
+  for ( int i = 0; i < index_count; i++ ) { indices[i] = remap[indices[i]]; }
+  free( scratch );
+  free( remap );
+  return (int)next;
+}
+
+/*------------------------------------ANALYSIS--------------------------------*/
+vertex_cache_stats analyze_vertex_cache( const unsigned int* indices, int index_count, int vertex_count, int cache_size ) {
+  vertex_cache_stats stats = { 0, 0.0f, 0.0f };
+  fifo_cache fc            = { (unsigned int*)calloc( vertex_count + 1, sizeof( unsigned int ) ), (unsigned int)cache_size, cache_size };
+  char* used               = (char*)calloc( vertex_count + 1, 1 );
+  if ( !fc.stamp || !used ) {
+    fprintf( stderr, "ERROR: out of memory analysing vertex cache\n" );
+    free( fc.stamp );
+    free( used );
+    return stats;
+  }
+  int unique = 0, tri_count = index_count / 3;
+  for ( int t = 0; t < tri_count; t++ ) { stats.transforms += fifo_misses( &fc, &indices[t * 3] ); }
+  for ( int i = 0; i < tri_count * 3; i++ ) {
+    if ( !used[indices[i]] ) {
+      used[indices[i]] = 1;
+      unique++;
+    }
+  }
+  stats.acmr = tri_count > 0 ? (float)stats.transforms / tri_count : 0.0f;
+  stats.atvr = unique > 0 ? (float)stats.transforms / unique : 0.0f;
+  free( fc.stamp );
+  free( used );
+  return stats;
+}
+
+// edge function: > 0 with p to the left of a->b
+static float edge_fn( const float* a, const float* b, float px, float py ) { return ( b[0] - a[0] ) * ( py - a[1] ) - ( b[1] - a[1] ) * ( px - a[0] ); }
+
+/* top-left fill rule for counter-clockwise triangles with y up, so a pixel
+centre exactly on an edge shared by two triangles is only drawn once */
+static bool edge_owns( const float* a, const float* b ) { return b[1] < a[1] || ( b[1] == a[1] && b[0] < a[0] ); }
+
+overdraw_stats analyze_overdraw( const unsigned int* indices, int index_count, const float* points, int vertex_count ) {
+  overdraw_stats stats = { 0, 0, 0.0f };
+  float* depth         = (float*)malloc( OVERDRAW_VIEW_RES * OVERDRAW_VIEW_RES * sizeof( float ) );
+  if ( !depth ) {
+    fprintf( stderr, "ERROR: out of memory analysing overdraw\n" );
+    return stats;
+  }
+  float mn[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for ( int v = 0; v < vertex_count; v++ ) {
+    for ( int k = 0; k < 3; k++ ) {
+      mn[k] = points[v * 3 + k] < mn[k] ? points[v * 3 + k] : mn[k];
+      mx[k] = points[v * 3 + k] > mx[k] ? points[v * 3 + k] : mx[k];
+    }
+  }
+  int tri_count = index_count / 3;
+  for ( int view = 0; view < 6; view++ ) {
+    // looking down axis a from the + side (dir 1) or the - side (dir -1)
+    int a = view / 2, u = ( a + 1 ) % 3, w = ( a + 2 ) % 3;
+    float dir   = ( view & 1 ) ? -1.0f : 1.0f;
+    float ext   = ( mx[u] - mn[u] ) > ( mx[w] - mn[w] ) ? ( mx[u] - mn[u] ) : ( mx[w] - mn[w] );
+    float scale = ext > 0.0f ? ( OVERDRAW_VIEW_RES - 1 ) / ext : 0.0f;
+    for ( int i = 0; i < OVERDRAW_VIEW_RES * OVERDRAW_VIEW_RES; i++ ) { depth[i] = FLT_MAX; }
+
+    for ( int t = 0; t < tri_count; t++ ) {
+      // x, y in pixels, z smaller = nearer
+      float v[3][3];
+      for ( int c = 0; c < 3; c++ ) {
+        const float* p = &points[indices[t * 3 + c] * 3];
+        v[c][0]        = ( p[u] - mn[u] ) * scale;
+        v[c][1]        = ( p[w] - mn[w] ) * scale;
+        v[c][2]        = -dir * p[a];
+      }
+      float area = edge_fn( v[0], v[1], v[2][0], v[2][1] );
+      // back-facing (or edge-on) from this side
+      if ( dir * area <= 0.0f ) { continue; }
+      // seen from the - side the winding flips. swap to keep the rasteriser counter-clockwise
+      const float* p0 = v[0];
+      const float* p1 = dir > 0.0f ? v[1] : v[2];
+      const float* p2 = dir > 0.0f ? v[2] : v[1];
+      area            = dir * area;
+      int x0 = (int)ceilf( fminf( p0[0], fminf( p1[0], p2[0] ) ) ), x1 = (int)floorf( fmaxf( p0[0], fmaxf( p1[0], p2[0] ) ) );
+      int y0 = (int)ceilf( fminf( p0[1], fminf( p1[1], p2[1] ) ) ), y1 = (int)floorf( fmaxf( p0[1], fmaxf( p1[1], p2[1] ) ) );
+      x0 = x0 < 0 ? 0 : x0;
+      y0 = y0 < 0 ? 0 : y0;
+      x1 = x1 > OVERDRAW_VIEW_RES - 1 ? OVERDRAW_VIEW_RES - 1 : x1;
+      y1 = y1 > OVERDRAW_VIEW_RES - 1 ? OVERDRAW_VIEW_RES - 1 : y1;
+      bool own0 = edge_owns( p1, p2 ), own1 = edge_owns( p2, p0 ), own2 = edge_owns( p0, p1 );
+      for ( int y = y0; y <= y1; y++ ) {
+        for ( int x = x0; x <= x1; x++ ) {
+          float w0 = edge_fn( p1, p2, (float)x, (float)y );
+          float w1 = edge_fn( p2, p0, (float)x, (float)y );
+          float w2 = edge_fn( p0, p1, (float)x, (float)y );
+          if ( w0 < 0.0f || w1 < 0.0f || w2 < 0.0f ) { continue; }
+          if ( ( 0.0f == w0 && !own0 ) || ( 0.0f == w1 && !own1 ) || ( 0.0f == w2 && !own2 ) ) { continue; }
+          float z   = ( w0 * p0[2] + w1 * p1[2] + w2 * p2[2] ) / area;
+          float* d  = &depth[y * OVERDRAW_VIEW_RES + x];
+          if ( z < *d ) {
+            *d = z;
+            stats.pixels_shaded++;
+          }
+        }
+      }
+    }
+    for ( int i = 0; i < OVERDRAW_VIEW_RES * OVERDRAW_VIEW_RES; i++ ) { stats.pixels_covered += depth[i] != FLT_MAX; }
+  }
+  stats.overdraw = stats.pixels_covered > 0 ? (float)( (double)stats.pixels_shaded / stats.pixels_covered ) : 0.0f;
+  free( depth );
+  return stats;
+}
@@ -0,0 +1,74 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Mesh optimisation for indexed triangle lists, e.g. from                      |
+| load_obj_file_indexed() or Assimp. Exporters write triangles in any old      |
+| order; the GPU is faster when the order suits its caches. Run, in order:     |
+| 1. optimize_vertex_cache()  - triangle order for the post-transform cache,   |
+|                               so each vertex shader result gets reused       |
+|                               (Forsyth's linear-speed algorithm)             |
+| 2. optimize_overdraw()      - regroups the result so outward-facing parts    |
+|                               draw first and hide the parts behind them,     |
+|                               giving up only a little cache efficiency       |
+|                               (Sander, Nehab and Barczak 2007)               |
+| 3. optimize_vertex_fetch()  - vertex order to match, so vertex fetches walk  |
+|                               memory forwards                                |
+| Each is cheap enough to run at load time, or once offline before writing a   |
+| mesh cache. analyze_vertex_cache() and analyze_overdraw() measure the win.   |
+| Indices are 32-bit. optimize_vertex_cache() and optimize_overdraw() write to |
+| a separate dst array; optimize_vertex_fetch() rewrites the indices and the   |
+| vertex arrays in place.                                                      |
+\******************************************************************************/
+#ifndef _MESH_OPTIMIZER_H_
+#define _MESH_OPTIMIZER_H_
+
+// entries in the post-transform cache Forsyth's scoring assumes
+#define VERTEX_CACHE_OPT_SIZE 32
+// square image each view of analyze_overdraw() rasterises into
+#define OVERDRAW_VIEW_RES 256
+
+/* acmr - average cache miss ratio: vertex shader runs per triangle. 3 is the
+worst, about 0.5 the best possible on big regular meshes.
+atvr - average transform to vertex ratio: vertex shader runs per vertex. 1 is
+perfect, and means every vertex was transformed exactly once */
+struct vertex_cache_stats {
+  int transforms;
+  float acmr;
+  float atvr;
+};
+
+/* overdraw - fragments shaded per covered pixel, with back-face culling and a
+depth test, averaged over 6 axis-aligned views. 1 is perfect */
+struct overdraw_stats {
+  long long pixels_covered;
+  long long pixels_shaded;
+  float overdraw;
+};
+
+/* reorders the triangles in indices for the post-transform vertex cache. dst
+must not alias indices. triangles keep their winding */
+void optimize_vertex_cache( unsigned int* dst, const unsigned int* indices, int index_count, int vertex_count );
+
+/* reorders the vertex-cache-optimised indices to reduce overdraw. triangles are
+split into clusters, each starting with a cold cache, and the clusters sorted
+so those facing out from the mesh's centre draw first. threshold is how much
+worse the ACMR may get: 1.05 allows 5%, 1 keeps only the free splits. dst
+must not alias indices */
+void optimize_overdraw( unsigned int* dst, const unsigned int* indices, int index_count, const float* points, int vertex_count, float threshold );
+
+/* reorders the vertices in order of first use and rewrites indices to match,
+in place. points is 3 floats per vertex, tex_coords 2, normals 3; any may be
+NULL. unused vertices are dropped. returns the new vertex count. if it runs
+out of memory, nothing is changed and vertex_count is returned */
+int optimize_vertex_fetch( unsigned int* indices, int index_count, float* points, float* tex_coords, float* normals, int vertex_count );
+
+// simulates a FIFO post-transform cache of cache_size entries
+vertex_cache_stats analyze_vertex_cache( const unsigned int* indices, int index_count, int vertex_count, int cache_size );
+
+// rasterises the mesh on the CPU from +-x, +-y, +-z, counting depth test passes
+overdraw_stats analyze_overdraw( const unsigned int* indices, int index_count, const float* points, int vertex_count );
+
+#endif
@@ -0,0 +1,553 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Mesh simplification - see mesh_simplify.h.                                   |
+| Works in passes. Each pass lists every edge collapse allowed, sorts them by  |
+| error, and makes the cheapest ones that don't touch each other's             |
+| neighbourhoods, until there are few enough triangles. Then the index buffer  |
+| is remapped, degenerate triangles dropped, and the next pass starts.         |
+| Reference: M. Garland and P. Heckbert, "Surface Simplification Using Quadric |
+| Error Metrics", SIGGRAPH 1997                                                |
+\******************************************************************************/
+#include "mesh_simplify.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// how strongly border edges are held in place, vs the surface
+#define SIMPLIFY_BORDER_WEIGHT 10.0
+// how much a collapse across a normal crease costs, vs moving the surface
+#define SIMPLIFY_NORMAL_WEIGHT 0.5
+// a collapse may turn no triangle's normal more than about 75 degrees (cos = 0.25)
+#define SIMPLIFY_MIN_NORMAL_COS 0.25
+// a pass makes collapses up to this times the cost of the goal-th cheapest
+#define SIMPLIFY_PASS_COST_SLACK 1.5
+// build_lod_chain() stops when a level saves less than this
+#define LOD_MIN_REDUCTION 0.95f
+
+/*------------------------------------QUADRICS--------------------------------*/
+// error at p: p.A.p + 2 b.p + c, summed over planes, each weighted by area
+struct quadric {
+  double a00, a11, a22, a01, a02, a12;
+  double b0, b1, b2;
+  double c;
+  double w;
+};
+
+static void add_plane( quadric* q, const double* n, double d, double w ) {
+  q->a00 += w * n[0] * n[0];
+  q->a11 += w * n[1] * n[1];
+  q->a22 += w * n[2] * n[2];
+  q->a01 += w * n[0] * n[1];
+  q->a02 += w * n[0] * n[2];
+  q->a12 += w * n[1] * n[2];
+  q->b0 += w * d * n[0];
+  q->b1 += w * d * n[1];
+  q->b2 += w * d * n[2];
+  q->c += w * d * d;
+  q->w += w;
+}
+
+static void add_quadric( quadric* q, const quadric* r ) {
+  q->a00 += r->a00;
+  q->a11 += r->a11;
+  q->a22 += r->a22;
+  q->a01 += r->a01;
+  q->a02 += r->a02;
+  q->a12 += r->a12;
+  q->b0 += r->b0;
+  q->b1 += r->b1;
+  q->b2 += r->b2;
+  q->c += r->c;
+  q->w += r->w;
+}
+
+static double quadric_eval( const quadric* q, const float* p ) {
+  double x = p[0], y = p[1], z = p[2];
+  double e = q->a00 * x * x + q->a11 * y * y + q->a22 * z * z + 2.0 * ( q->a01 * x * y + q->a02 * x * z + q->a12 * y * z ) +
+             2.0 * ( q->b0 * x + q->b1 * y + q->b2 * z ) + q->c;
+  return e > 0.0 ? e : 0.0;
+}
+
+// unnormalised normal of the triangle a, b, c
+static void tri_normal( const float* a, const float* b, const float* c, double* n ) {
+  double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+  double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+  n[0]         = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1]         = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2]         = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+/*------------------------------------TOPOLOGY--------------------------------*/
+/* what a vertex may collapse onto. the table is indexed [from][to]:
+manifold - anything. border and seam - only their own kind, along the edge */
+enum vertex_kind_t { KIND_MANIFOLD = 0, KIND_BORDER, KIND_SEAM, KIND_LOCKED, KIND_COUNT };
+
+static const bool k_can_collapse[KIND_COUNT][KIND_COUNT] = {
+  { true, true, true, true },     // manifold
+  { false, true, false, false },  // border
+  { false, false, true, false },  // seam
+  { false, false, false, false }, // locked
+};
+
+struct simplify_state {
+  int vertex_count;
+  // first vertex with the same position, and a ring through all vertices at that position
+  unsigned int* remap;
+  unsigned int* wedge;
+  unsigned char* kind;
+  // the other end of the vertex's open (unpaired) edge, going out and coming in
+  unsigned int* loop;
+  unsigned int* loopback;
+  quadric* quadrics;
+  // adjacency of the current index buffer. vertex v's outgoing edges / triangles are [start[v], start[v + 1])
+  unsigned int* edge_start;
+  unsigned int* edge_to;
+  unsigned int* tri_start;
+  unsigned int* tri_list;
+};
+
+static unsigned int hash_position( const float* p ) {
+  unsigned int bits[3];
+  memcpy( bits, p, sizeof( bits ) );
+  unsigned int h = bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u;
+  return h ^ ( h >> 16 );
+}
+
+// remap and wedge. -0.0f and 0.0f count as different positions, which is harmless
+static bool build_position_remap( simplify_state* s, const float* points ) {
+  int n          = s->vertex_count;
+  unsigned int cap = 16;
+  while ( cap < (unsigned int)n * 2 ) { cap *= 2; }
+  unsigned int* table = (unsigned int*)malloc( cap * sizeof( unsigned int ) );
+  if ( !table ) { return false; }
+  memset( table, 0xff, cap * sizeof( unsigned int ) );
+  for ( int v = 0; v < n; v++ ) {
+    unsigned int slot = hash_position( &points[v * 3] ) & ( cap - 1 );
+    while ( table[slot] != ~0u && memcmp( &points[table[slot] * 3], &points[v * 3], 3 * sizeof( float ) ) ) { slot = ( slot + 1 ) & ( cap - 1 ); }
+    if ( table[slot] == ~0u ) {
+      table[slot] = v;
+      s->remap[v] = v;
+      s->wedge[v] = v;
+    } else {
+      // splice into the first vertex's ring
+      unsigned int first = table[slot];
+      s->remap[v]        = first;
+      s->wedge[v]        = s->wedge[first];
+      s->wedge[first]    = v;
+    }
+  }
+  free( table );
+  return true;
+}
+
+// builds edge_start/edge_to and tri_start/tri_list for indices
+static void build_adjacency( simplify_state* s, const unsigned int* indices, int index_count ) {
+  int n = s->vertex_count;
+  memset( s->edge_start, 0, ( n + 1 ) * sizeof( unsigned int ) );
+  for ( int i = 0; i < index_count; i++ ) { s->edge_start[indices[i] + 1]++; }
+  for ( int v = 0; v < n; v++ ) { s->edge_start[v + 1] += s->edge_start[v]; }
+  memcpy( s->tri_start, s->edge_start, ( n + 1 ) * sizeof( unsigned int ) );
+  // fill by bumping each vertex's start up to its end, then shift them all back one vertex
+  for ( int i = 0; i < index_count; i++ ) {
+    unsigned int v = indices[i];
+    unsigned int t = i / 3, next = indices[t * 3 + ( i + 1 ) % 3];
+    s->edge_to[s->edge_start[v]++]  = next;
+    s->tri_list[s->tri_start[v]++] = t;
+  }
+  memmove( s->edge_start + 1, s->edge_start, n * sizeof( unsigned int ) );
+  memmove( s->tri_start + 1, s->tri_start, n * sizeof( unsigned int ) );
+  s->edge_start[0] = s->tri_start[0] = 0;
+}
+
+static bool has_edge( const simplify_state* s, unsigned int a, unsigned int b ) {
+  for ( unsigned int i = s->edge_start[a]; i < s->edge_start[a + 1]; i++ ) {
+    if ( s->edge_to[i] == b ) { return true; }
+  }
+  return false;
+}
+
+// is there an edge from any vertex at a's position to any at b's?
+static bool has_position_edge( const simplify_state* s, unsigned int a, unsigned int b ) {
+  unsigned int w = a;
+  do {
+    for ( unsigned int i = s->edge_start[w]; i < s->edge_start[w + 1]; i++ ) {
+      if ( s->remap[s->edge_to[i]] == s->remap[b] ) { return true; }
+    }
+    w = s->wedge[w];
+  } while ( w != a );
+  return false;
+}
+
+static bool classify_vertices( simplify_state* s, const unsigned int* indices, int index_count, bool weld_seams ) {
+  int n = s->vertex_count;
+  // how many open edges leave and reach each vertex
+  unsigned char* open_out = (unsigned char*)calloc( n + 1, 1 );
+  unsigned char* open_in  = (unsigned char*)calloc( n + 1, 1 );
+  if ( !open_out || !open_in ) {
+    free( open_out );
+    free( open_in );
+    return false;
+  }
+  for ( int i = 0; i < index_count; i++ ) {
+    unsigned int a = indices[i], b = indices[( i / 3 ) * 3 + ( i + 1 ) % 3];
+    // welded, only edges open at the same positions count, and a position's wedges are counted as one
+    if ( weld_seams ? has_position_edge( s, b, a ) : has_edge( s, b, a ) ) { continue; }
+    if ( weld_seams ) { a = s->remap[a]; }
+    unsigned int b_count = weld_seams ? s->remap[b] : b;
+    open_out[a]          = open_out[a] < 255 ? open_out[a] + 1 : 255;
+    open_in[b_count]     = open_in[b_count] < 255 ? open_in[b_count] + 1 : 255;
+    s->loop[a]           = b;
+    s->loopback[b_count] = indices[i];
+  }
+  for ( int v = 0; v < n; v++ ) {
+    if ( s->remap[v] != (unsigned int)v ) { continue; }
+    unsigned int other = s->wedge[v];
+    unsigned char kind = KIND_LOCKED;
+    if ( other == (unsigned int)v || weld_seams ) {
+      if ( 0 == open_out[v] && 0 == open_in[v] ) {
+        kind = KIND_MANIFOLD;
+      } else if ( 1 == open_out[v] && 1 == open_in[v] ) {
+        kind = KIND_BORDER;
+      }
+    } else if ( s->wedge[other] == (unsigned int)v ) {
+      // two wedges, each with one open edge in and out, which the other side closes
+      bool simple = 1 == open_out[v] && 1 == open_in[v] && 1 == open_out[other] && 1 == open_in[other];
+      if ( simple && s->remap[s->loop[v]] == s->remap[s->loopback[other]] && s->remap[s->loopback[v]] == s->remap[s->loop[other]] &&
+           has_position_edge( s, s->loop[v], v ) && has_position_edge( s, v, s->loopback[v] ) ) {
+        kind = KIND_SEAM;
+      }
+    }
+    unsigned int w = v;
+    do {
+      s->kind[w] = kind;
+      if ( weld_seams ) {
+        s->loop[w]     = s->loop[v];
+        s->loopback[w] = s->loopback[v];
+      }
+      w = s->wedge[w];
+    } while ( w != (unsigned int)v );
+  }
+  free( open_out );
+  free( open_in );
+  return true;
+}
+
+/* after a pass, points the loops past vertices that collapsed. a loop that
+would now point at the vertex itself takes over the collapsed vertex's loop */
+static void remap_loops( unsigned int* loop, const unsigned int* collapse_to, const unsigned int* remap, int vertex_count ) {
+  for ( int v = 0; v < vertex_count; v++ ) {
+    unsigned int l = loop[v], r = collapse_to[l];
+    loop[v]        = remap[r] == remap[v] ? loop[l] : r;
+  }
+}
+
+static void build_quadrics( simplify_state* s, const unsigned int* indices, int index_count, const float* points ) {
+  memset( s->quadrics, 0, s->vertex_count * sizeof( quadric ) );
+  for ( int t = 0; t < index_count / 3; t++ ) {
+    const unsigned int* tri = &indices[t * 3];
+    double n[3];
+    tri_normal( &points[tri[0] * 3], &points[tri[1] * 3], &points[tri[2] * 3], n );
+    double len = sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    if ( len <= 0.0 ) { continue; }
+    for ( int k = 0; k < 3; k++ ) { n[k] /= len; }
+    const float* p0 = &points[tri[0] * 3];
+    double d        = -( n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2] );
+    for ( int c = 0; c < 3; c++ ) { add_plane( &s->quadrics[s->remap[tri[c]]], n, d, len * 0.5 ); }
+
+    // border edges get a plane at right angles to the surface, so they stay put
+    for ( int c = 0; c < 3; c++ ) {
+      unsigned int a = tri[c], b = tri[( c + 1 ) % 3];
+      if ( has_position_edge( s, b, a ) ) { continue; }
+      const float* pa = &points[a * 3];
+      const float* pb = &points[b * 3];
+      double e[3]     = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+      double bn[3]    = { e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0] };
+      double bl       = sqrt( bn[0] * bn[0] + bn[1] * bn[1] + bn[2] * bn[2] );
+      if ( bl <= 0.0 ) { continue; }
+      for ( int k = 0; k < 3; k++ ) { bn[k] /= bl; }
+      double bd = -( bn[0] * pa[0] + bn[1] * pa[1] + bn[2] * pa[2] );
+      double w  = ( e[0] * e[0] + e[1] * e[1] + e[2] * e[2] ) * SIMPLIFY_BORDER_WEIGHT;
+      add_plane( &s->quadrics[s->remap[a]], bn, bd, w );
+      add_plane( &s->quadrics[s->remap[b]], bn, bd, w );
+    }
+  }
+}
+
+/*------------------------------------COLLAPSES-------------------------------*/
+struct collapse {
+  unsigned int from;
+  unsigned int to;
+  float cost;
+};
+
+// cheapest first. ties broken by vertex so the result doesn't depend on qsort
+static int compare_collapses( const void* a, const void* b ) {
+  const collapse* ca = (const collapse*)a;
+  const collapse* cb = (const collapse*)b;
+  if ( ca->cost != cb->cost ) { return ca->cost < cb->cost ? -1 : 1; }
+  if ( ca->from != cb->from ) { return ca->from < cb->from ? -1 : 1; }
+  return ca->to < cb->to ? -1 : ( ca->to > cb->to ? 1 : 0 );
+}
+
+static bool collapse_allowed( const simplify_state* s, unsigned int from, unsigned int to ) {
+  if ( !k_can_collapse[s->kind[from]][s->kind[to]] ) { return false; }
+  // borders and seams only slide along themselves
+  if ( KIND_BORDER == s->kind[from] || KIND_SEAM == s->kind[from] ) {
+    return s->remap[to] == s->remap[s->loop[from]] || s->remap[to] == s->remap[s->loopback[from]];
+  }
+  return true;
+}
+
+// squared error, in world units, of moving from's position onto to's
+static double collapse_cost( const simplify_state* s, unsigned int from, unsigned int to, const float* points, const float* normals ) {
+  const quadric* qa = &s->quadrics[s->remap[from]];
+  const quadric* qb = &s->quadrics[s->remap[to]];
+  double w          = qa->w + qb->w;
+  double cost       = w > 0.0 ? ( quadric_eval( qa, &points[to * 3] ) + quadric_eval( qb, &points[to * 3] ) ) / w : 0.0;
+  if ( normals ) {
+    // the normals the moved corners lose, scaled by the edge so it's a distance too
+    const float* pa = &points[from * 3];
+    const float* pb = &points[to * 3];
+    double e2       = ( pb[0] - pa[0] ) * ( pb[0] - pa[0] ) + ( pb[1] - pa[1] ) * ( pb[1] - pa[1] ) + ( pb[2] - pa[2] ) * ( pb[2] - pa[2] );
+    const float* na = &normals[from * 3];
+    const float* nb = &normals[to * 3];
+    double dn       = ( na[0] - nb[0] ) * ( na[0] - nb[0] ) + ( na[1] - nb[1] ) * ( na[1] - nb[1] ) + ( na[2] - nb[2] ) * ( na[2] - nb[2] );
+    cost += SIMPLIFY_NORMAL_WEIGHT * dn * e2;
+  }
+  return cost;
+}
+
+// would moving from's position to to's turn any triangle around it too far, or over?
+static bool collapse_flips( const simplify_state* s, unsigned int from, unsigned int to, const unsigned int* indices, const float* points ) {
+  unsigned int w = from;
+  do {
+    for ( unsigned int i = s->tri_start[w]; i < s->tri_start[w + 1]; i++ ) {
+      const unsigned int* tri = &indices[s->tri_list[i] * 3];
+      // triangles on the edge itself just disappear
+      if ( s->remap[tri[0]] == s->remap[to] || s->remap[tri[1]] == s->remap[to] || s->remap[tri[2]] == s->remap[to] ) { continue; }
+      const float* p[3];
+      for ( int c = 0; c < 3; c++ ) { p[c] = &points[tri[c] * 3]; }
+      double before[3], after[3];
+      tri_normal( p[0], p[1], p[2], before );
+      for ( int c = 0; c < 3; c++ ) {
+        if ( tri[c] == w ) { p[c] = &points[to * 3]; }
+      }
+      tri_normal( p[0], p[1], p[2], after );
+      double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+      double lb  = before[0] * before[0] + before[1] * before[1] + before[2] * before[2];
+      double la  = after[0] * after[0] + after[1] * after[1] + after[2] * after[2];
+      if ( dot <= SIMPLIFY_MIN_NORMAL_COS * sqrt( lb * la ) ) { return true; }
+    }
+    w = s->wedge[w];
+  } while ( w != from );
+  return false;
+}
+
+/* stops the positions in every triangle around v's position moving again this
+pass. those are the only triangles a collapse of v changes, so every flip test
+in a pass sees the triangles as they'll end up */
+static void lock_neighbourhood( const simplify_state* s, unsigned int v, const unsigned int* indices, unsigned char* locked ) {
+  unsigned int w = v;
+  do {
+    for ( unsigned int i = s->tri_start[w]; i < s->tri_start[w + 1]; i++ ) {
+      const unsigned int* tri = &indices[s->tri_list[i] * 3];
+      for ( int c = 0; c < 3; c++ ) { locked[s->remap[tri[c]]] = 1; }
+    }
+    w = s->wedge[w];
+  } while ( w != v );
+  locked[s->remap[v]] = 1;
+}
+
+static void free_state( simplify_state* s ) {
+  free( s->remap );
+  free( s->wedge );
+  free( s->kind );
+  free( s->loop );
+  free( s->loopback );
+  free( s->quadrics );
+  free( s->edge_start );
+  free( s->edge_to );
+  free( s->tri_start );
+  free( s->tri_list );
+}
+
+int simplify_mesh( unsigned int* dst, const unsigned int* indices, int index_count, const float* points, const float* normals, int vertex_count,
+  int target_index_count, float target_error, unsigned int flags, float* result_error ) {
+  index_count -= index_count % 3;
+  memmove( dst, indices, (size_t)index_count * sizeof( unsigned int ) );
+  if ( result_error ) { *result_error = 0.0f; }
+  if ( index_count <= target_index_count || vertex_count <= 0 ) { return index_count; }
+
+  simplify_state s;
+  memset( &s, 0, sizeof( s ) );
+  size_t vn         = (size_t)vertex_count + 1;
+  s.vertex_count    = vertex_count;
+  s.remap           = (unsigned int*)malloc( vn * sizeof( unsigned int ) );
+  s.wedge           = (unsigned int*)malloc( vn * sizeof( unsigned int ) );
+  s.kind            = (unsigned char*)malloc( vn );
+  s.loop            = (unsigned int*)malloc( vn * sizeof( unsigned int ) );
+  s.loopback        = (unsigned int*)malloc( vn * sizeof( unsigned int ) );
+  s.quadrics        = (quadric*)malloc( vn * sizeof( quadric ) );
+  s.edge_start      = (unsigned int*)malloc( ( vn + 1 ) * sizeof( unsigned int ) );
+  s.edge_to         = (unsigned int*)malloc( (size_t)index_count * sizeof( unsigned int ) + 1 );
+  s.tri_start       = (unsigned int*)malloc( ( vn + 1 ) * sizeof( unsigned int ) );
+  s.tri_list        = (unsigned int*)malloc( (size_t)index_count * sizeof( unsigned int ) + 1 );
+  collapse* cands   = (collapse*)malloc( (size_t)index_count * sizeof( collapse ) + 1 );
+  unsigned int* collapse_to = (unsigned int*)malloc( vn * sizeof( unsigned int ) );
+  unsigned char* locked = (unsigned char*)malloc( vn );
+  if ( !s.remap || !s.wedge || !s.kind || !s.loop || !s.loopback || !s.quadrics || !s.edge_start || !s.edge_to || !s.tri_start || !s.tri_list || !cands ||
+       !collapse_to || !locked || !build_position_remap( &s, points ) ) {
+    fprintf( stderr, "ERROR: out of memory simplifying mesh\n" );
+    free_state( &s );
+    free( cands );
+    free( collapse_to );
+    free( locked );
+    return index_count;
+  }
+  for ( int v = 0; v < vertex_count; v++ ) { s.loop[v] = s.loopback[v] = v; }
+  build_adjacency( &s, dst, index_count );
+  if ( !classify_vertices( &s, dst, index_count, 0 != ( flags & SIMPLIFY_WELD_SEAMS ) ) ) {
+    fprintf( stderr, "ERROR: out of memory simplifying mesh\n" );
+    free_state( &s );
+    free( cands );
+    free( collapse_to );
+    free( locked );
+    return index_count;
+  }
+  build_quadrics( &s, dst, index_count, points );
+
+  // errors are compared squared and in world units
+  float mn[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for ( int v = 0; v < vertex_count; v++ ) {
+    for ( int k = 0; k < 3; k++ ) {
+      mn[k] = fminf( mn[k], points[v * 3 + k] );
+      mx[k] = fmaxf( mx[k], points[v * 3 + k] );
+    }
+  }
+  double extent    = fmax( mx[0] - mn[0], fmax( mx[1] - mn[1], mx[2] - mn[2] ) );
+  double max_cost  = target_error >= FLT_MAX ? DBL_MAX : (double)target_error * target_error * extent * extent;
+  double worst     = 0.0;
+
+  while ( index_count > target_index_count ) {
+    // every allowed collapse of every edge, cheaper direction first
+    int n_cands = 0;
+    for ( int i = 0; i < index_count; i++ ) {
+      unsigned int a = dst[i], b = dst[( i / 3 ) * 3 + ( i + 1 ) % 3];
+      // each edge once: the triangle on the other side lists it as b, a
+      if ( s.remap[a] == s.remap[b] || ( a > b && has_edge( &s, b, a ) ) ) { continue; }
+      bool ab = collapse_allowed( &s, a, b ), ba = collapse_allowed( &s, b, a );
+      if ( !ab && !ba ) { continue; }
+      double cab = ab ? collapse_cost( &s, a, b, points, normals ) : DBL_MAX;
+      double cba = ba ? collapse_cost( &s, b, a, points, normals ) : DBL_MAX;
+      collapse c;
+      c.from           = cab <= cba ? a : b;
+      c.to             = cab <= cba ? b : a;
+      c.cost           = (float)( cab <= cba ? cab : cba );
+      cands[n_cands++] = c;
+    }
+    qsort( cands, n_cands, sizeof( collapse ), compare_collapses );
+
+    for ( int v = 0; v < vertex_count; v++ ) { collapse_to[v] = v; }
+    memset( locked, 0, vertex_count );
+    // each collapse removes about 2 triangles (1 on a border)
+    int goal = ( index_count - target_index_count ) / 3, removed = 0, made = 0;
+    /* neighbourhood locks turn down about half the collapses, leaving cheap
+    ones for the next pass, so don't reach far past the cost of the goal-th */
+    double pass_cost = n_cands > 0 ? cands[goal < n_cands ? goal : n_cands - 1].cost * SIMPLIFY_PASS_COST_SLACK : 0.0;
+    for ( int i = 0; i < n_cands && removed < goal; i++ ) {
+      const collapse* c = &cands[i];
+      if ( c->cost > max_cost || ( c->cost > pass_cost && made > 0 ) ) { break; }
+      if ( locked[s.remap[c->from]] || locked[s.remap[c->to]] ) { continue; }
+      if ( collapse_flips( &s, c->from, c->to, dst, points ) ) { continue; }
+      if ( KIND_SEAM == s.kind[c->from] ) {
+        // both sides of the seam move together, each onto its own side
+        collapse_to[c->from]          = c->to;
+        collapse_to[s.wedge[c->from]] = s.wedge[c->to];
+      } else {
+        unsigned int w = c->from;
+        do {
+          collapse_to[w] = c->to;
+          w              = s.wedge[w];
+        } while ( w != c->from );
+      }
+      add_quadric( &s.quadrics[s.remap[c->to]], &s.quadrics[s.remap[c->from]] );
+      lock_neighbourhood( &s, c->from, dst, locked );
+      worst = c->cost > worst ? c->cost : worst;
+      removed += KIND_BORDER == s.kind[c->from] ? 1 : 2;
+      made++;
+    }
+    if ( 0 == made ) { break; }
+
+    // apply the pass, dropping triangles that lost a corner
+    int out = 0;
+    for ( int t = 0; t < index_count / 3; t++ ) {
+      unsigned int a = collapse_to[dst[t * 3]], b = collapse_to[dst[t * 3 + 1]], c = collapse_to[dst[t * 3 + 2]];
+      if ( s.remap[a] == s.remap[b] || s.remap[b] == s.remap[c] || s.remap[a] == s.remap[c] ) { continue; }
+      dst[out++] = a;
+      dst[out++] = b;
+      dst[out++] = c;
+    }
+    index_count = out;
+    remap_loops( s.loop, collapse_to, s.remap, vertex_count );
+    remap_loops( s.loopback, collapse_to, s.remap, vertex_count );
+    build_adjacency( &s, dst, index_count );
+  }
+
+  if ( result_error ) { *result_error = extent > 0.0 ? (float)( sqrt( worst ) / extent ) : 0.0f; }
+  free_state( &s );
+  free( cands );
+  free( collapse_to );
+  free( locked );
+  return index_count;
+}
+
+/*--------------------------------------LODS----------------------------------*/
+int build_lod_chain( const unsigned int* indices, int index_count, const float* points, const float* normals, int vertex_count, int max_levels,
+  float ratio, float max_error, unsigned int flags, mesh_lod* lods ) {
+  if ( max_levels > MAX_MESH_LODS ) { max_levels = MAX_MESH_LODS; }
+  if ( max_levels < 1 ) { return 0; }
+  index_count -= index_count % 3;
+  lods[0].indices = (unsigned int*)malloc( (size_t)index_count * sizeof( unsigned int ) + 1 );
+  if ( !lods[0].indices ) {
+    fprintf( stderr, "ERROR: out of memory building LODs\n" );
+    return 0;
+  }
+  memcpy( lods[0].indices, indices, (size_t)index_count * sizeof( unsigned int ) );
+  lods[0].index_count = index_count;
+  lods[0].error       = 0.0f;
+
+  int levels = 1;
+  for ( ; levels < max_levels; levels++ ) {
+    int prev   = lods[levels - 1].index_count;
+    int target = (int)( prev / 3 * ratio ) * 3;
+    unsigned int* lod = (unsigned int*)malloc( (size_t)index_count * sizeof( unsigned int ) + 1 );
+    if ( !lod ) {
+      fprintf( stderr, "ERROR: out of memory building LODs\n" );
+      break;
+    }
+    float error = 0.0f;
+    int count   = simplify_mesh( lod, indices, index_count, points, normals, vertex_count, target, max_error, flags, &error );
+    if ( count == 0 || count > prev * LOD_MIN_REDUCTION ) {
+      free( lod );
+      break;
+    }
+    lods[levels].indices     = lod;
+    lods[levels].index_count = count;
+    lods[levels].error       = error;
+  }
+  return levels;
+}
+
+void free_lod_chain( mesh_lod* lods, int count ) {
+  for ( int i = 0; i < count; i++ ) {
+    free( lods[i].indices );
+    lods[i].indices     = NULL;
+    lods[i].index_count = 0;
+  }
+}
@@ -0,0 +1,60 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Mesh simplification by edge collapse, with quadric error metrics (Garland    |
+| and Heckbert 1997), for indexed meshes from load_obj_file_indexed() or       |
+| Assimp. Only the index buffer changes: each collapse moves a vertex onto a   |
+| neighbour that already exists, so every LOD draws from the one vertex        |
+| buffer and a LOD switch is just a different index buffer.                    |
+| Attributes are kept by never moving what would show:                         |
+| - mesh borders only collapse along the border                                |
+| - texture/normal seams (vertices split by load_obj_file_indexed() because    |
+|   vt or vn differ) only collapse along the seam, both sides together         |
+| - anywhere else three or more splits meet is locked                          |
+|   (or, with SIMPLIFY_WELD_SEAMS, vertices at one position move as one and    |
+|   the seams may smear - for meshes whose UVs don't matter)                   |
+| - with normals, collapses across a crease cost more                          |
+| - collapses that would flip a triangle are refused                           |
+| Errors are distances relative to the mesh's size (its bounding box's         |
+| longest side): 0.01 is 1% of the mesh.                                       |
+\******************************************************************************/
+#ifndef _MESH_SIMPLIFY_H_
+#define _MESH_SIMPLIFY_H_
+
+// most LODs build_lod_chain() makes, including the original
+#define MAX_MESH_LODS 16
+
+// flags. treats all vertices at a position as one, ignoring vt/vn splits
+#define SIMPLIFY_WELD_SEAMS 1u
+
+/* one level of detail: an index buffer into the original vertex arrays. error
+is how far simplification may have moved the surface */
+struct mesh_lod {
+  unsigned int* indices;
+  int index_count;
+  float error;
+};
+
+/* simplifies a triangle list to target_index_count indices or fewer, unless
+that would mean an error above target_error (FLT_MAX for no limit). dst must
+hold index_count indices and may alias indices. points is 3 floats per vertex;
+normals (3 floats) may be NULL. flags are SIMPLIFY_ flags, or 0. returns the
+new index count, and sets result_error, if not NULL, to the largest error of
+the collapses made */
+int simplify_mesh( unsigned int* dst, const unsigned int* indices, int index_count, const float* points, const float* normals, int vertex_count,
+  int target_index_count, float target_error, unsigned int flags, float* result_error );
+
+/* builds up to max_levels LODs. lods[0] is a copy of the original, and each
+level after has about ratio times the triangles of the one before, simplified
+from the original so the errors don't build up. no level goes past max_error
+(FLT_MAX for no limit), so the chain stops early once the next level would
+have to. returns the number of levels. free with free_lod_chain() */
+int build_lod_chain( const unsigned int* indices, int index_count, const float* points, const float* normals, int vertex_count, int max_levels,
+  float ratio, float max_error, unsigned int flags, mesh_lod* lods );
+
+void free_lod_chain( mesh_lod* lods, int count );
+
+#endif
@@ -0,0 +1,279 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Meshlets - see meshlet.h.                                                    |
+\******************************************************************************/
+#include "meshlet.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// how much facing the same way counts against being close by, when growing a meshlet. 0 to 1
+#define MESHLET_CONE_WEIGHT 0.25f
+
+/*------------------------------------BUILDING--------------------------------*/
+size_t meshlet_count_bound( int index_count, int max_vertices, int max_triangles ) {
+  /* a meshlet only closes with max_triangles triangles, or with at least
+  max_vertices - 2 vertices, when the next triangle might not fit. either way
+  it used at least that many indices. the last one may be short */
+  if ( max_vertices > 256 ) { max_vertices = 256; }
+  if ( max_vertices < 3 || max_triangles < 1 ) { return 0; }
+  size_t per_meshlet = (size_t)max_vertices - 2 < (size_t)max_triangles * 3 ? (size_t)max_vertices - 2 : (size_t)max_triangles * 3;
+  return (size_t)index_count / per_meshlet + 1;
+}
+
+// a meshlet being grown
+struct meshlet_builder {
+  meshlet m;
+  float centre_sum[3];
+  float normal_sum[3];
+};
+
+static float dot3( const float* a, const float* b ) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+// vertices of tri not in the meshlet yet, counting repeats once
+static int count_new_vertices( const unsigned int* tri, const unsigned char* local ) {
+  return ( 0xff == local[tri[0]] ) + ( 0xff == local[tri[1]] && tri[1] != tri[0] ) + ( 0xff == local[tri[2]] && tri[2] != tri[0] && tri[2] != tri[1] );
+}
+
+size_t build_meshlets( meshlet* meshlets, unsigned int* meshlet_vertices, unsigned char* meshlet_triangles, const unsigned int* indices, int index_count,
+  const float* points, int vertex_count, int max_vertices, int max_triangles ) {
+  if ( max_vertices > 256 ) { max_vertices = 256; }
+  if ( max_vertices < 3 || max_triangles < 1 ) { return 0; }
+  int tri_count = index_count / 3;
+  // per vertex: triangles not in a meshlet yet, as a slice of adj starting at adj_start
+  int* live        = (int*)calloc( vertex_count + 1, sizeof( int ) );
+  int* adj_start   = (int*)malloc( ( vertex_count + 1 ) * sizeof( int ) );
+  int* adj         = (int*)malloc( (size_t)tri_count * 3 * sizeof( int ) + 1 );
+  // where each vertex is in the current meshlet's vertex list, or 0xff
+  unsigned char* local = (unsigned char*)malloc( vertex_count + 1 );
+  char* used           = (char*)calloc( tri_count + 1, 1 );
+  // per triangle: centroid, then unit normal
+  float* tri_info = (float*)malloc( (size_t)tri_count * 6 * sizeof( float ) + 1 );
+  if ( !live || !adj_start || !adj || !local || !used || !tri_info ) {
+    fprintf( stderr, "ERROR: out of memory building meshlets\n" );
+    free( live );
+    free( adj_start );
+    free( adj );
+    free( local );
+    free( used );
+    free( tri_info );
+    return 0;
+  }
+  for ( int i = 0; i < tri_count * 3; i++ ) { live[indices[i]]++; }
+  int offset = 0;
+  for ( int v = 0; v < vertex_count; v++ ) {
+    adj_start[v] = offset;
+    offset += live[v];
+    live[v] = 0;
+  }
+  for ( int i = 0; i < tri_count * 3; i++ ) { adj[adj_start[indices[i]] + live[indices[i]]++] = i / 3; }
+  memset( local, 0xff, vertex_count );
+  for ( int t = 0; t < tri_count; t++ ) {
+    const float* p0 = &points[indices[t * 3] * 3];
+    const float* p1 = &points[indices[t * 3 + 1] * 3];
+    const float* p2 = &points[indices[t * 3 + 2] * 3];
+    float* info     = &tri_info[t * 6];
+    float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] }, e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    float n[3]  = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+    float l     = sqrtf( dot3( n, n ) );
+    for ( int k = 0; k < 3; k++ ) {
+      info[k]     = ( p0[k] + p1[k] + p2[k] ) / 3.0f;
+      info[3 + k] = l > 0.0f ? n[k] / l : 0.0f;
+    }
+  }
+
+  size_t count = 0;
+  meshlet_builder b;
+  memset( &b, 0, sizeof( b ) );
+  int scan_from = 0, emitted = 0, next_tri = -1;
+  while ( emitted < tri_count ) {
+    if ( next_tri < 0 ) {
+      // nothing next to the meshlet. carry on from the next triangle in index order
+      while ( used[scan_from] ) { scan_from++; }
+      next_tri = scan_from;
+    }
+    const unsigned int* tri = &indices[next_tri * 3];
+    int new_verts           = count_new_vertices( tri, local );
+    // full: close the meshlet, and put this triangle in the next one
+    if ( b.m.vertex_count + new_verts > (unsigned int)max_vertices || b.m.triangle_count >= (unsigned int)max_triangles ) {
+      for ( unsigned int i = 0; i < b.m.vertex_count; i++ ) { local[meshlet_vertices[b.m.vertex_offset + i]] = 0xff; }
+      meshlets[count++]        = b.m;
+      unsigned int next_vertex = b.m.vertex_offset + b.m.vertex_count;
+      unsigned int next_index  = b.m.triangle_offset + b.m.triangle_count * 3;
+      memset( &b, 0, sizeof( b ) );
+      b.m.vertex_offset   = next_vertex;
+      b.m.triangle_offset = next_index;
+    }
+
+    // add the triangle
+    for ( int c = 0; c < 3; c++ ) {
+      if ( 0xff == local[tri[c]] ) {
+        local[tri[c]]                                           = (unsigned char)b.m.vertex_count;
+        meshlet_vertices[b.m.vertex_offset + b.m.vertex_count++] = tri[c];
+      }
+      meshlet_triangles[b.m.triangle_offset + b.m.triangle_count * 3 + c] = local[tri[c]];
+    }
+    b.m.triangle_count++;
+    for ( int k = 0; k < 3; k++ ) {
+      b.centre_sum[k] += tri_info[next_tri * 6 + k];
+      b.normal_sum[k] += tri_info[next_tri * 6 + 3 + k];
+    }
+    used[next_tri] = 1;
+    emitted++;
+    for ( int c = 0; c < 3; c++ ) {
+      int* list = &adj[adj_start[tri[c]]];
+      for ( int i = 0; i < live[tri[c]]; i++ ) {
+        if ( list[i] == next_tri ) {
+          list[i] = list[--live[tri[c]]];
+          break;
+        }
+      }
+    }
+
+    /* pick the next triangle from those touching the meshlet: fewest new
+    vertices first, then closest to the meshlet's middle, and facing its way */
+    float centre[3], axis[3];
+    float nl = sqrtf( dot3( b.normal_sum, b.normal_sum ) );
+    for ( int k = 0; k < 3; k++ ) {
+      centre[k] = b.centre_sum[k] / b.m.triangle_count;
+      axis[k]   = nl > 0.0f ? b.normal_sum[k] / nl : 0.0f;
+    }
+    // distances are compared relative to the meshlet's spread so far
+    float spread = 0.0f;
+    for ( unsigned int i = 0; i < b.m.vertex_count; i++ ) {
+      const float* p = &points[meshlet_vertices[b.m.vertex_offset + i] * 3];
+      float d[3]     = { p[0] - centre[0], p[1] - centre[1], p[2] - centre[2] };
+      spread         = fmaxf( spread, dot3( d, d ) );
+    }
+    next_tri          = -1;
+    int best_new      = 4, seed_tri = -1;
+    float best_score  = FLT_MAX, seed_score = FLT_MAX;
+    bool meshlet_full = b.m.triangle_count >= (unsigned int)max_triangles;
+    for ( unsigned int i = 0; i < b.m.vertex_count; i++ ) {
+      unsigned int v  = meshlet_vertices[b.m.vertex_offset + i];
+      const int* list = &adj[adj_start[v]];
+      for ( int j = 0; j < live[v]; j++ ) {
+        int t             = list[j];
+        int extra         = count_new_vertices( &indices[t * 3], local );
+        const float* info = &tri_info[t * 6];
+        float d[3]        = { info[0] - centre[0], info[1] - centre[1], info[2] - centre[2] };
+        float dist        = spread > 0.0f ? dot3( d, d ) / spread : 0.0f;
+        float score       = ( 1.0f - MESHLET_CONE_WEIGHT ) * dist + MESHLET_CONE_WEIGHT * ( 1.0f - dot3( &info[3], axis ) );
+        if ( score < seed_score ) {
+          seed_score = score;
+          seed_tri   = t;
+        }
+        if ( meshlet_full || b.m.vertex_count + extra > (unsigned int)max_vertices ) { continue; }
+        if ( extra < best_new || ( extra == best_new && score < best_score ) ) {
+          best_new   = extra;
+          best_score = score;
+          next_tri   = t;
+        }
+      }
+    }
+    // nothing more fits: start the next meshlet next door to this one, so it's compact too
+    if ( next_tri < 0 ) { next_tri = seed_tri; }
+  }
+  if ( b.m.triangle_count > 0 ) { meshlets[count++] = b.m; }
+  free( live );
+  free( adj_start );
+  free( adj );
+  free( local );
+  free( used );
+  free( tri_info );
+  return count;
+}
+
+/*-------------------------------------BOUNDS---------------------------------*/
+meshlet_bounds compute_meshlet_bounds( const meshlet& m, const unsigned int* meshlet_vertices, const unsigned char* meshlet_triangles, const float* points ) {
+  meshlet_bounds b;
+  memset( &b, 0, sizeof( b ) );
+  const unsigned int* verts = &meshlet_vertices[m.vertex_offset];
+
+  // sphere: middle of the box, then the furthest point. not minimal, but close for compact clusters
+  float mn[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, mx[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for ( unsigned int i = 0; i < m.vertex_count; i++ ) {
+    const float* p = &points[verts[i] * 3];
+    for ( int k = 0; k < 3; k++ ) {
+      mn[k] = fminf( mn[k], p[k] );
+      mx[k] = fmaxf( mx[k], p[k] );
+    }
+  }
+  for ( int k = 0; k < 3; k++ ) { b.centre[k] = ( mn[k] + mx[k] ) * 0.5f; }
+  float r2 = 0.0f;
+  for ( unsigned int i = 0; i < m.vertex_count; i++ ) {
+    const float* p = &points[verts[i] * 3];
+    float d[3]     = { p[0] - b.centre[0], p[1] - b.centre[1], p[2] - b.centre[2] };
+    r2             = fmaxf( r2, dot3( d, d ) );
+  }
+  // a hair bigger, so float rounding in the cull test can't clip a corner
+  b.radius = sqrtf( r2 ) * 1.0001f;
+
+  // cone: the average normal, and the widest angle any triangle's normal makes with it
+  float sum[3] = { 0.0f, 0.0f, 0.0f }, min_dot = 1.0f;
+  for ( int pass = 0; pass < 2; pass++ ) {
+    for ( unsigned int t = 0; t < m.triangle_count; t++ ) {
+      const unsigned char* tri = &meshlet_triangles[m.triangle_offset + t * 3];
+      const float* p0          = &points[verts[tri[0]] * 3];
+      const float* p1          = &points[verts[tri[1]] * 3];
+      const float* p2          = &points[verts[tri[2]] * 3];
+      float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] }, e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      float n[3]  = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+      float l     = sqrtf( dot3( n, n ) );
+      // degenerate triangles are never drawn, so don't constrain the cone
+      if ( l <= 0.0f ) { continue; }
+      for ( int k = 0; k < 3; k++ ) { n[k] /= l; }
+      if ( 0 == pass ) {
+        for ( int k = 0; k < 3; k++ ) { sum[k] += n[k]; }
+      } else {
+        min_dot = fminf( min_dot, dot3( n, b.cone_axis ) );
+      }
+    }
+    float sl = sqrtf( dot3( sum, sum ) );
+    if ( sl <= 0.0f ) {
+      b.cone_cos = 0.0f;
+      return b;
+    }
+    for ( int k = 0; k < 3; k++ ) { b.cone_axis[k] = sum[k] / sl; }
+  }
+  // slightly wider than measured, for the same reason as the radius
+  b.cone_cos = min_dot - 1e-4f;
+  b.cone_sin = b.cone_cos > 0.0f ? sqrtf( 1.0f - b.cone_cos * b.cone_cos ) : 1.0f;
+  return b;
+}
+
+/*-------------------------------------CULLING--------------------------------*/
+/* every triangle faces away if, for each point p in the sphere and normal n in
+the cone, (p - camera).n >= 0. the worst p is radius closer along n, and the
+worst n is the cone's half-angle further round from the direction to the
+centre, so with d = centre - camera at angle theta to the axis, that's
+|d| cos(theta + half-angle) >= radius */
+static bool meshlet_backfacing( const meshlet_bounds& b, const vec3& camera_pos ) {
+  if ( b.cone_cos <= 0.0f ) { return false; }
+  float d[3] = { b.centre[0] - camera_pos.v[0], b.centre[1] - camera_pos.v[1], b.centre[2] - camera_pos.v[2] };
+  float len  = sqrtf( dot3( d, d ) );
+  if ( len <= b.radius ) { return false; }
+  float cos_theta = dot3( d, b.cone_axis ) / len;
+  float sin_theta = sqrtf( fmaxf( 0.0f, 1.0f - cos_theta * cos_theta ) );
+  return cos_theta * b.cone_cos - sin_theta * b.cone_sin >= b.radius / len;
+}
+
+size_t cull_meshlets( const frustum& f, const vec3& camera_pos, const meshlet_bounds* bounds, size_t count, unsigned int* visible ) {
+  size_t n = 0;
+  for ( size_t i = 0; i < count; i++ ) {
+    const meshlet_bounds& b = bounds[i];
+    bool inside             = true;
+    for ( int p = 0; p < 6 && inside; p++ ) {
+      float d = f.planes[p][0] * b.centre[0] + f.planes[p][1] * b.centre[1] + f.planes[p][2] * b.centre[2] + f.planes[p][3];
+      inside  = d >= -b.radius;
+    }
+    if ( inside && !meshlet_backfacing( b, camera_pos ) ) { visible[n++] = (unsigned int)i; }
+  }
+  return n;
+}
@@ -0,0 +1,68 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Meshlets: an indexed mesh cut into small clusters of neighbouring triangles, |
+| each with bounds, so whole clusters can be culled on the CPU before drawing. |
+| Each meshlet has its own small vertex list (indices into the mesh's vertex   |
+| arrays) and triangles as 3 bytes of local index each, like mesh shaders use. |
+| Every meshlet has a bounding sphere, for frustum culling, and a normal cone  |
+| - an axis and angle that all its triangles' normals lie within - for culling |
+| clusters that face entirely away from the camera.                            |
+| Triangle order matters: run optimize_vertex_cache() first for tidier         |
+| clusters when the mesh comes straight from an exporter.                      |
+\******************************************************************************/
+#ifndef _MESHLET_H_
+#define _MESHLET_H_
+
+#include "maths_funcs.h"
+#include <stddef.h>
+
+// sizes that suit mesh shader hardware: 124 * 3 local indices + padding fit in 384 bytes
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+/* vertices are meshlet_vertices[vertex_offset, vertex_offset + vertex_count).
+triangles are 3 bytes each in meshlet_triangles starting at triangle_offset,
+indexing the meshlet's own vertex list */
+struct meshlet {
+  unsigned int vertex_offset;
+  unsigned int triangle_offset;
+  unsigned int vertex_count;
+  unsigned int triangle_count;
+};
+
+/* centre and radius bound every point. cone_axis is unit length; every
+triangle's normal is within the cone's half-angle of it. cone_cos is that
+angle's cosine, and 0 or less if the normals spread too far to cull by */
+struct meshlet_bounds {
+  float centre[3];
+  float radius;
+  float cone_axis[3];
+  float cone_cos;
+  float cone_sin;
+};
+
+/* most meshlets build_meshlets() can write for index_count indices. size the
+arrays with this: meshlets by the count, meshlet_vertices by count * max_vertices
+and meshlet_triangles by count * max_triangles * 3 */
+size_t meshlet_count_bound( int index_count, int max_vertices, int max_triangles );
+
+/* cuts a triangle list into meshlets of at most max_vertices (up to 256) and
+max_triangles. grows each meshlet across neighbouring triangles, preferring
+those that add the fewest vertices, then those nearest and facing the same way.
+points is 3 floats per vertex. returns the number of meshlets */
+size_t build_meshlets( meshlet* meshlets, unsigned int* meshlet_vertices, unsigned char* meshlet_triangles, const unsigned int* indices, int index_count,
+  const float* points, int vertex_count, int max_vertices, int max_triangles );
+
+meshlet_bounds compute_meshlet_bounds( const meshlet& m, const unsigned int* meshlet_vertices, const unsigned char* meshlet_triangles, const float* points );
+
+/* writes the indices of the meshlets that are in the frustum and not facing
+entirely away from camera_pos to visible, and returns how many. get the frustum
+from P * V and camera_pos in world space, or from P * V * M and camera_pos in
+the mesh's local space. conservative - it never culls a visible triangle */
+size_t cull_meshlets( const frustum& f, const vec3& camera_pos, const meshlet_bounds* bounds, size_t count, unsigned int* visible );
+
+#endif
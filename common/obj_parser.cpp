@@ -0,0 +1,926 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 7 Nov 2013                                                     |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Anton's lazy Wavefront OBJ parser                                            |
+| Anton Gerdelan 7 Nov 2013                                                    |
+| Notes:                                                                       |
+| I ignore MTL files                                                           |
+| Mesh MUST be triangulated - quads not accepted                               |
+| Mesh MUST contain vertex points, normals, and texture coordinates            |
+| Faces MUST come after the v/vt/vn lines they refer to                        |
+| Single pass over a memory-mapped file. The first version read the file twice |
+| with fgets() and sscanf()'d every line, which took seconds on big scans.     |
+| Big files are cut into chunks and parsed on all cores - see parse_threaded() |
+\******************************************************************************/
+#include "obj_parser.h"
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined( OBJ_NO_THREADS )
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
+
+// load_obj_file_streamed() reads the file this much at a time
+#define OBJ_STREAM_READ_BYTES ( 1 << 20 )
+// chunks for the threaded parser are at least this big
+#define OBJ_MIN_CHUNK_BYTES ( 1 << 20 )
+
+/*---------------------------------SCANNING-----------------------------------*/
+// powers of 10 that are exact in a double
+static const double k_pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+  1e21, 1e22 };
+
+static bool is_digit( char c ) { return c >= '0' && c <= '9'; }
+
+static const char* skip_blanks( const char* p, const char* end ) {
+  while ( p < end && ( ' ' == *p || '\t' == *p ) ) { p++; }
+  return p;
+}
+
+static const char* next_line( const char* p, const char* end ) {
+  const char* nl = (const char*)memchr( p, '\n', end - p );
+  return nl ? nl + 1 : end;
+}
+
+/* anything the fast path can't do exactly (more than 15 or so significant
+digits, big exponents, inf, nan, hex) goes through strtof() so the result is
+always the correctly-rounded float that sscanf( "%f" ) gives */
+static bool scan_float_slow( const char*& p, const char* end, float& out ) {
+  char buf[64];
+  size_t n = 0;
+  while ( p + n < end && n < sizeof( buf ) - 1 && p[n] != ' ' && p[n] != '\t' && p[n] != '\r' && p[n] != '\n' ) {
+    buf[n] = p[n];
+    n++;
+  }
+  buf[n]    = '\0';
+  char* ep  = buf;
+  float f   = strtof( buf, &ep );
+  if ( ep == buf ) { return false; }
+  out = f;
+  p += ep - buf;
+  return true;
+}
+
+/* reads a decimal float at p and moves p past it. returns false, without
+moving p, if there isn't one */
+static bool scan_float( const char*& p, const char* end, float& out ) {
+  const char* s = p;
+  bool neg      = false;
+  if ( s < end && ( '-' == *s || '+' == *s ) ) {
+    neg = '-' == *s;
+    s++;
+  }
+  unsigned long long mant = 0;
+  int sig_digits = 0, exp10 = 0;
+  bool any_digits = false, truncated = false;
+  for ( ; s < end && is_digit( *s ); s++ ) {
+    any_digits = true;
+    if ( sig_digits < 19 ) {
+      mant = mant * 10 + ( *s - '0' );
+      if ( mant ) { sig_digits++; }
+    } else {
+      exp10++;
+      truncated = true;
+    }
+  }
+  if ( s < end && '.' == *s ) {
+    for ( s++; s < end && is_digit( *s ); s++ ) {
+      any_digits = true;
+      if ( sig_digits < 19 ) {
+        mant = mant * 10 + ( *s - '0' );
+        if ( mant ) { sig_digits++; }
+        exp10--;
+      } else {
+        truncated = true;
+      }
+    }
+  }
+  if ( !any_digits ) { return scan_float_slow( p, end, out ); }
+  if ( s < end && ( 'e' == *s || 'E' == *s ) ) {
+    const char* e = s + 1;
+    bool eneg     = false;
+    if ( e < end && ( '-' == *e || '+' == *e ) ) {
+      eneg = '-' == *e;
+      e++;
+    }
+    if ( e < end && is_digit( *e ) ) {
+      int ev = 0;
+      for ( ; e < end && is_digit( *e ); e++ ) {
+        if ( ev < 10000 ) { ev = ev * 10 + ( *e - '0' ); }
+      }
+      exp10 += eneg ? -ev : ev;
+      s = e;
+    }
+  }
+  /* Clinger's fast path: mant and 10^exp10 are both exact doubles, so one
+  multiply or divide gives the correctly-rounded double. rounding that again to
+  float only differs from rounding straight to float when the double lands
+  exactly half way between two floats (low 29 bits == 0x10000000) */
+  if ( !truncated && mant <= ( 1ull << 53 ) && exp10 >= -22 && exp10 <= 22 ) {
+    double d = (double)mant;
+    d        = exp10 < 0 ? d / k_pow10[-exp10] : d * k_pow10[exp10];
+    unsigned long long bits;
+    memcpy( &bits, &d, sizeof( bits ) );
+    if ( ( bits & 0x1fffffffull ) != 0x10000000ull ) {
+      float f = (float)d;
+      out     = neg ? -f : f;
+      p       = s;
+      return true;
+    }
+  }
+  return scan_float_slow( p, end, out );
+}
+
+// decimal int, optional sign
+static bool scan_int( const char*& p, const char* end, int& out ) {
+  const char* s = p;
+  bool neg      = false;
+  if ( s < end && ( '-' == *s || '+' == *s ) ) {
+    neg = '-' == *s;
+    s++;
+  }
+  if ( s >= end || !is_digit( *s ) ) { return false; }
+  long long v = 0;
+  for ( ; s < end && is_digit( *s ); s++ ) {
+    if ( v < 0x7fffffffll ) { v = v * 10 + ( *s - '0' ); }
+  }
+  if ( v > 0x7fffffffll ) { v = 0x7fffffffll; }
+  out = (int)( neg ? -v : v );
+  p   = s;
+  return true;
+}
+
+
+/*----------------------------------BUFFERS-----------------------------------*/
+// malloc'd arrays that double as they fill up
+struct float_buffer {
+  float* data;
+  size_t count;
+  size_t cap;
+};
+
+struct int_buffer {
+  int* data;
+  size_t count;
+  size_t cap;
+};
+
+static bool reserve( float_buffer& b, size_t extra ) {
+  if ( b.count + extra <= b.cap ) { return true; }
+  size_t cap = b.cap ? b.cap : 1024;
+  while ( cap < b.count + extra ) { cap *= 2; }
+  float* data = (float*)realloc( b.data, cap * sizeof( float ) );
+  if ( !data ) { return false; }
+  b.data = data;
+  b.cap  = cap;
+  return true;
+}
+
+static bool reserve( int_buffer& b, size_t extra ) {
+  if ( b.count + extra <= b.cap ) { return true; }
+  size_t cap = b.cap ? b.cap : 1024;
+  while ( cap < b.count + extra ) { cap *= 2; }
+  int* data = (int*)realloc( b.data, cap * sizeof( int ) );
+  if ( !data ) { return false; }
+  b.data = data;
+  b.cap  = cap;
+  return true;
+}
+
+/*-----------------------------------LINES------------------------------------*/
+// shared by the serial and threaded parsers, so they can't disagree
+enum obj_attrib_t { OBJ_VP = 0, OBJ_VT, OBJ_VN, OBJ_NOT_VERTEX };
+static const int k_attrib_comps[3] = { 3, 2, 3 };
+
+enum obj_error_t { OBJ_OK = 0, OBJ_ERR_LAYOUT, OBJ_ERR_VP, OBJ_ERR_VT, OBJ_ERR_VN, OBJ_ERR_MEMORY };
+
+static void print_obj_error( int err, int bad_index ) {
+  switch ( err ) {
+  case OBJ_ERR_LAYOUT:
+    fprintf( stderr,
+      "ERROR: file contains quads or does not match v vp/vt/vn layout - \
+					make sure exported mesh is triangulated and contains vertex points, \
+					texture coordinates, and normals\n" );
+    break;
+  case OBJ_ERR_VP: fprintf( stderr, "ERROR: invalid vertex position index in face\n" ); break;
+  case OBJ_ERR_VT: fprintf( stderr, "ERROR: invalid texture coord index %i in face.\n", bad_index ); break;
+  case OBJ_ERR_VN: fprintf( stderr, "ERROR: invalid vertex normal index in face\n" ); break;
+  case OBJ_ERR_MEMORY: fprintf( stderr, "ERROR: out of memory reading obj\n" ); break;
+  default: break;
+  }
+}
+
+static obj_attrib_t vertex_line_attrib( const char* line, const char* end ) {
+  if ( 'v' != line[0] || line + 1 >= end ) { return OBJ_NOT_VERTEX; }
+  switch ( line[1] ) {
+  case ' ': return OBJ_VP;
+  case 't': return OBJ_VT;
+  case 'n': return OBJ_VN;
+  default: return OBJ_NOT_VERTEX;
+  }
+}
+
+// writes 3 floats to v. missing values are 0, as they were with sscanf()
+static void parse_vertex_line( const char* line, const char* end, obj_attrib_t attrib, float* v ) {
+  v[0] = v[1] = v[2] = 0.0f;
+  const char* s      = line + ( OBJ_VP == attrib ? 1 : 2 );
+  for ( int i = 0; i < k_attrib_comps[attrib]; i++ ) {
+    s = skip_blanks( s, end );
+    if ( !scan_float( s, end, v[i] ) ) { break; }
+  }
+}
+
+/* reads the raw 1-based/negative vp/vt/vn indices of a triangle. false if it
+isn't "f a/b/c d/e/f g/h/i". if no_normals isn't NULL "f a/b c/d e/f" is
+allowed too: no_normals is set and the vn indices are 0 */
+static bool parse_face_line( const char* line, const char* end, int* idx, bool* no_normals ) {
+  const char* s = line + 1;
+  int missing   = 0;
+  for ( int i = 0; i < 3; i++ ) {
+    s = skip_blanks( s, end );
+    if ( !scan_int( s, end, idx[i * 3] ) || s >= end || '/' != *s++ ) { return false; }
+    if ( !scan_int( s, end, idx[i * 3 + 1] ) ) { return false; }
+    if ( no_normals && ( s >= end || '/' != *s ) ) {
+      idx[i * 3 + 2] = 0;
+      missing++;
+      continue;
+    }
+    if ( s >= end || '/' != *s++ || !scan_int( s, end, idx[i * 3 + 2] ) ) { return false; }
+  }
+  // all or nothing
+  if ( missing % 3 ) { return false; }
+  if ( no_normals ) { *no_normals = 3 == missing; }
+  // anything but whitespace after the third corner means a quad or polygon
+  s = skip_blanks( s, end );
+  if ( s < end && '\r' == *s ) { s++; }
+  return s >= end || '\n' == *s;
+}
+
+// converts a 1-based or negative (relative) OBJ index to 0-based, or -1 if it's out of range
+static int resolve_index( int i, size_t count ) {
+  long long r = i > 0 ? (long long)i - 1 : (long long)count + i;
+  return ( r >= 0 && r < (long long)count ) ? (int)r : -1;
+}
+
+/*-----------------------------------SERIAL-----------------------------------*/
+/* one pass. faces are resolved as soon as they're read, because OBJ indices
+only ever refer back to vertices that came earlier in the file */
+static bool parse_serial( const char* data, const char* end, float*& points, float*& tex_coords, float*& normals, int& point_count ) {
+  float_buffer v[3]   = { { NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 } };
+  float_buffer out[3] = { { NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 } };
+  int err = OBJ_OK, bad_index = 0;
+  for ( const char* line = data; OBJ_OK == err && line < end; line = next_line( line, end ) ) {
+    obj_attrib_t attrib = vertex_line_attrib( line, end );
+    // vertex
+    if ( attrib != OBJ_NOT_VERTEX ) {
+      if ( !reserve( v[attrib], 3 ) ) {
+        err = OBJ_ERR_MEMORY;
+        break;
+      }
+      parse_vertex_line( line, end, attrib, &v[attrib].data[v[attrib].count] );
+      v[attrib].count += k_attrib_comps[attrib];
+
+      // faces
+    } else if ( 'f' == line[0] ) {
+      int idx[9];
+      if ( !parse_face_line( line, end, idx, NULL ) ) {
+        err = OBJ_ERR_LAYOUT;
+        break;
+      }
+      if ( !reserve( out[OBJ_VP], 9 ) || !reserve( out[OBJ_VT], 6 ) || !reserve( out[OBJ_VN], 9 ) ) {
+        err = OBJ_ERR_MEMORY;
+        break;
+      }
+      for ( int i = 0; i < 9 && OBJ_OK == err; i++ ) {
+        int a = i % 3, nc = k_attrib_comps[a];
+        int r = resolve_index( idx[i], v[a].count / nc );
+        if ( r < 0 ) {
+          err       = OBJ_ERR_VP + a;
+          bad_index = idx[i];
+          break;
+        }
+        memcpy( &out[a].data[out[a].count], &v[a].data[(size_t)r * nc], nc * sizeof( float ) );
+        out[a].count += nc;
+      }
+    }
+  }
+  for ( int a = 0; a < 3; a++ ) { free( v[a].data ); }
+  if ( err ) {
+    print_obj_error( err, bad_index );
+    for ( int a = 0; a < 3; a++ ) { free( out[a].data ); }
+    return false;
+  }
+  printf( "found %i vp %i vt %i vn unique in obj\n", (int)( v[OBJ_VP].count / 3 ), (int)( v[OBJ_VT].count / 2 ), (int)( v[OBJ_VN].count / 3 ) );
+
+  // give back the unused end of each doubled buffer. shrinking never fails in practice, but keep the big one if it does
+  point_count = (int)( out[OBJ_VP].count / 3 );
+  for ( int a = 0; a < 3 && point_count > 0; a++ ) {
+    float* shrunk = (float*)realloc( out[a].data, out[a].count * sizeof( float ) );
+    if ( shrunk ) { out[a].data = shrunk; }
+  }
+  points     = out[OBJ_VP].data;
+  tex_coords = out[OBJ_VT].data;
+  normals    = out[OBJ_VN].data;
+  return true;
+}
+
+/*----------------------------------THREADED----------------------------------*/
+#if !defined( OBJ_NO_THREADS )
+/* the file is cut into line-aligned chunks. pass 1 parses each chunk into its
+own vertex arrays plus a list of face indices, without resolving them, since a
+face can refer to vertices in earlier chunks. a prefix sum over the chunks'
+counts then gives each chunk's place in the final arrays, and pass 2 copies the
+vertices there and resolves the faces. each output float is written by exactly
+one chunk, in file order, so the result doesn't depend on the thread count */
+struct obj_chunk {
+  const char* begin;
+  const char* end;
+  float_buffer v[3];
+  // 9 indices per face, 0-based. positive OBJ indices are already global
+  int_buffer faces;
+  // (face, corner bit mask) pairs for faces that used negative indices. those are relative to the chunk's first vertex
+  int_buffer rel;
+  // largest ( index - vertices read so far in chunk ) and smallest relative index. checked once the chunk's base is known
+  long long max_excess[3], min_rel[3];
+  int bad_hi[3], bad_lo[3];
+  int err, bad_index;
+  // filled in by the prefix sum
+  size_t base[3], first_point;
+};
+
+struct obj_merge {
+  float* unsorted[3];
+  float* out[3];
+};
+
+static void parse_chunk( obj_chunk* c, const obj_merge* ) {
+  for ( const char* line = c->begin; line < c->end; line = next_line( line, c->end ) ) {
+    obj_attrib_t attrib = vertex_line_attrib( line, c->end );
+    if ( attrib != OBJ_NOT_VERTEX ) {
+      if ( !reserve( c->v[attrib], 3 ) ) {
+        c->err = OBJ_ERR_MEMORY;
+        return;
+      }
+      parse_vertex_line( line, c->end, attrib, &c->v[attrib].data[c->v[attrib].count] );
+      c->v[attrib].count += k_attrib_comps[attrib];
+    } else if ( 'f' == line[0] ) {
+      int idx[9];
+      if ( !parse_face_line( line, c->end, idx, NULL ) ) {
+        c->err = OBJ_ERR_LAYOUT;
+        return;
+      }
+      if ( !reserve( c->faces, 9 ) ) {
+        c->err = OBJ_ERR_MEMORY;
+        return;
+      }
+      int mask = 0;
+      for ( int i = 0; i < 9; i++ ) {
+        int a           = i % 3;
+        long long local = (long long)( c->v[a].count / k_attrib_comps[a] );
+        long long r;
+        if ( idx[i] > 0 ) {
+          r = idx[i] - 1;
+          if ( r - local > c->max_excess[a] ) {
+            c->max_excess[a] = r - local;
+            c->bad_hi[a]     = idx[i];
+          }
+        } else if ( idx[i] < 0 ) {
+          r = local + idx[i];
+          if ( r < c->min_rel[a] ) {
+            c->min_rel[a] = r;
+            c->bad_lo[a]  = idx[i];
+          }
+          mask |= 1 << i;
+        } else {
+          c->err       = OBJ_ERR_VP + a;
+          c->bad_index = 0;
+          return;
+        }
+        c->faces.data[c->faces.count + i] = (int)r;
+      }
+      if ( mask ) {
+        if ( !reserve( c->rel, 2 ) ) {
+          c->err = OBJ_ERR_MEMORY;
+          return;
+        }
+        c->rel.data[c->rel.count++] = (int)( c->faces.count / 9 );
+        c->rel.data[c->rel.count++] = mask;
+      }
+      c->faces.count += 9;
+    }
+  }
+}
+
+static void copy_chunk_vertices( obj_chunk* c, const obj_merge* m ) {
+  for ( int a = 0; a < 3; a++ ) {
+    if ( c->v[a].count ) { memcpy( &m->unsorted[a][c->base[a] * k_attrib_comps[a]], c->v[a].data, c->v[a].count * sizeof( float ) ); }
+    free( c->v[a].data );
+    c->v[a].data = NULL;
+  }
+}
+
+static void resolve_chunk_faces( obj_chunk* c, const obj_merge* m ) {
+  size_t n_faces = c->faces.count / 9, next_rel = 0;
+  for ( size_t f = 0; f < n_faces; f++ ) {
+    int mask = 0;
+    if ( next_rel < c->rel.count && (size_t)c->rel.data[next_rel] == f ) {
+      mask = c->rel.data[next_rel + 1];
+      next_rel += 2;
+    }
+    for ( int i = 0; i < 9; i++ ) {
+      int a     = i % 3, nc = k_attrib_comps[a];
+      size_t r  = (size_t)( ( mask >> i ) & 1 ? (long long)c->base[a] + c->faces.data[f * 9 + i] : c->faces.data[f * 9 + i] );
+      size_t pt = c->first_point + f * 3 + i / 3;
+      memcpy( &m->out[a][pt * nc], &m->unsorted[a][r * nc], nc * sizeof( float ) );
+    }
+  }
+}
+
+typedef void ( *chunk_pass_t )( obj_chunk* c, const obj_merge* m );
+
+static void chunk_worker( obj_chunk* chunks, int n_chunks, std::atomic<int>* next_chunk, chunk_pass_t pass, const obj_merge* m ) {
+  for ( int i = ( *next_chunk )++; i < n_chunks; i = ( *next_chunk )++ ) { pass( &chunks[i], m ); }
+}
+
+// runs pass over every chunk, on n_threads threads including this one, taking chunks in turn
+static void for_each_chunk( obj_chunk* chunks, int n_chunks, int n_threads, chunk_pass_t pass, const obj_merge* m ) {
+  std::atomic<int> next_chunk( 0 );
+  std::vector<std::thread> threads;
+  for ( int i = 1; i < n_threads && i < n_chunks; i++ ) { threads.push_back( std::thread( chunk_worker, chunks, n_chunks, &next_chunk, pass, m ) ); }
+  chunk_worker( chunks, n_chunks, &next_chunk, pass, m );
+  for ( size_t i = 0; i < threads.size(); i++ ) { threads[i].join(); }
+}
+
+static bool parse_threaded( const char* data, const char* end, int n_threads, float*& points, float*& tex_coords, float*& normals, int& point_count ) {
+  // a few chunks per thread evens out chunks that happen to be all faces, which are slower to parse than vertices
+  size_t sz    = end - data;
+  int n_chunks = n_threads * 4;
+  if ( (size_t)n_chunks > sz / OBJ_MIN_CHUNK_BYTES ) { n_chunks = (int)( sz / OBJ_MIN_CHUNK_BYTES ); }
+  if ( n_chunks < n_threads ) { n_chunks = n_threads; }
+  obj_chunk* chunks = (obj_chunk*)calloc( n_chunks, sizeof( obj_chunk ) );
+  if ( !chunks ) {
+    print_obj_error( OBJ_ERR_MEMORY, 0 );
+    return false;
+  }
+  const char* prev_end = data;
+  for ( int i = 0; i < n_chunks; i++ ) {
+    chunks[i].begin = prev_end;
+    chunks[i].end   = end;
+    if ( i < n_chunks - 1 ) {
+      const char* cut = data + sz / n_chunks * ( i + 1 );
+      // cut after the end of the line the split point lands in
+      chunks[i].end   = cut > prev_end ? next_line( cut - 1, end ) : prev_end;
+    }
+    prev_end = chunks[i].end;
+    for ( int a = 0; a < 3; a++ ) { chunks[i].max_excess[a] = -( 1ll << 62 ); }
+  }
+
+  // pass 1
+  for_each_chunk( chunks, n_chunks, n_threads, parse_chunk, NULL );
+
+  // prefix sum, and the range checks that needed it. the first error in file order is the one reported
+  size_t totals[3] = { 0, 0, 0 }, total_points = 0;
+  int err = OBJ_OK, bad_index = 0;
+  for ( int i = 0; i < n_chunks && OBJ_OK == err; i++ ) {
+    obj_chunk* c = &chunks[i];
+    for ( int a = 0; a < 3 && OBJ_OK == err; a++ ) {
+      if ( c->max_excess[a] >= (long long)totals[a] ) {
+        err       = OBJ_ERR_VP + a;
+        bad_index = c->bad_hi[a];
+      } else if ( c->min_rel[a] + (long long)totals[a] < 0 ) {
+        err       = OBJ_ERR_VP + a;
+        bad_index = c->bad_lo[a];
+      }
+    }
+    if ( c->err && OBJ_OK == err ) {
+      err       = c->err;
+      bad_index = c->bad_index;
+    }
+    for ( int a = 0; a < 3; a++ ) {
+      c->base[a] = totals[a];
+      totals[a] += c->v[a].count / k_attrib_comps[a];
+    }
+    c->first_point = total_points;
+    total_points += c->faces.count / 3;
+  }
+
+  obj_merge m;
+  memset( &m, 0, sizeof( m ) );
+  if ( OBJ_OK == err ) {
+    for ( int a = 0; a < 3; a++ ) {
+      // +1 so that an empty array still gets a valid pointer
+      m.unsorted[a] = (float*)malloc( ( totals[a] * k_attrib_comps[a] + 1 ) * sizeof( float ) );
+      m.out[a]      = (float*)malloc( ( total_points * k_attrib_comps[a] + 1 ) * sizeof( float ) );
+      if ( !m.unsorted[a] || !m.out[a] ) { err = OBJ_ERR_MEMORY; }
+    }
+  }
+  if ( OBJ_OK == err ) {
+    // pass 2. every chunk's vertices have to be in place before any faces are resolved
+    for_each_chunk( chunks, n_chunks, n_threads, copy_chunk_vertices, &m );
+    for_each_chunk( chunks, n_chunks, n_threads, resolve_chunk_faces, &m );
+  }
+
+  for ( int i = 0; i < n_chunks; i++ ) {
+    for ( int a = 0; a < 3; a++ ) { free( chunks[i].v[a].data ); }
+    free( chunks[i].faces.data );
+    free( chunks[i].rel.data );
+  }
+  free( chunks );
+  for ( int a = 0; a < 3; a++ ) { free( m.unsorted[a] ); }
+  if ( err ) {
+    print_obj_error( err, bad_index );
+    for ( int a = 0; a < 3; a++ ) { free( m.out[a] ); }
+    return false;
+  }
+  printf( "found %i vp %i vt %i vn unique in obj\n", (int)totals[OBJ_VP], (int)totals[OBJ_VT], (int)totals[OBJ_VN] );
+  point_count = (int)total_points;
+  points      = m.out[OBJ_VP];
+  tex_coords  = m.out[OBJ_VT];
+  normals     = m.out[OBJ_VN];
+  return true;
+}
+#endif
+
+/*----------------------------------INDEXED-----------------------------------*/
+/* each distinct (vp, vt, vn) triple in the faces becomes one output vertex, in
+the order it's first used. the hash table holds vertex numbers; the triples
+themselves live in one array indexed by vertex number, so the table is just
+ints */
+static unsigned int hash_triple( const int* t ) {
+  unsigned long long h = (unsigned long long)(unsigned int)t[0] * 0x9e3779b97f4a7c15ull;
+  h ^= (unsigned long long)(unsigned int)t[1] * 0xc2b2ae3d27d4eb4full;
+  h ^= (unsigned long long)(unsigned int)t[2] * 0x165667b19e3779f9ull;
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ull;
+  h ^= h >> 32;
+  return (unsigned int)h;
+}
+
+struct vertex_table {
+  int* slots; // vertex number, or -1 if empty
+  size_t n_slots;
+  int_buffer triples;
+};
+
+static bool grow_table( vertex_table& vt ) {
+  size_t n_slots = vt.n_slots ? vt.n_slots * 2 : 4096;
+  int* slots     = (int*)malloc( n_slots * sizeof( int ) );
+  if ( !slots ) { return false; }
+  memset( slots, 0xff, n_slots * sizeof( int ) );
+  size_t n_vertices = vt.triples.count / 3;
+  for ( size_t i = 0; i < n_vertices; i++ ) {
+    size_t slot = hash_triple( &vt.triples.data[i * 3] ) & ( n_slots - 1 );
+    while ( slots[slot] >= 0 ) { slot = ( slot + 1 ) & ( n_slots - 1 ); }
+    slots[slot] = (int)i;
+  }
+  free( vt.slots );
+  vt.slots   = slots;
+  vt.n_slots = n_slots;
+  return true;
+}
+
+// vertex number for the triple, adding it if it's new. -1 if out of memory
+static int find_or_add_vertex( vertex_table& vt, const int* triple ) {
+  // keep the table at most half full so probe runs stay short
+  if ( ( vt.triples.count / 3 + 1 ) * 2 > vt.n_slots && !grow_table( vt ) ) { return -1; }
+  size_t slot = hash_triple( triple ) & ( vt.n_slots - 1 );
+  for ( ; vt.slots[slot] >= 0; slot = ( slot + 1 ) & ( vt.n_slots - 1 ) ) {
+    const int* t = &vt.triples.data[vt.slots[slot] * 3];
+    if ( t[0] == triple[0] && t[1] == triple[1] && t[2] == triple[2] ) { return vt.slots[slot]; }
+  }
+  if ( !reserve( vt.triples, 3 ) ) { return -1; }
+  int id = (int)( vt.triples.count / 3 );
+  memcpy( &vt.triples.data[vt.triples.count], triple, 3 * sizeof( int ) );
+  vt.triples.count += 3;
+  vt.slots[slot] = id;
+  return id;
+}
+
+/* with a layout (from make_vertex_layout()), points gets the vertices interleaved by it, and tex_coords
+and normals are left NULL */
+static bool load_indexed( const char* file_name, const vertex_layout* layout, float*& points, float*& tex_coords, float*& normals, int& vertex_count,
+  void*& indices, int& index_count, int& index_size ) {
+  points       = NULL;
+  tex_coords   = NULL;
+  normals      = NULL;
+  indices      = NULL;
+  vertex_count = 0;
+  index_count  = 0;
+  index_size   = 0;
+
+  mapped_file mf;
+  if ( !map_file( file_name, &mf ) ) { return false; }
+  const char* end   = mf.data + mf.sz;
+  float_buffer v[3] = { { NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 } };
+  int_buffer idx32  = { NULL, 0, 0 };
+  vertex_table table;
+  memset( &table, 0, sizeof( table ) );
+  int err = OBJ_OK, bad_index = 0;
+  size_t n_faces       = 0;
+  bool without_normals = false;
+  for ( const char* line = mf.data; OBJ_OK == err && line < end; line = next_line( line, end ) ) {
+    obj_attrib_t attrib = vertex_line_attrib( line, end );
+    if ( attrib != OBJ_NOT_VERTEX ) {
+      if ( !reserve( v[attrib], 3 ) ) {
+        err = OBJ_ERR_MEMORY;
+        break;
+      }
+      parse_vertex_line( line, end, attrib, &v[attrib].data[v[attrib].count] );
+      v[attrib].count += k_attrib_comps[attrib];
+    } else if ( 'f' == line[0] ) {
+      int idx[9];
+      bool no_normals = false;
+      // every face has normals, or none do
+      if ( !parse_face_line( line, end, idx, &no_normals ) || ( n_faces > 0 && no_normals != without_normals ) ) {
+        err = OBJ_ERR_LAYOUT;
+        break;
+      }
+      without_normals = no_normals;
+      n_faces++;
+      if ( !reserve( idx32, 3 ) ) {
+        err = OBJ_ERR_MEMORY;
+        break;
+      }
+      for ( int i = 0; i < 9 && OBJ_OK == err; i++ ) {
+        int a = i % 3;
+        if ( OBJ_VN == a && without_normals ) {
+          idx[i] = 0;
+          continue;
+        }
+        int r = resolve_index( idx[i], v[a].count / k_attrib_comps[a] );
+        if ( r < 0 ) {
+          err       = OBJ_ERR_VP + a;
+          bad_index = idx[i];
+        }
+        idx[i] = r;
+      }
+      for ( int i = 0; i < 3 && OBJ_OK == err; i++ ) {
+        int id = find_or_add_vertex( table, &idx[i * 3] );
+        if ( id < 0 ) {
+          err = OBJ_ERR_MEMORY;
+          break;
+        }
+        idx32.data[idx32.count++] = id;
+      }
+    }
+  }
+  unmap_file( &mf );
+  free( table.slots );
+
+  size_t n_vertices = table.triples.count / 3;
+  // where each of vp/vt/vn goes in a vertex, and how far apart vertices are, in floats. -1 to leave it out
+  int out_offset[3] = { 0, 0, 0 }, out_stride[3] = { 3, 2, 3 };
+  if ( OBJ_OK == err && layout ) {
+    static const unsigned int locations[3] = { VERTEX_LOCATION_POINTS, VERTEX_LOCATION_TEX_COORDS, VERTEX_LOCATION_NORMALS };
+    for ( int a = 0; a < 3; a++ ) {
+      int i         = find_vertex_attrib( *layout, locations[a] );
+      out_offset[a] = i < 0 ? -1 : (int)( layout->attribs[i].offset / sizeof( float ) );
+      out_stride[a] = (int)( layout->stride / sizeof( float ) );
+    }
+    // no vn in the file: the normals stay zeroed, for compute_vertex_normals() to fill in
+    if ( without_normals ) { out_offset[OBJ_VN] = -1; }
+    // calloc, so padding is zeroed
+    points = (float*)calloc( n_vertices * layout->stride + 1, 1 );
+    if ( !points ) { err = OBJ_ERR_MEMORY; }
+  } else if ( OBJ_OK == err ) {
+    points     = (float*)malloc( ( n_vertices * 3 + 1 ) * sizeof( float ) );
+    tex_coords = (float*)malloc( ( n_vertices * 2 + 1 ) * sizeof( float ) );
+    normals    = without_normals ? NULL : (float*)malloc( ( n_vertices * 3 + 1 ) * sizeof( float ) );
+    if ( !points || !tex_coords || ( !normals && !without_normals ) ) { err = OBJ_ERR_MEMORY; }
+    if ( without_normals ) { out_offset[OBJ_VN] = -1; }
+  }
+  if ( OBJ_OK == err ) {
+    float* out[3] = { points, layout ? points : tex_coords, layout ? points : normals };
+    for ( size_t i = 0; i < n_vertices; i++ ) {
+      for ( int a = 0; a < 3; a++ ) {
+        if ( out_offset[a] < 0 ) { continue; }
+        int nc = k_attrib_comps[a];
+        memcpy( &out[a][i * out_stride[a] + out_offset[a]], &v[a].data[(size_t)table.triples.data[i * 3 + a] * nc], nc * sizeof( float ) );
+      }
+    }
+    // 16-bit indices halve the index buffer when every vertex number fits
+    index_count = (int)idx32.count;
+    if ( n_vertices <= 65536 ) {
+      unsigned short* idx16 = (unsigned short*)malloc( ( idx32.count + 1 ) * sizeof( unsigned short ) );
+      if ( idx16 ) {
+        for ( size_t i = 0; i < idx32.count; i++ ) { idx16[i] = (unsigned short)idx32.data[i]; }
+        indices    = idx16;
+        index_size = 2;
+      } else {
+        err = OBJ_ERR_MEMORY;
+      }
+      free( idx32.data );
+    } else {
+      int* shrunk = (int*)realloc( idx32.data, ( idx32.count + 1 ) * sizeof( int ) );
+      indices     = shrunk ? shrunk : idx32.data;
+      index_size  = 4;
+    }
+  } else {
+    free( idx32.data );
+  }
+  for ( int a = 0; a < 3; a++ ) { free( v[a].data ); }
+  free( table.triples.data );
+  if ( err ) {
+    print_obj_error( err, bad_index );
+    free( points );
+    free( tex_coords );
+    free( normals );
+    free( indices );
+    points      = NULL;
+    tex_coords  = NULL;
+    normals     = NULL;
+    indices     = NULL;
+    index_count = 0;
+    index_size  = 0;
+    return false;
+  }
+  vertex_count = (int)n_vertices;
+  printf( "found %i vp %i vt %i vn unique in obj\n", (int)( v[OBJ_VP].count / 3 ), (int)( v[OBJ_VT].count / 2 ), (int)( v[OBJ_VN].count / 3 ) );
+  printf( "allocated %i vertices, %i %i-bit indices\n", vertex_count, index_count, index_size * 8 );
+  return true;
+}
+
+bool load_obj_file_indexed( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& vertex_count, void*& indices, int& index_count,
+  int& index_size ) {
+  return load_indexed( file_name, NULL, points, tex_coords, normals, vertex_count, indices, index_count, index_size );
+}
+
+/*-------------------------------INTERLEAVED----------------------------------*/
+bool load_obj_file_indexed_interleaved( const char* file_name, unsigned int layout_flags, unsigned int alignment, void*& vertices, vertex_layout& layout,
+  int& vertex_count, void*& indices, int& index_count, int& index_size ) {
+  layout   = make_vertex_layout( layout_flags, alignment );
+  float *p = NULL, *t = NULL, *n = NULL;
+  bool ok  = load_indexed( file_name, &layout, p, t, n, vertex_count, indices, index_count, index_size );
+  vertices = p;
+  return ok;
+}
+
+bool load_obj_file_interleaved( const char* file_name, unsigned int layout_flags, unsigned int alignment, void*& vertices, vertex_layout& layout,
+  int& point_count ) {
+  vertices      = NULL;
+  layout        = make_vertex_layout( layout_flags, alignment );
+  float *points = NULL, *tex_coords = NULL, *normals = NULL;
+  if ( !load_obj_file( file_name, points, tex_coords, normals, point_count ) ) { return false; }
+  // grow the points array into the interleaved one, so only tex coords and normals are extra
+  float* grown = (float*)realloc( points, (size_t)point_count * layout.stride + 1 );
+  bool ok      = NULL != grown;
+  if ( grown ) {
+    points = grown;
+    ok     = interleave_vertices( layout, points, tex_coords, normals, point_count, points );
+  } else {
+    fprintf( stderr, "ERROR: out of memory interleaving %s\n", file_name );
+  }
+  free( tex_coords );
+  free( normals );
+  if ( !ok ) {
+    free( points );
+    point_count = 0;
+    return false;
+  }
+  vertices = points;
+  return true;
+}
+
+/*---------------------------------STREAMED-----------------------------------*/
+bool load_obj_file_streamed( const char* file_name, int batch_points, obj_batch_callback_t callback, void* user_data, int* total_points ) {
+  if ( total_points ) { *total_points = 0; }
+  FILE* fp = fopen( file_name, "rb" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not find file %s\n", file_name );
+    return false;
+  }
+  // whole triangles only
+  int batch = batch_points - batch_points % 3;
+  if ( batch < 3 ) { batch = 3; }
+  float_buffer v[3] = { { NULL, 0, 0 }, { NULL, 0, 0 }, { NULL, 0, 0 } };
+  float* out[3];
+  for ( int a = 0; a < 3; a++ ) { out[a] = (float*)malloc( (size_t)batch * k_attrib_comps[a] * sizeof( float ) ); }
+  size_t buf_cap = OBJ_STREAM_READ_BYTES, have = 0;
+  char* buf      = (char*)malloc( buf_cap );
+  int err = OBJ_OK, bad_index = 0, n_out = 0, total = 0;
+  bool stopped = false, at_eof = false;
+  if ( !out[0] || !out[1] || !out[2] || !buf ) { err = OBJ_ERR_MEMORY; }
+
+  while ( OBJ_OK == err && !stopped ) {
+    if ( !at_eof ) {
+      size_t want = buf_cap - have;
+      size_t got  = fread( buf + have, 1, want, fp );
+      have += got;
+      at_eof = got < want;
+    }
+    // only whole lines are parsed. the partial one at the end waits for the next read
+    const char* end  = buf + have;
+    const char* stop = end;
+    if ( !at_eof ) {
+      while ( stop > buf && '\n' != stop[-1] ) { stop--; }
+      if ( stop == buf ) {
+        // one line longer than the whole buffer. make room for it
+        char* bigger = (char*)realloc( buf, buf_cap * 2 );
+        if ( !bigger ) {
+          err = OBJ_ERR_MEMORY;
+          break;
+        }
+        buf = bigger;
+        buf_cap *= 2;
+        continue;
+      }
+    }
+
+    for ( const char* line = buf; OBJ_OK == err && !stopped && line < stop; line = next_line( line, stop ) ) {
+      obj_attrib_t attrib = vertex_line_attrib( line, stop );
+      if ( attrib != OBJ_NOT_VERTEX ) {
+        if ( !reserve( v[attrib], 3 ) ) {
+          err = OBJ_ERR_MEMORY;
+          break;
+        }
+        parse_vertex_line( line, stop, attrib, &v[attrib].data[v[attrib].count] );
+        v[attrib].count += k_attrib_comps[attrib];
+      } else if ( 'f' == line[0] ) {
+        int idx[9];
+        if ( !parse_face_line( line, stop, idx, NULL ) ) {
+          err = OBJ_ERR_LAYOUT;
+          break;
+        }
+        for ( int i = 0; i < 9 && OBJ_OK == err; i++ ) {
+          int a = i % 3, nc = k_attrib_comps[a];
+          int r = resolve_index( idx[i], v[a].count / nc );
+          if ( r < 0 ) {
+            err       = OBJ_ERR_VP + a;
+            bad_index = idx[i];
+            break;
+          }
+          memcpy( &out[a][( n_out + i / 3 ) * nc], &v[a].data[(size_t)r * nc], nc * sizeof( float ) );
+        }
+        n_out += 3;
+        if ( OBJ_OK == err && n_out == batch ) {
+          total += n_out;
+          stopped = !callback( out[OBJ_VP], out[OBJ_VT], out[OBJ_VN], n_out, user_data );
+          n_out   = 0;
+        }
+      }
+    }
+    // keep the partial line for the next read
+    have = (size_t)( end - stop );
+    memmove( buf, stop, have );
+    if ( at_eof && 0 == have ) { break; }
+  }
+  // the last, short batch
+  if ( OBJ_OK == err && !stopped && n_out > 0 ) {
+    total += n_out;
+    stopped = !callback( out[OBJ_VP], out[OBJ_VT], out[OBJ_VN], n_out, user_data );
+  }
+  fclose( fp );
+  free( buf );
+  for ( int a = 0; a < 3; a++ ) {
+    free( v[a].data );
+    free( out[a] );
+  }
+  if ( err ) {
+    print_obj_error( err, bad_index );
+    return false;
+  }
+  if ( total_points ) { *total_points = total; }
+  return !stopped;
+}
+
+/*------------------------------------API-------------------------------------*/
+bool load_obj_file_threads( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& point_count, int n_threads ) {
+  points      = NULL;
+  tex_coords  = NULL;
+  normals     = NULL;
+  point_count = 0;
+
+  mapped_file mf;
+  if ( !map_file( file_name, &mf ) ) { return false; }
+  const char* end = mf.data + mf.sz;
+  bool ok;
+#if !defined( OBJ_NO_THREADS )
+  if ( n_threads <= 0 ) {
+    n_threads = mf.sz >= OBJ_PARALLEL_MIN_BYTES ? (int)std::thread::hardware_concurrency() : 1;
+  }
+  if ( n_threads > 1 ) {
+    ok = parse_threaded( mf.data, end, n_threads, points, tex_coords, normals, point_count );
+  } else {
+    ok = parse_serial( mf.data, end, points, tex_coords, normals, point_count );
+  }
+#else
+  ( void )n_threads;
+  ok = parse_serial( mf.data, end, points, tex_coords, normals, point_count );
+#endif
+  unmap_file( &mf );
+  if ( ok ) { printf( "allocated %i points\n", point_count ); }
+  return ok;
+}
+
+bool load_obj_file( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& point_count ) {
+  return load_obj_file_threads( file_name, points, tex_coords, normals, point_count, 0 );
+}
+
@@ -0,0 +1,72 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| First version 7 Nov 2013                                                     |
+| Dr Anton Gerdelan, Trinity College Dublin, Ireland.                          |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Anton's lazy Wavefront OBJ parser                                            |
+| Anton Gerdelan 7 Nov 2013                                                    |
+| Notes:                                                                       |
+| I ignore MTL files                                                           |
+| Mesh MUST be triangulated - quads not accepted                               |
+| Mesh MUST contain vertex points, normals, and texture coordinates            |
+| (the indexed loaders also take faces without normals - see below)            |
+| Faces MUST come after the v/vt/vn lines they refer to                        |
+| Negative (relative) indices are allowed                                      |
+| The file is memory-mapped and parsed in one pass with a hand-written number  |
+| scanner. Floats are rounded exactly as sscanf( "%f" ) would round them.      |
+| The arrays are malloc'd - free() them when done.                             |
+\******************************************************************************/
+#ifndef _OBJ_PARSER_H_
+#define _OBJ_PARSER_H_
+
+#include "vertex_layout.h"
+
+// files at least this big are parsed on all cores. define OBJ_NO_THREADS to always parse on one
+#define OBJ_PARALLEL_MIN_BYTES ( 4 << 20 )
+
+bool load_obj_file( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& point_count );
+
+/* as load_obj_file, with the thread count chosen. 0 picks one per core, or 1
+for small files. the arrays are identical, byte for byte, whatever the count */
+bool load_obj_file_threads( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& point_count, int n_threads );
+
+/* as load_obj_file, but vertices shared by several faces are only stored once.
+each distinct vp/vt/vn combination becomes one vertex, and faces are given as
+index_count indices into them, for glDrawElements(). index_size is 2 when
+vertex_count <= 65536, and indices is then an unsigned short array
+(GL_UNSIGNED_SHORT), otherwise 4 and unsigned int (GL_UNSIGNED_INT).
+all four arrays are malloc'd. unlike load_obj_file, faces may leave out the
+normals ("f a/b c/d e/f") if all of them do; normals is then NULL - make them
+with compute_vertex_normals() */
+bool load_obj_file_indexed( const char* file_name, float*& points, float*& tex_coords, float*& normals, int& vertex_count, void*& indices, int& index_count,
+  int& index_size );
+
+/* as load_obj_file, but into one interleaved buffer for a single VBO, laid
+out by make_vertex_layout( layout_flags, alignment ), which is returned in
+layout for create_vao_from_layout(). vertices is malloc'd, point_count *
+layout.stride bytes. VERTEX_LAYOUT_ALL and alignment 4 give 32-byte vertices */
+bool load_obj_file_interleaved( const char* file_name, unsigned int layout_flags, unsigned int alignment, void*& vertices, vertex_layout& layout,
+  int& point_count );
+
+/* as load_obj_file_indexed, with the vertices interleaved as above. normals
+are zeroed if the file has none */
+bool load_obj_file_indexed_interleaved( const char* file_name, unsigned int layout_flags, unsigned int alignment, void*& vertices, vertex_layout& layout,
+  int& vertex_count, void*& indices, int& index_count, int& index_size );
+
+/* called by load_obj_file_streamed() with each batch of vertices, laid out like
+load_obj_file()'s arrays. the arrays are reused for the next batch, so copy
+them out (or glBufferSubData() them) before returning. return false to stop */
+typedef bool ( *obj_batch_callback_t )( const float* points, const float* tex_coords, const float* normals, int point_count, void* user_data );
+
+/* streams the mesh through callback in batches of batch_points vertices
+(rounded down to whole triangles), the last batch shorter. the file is read a
+buffer at a time and the expanded vertices are never all in memory: peak memory
+is the file's unique v/vt/vn values plus one batch, not the ~6x bigger expanded
+arrays load_obj_file() returns. total_points gets the number of vertices sent.
+false on a parse error, or if callback stopped it */
+bool load_obj_file_streamed( const char* file_name, int batch_points, obj_batch_callback_t callback, void* user_data, int* total_points );
+
+#endif
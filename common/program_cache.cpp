@@ -0,0 +1,289 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shader programme binary cache. See program_cache.h for the file layout and   |
+| when a binary is used.                                                       |
+\******************************************************************************/
+#include "program_cache.h"
+#include "gl_utils.h"
+#include "hash64.h"
+#include "mapped_file.h"
+#include <chrono>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+static char* g_cache_dir = NULL;
+static unsigned long long g_driver_hash;
+static GLint g_formats[PROGRAM_CACHE_MAX_FORMATS];
+static int g_format_count;
+static program_cache_stats g_stats;
+
+/*----------------------------------HELPERS-----------------------------------*/
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+static bool make_dir( const char* dir ) {
+#ifdef _WIN32
+  int r = _mkdir( dir );
+#else
+  int r = mkdir( dir, 0755 );
+#endif
+  if ( 0 == r ) { return true; }
+  // EEXIST is fine as long as what's there is a directory, not a file
+  struct stat st;
+  if ( EEXIST == errno && 0 == stat( dir, &st ) && S_ISDIR( st.st_mode ) ) { return true; }
+  fprintf( stderr, "ERROR: could not make program cache directory %s\n", dir );
+  return false;
+}
+
+// dir/<hash_combine64( vert hash, frag hash )>.pbin. caller frees
+static char* cache_file_name( unsigned long long vert_hash, unsigned long long frag_hash ) {
+  size_t len = strlen( g_cache_dir ) + 1 + 16 + strlen( PROGRAM_CACHE_SUFFIX ) + 1;
+  char* name = (char*)malloc( len );
+  if ( name ) { snprintf( name, len, "%s/%016llx%s", g_cache_dir, hash_combine64( vert_hash, frag_hash ), PROGRAM_CACHE_SUFFIX ); }
+  return name;
+}
+
+static bool driver_has_format( unsigned int format ) {
+  for ( int i = 0; i < g_format_count; i++ ) {
+    if ( (unsigned int)g_formats[i] == format ) { return true; }
+  }
+  return false;
+}
+
+/*---------------------------------CACHE FILES--------------------------------*/
+/* returns a linked programme from the file, or 0 if there's no file (rejected
+false) or it can't be used (rejected true) */
+static GLuint load_binary( const char* file_name, const program_cache_header& key, bool* rejected ) {
+  *rejected = false;
+  struct stat st;
+  if ( stat( file_name, &st ) != 0 ) { return 0; }
+  *rejected = true;
+  mapped_file mf;
+  if ( !map_file( file_name, &mf ) ) { return 0; }
+  program_cache_header h;
+  bool ok = mf.sz >= sizeof( h );
+  if ( ok ) { memcpy( &h, mf.data, sizeof( h ) ); }
+  ok = ok && PROGRAM_CACHE_MAGIC == h.magic && PROGRAM_CACHE_VERSION == h.version && sizeof( h ) == h.header_size;
+  ok = ok && h.vert_hash == key.vert_hash && h.frag_hash == key.frag_hash && h.binary_size == mf.sz - sizeof( h );
+  if ( ok && h.driver_hash != key.driver_hash ) {
+    gl_log( "program cache: %s is from a different driver\n", file_name );
+    ok = false;
+  }
+  // a format glProgramBinary() would reject anyway, but without a GL error to clear up
+  if ( ok && !driver_has_format( h.binary_format ) ) {
+    gl_log( "program cache: %s has binary format 0x%x, which the driver doesn't list\n", file_name, h.binary_format );
+    ok = false;
+  }
+  GLuint programme = 0;
+  if ( ok ) {
+    programme = glCreateProgram();
+    /* drivers may also refuse a binary with an error, e.g. GL_INVALID_ENUM for a
+    format they've stopped supporting. clear out anything already pending first so
+    only glProgramBinary()'s own error is looked at. whatever was pending is
+    logged rather than silently lost */
+    for ( GLenum err = glGetError(); GL_NO_ERROR != err; err = glGetError() ) {
+      gl_log( "program cache: GL error 0x%x was pending before loading %s\n", err, file_name );
+    }
+    // straight from the mapped file. the driver copies what it needs
+    glProgramBinary( programme, h.binary_format, mf.data + sizeof( h ), (GLsizei)h.binary_size );
+    bool had_error = GL_NO_ERROR != glGetError();
+    GLint params   = GL_FALSE;
+    glGetProgramiv( programme, GL_LINK_STATUS, &params );
+    if ( GL_TRUE != params || had_error ) {
+      gl_log( "program cache: the driver refused the binary in %s\n", file_name );
+      glDeleteProgram( programme );
+      programme = 0;
+    }
+  }
+  unmap_file( &mf );
+  return programme;
+}
+
+// writes the programme's binary to a temporary file, then renames it over the old one
+static bool store_binary( const char* file_name, GLuint programme, program_cache_header h ) {
+  GLint len = 0;
+  glGetProgramiv( programme, GL_PROGRAM_BINARY_LENGTH, &len );
+  if ( len <= 0 ) { return false; }
+  char* binary   = (char*)malloc( len );
+  GLenum format  = 0;
+  GLsizei actual = 0;
+  if ( !binary ) { return false; }
+  glGetProgramBinary( programme, len, &actual, &format, binary );
+  h.binary_format = format;
+  h.binary_size   = (unsigned long long)actual;
+
+  size_t tmp_len = strlen( file_name ) + 5;
+  char* tmp_file = (char*)malloc( tmp_len );
+  FILE* fp       = NULL;
+  if ( tmp_file ) {
+    snprintf( tmp_file, tmp_len, "%s.tmp", file_name );
+    fp = fopen( tmp_file, "wb" );
+  }
+  bool ok = fp && actual > 0;
+  if ( fp ) {
+    ok = ok && 1 == fwrite( &h, sizeof( h ), 1, fp ) && (size_t)actual == fwrite( binary, 1, actual, fp );
+    ok = ( 0 == fclose( fp ) ) && ok;
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows
+    if ( ok ) { remove( file_name ); }
+#endif
+    ok = ok && 0 == rename( tmp_file, file_name );
+    if ( !ok ) { remove( tmp_file ); }
+  }
+  if ( !ok ) { fprintf( stderr, "ERROR: could not write program cache %s\n", file_name ); }
+  free( tmp_file );
+  free( binary );
+  return ok;
+}
+
+// compile and link, asking the driver to keep the binary retrievable
+static GLuint compile_programme( const char* vert_str, int vert_len, const char* frag_str, int frag_len ) {
+  GLuint vert, frag;
+  if ( !create_shader_from_string( "vertex shader string", vert_str, vert_len, &vert, GL_VERTEX_SHADER ) ) { return 0; }
+  if ( !create_shader_from_string( "fragment shader string", frag_str, frag_len, &frag, GL_FRAGMENT_SHADER ) ) {
+    glDeleteShader( vert );
+    return 0;
+  }
+  GLuint programme = glCreateProgram();
+  glProgramParameteri( programme, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+  glAttachShader( programme, vert );
+  glAttachShader( programme, frag );
+  glLinkProgram( programme );
+  glDetachShader( programme, vert );
+  glDetachShader( programme, frag );
+  glDeleteShader( vert );
+  glDeleteShader( frag );
+  GLint params = -1;
+  glGetProgramiv( programme, GL_LINK_STATUS, &params );
+  if ( GL_TRUE != params ) {
+    gl_log_err( "ERROR: could not link shader programme GL index %u\n", programme );
+    print_programme_info_log( programme );
+    glDeleteProgram( programme );
+    return 0;
+  }
+  return programme;
+}
+
+/*------------------------------------API-------------------------------------*/
+bool init_program_cache( const char* dir ) {
+  stop_program_cache();
+  if ( !dir || !dir[0] || !make_dir( dir ) ) { return false; }
+  GLint n = 0;
+  glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &n );
+  if ( n <= 0 ) {
+    gl_log( "program cache: the driver has no program binary formats, so it's off\n" );
+    return false;
+  }
+  GLint* formats = (GLint*)malloc( n * sizeof( GLint ) );
+  if ( !formats ) { return false; }
+  glGetIntegerv( GL_PROGRAM_BINARY_FORMATS, formats );
+  g_format_count = n < PROGRAM_CACHE_MAX_FORMATS ? n : PROGRAM_CACHE_MAX_FORMATS;
+  memcpy( g_formats, formats, g_format_count * sizeof( GLint ) );
+  free( formats );
+
+  // binaries are only good for this driver build on this GPU
+  const char* strings[] = { (const char*)glGetString( GL_VENDOR ), (const char*)glGetString( GL_RENDERER ), (const char*)glGetString( GL_VERSION ),
+    (const char*)glGetString( GL_SHADING_LANGUAGE_VERSION ) };
+  g_driver_hash = PROGRAM_CACHE_VERSION;
+  for ( int i = 0; i < 4; i++ ) { g_driver_hash = hash_combine64( g_driver_hash, strings[i] ? hash_bytes64( strings[i], strlen( strings[i] ) ) : 0 ); }
+
+  size_t len  = strlen( dir ) + 1;
+  g_cache_dir = (char*)malloc( len );
+  if ( !g_cache_dir ) { return false; }
+  memcpy( g_cache_dir, dir, len );
+  gl_log( "program cache in %s. %i binary format(s)\n", g_cache_dir, n );
+  return true;
+}
+
+void stop_program_cache() {
+  free( g_cache_dir );
+  g_cache_dir    = NULL;
+  g_format_count = 0;
+}
+
+bool program_cache_enabled() { return NULL != g_cache_dir; }
+
+// the header a cache file for key should have, before the binary's format and size are filled in
+static program_cache_header make_header( const program_cache_key* key ) {
+  program_cache_header h;
+  memset( &h, 0, sizeof( h ) );
+  h.magic       = PROGRAM_CACHE_MAGIC;
+  h.version     = PROGRAM_CACHE_VERSION;
+  h.header_size = sizeof( program_cache_header );
+  h.vert_hash   = key->vert_hash;
+  h.frag_hash   = key->frag_hash;
+  h.driver_hash = g_driver_hash;
+  return h;
+}
+
+GLuint load_cached_programme( const char* vert_str, int vert_len, const char* frag_str, int frag_len, program_cache_key* key ) {
+  double t0 = now_ms();
+  if ( vert_len < 0 ) { vert_len = (int)strlen( vert_str ); }
+  if ( frag_len < 0 ) { frag_len = (int)strlen( frag_str ); }
+  key->vert_hash = hash_bytes64( vert_str, vert_len );
+  key->frag_hash = hash_bytes64( frag_str, frag_len );
+  if ( !g_cache_dir ) {
+    g_stats.misses++;
+    return 0;
+  }
+  char* file_name  = cache_file_name( key->vert_hash, key->frag_hash );
+  bool rejected    = false;
+  GLuint programme = file_name ? load_binary( file_name, make_header( key ), &rejected ) : 0;
+  if ( programme ) {
+    g_stats.hits++;
+    g_stats.hit_ms += now_ms() - t0;
+    gl_log( "program cache hit: programme %u from %s\n", programme, file_name );
+  } else if ( rejected ) {
+    g_stats.rejected++;
+  } else {
+    g_stats.misses++;
+  }
+  free( file_name );
+  return programme;
+}
+
+void store_cached_programme( const program_cache_key* key, GLuint programme, double compile_ms ) {
+  g_stats.compile_ms += compile_ms;
+  if ( !programme ) {
+    g_stats.failed++;
+    return;
+  }
+  if ( !g_cache_dir ) { return; }
+  char* file_name = cache_file_name( key->vert_hash, key->frag_hash );
+  if ( file_name && store_binary( file_name, programme, make_header( key ) ) ) {
+    g_stats.stored++;
+    gl_log( "program cache: programme %u stored in %s\n", programme, file_name );
+  }
+  free( file_name );
+}
+
+GLuint create_programme_from_strings_cached( const char* vert_str, int vert_len, const char* frag_str, int frag_len ) {
+  program_cache_key key;
+  GLuint programme = load_cached_programme( vert_str, vert_len, frag_str, frag_len, &key );
+  if ( programme ) { return programme; }
+  double t0 = now_ms();
+  programme = compile_programme( vert_str, vert_len, frag_str, frag_len );
+  store_cached_programme( &key, programme, now_ms() - t0 );
+  return programme;
+}
+
+program_cache_stats get_program_cache_stats() { return g_stats; }
+
+void reset_program_cache_stats() { memset( &g_stats, 0, sizeof( g_stats ) ); }
+
+void log_program_cache_stats() {
+  gl_log( "program cache: %i hits (%.1fms), %i misses and %i rejected (%.1fms compiling), %i stored, %i failed\n", g_stats.hits, g_stats.hit_ms, g_stats.misses,
+    g_stats.rejected, g_stats.compile_ms, g_stats.stored, g_stats.failed );
+}
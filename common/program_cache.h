@@ -0,0 +1,91 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| On-disk cache of linked shader programmes. Compiling and linking GLSL at     |
+| every start-up is slow once there are a lot of programmes, so after the      |
+| first link the driver's own binary (glGetProgramBinary()) is written to a    |
+| file, and later start-ups hand it back with glProgramBinary() instead.       |
+| One file per pair of sources, named from a hash of their text - exactly the  |
+| text given to glShaderSource(), so anything that edits sources before that   |
+| has to happen before the hash. The header also holds a hash of the GL        |
+| vendor, renderer and version strings: binaries only work on the driver that  |
+| made them, so a new driver, a different GPU, a format the driver doesn't     |
+| list, or a binary it refuses to link are all compiled from source again and  |
+| the file replaced. Nothing fails because of the cache.                       |
+| File layout, in the machine's native byte order:                             |
+|   program_cache_header                                                       |
+|   binary_size bytes from glGetProgramBinary()                                |
+| Once init_program_cache() has been called, create_programme_from_files()     |
+| and create_programme_from_strings() in gl_utils go through the cache.        |
+\******************************************************************************/
+#ifndef _PROGRAM_CACHE_H_
+#define _PROGRAM_CACHE_H_
+
+#include <GL/glew.h>
+
+// "AGPB" read as a little-endian uint32
+#define PROGRAM_CACHE_MAGIC 0x42504741u
+// bump whenever program_cache_header changes
+#define PROGRAM_CACHE_VERSION 1u
+#define PROGRAM_CACHE_SUFFIX ".pbin"
+// the most binary formats remembered from GL_PROGRAM_BINARY_FORMATS. drivers list one or two
+#define PROGRAM_CACHE_MAX_FORMATS 16
+
+struct program_cache_header {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int header_size;
+  unsigned int binary_format;
+  unsigned long long binary_size;
+  // key. the file name comes from the two source hashes, so a file is only ever replaced by one for the same sources
+  unsigned long long vert_hash;
+  unsigned long long frag_hash;
+  unsigned long long driver_hash;
+};
+
+struct program_cache_stats {
+  int hits;     // made with glProgramBinary()
+  int misses;   // no cache file, so compiled from source
+  int rejected; // a file that didn't fit the driver, or that it refused, so compiled from source
+  int stored;   // binaries written after compiling
+  int failed;   // sources that didn't compile or link - these go uncached
+  double hit_ms;     // loading binaries, file access included
+  double compile_ms; // compiling and linking from source
+};
+
+/* turns the cache on, with files in dir (created if need be). call with the
+context current - it reads the driver's strings and binary formats. returns
+false, and leaves the cache off, if dir can't be made or the driver has no
+binary formats */
+bool init_program_cache( const char* dir );
+// turns it off again. files are left on disk
+void stop_program_cache();
+bool program_cache_enabled();
+
+/* as create_programme_from_strings() in gl_utils, but from the cache if
+there's a usable binary for these sources, and storing one if not. lengths
+may be -1 for null-terminated strings. returns 0 if it doesn't compile */
+GLuint create_programme_from_strings_cached( const char* vert_str, int vert_len, const char* frag_str, int frag_len );
+
+/* the two halves of create_programme_from_strings_cached(), for callers that
+compile and link themselves - e.g. the batch in programme_batch.h. on a miss
+load_cached_programme() returns 0 and fills in key, and the caller should set
+GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking, then hand the programme
+(0 if it failed) and how long it took to store_cached_programme() */
+struct program_cache_key {
+  unsigned long long vert_hash;
+  unsigned long long frag_hash;
+};
+GLuint load_cached_programme( const char* vert_str, int vert_len, const char* frag_str, int frag_len, program_cache_key* key );
+void store_cached_programme( const program_cache_key* key, GLuint programme, double compile_ms );
+
+// counts since start-up or the last reset
+program_cache_stats get_program_cache_stats();
+void reset_program_cache_stats();
+// writes the counts to gl_log
+void log_program_cache_stats();
+
+#endif
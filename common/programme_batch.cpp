@@ -0,0 +1,248 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Batched shader programme creation - see programme_batch.h.                   |
+\******************************************************************************/
+#include "programme_batch.h"
+#include "gl_utils.h"
+#include "program_cache.h"
+#if defined( _WIN32 )
+#include <GL/wglew.h>
+#elif !defined( __APPLE__ )
+#include <GL/glxew.h>
+#endif
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+// how long to sleep between polls of GL_COMPLETION_STATUS
+#define POLL_US 100
+
+struct batch_entry {
+  programme_timing timing;
+  GLuint vert, frag;
+  double start_ms;
+  bool compiled, linked;
+  program_cache_key key;
+};
+
+static batch_entry* g_entries;
+static int g_entry_count, g_entry_capacity;
+static programme_timing* g_timings;
+static int g_timing_count;
+static bool g_open;
+
+static double now_ms() {
+  return (double)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() / 1000.0;
+}
+
+/*----------------------------------HELPERS-----------------------------------*/
+// GLEW doesn't know the KHR name. it's the same extension as ARB, with the same GL_COMPLETION_STATUS
+static bool khr_parallel_shader_compile_available() {
+  GLint n = 0;
+  glGetIntegerv( GL_NUM_EXTENSIONS, &n );
+  for ( int i = 0; i < n; i++ ) {
+    const char* ext = (const char*)glGetStringi( GL_EXTENSIONS, i );
+    if ( ext && 0 == strcmp( ext, "GL_KHR_parallel_shader_compile" ) ) { return true; }
+  }
+  return false;
+}
+
+bool parallel_shader_compile_available() { return GLEW_ARB_parallel_shader_compile || khr_parallel_shader_compile_available(); }
+
+/* glMaxShaderCompilerThreadsKHR(), which GLEW doesn't load, from the same place
+GLEW gets everything else. NULL if there's no such function */
+static PFNGLMAXSHADERCOMPILERTHREADSARBPROC get_max_shader_compiler_threads_khr() {
+#if defined( _WIN32 )
+  return (PFNGLMAXSHADERCOMPILERTHREADSARBPROC)wglGetProcAddress( "glMaxShaderCompilerThreadsKHR" );
+#elif defined( __APPLE__ )
+  return NULL; // no parallel_shader_compile on OS X
+#else
+  return (PFNGLMAXSHADERCOMPILERTHREADSARBPROC)glXGetProcAddressARB( (const GLubyte*)"glMaxShaderCompilerThreadsKHR" );
+#endif
+}
+
+static batch_entry* add_entry( const char* name ) {
+  if ( g_entry_count == g_entry_capacity ) {
+    int capacity       = g_entry_capacity ? g_entry_capacity * 2 : 16;
+    batch_entry* grown = (batch_entry*)realloc( g_entries, capacity * sizeof( batch_entry ) );
+    if ( !grown ) { return NULL; }
+    g_entries        = grown;
+    g_entry_capacity = capacity;
+  }
+  batch_entry* e = &g_entries[g_entry_count++];
+  memset( e, 0, sizeof( batch_entry ) );
+  snprintf( e->timing.name, PROGRAMME_BATCH_NAME_LEN, "%s", name );
+  e->start_ms = now_ms();
+  return e;
+}
+
+// glCompileShader() without asking how it went
+static GLuint submit_shader( const char* source, int len, GLenum type ) {
+  GLuint shader   = glCreateShader( type );
+  const GLchar* p = (const GLchar*)source;
+  glShaderSource( shader, 1, &p, len < 0 ? NULL : &len );
+  glCompileShader( shader );
+  return shader;
+}
+
+static bool is_complete_shader( GLuint shader ) {
+  GLint params = GL_FALSE;
+  glGetShaderiv( shader, GL_COMPLETION_STATUS_ARB, &params );
+  return GL_TRUE == params;
+}
+
+static bool is_complete_programme( GLuint programme ) {
+  GLint params = GL_FALSE;
+  glGetProgramiv( programme, GL_COMPLETION_STATUS_ARB, &params );
+  return GL_TRUE == params;
+}
+
+/* with parallel_shader_compile, polls until every entry is done, timing each
+as it finishes */
+static void poll_until_done() {
+  for ( ;; ) {
+    bool waiting = false;
+    for ( int i = 0; i < g_entry_count; i++ ) {
+      batch_entry* e = &g_entries[i];
+      if ( !e->compiled && is_complete_shader( e->vert ) && is_complete_shader( e->frag ) ) {
+        e->compiled          = true;
+        e->timing.compile_ms = now_ms() - e->start_ms;
+      }
+      if ( e->compiled && !e->linked && is_complete_programme( e->timing.programme ) ) {
+        e->linked         = true;
+        e->timing.link_ms = now_ms() - e->start_ms;
+      }
+      waiting = waiting || !e->linked;
+    }
+    if ( !waiting ) { return; }
+    std::this_thread::sleep_for( std::chrono::microseconds( POLL_US ) );
+  }
+}
+
+/*------------------------------------API-------------------------------------*/
+void begin_programme_batch() {
+  if ( g_open ) { end_programme_batch(); }
+  g_entry_count = 0;
+  g_open        = true;
+  // 0xFFFFFFFF lets the driver pick
+  if ( GLEW_ARB_parallel_shader_compile && glMaxShaderCompilerThreadsARB ) {
+    glMaxShaderCompilerThreadsARB( 0xFFFFFFFF );
+  } else if ( khr_parallel_shader_compile_available() ) {
+    PFNGLMAXSHADERCOMPILERTHREADSARBPROC max_threads_khr = get_max_shader_compiler_threads_khr();
+    if ( max_threads_khr ) { max_threads_khr( 0xFFFFFFFF ); }
+  }
+}
+
+bool programme_batch_open() { return g_open; }
+
+GLuint submit_programme( const char* name, const char* vert_str, int vert_len, const char* frag_str, int frag_len ) {
+  batch_entry* e = add_entry( name );
+  if ( !e ) {
+    gl_log_err( "ERROR: out of memory for the programme batch\n" );
+    return 0;
+  }
+  if ( program_cache_enabled() ) {
+    GLuint programme = load_cached_programme( vert_str, vert_len, frag_str, frag_len, &e->key );
+    if ( programme ) {
+      e->timing.programme  = programme;
+      e->timing.from_cache = true;
+      e->compiled = e->linked = true;
+      e->timing.submit_ms = e->timing.compile_ms = e->timing.link_ms = now_ms() - e->start_ms;
+      return programme;
+    }
+  }
+  e->vert             = submit_shader( vert_str, vert_len, GL_VERTEX_SHADER );
+  e->frag             = submit_shader( frag_str, frag_len, GL_FRAGMENT_SHADER );
+  GLuint programme    = glCreateProgram();
+  e->timing.programme = programme;
+  if ( program_cache_enabled() ) { glProgramParameteri( programme, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE ); }
+  glAttachShader( programme, e->vert );
+  glAttachShader( programme, e->frag );
+  // the link waits for the compiles inside the driver, not here
+  glLinkProgram( programme );
+  e->timing.submit_ms = now_ms() - e->start_ms;
+  return programme;
+}
+
+bool end_programme_batch() {
+  if ( !g_open ) { return true; }
+  g_open = false;
+  if ( parallel_shader_compile_available() ) {
+    poll_until_done();
+  } else {
+    // each query blocks, so these are times to done in submission order
+    for ( int i = 0; i < g_entry_count; i++ ) {
+      batch_entry* e = &g_entries[i];
+      if ( e->linked ) { continue; }
+      GLint params = -1;
+      glGetShaderiv( e->vert, GL_COMPILE_STATUS, &params );
+      glGetShaderiv( e->frag, GL_COMPILE_STATUS, &params );
+      e->timing.compile_ms = now_ms() - e->start_ms;
+      glGetProgramiv( e->timing.programme, GL_LINK_STATUS, &params );
+      e->timing.link_ms = now_ms() - e->start_ms;
+    }
+  }
+
+  bool all_ok = true;
+  for ( int i = 0; i < g_entry_count; i++ ) {
+    batch_entry* e   = &g_entries[i];
+    GLuint programme = e->timing.programme;
+    if ( e->timing.from_cache ) {
+      e->timing.ok = true;
+    } else {
+      GLint vert_ok = GL_FALSE, frag_ok = GL_FALSE, link_ok = GL_FALSE;
+      glGetShaderiv( e->vert, GL_COMPILE_STATUS, &vert_ok );
+      glGetShaderiv( e->frag, GL_COMPILE_STATUS, &frag_ok );
+      glGetProgramiv( programme, GL_LINK_STATUS, &link_ok );
+      if ( GL_TRUE != vert_ok ) {
+        gl_log_err( "ERROR: GL shader index %i did not compile (vertex shader of %s)\n", e->vert, e->timing.name );
+        print_shader_info_log( e->vert );
+      }
+      if ( GL_TRUE != frag_ok ) {
+        gl_log_err( "ERROR: GL shader index %i did not compile (fragment shader of %s)\n", e->frag, e->timing.name );
+        print_shader_info_log( e->frag );
+      }
+      if ( GL_TRUE == vert_ok && GL_TRUE == frag_ok && GL_TRUE != link_ok ) {
+        gl_log_err( "ERROR: could not link shader programme GL index %u (%s)\n", programme, e->timing.name );
+        print_programme_info_log( programme );
+      }
+      e->timing.ok = GL_TRUE == link_ok;
+      glDetachShader( programme, e->vert );
+      glDetachShader( programme, e->frag );
+      glDeleteShader( e->vert );
+      glDeleteShader( e->frag );
+      if ( program_cache_enabled() ) { store_cached_programme( &e->key, e->timing.ok ? programme : 0, e->timing.link_ms ); }
+    }
+    all_ok = all_ok && e->timing.ok;
+    gl_log( "programme %u (%s)%s: %.2fms to submit, compiled %.2fms and linked %.2fms after starting\n", programme, e->timing.name,
+      e->timing.from_cache ? " from the cache" : "", e->timing.submit_ms, e->timing.compile_ms, e->timing.link_ms );
+  }
+
+  // keep the timings apart from the entries, so a new batch can start while they're read
+  programme_timing* timings = (programme_timing*)realloc( g_timings, ( g_entry_count ? g_entry_count : 1 ) * sizeof( programme_timing ) );
+  if ( timings ) {
+    g_timings      = timings;
+    g_timing_count = g_entry_count;
+    for ( int i = 0; i < g_entry_count; i++ ) { g_timings[i] = g_entries[i].timing; }
+  }
+  g_entry_count = 0;
+  return all_ok;
+}
+
+bool programme_batch_linked( GLuint programme ) {
+  for ( int i = 0; i < g_timing_count; i++ ) {
+    if ( g_timings[i].programme == programme ) { return g_timings[i].ok; }
+  }
+  return false;
+}
+
+const programme_timing* programme_batch_timings( int* count ) {
+  *count = g_timing_count;
+  return g_timings;
+}
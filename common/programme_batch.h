@@ -0,0 +1,68 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Batched shader programme creation. Asking for a shader's compile status      |
+| straight after glCompileShader() makes the CPU wait for every compile and    |
+| link in turn. Between begin_programme_batch() and end_programme_batch(),     |
+| create_programme_from_files() and create_programme_from_strings() in         |
+| gl_utils only submit the compiles and the link, and return the programme     |
+| straight away. end_programme_batch() then waits for them all, checks and     |
+| logs each one, and records how long each took. With                          |
+| KHR/ARB_parallel_shader_compile the driver compiles on its own threads, and  |
+| the wait polls GL_COMPLETION_STATUS so each time is the programme's own.     |
+| Without it the statuses are asked for in order after everything has been     |
+| submitted, so a driver that compiles lazily still overlaps the work.         |
+| Programmes from the binary cache (program_cache.h) are used as they are,     |
+| and new ones are stored once they have linked.                               |
+| The programmes can be used before end_programme_batch() - GL waits for the   |
+| link where it has to - but asking for uniform locations straight after each  |
+| create defeats the point: do that after the batch.                           |
+\******************************************************************************/
+#ifndef _PROGRAMME_BATCH_H_
+#define _PROGRAMME_BATCH_H_
+
+#include <GL/glew.h>
+
+#define PROGRAMME_BATCH_NAME_LEN 128
+
+struct programme_timing {
+  char name[PROGRAMME_BATCH_NAME_LEN]; // the source files, or "strings"
+  GLuint programme;
+  /* time spent in the GL calls submitting it - where a driver that compiles
+  as it's asked to does all the work - then from the start of submitting to
+  the compiles, and then the link, being done */
+  double submit_ms;
+  double compile_ms;
+  double link_ms;
+  bool from_cache;
+  bool ok; // compiled and linked
+};
+
+/* starts a batch, and asks the driver for as many compiler threads as it
+likes if it has parallel_shader_compile. call with the context current */
+void begin_programme_batch();
+bool programme_batch_open();
+/* waits for everything submitted since begin_programme_batch(), logs any
+errors and each programme's times to gl_log, and stores new binaries in the
+program cache. returns false if any programme failed. a failed programme's
+handle is NOT deleted, since the caller already has it and GL could hand the
+name out again: it stays valid but unlinked, and glUseProgram() on it is a GL
+error. check with programme_batch_linked() and delete it yourself */
+bool end_programme_batch();
+/* true if programme was in the last batch ended and compiled and linked (or
+came from the program cache) */
+bool programme_batch_linked( GLuint programme );
+// true if the driver has KHR_ or ARB_parallel_shader_compile
+bool parallel_shader_compile_available();
+
+/* compiles and links without waiting, as create_programme_from_strings()
+does between begin and end. name is for the log */
+GLuint submit_programme( const char* name, const char* vert_str, int vert_len, const char* frag_str, int frag_len );
+
+// the programmes in the last batch ended, in the order they were created. valid until the next one ends
+const programme_timing* programme_batch_timings( int* count );
+
+#endif
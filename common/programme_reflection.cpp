@@ -0,0 +1,401 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Uniform reflection and redundant upload skipping - see                       |
+| programme_reflection.h.                                                      |
+\******************************************************************************/
+#include "programme_reflection.h"
+#include "gl_log.h"
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the setters hand arrays of these straight to GL
+static_assert( sizeof( vec4 ) == 4 * sizeof( float ) && sizeof( mat4 ) == 16 * sizeof( float ), "vec4 and mat4 must be tightly packed floats" );
+
+/*---------------------------------INTERNING----------------------------------*/
+static std::mutex g_intern_mutex;
+static char** g_strings;
+static int g_string_count, g_string_capacity;
+// open addressing from a name's hash to its id. -1 is empty
+static int* g_intern_table;
+static int g_intern_table_size;
+
+static unsigned int hash_name( const char* s ) {
+  unsigned int h = 2166136261u;
+  for ( ; *s; s++ ) { h = ( h ^ (unsigned char)*s ) * 16777619u; }
+  return h;
+}
+
+// the slot holding name's id, or the empty one it would go in. call locked, with a table
+static int intern_slot( const char* name ) {
+  int mask = g_intern_table_size - 1;
+  int i    = (int)( hash_name( name ) & mask );
+  while ( g_intern_table[i] >= 0 && 0 != strcmp( g_strings[g_intern_table[i]], name ) ) { i = ( i + 1 ) & mask; }
+  return i;
+}
+
+// doubles the table and re-inserts every id. call locked
+static bool grow_intern_table() {
+  int size   = g_intern_table_size ? g_intern_table_size * 2 : 256;
+  int* table = (int*)malloc( size * sizeof( int ) );
+  if ( !table ) { return false; }
+  free( g_intern_table );
+  g_intern_table      = table;
+  g_intern_table_size = size;
+  memset( g_intern_table, -1, size * sizeof( int ) );
+  for ( int id = 0; id < g_string_count; id++ ) { g_intern_table[intern_slot( g_strings[id] )] = id; }
+  return true;
+}
+
+int intern_name( const char* name ) {
+  std::lock_guard<std::mutex> lock( g_intern_mutex );
+  // kept under half full so probes stay short
+  if ( ( g_string_count + 1 ) * 2 > g_intern_table_size && !grow_intern_table() ) { return -1; }
+  int slot = intern_slot( name );
+  if ( g_intern_table[slot] >= 0 ) { return g_intern_table[slot]; }
+  if ( g_string_count == g_string_capacity ) {
+    int capacity = g_string_capacity ? g_string_capacity * 2 : 128;
+    char** grown = (char**)realloc( g_strings, capacity * sizeof( char* ) );
+    if ( !grown ) { return -1; }
+    g_strings         = grown;
+    g_string_capacity = capacity;
+  }
+  size_t len = strlen( name ) + 1;
+  char* copy = (char*)malloc( len );
+  if ( !copy ) { return -1; }
+  memcpy( copy, name, len );
+  g_strings[g_string_count] = copy;
+  g_intern_table[slot]      = g_string_count;
+  return g_string_count++;
+}
+
+// as intern_name(), but -1 rather than adding a name nothing has
+static int find_interned( const char* name ) {
+  std::lock_guard<std::mutex> lock( g_intern_mutex );
+  if ( !g_intern_table ) { return -1; }
+  return g_intern_table[intern_slot( name )];
+}
+
+const char* interned_name( int id ) {
+  std::lock_guard<std::mutex> lock( g_intern_mutex );
+  return id >= 0 && id < g_string_count ? g_strings[id] : NULL;
+}
+
+/*-----------------------------------TYPES------------------------------------*/
+static bool is_sampler( GLenum type ) {
+  switch ( type ) {
+  case GL_SAMPLER_1D:
+  case GL_SAMPLER_2D:
+  case GL_SAMPLER_3D:
+  case GL_SAMPLER_CUBE:
+  case GL_SAMPLER_1D_SHADOW:
+  case GL_SAMPLER_2D_SHADOW:
+  case GL_SAMPLER_1D_ARRAY:
+  case GL_SAMPLER_2D_ARRAY:
+  case GL_SAMPLER_1D_ARRAY_SHADOW:
+  case GL_SAMPLER_2D_ARRAY_SHADOW:
+  case GL_SAMPLER_CUBE_SHADOW:
+  case GL_SAMPLER_2D_RECT:
+  case GL_SAMPLER_2D_RECT_SHADOW:
+  case GL_SAMPLER_BUFFER:
+  case GL_SAMPLER_2D_MULTISAMPLE:
+  case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+  case GL_SAMPLER_CUBE_MAP_ARRAY:
+  case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+  case GL_INT_SAMPLER_2D:
+  case GL_INT_SAMPLER_3D:
+  case GL_INT_SAMPLER_CUBE:
+  case GL_INT_SAMPLER_2D_ARRAY:
+  case GL_INT_SAMPLER_BUFFER:
+  case GL_UNSIGNED_INT_SAMPLER_2D:
+  case GL_UNSIGNED_INT_SAMPLER_3D:
+  case GL_UNSIGNED_INT_SAMPLER_CUBE:
+  case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+  case GL_UNSIGNED_INT_SAMPLER_BUFFER: return true;
+  default: return false;
+  }
+}
+
+/* floats (is_float) or ints per element, as glGetUniform*v() gives them. 0
+for types the setters don't take, which are left untracked */
+static int type_components( GLenum type, bool* is_float ) {
+  *is_float = true;
+  switch ( type ) {
+  case GL_FLOAT: return 1;
+  case GL_FLOAT_VEC2: return 2;
+  case GL_FLOAT_VEC3: return 3;
+  case GL_FLOAT_VEC4: return 4;
+  case GL_FLOAT_MAT3: return 9;
+  case GL_FLOAT_MAT4: return 16;
+  default: break;
+  }
+  *is_float = false;
+  if ( GL_INT == type || GL_BOOL == type || is_sampler( type ) ) { return 1; }
+  return 0;
+}
+
+// a setter for GL type setter_type can upload to a uniform of type
+static bool setter_takes( GLenum setter_type, GLenum type ) {
+  if ( setter_type == type ) { return true; }
+  return GL_INT == setter_type && ( GL_BOOL == type || is_sampler( type ) );
+}
+
+static void upload( GLuint programme, GLint location, GLenum setter_type, int count, const void* data ) {
+  const GLfloat* f = (const GLfloat*)data;
+  switch ( setter_type ) {
+  case GL_INT: glProgramUniform1iv( programme, location, count, (const GLint*)data ); break;
+  case GL_FLOAT: glProgramUniform1fv( programme, location, count, f ); break;
+  case GL_FLOAT_VEC2: glProgramUniform2fv( programme, location, count, f ); break;
+  case GL_FLOAT_VEC3: glProgramUniform3fv( programme, location, count, f ); break;
+  case GL_FLOAT_VEC4: glProgramUniform4fv( programme, location, count, f ); break;
+  case GL_FLOAT_MAT3: glProgramUniformMatrix3fv( programme, location, count, GL_FALSE, f ); break;
+  case GL_FLOAT_MAT4: glProgramUniformMatrix4fv( programme, location, count, GL_FALSE, f ); break;
+  default: break;
+  }
+}
+
+/*---------------------------------REFLECTION---------------------------------*/
+// cuts a "[0]" off the end of an array's name, in place
+static void strip_array_suffix( char* name ) {
+  size_t len = strlen( name );
+  if ( len > 3 && 0 == strcmp( name + len - 3, "[0]" ) ) { name[len - 3] = '\0'; }
+}
+
+static int table_slot( const programme_reflection* r, int name_id ) {
+  int mask = r->table_size - 1;
+  int i    = (int)( ( (unsigned int)name_id * 2654435761u ) & mask );
+  while ( r->table[i] >= 0 && r->uniforms[r->table[i]].name_id != name_id ) { i = ( i + 1 ) & mask; }
+  return i;
+}
+
+bool reflect_programme( GLuint programme, programme_reflection* r ) {
+  memset( r, 0, sizeof( programme_reflection ) );
+  r->programme = programme;
+  GLint linked = GL_FALSE;
+  glGetProgramiv( programme, GL_LINK_STATUS, &linked );
+  if ( GL_TRUE != linked ) {
+    gl_log_err( "ERROR: can't reflect programme %u - it isn't linked\n", programme );
+    return false;
+  }
+  GLint n_uniforms = 0, n_blocks = 0;
+  glGetProgramiv( programme, GL_ACTIVE_UNIFORMS, &n_uniforms );
+  glGetProgramiv( programme, GL_ACTIVE_UNIFORM_BLOCKS, &n_blocks );
+  r->table_size = 8;
+  while ( r->table_size < n_uniforms * 2 ) { r->table_size *= 2; }
+  r->uniforms = (reflected_uniform*)calloc( n_uniforms > 0 ? n_uniforms : 1, sizeof( reflected_uniform ) );
+  r->blocks   = (reflected_block*)calloc( n_blocks > 0 ? n_blocks : 1, sizeof( reflected_block ) );
+  r->table    = (int*)malloc( r->table_size * sizeof( int ) );
+  GLuint* indices = (GLuint*)malloc( ( n_uniforms > 0 ? n_uniforms : 1 ) * sizeof( GLuint ) );
+  GLint* params   = (GLint*)malloc( ( n_uniforms > 0 ? n_uniforms : 1 ) * 4 * sizeof( GLint ) );
+  if ( !r->uniforms || !r->blocks || !r->table || !indices || !params ) {
+    gl_log_err( "ERROR: out of memory reflecting programme %u\n", programme );
+    free( indices );
+    free( params );
+    free_programme_reflection( r );
+    return false;
+  }
+  memset( r->table, -1, r->table_size * sizeof( int ) );
+  char name[REFLECTION_MAX_NAME];
+
+  for ( int b = 0; b < n_blocks; b++ ) {
+    reflected_block& rb = r->blocks[r->block_count++];
+    GLsizei len         = 0;
+    glGetActiveUniformBlockName( programme, b, REFLECTION_MAX_NAME, &len, name );
+    rb.name_id = intern_name( name );
+    rb.index   = (GLuint)b;
+    glGetActiveUniformBlockiv( programme, b, GL_UNIFORM_BLOCK_DATA_SIZE, &rb.data_size );
+    glGetActiveUniformBlockiv( programme, b, GL_UNIFORM_BLOCK_BINDING, &rb.binding );
+  }
+
+  // every property of every uniform in one call each
+  for ( int i = 0; i < n_uniforms; i++ ) { indices[i] = (GLuint)i; }
+  GLint* types   = params;
+  GLint* sizes   = params + n_uniforms;
+  GLint* blocks  = params + n_uniforms * 2;
+  GLint* offsets = params + n_uniforms * 3;
+  glGetActiveUniformsiv( programme, n_uniforms, indices, GL_UNIFORM_TYPE, types );
+  glGetActiveUniformsiv( programme, n_uniforms, indices, GL_UNIFORM_SIZE, sizes );
+  glGetActiveUniformsiv( programme, n_uniforms, indices, GL_UNIFORM_BLOCK_INDEX, blocks );
+  glGetActiveUniformsiv( programme, n_uniforms, indices, GL_UNIFORM_OFFSET, offsets );
+  int n_locations = 0, values_bytes = 0;
+  for ( int i = 0; i < n_uniforms; i++ ) {
+    reflected_uniform& ru = r->uniforms[i];
+    ru.type               = (GLenum)types[i];
+    ru.array_size         = sizes[i] > 0 ? sizes[i] : 1;
+    ru.block              = blocks[i];
+    ru.block_offset       = blocks[i] >= 0 ? offsets[i] : -1;
+    ru.first_location     = -1;
+    ru.value_offset       = -1;
+    if ( ru.block < 0 ) {
+      ru.first_location = n_locations;
+      n_locations += ru.array_size;
+      bool is_float = false;
+      int components = type_components( ru.type, &is_float );
+      if ( components > 0 ) {
+        ru.value_offset = values_bytes;
+        ru.value_size   = components * 4;
+        values_bytes += ru.value_size * ru.array_size;
+      }
+    }
+  }
+  free( indices );
+  free( params );
+  r->locations = (GLint*)malloc( ( n_locations > 0 ? n_locations : 1 ) * sizeof( GLint ) );
+  r->values    = (unsigned char*)calloc( values_bytes > 0 ? values_bytes : 1, 1 );
+  if ( !r->locations || !r->values ) {
+    gl_log_err( "ERROR: out of memory reflecting programme %u\n", programme );
+    free_programme_reflection( r );
+    return false;
+  }
+
+  // names and locations. arrays get every element's, once, here
+  for ( int i = 0; i < n_uniforms; i++ ) {
+    reflected_uniform& ru = r->uniforms[i];
+    GLsizei len           = 0;
+    glGetActiveUniformName( programme, (GLuint)i, REFLECTION_MAX_NAME, &len, name );
+    strip_array_suffix( name );
+    ru.name_id = intern_name( name );
+    r->uniform_count++;
+    r->table[table_slot( r, ru.name_id )] = i;
+    if ( ru.block >= 0 ) { continue; }
+    GLint* locations = r->locations + ru.first_location;
+    if ( 1 == ru.array_size ) {
+      locations[0] = glGetUniformLocation( programme, name );
+    } else {
+      char element[REFLECTION_MAX_NAME + 16];
+      for ( int e = 0; e < ru.array_size; e++ ) {
+        snprintf( element, sizeof( element ), "%s[%i]", name, e );
+        locations[e] = glGetUniformLocation( programme, element );
+      }
+    }
+  }
+  refresh_uniform_values( r );
+  gl_log( "reflected programme %u: %i uniforms, %i blocks, %i locations\n", programme, r->uniform_count, r->block_count, n_locations );
+  return true;
+}
+
+void free_programme_reflection( programme_reflection* r ) {
+  free( r->uniforms );
+  free( r->blocks );
+  free( r->locations );
+  free( r->values );
+  free( r->table );
+  memset( r, 0, sizeof( programme_reflection ) );
+}
+
+void refresh_uniform_values( programme_reflection* r ) {
+  for ( int i = 0; i < r->uniform_count; i++ ) {
+    const reflected_uniform& ru = r->uniforms[i];
+    if ( ru.value_offset < 0 ) { continue; }
+    bool is_float = false;
+    type_components( ru.type, &is_float );
+    for ( int e = 0; e < ru.array_size; e++ ) {
+      GLint location = r->locations[ru.first_location + e];
+      void* value    = r->values + ru.value_offset + e * ru.value_size;
+      if ( location < 0 ) { continue; }
+      if ( is_float ) {
+        glGetUniformfv( r->programme, location, (GLfloat*)value );
+      } else {
+        glGetUniformiv( r->programme, location, (GLint*)value );
+      }
+    }
+  }
+}
+
+int find_uniform_id( const programme_reflection* r, int name_id ) {
+  if ( name_id < 0 || !r->table ) { return -1; }
+  return r->table[table_slot( r, name_id )];
+}
+
+int find_uniform( const programme_reflection* r, const char* name ) {
+  size_t len = strlen( name );
+  if ( len <= 3 || 0 != strcmp( name + len - 3, "[0]" ) ) { return find_uniform_id( r, find_interned( name ) ); }
+  char base[REFLECTION_MAX_NAME];
+  snprintf( base, sizeof( base ), "%s", name );
+  strip_array_suffix( base );
+  return find_uniform_id( r, find_interned( base ) );
+}
+
+int find_uniform_block( const programme_reflection* r, const char* name ) {
+  int name_id = find_interned( name );
+  for ( int b = 0; b < r->block_count; b++ ) {
+    if ( r->blocks[b].name_id == name_id ) { return b; }
+  }
+  return -1;
+}
+
+bool bind_uniform_block( programme_reflection* r, int block, GLuint binding ) {
+  if ( block < 0 || block >= r->block_count ) {
+    gl_log_err( "ERROR: programme %u has no uniform block %i\n", r->programme, block );
+    return false;
+  }
+  reflected_block& rb = r->blocks[block];
+  if ( rb.binding == (GLint)binding ) {
+    r->skipped++;
+    return true;
+  }
+  glUniformBlockBinding( r->programme, rb.index, binding );
+  rb.binding = (GLint)binding;
+  r->uploads++;
+  return true;
+}
+
+/*----------------------------------SETTERS-----------------------------------*/
+/* uploads count elements from first, as setter_type, skipping the elements at
+either end that GL already has */
+static bool set_values( programme_reflection* r, int u, GLenum setter_type, int first, int count, const void* data ) {
+  if ( u < 0 || u >= r->uniform_count ) {
+    gl_log_err( "ERROR: programme %u: set_uniform() on a uniform it doesn't have (%i)\n", r->programme, u );
+    return false;
+  }
+  const reflected_uniform& ru = r->uniforms[u];
+  if ( ru.block >= 0 ) {
+    gl_log_err( "ERROR: programme %u: uniform %s is in a uniform block - write it to the block's buffer\n", r->programme, interned_name( ru.name_id ) );
+    return false;
+  }
+  if ( ru.value_offset < 0 || !setter_takes( setter_type, ru.type ) ) {
+    gl_log_err( "ERROR: programme %u: uniform %s is type 0x%x - it can't be set as 0x%x\n", r->programme, interned_name( ru.name_id ), ru.type, setter_type );
+    return false;
+  }
+  if ( first < 0 || count < 1 || first + count > ru.array_size ) {
+    gl_log_err( "ERROR: programme %u: elements %i to %i of uniform %s, which has %i\n", r->programme, first, first + count - 1, interned_name( ru.name_id ),
+      ru.array_size );
+    return false;
+  }
+  int sz                  = ru.value_size;
+  unsigned char* saved    = r->values + ru.value_offset + first * sz;
+  const unsigned char* in = (const unsigned char*)data;
+  int lo = -1, hi = -1;
+  for ( int i = 0; i < count; i++ ) {
+    if ( 0 != memcmp( saved + i * sz, in + i * sz, sz ) ) {
+      if ( lo < 0 ) { lo = i; }
+      hi = i;
+    }
+  }
+  if ( lo < 0 ) {
+    r->skipped++;
+    return true;
+  }
+  memcpy( saved + lo * sz, in + lo * sz, ( hi - lo + 1 ) * sz );
+  // glProgramUniform*() with a count fills consecutive elements from the location given
+  upload( r->programme, r->locations[ru.first_location + first + lo], setter_type, hi - lo + 1, in + lo * sz );
+  r->uploads++;
+  return true;
+}
+
+bool set_uniform( programme_reflection* r, int u, int v ) { return set_values( r, u, GL_INT, 0, 1, &v ); }
+bool set_uniform( programme_reflection* r, int u, float v ) { return set_values( r, u, GL_FLOAT, 0, 1, &v ); }
+bool set_uniform( programme_reflection* r, int u, const vec2& v ) { return set_values( r, u, GL_FLOAT_VEC2, 0, 1, v.v ); }
+bool set_uniform( programme_reflection* r, int u, const vec3& v ) { return set_values( r, u, GL_FLOAT_VEC3, 0, 1, v.v ); }
+bool set_uniform( programme_reflection* r, int u, const vec4& v ) { return set_values( r, u, GL_FLOAT_VEC4, 0, 1, v.v ); }
+bool set_uniform( programme_reflection* r, int u, const mat3& v ) { return set_values( r, u, GL_FLOAT_MAT3, 0, 1, v.m ); }
+bool set_uniform( programme_reflection* r, int u, const mat4& v ) { return set_values( r, u, GL_FLOAT_MAT4, 0, 1, v.m ); }
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const int* v ) { return set_values( r, u, GL_INT, first, count, v ); }
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const float* v ) { return set_values( r, u, GL_FLOAT, first, count, v ); }
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const vec4* v ) { return set_values( r, u, GL_FLOAT_VEC4, first, count, v ); }
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const mat4* v ) { return set_values( r, u, GL_FLOAT_MAT4, first, count, v ); }
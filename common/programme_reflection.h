@@ -0,0 +1,105 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Uniforms by handle instead of by string. Call reflect_programme() once after |
+| linking: it asks GL for every active uniform and uniform block, their types, |
+| array sizes and locations (every element's, for arrays), and the values      |
+| they start with, and puts the names in a hash table. find_uniform() then     |
+| gives a handle to keep instead of an "int X_loc", and set_uniform() uploads  |
+| with glProgramUniform*() - no glUseProgram() needed - only if the value is   |
+| different to the one GL already has. A whole array, e.g. a skeleton's bone   |
+| matrices, goes in one set_uniform_array() call, which uploads just the       |
+| span of elements that changed.                                               |
+| Names are interned: intern_name() gives each distinct string one id, the     |
+| same in every programme, so code can look up "P" as an int.                  |
+| The saved values are only right if every upload goes through here. After     |
+| calling glUniform*() on the programme directly, use                          |
+| refresh_uniform_values().                                                    |
+\******************************************************************************/
+#ifndef _PROGRAMME_REFLECTION_H_
+#define _PROGRAMME_REFLECTION_H_
+
+#include "maths_funcs.h"
+#include <GL/glew.h>
+
+// longest uniform or block name kept. GL_ACTIVE_UNIFORM_MAX_LENGTH is rarely near this
+#define REFLECTION_MAX_NAME 256
+
+/* the id for name, the same every call. safe to call from any thread. -1 if
+out of memory */
+int intern_name( const char* name );
+// the string for an id from intern_name()
+const char* interned_name( int id );
+
+struct reflected_uniform {
+  int name_id;    // an array's name has no "[0]" on the end
+  GLenum type;    // e.g. GL_FLOAT_MAT4
+  int array_size; // 1 if it isn't an array
+  // uniforms in a block have no location, just an offset in the block's buffer
+  int block;           // index into blocks, or -1
+  GLint block_offset;  // bytes, or -1 outside a block
+  int first_location;  // index of element 0's location in locations, or -1 in a block
+  int value_offset;    // of element 0 in values, or -1 in a block or for a type set_uniform() doesn't take
+  int value_size;      // bytes per element in values
+};
+
+struct reflected_block {
+  int name_id;
+  GLuint index;
+  GLint data_size; // bytes the buffer bound to it must have
+  GLint binding;
+};
+
+struct programme_reflection {
+  GLuint programme;
+  reflected_uniform* uniforms;
+  int uniform_count;
+  reflected_block* blocks;
+  int block_count;
+  GLint* locations;      // every element of every uniform outside a block
+  unsigned char* values; // what GL has for each, as floats or ints
+  // open addressing from name id to uniform index, table_size a power of 2
+  int* table;
+  int table_size;
+  // set_uniform() calls that uploaded, and that didn't because nothing changed
+  int uploads;
+  int skipped;
+};
+
+/* reads the active uniforms and blocks of a linked programme. returns false,
+and logs, if it isn't linked or runs out of memory */
+bool reflect_programme( GLuint programme, programme_reflection* r );
+void free_programme_reflection( programme_reflection* r );
+// reads every value back from GL, e.g. after glUniform*() calls made around set_uniform()
+void refresh_uniform_values( programme_reflection* r );
+
+/* the handle for a uniform, or -1 if the programme has no active uniform of
+that name (GLSL compilers remove unused ones). an array is found by its name
+with or without "[0]" - pass an element index to set_uniform_array() */
+int find_uniform( const programme_reflection* r, const char* name );
+int find_uniform_id( const programme_reflection* r, int name_id );
+// index into blocks, or -1
+int find_uniform_block( const programme_reflection* r, const char* name );
+// glUniformBlockBinding(), unless it's bound there already
+bool bind_uniform_block( programme_reflection* r, int block, GLuint binding );
+
+/* typed uploads. each returns false, and logs, if the handle is -1, the type
+doesn't match (int is for int, bool and sampler uniforms), or the uniform is
+in a block. they return true without calling GL if the value hasn't changed */
+bool set_uniform( programme_reflection* r, int u, int v );
+bool set_uniform( programme_reflection* r, int u, float v );
+bool set_uniform( programme_reflection* r, int u, const vec2& v );
+bool set_uniform( programme_reflection* r, int u, const vec3& v );
+bool set_uniform( programme_reflection* r, int u, const vec4& v );
+bool set_uniform( programme_reflection* r, int u, const mat3& v );
+bool set_uniform( programme_reflection* r, int u, const mat4& v );
+// count elements of an array uniform from element first. uploads in one call from the first changed element to the last
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const int* v );
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const float* v );
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const vec4* v );
+bool set_uniform_array( programme_reflection* r, int u, int first, int count, const mat4* v );
+
+#endif
@@ -0,0 +1,125 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shader source loading - see shader_source.h.                                 |
+\******************************************************************************/
+#include "shader_source.h"
+#include <limits.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+struct pool_buffer {
+  char* data;
+  size_t capacity;
+  bool in_use;
+};
+
+static pool_buffer g_pool[SHADER_SOURCE_POOL_BUFFERS];
+static std::mutex g_pool_mutex;
+
+/* a free pool buffer of at least sz bytes, grown if need be, or -1 if they're
+all in use. the biggest free one is picked, so one that's already grown is
+reused rather than another grown to match */
+static int take_pool_buffer( size_t sz ) {
+  std::lock_guard<std::mutex> lock( g_pool_mutex );
+  int best = -1;
+  for ( int i = 0; i < SHADER_SOURCE_POOL_BUFFERS; i++ ) {
+    if ( !g_pool[i].in_use && ( best < 0 || g_pool[i].capacity > g_pool[best].capacity ) ) { best = i; }
+  }
+  if ( best < 0 ) { return -1; }
+  pool_buffer& b = g_pool[best];
+  if ( b.capacity < sz ) {
+    char* grown = (char*)realloc( b.data, sz );
+    if ( !grown ) { return -1; }
+    b.data     = grown;
+    b.capacity = sz;
+  }
+  b.in_use = true;
+  return best;
+}
+
+// reads exactly sz bytes of file_name into buffer
+static bool read_whole_file( const char* file_name, char* buffer, size_t sz ) {
+#ifdef _WIN32
+  FILE* fp = fopen( file_name, "rb" );
+  if ( !fp ) { return false; }
+  bool ok = fread( buffer, 1, sz, fp ) == sz;
+  fclose( fp );
+  return ok;
+#else
+  int fd = open( file_name, O_RDONLY );
+  if ( fd < 0 ) { return false; }
+  size_t done = 0;
+  // one read() normally does it, but it's allowed to come back short
+  while ( done < sz ) {
+    ssize_t n = read( fd, buffer + done, sz - done );
+    if ( n <= 0 ) { break; }
+    done += (size_t)n;
+  }
+  close( fd );
+  return done == sz;
+#endif
+}
+
+bool load_shader_source( const char* file_name, shader_source* src ) {
+  memset( src, 0, sizeof( shader_source ) );
+  src->pool_index = -1;
+  struct stat st;
+  if ( 0 != stat( file_name, &st ) ) {
+    fprintf( stderr, "ERROR: could not open shader file %s\n", file_name );
+    return false;
+  }
+  // glShaderSource() takes an int length
+  if ( st.st_size < 0 || (unsigned long long)st.st_size >= INT_MAX ) {
+    fprintf( stderr, "ERROR: shader file %s is too big\n", file_name );
+    return false;
+  }
+  size_t sz = (size_t)st.st_size;
+  if ( sz >= SHADER_SOURCE_MAP_MIN ) {
+    if ( !map_file( file_name, &src->mf ) ) { return false; }
+    src->text = src->mf.data;
+    src->len  = (int)src->mf.sz;
+    return true;
+  }
+  // +1 for a terminating null
+  char* buffer    = NULL;
+  src->pool_index = take_pool_buffer( sz + 1 );
+  if ( src->pool_index >= 0 ) {
+    buffer = g_pool[src->pool_index].data;
+  } else {
+    buffer           = (char*)malloc( sz + 1 );
+    src->is_malloced = true;
+  }
+  src->text = buffer;
+  if ( !buffer || !read_whole_file( file_name, buffer, sz ) ) {
+    fprintf( stderr, "ERROR: could not read shader file %s\n", file_name );
+    free_shader_source( src );
+    return false;
+  }
+  buffer[sz] = '\0';
+  src->len   = (int)sz;
+  return true;
+}
+
+void free_shader_source( shader_source* src ) {
+  if ( src->pool_index >= 0 ) {
+    std::lock_guard<std::mutex> lock( g_pool_mutex );
+    g_pool[src->pool_index].in_use = false;
+  } else if ( src->is_malloced ) {
+    free( (void*)src->text );
+  } else {
+    unmap_file( &src->mf );
+  }
+  memset( src, 0, sizeof( shader_source ) );
+  src->pool_index = -1;
+}
@@ -0,0 +1,44 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Shader source files, of any length, loaded without copying line by line or   |
+| a fixed-size buffer on the stack. The file's size comes from stat(), then:   |
+| - small files (nearly all shaders) are read with one read() into a buffer    |
+|   from a small pool, which is kept and reused, so loading shaders doesn't    |
+|   allocate once the pool has grown to fit them                               |
+| - big files are mmap()ed, so they're never copied at all                     |
+| Either way, hand text and len straight to glShaderSource(), which copies     |
+| them itself - see create_shader_from_string() in gl_utils.                   |
+| No GL in here.                                                               |
+\******************************************************************************/
+#ifndef _SHADER_SOURCE_H_
+#define _SHADER_SOURCE_H_
+
+#include "mapped_file.h"
+
+// files at least this big are mapped, smaller ones read into the pool. below about this a read() is cheaper than the page faults
+#define SHADER_SOURCE_MAP_MIN ( 256 * 1024 )
+// sources that can be loaded at once before the pool falls back to malloc()
+#define SHADER_SOURCE_POOL_BUFFERS 4
+
+/* text is null-terminated if it was read into a buffer, but NOT if it was
+mapped - always use len */
+struct shader_source {
+  const char* text;
+  int len;
+  mapped_file mf;
+  // which pool buffer text is in, or -1 if it's mapped or malloc'd
+  int pool_index;
+  bool is_malloced;
+};
+
+/* on failure prints to stderr and returns false. safe to call from any
+thread. the source stays valid until free_shader_source() */
+bool load_shader_source( const char* file_name, shader_source* src );
+// hands the buffer back to the pool, or unmaps the file
+void free_shader_source( shader_source* src );
+
+#endif
@@ -0,0 +1,203 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Synthetic OBJ meshes of any size, for the mesh benchmarks.                   |
+\******************************************************************************/
+#include "synthetic_obj.h"
+#include <math.h>
+#include <stdio.h>
+
+size_t write_grid_obj( const char* file_name, int face_count, bool relative_faces ) {
+  FILE* fp = fopen( file_name, "w" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not write %s\n", file_name );
+    return 0;
+  }
+  int w = (int)sqrt( face_count / 2.0 );
+  if ( w < 1 ) { w = 1; }
+  fprintf( fp, "# synthetic grid, %i faces\no grid\n", 2 * w * w );
+  for ( int y = 0; y <= w; y++ ) {
+    for ( int x = 0; x <= w; x++ ) {
+      float fx = (float)x / w * 100.0f - 50.0f, fz = (float)y / w * 100.0f - 50.0f;
+      float fy = sinf( fx * 0.3f ) * cosf( fz * 0.2f ) * 4.0f;
+      static const char* fmts[8] = { "v %.9e %.9e %.9e\n", "v %.3f %.3f %.3f\n", "v %.12g %.12g %.12g\n", "v %.17g %.17g %.17g\n", "v %g %g %g\n",
+        "v %.1e %+.20f %.0f\n", "v %.30f %.8E %.15f\n", "v %f\t%f\t%f \r\n" };
+      const char* fmt            = ( ( x + y ) & 7 ) ? "v %f %f %f\n" : fmts[( ( x + y ) >> 3 ) & 7];
+      fprintf( fp, fmt, fx, fy, fz );
+    }
+  }
+  for ( int y = 0; y <= w; y++ ) {
+    for ( int x = 0; x <= w; x++ ) { fprintf( fp, "vt %f %f\n", (float)x / w, (float)y / w ); }
+  }
+  for ( int y = 0; y <= w; y++ ) {
+    for ( int x = 0; x <= w; x++ ) {
+      float fx = (float)x / w * 100.0f - 50.0f, fz = (float)y / w * 100.0f - 50.0f;
+      float dx = -cosf( fx * 0.3f ) * 1.2f * cosf( fz * 0.2f ), dz = sinf( fx * 0.3f ) * sinf( fz * 0.2f ) * 0.8f;
+      float l  = sqrtf( dx * dx + 1.0f + dz * dz );
+      fprintf( fp, "vn %f %f %f\n", dx / l, 1.0f / l, dz / l );
+    }
+  }
+  fprintf( fp, "s off\n" );
+  // -1 is the last vertex written
+  int rel = relative_faces ? -( ( w + 1 ) * ( w + 1 ) + 1 ) : 0;
+  for ( int y = 0; y < w; y++ ) {
+    for ( int x = 0; x < w; x++ ) {
+      int a = y * ( w + 1 ) + x + 1, b = a + 1, c = a + w + 1, d = c + 1;
+      fprintf( fp, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", a, a, a, c, c, c, b, b, b );
+      a += rel;
+      b += rel;
+      c += rel;
+      d += rel;
+      fprintf( fp, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", b, b, b, c, c, c, d, d, d );
+    }
+  }
+  long sz = ftell( fp );
+  fclose( fp );
+  return sz > 0 ? (size_t)sz : 0;
+}
+
+// point on the displaced sphere at polar angle theta (0 at +y) and azimuth phi
+static void sphere_point( float theta, float phi, float noise, float* p ) {
+  float d[3] = { sinf( theta ) * cosf( phi ), cosf( theta ), sinf( theta ) * sinf( phi ) };
+  float r    = 1.0f;
+  if ( noise > 0.0f ) {
+    // a few octaves of sines over the unit direction, so it matches up across the UV seam
+    float n = sinf( d[0] * 5.0f + 1.0f ) * sinf( d[1] * 7.0f ) * sinf( d[2] * 3.0f + 2.0f ) * 0.5f +
+              sinf( d[0] * 17.0f ) * sinf( d[1] * 13.0f + 1.0f ) * sinf( d[2] * 19.0f ) * 0.3f + sinf( d[0] * 41.0f + d[2] * 37.0f ) * 0.2f;
+    r += noise * n;
+  }
+  for ( int k = 0; k < 3; k++ ) { p[k] = d[k] * r; }
+}
+
+size_t write_sphere_obj( const char* file_name, int face_count, float noise ) {
+  FILE* fp = fopen( file_name, "w" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not write %s\n", file_name );
+    return 0;
+  }
+  // rings of quads, twice as many around as top to bottom. the pole rings are triangles
+  int rings = (int)sqrt( face_count / 4.0 );
+  if ( rings < 2 ) { rings = 2; }
+  int segs        = rings * 2;
+  const float pi  = 3.14159265358979f;
+  fprintf( fp, "# synthetic sphere, %i faces, noise %g\no sphere\n", 2 * segs * ( rings - 1 ), noise );
+  for ( int i = 0; i <= rings; i++ ) {
+    for ( int j = 0; j <= segs; j++ ) {
+      float p[3];
+      // the last column repeats the first, with its own tex coords. same position exactly
+      sphere_point( pi * i / rings, 2.0f * pi * ( j % segs ) / segs, noise, p );
+      fprintf( fp, "v %f %f %f\n", p[0], p[1], p[2] );
+    }
+  }
+  for ( int i = 0; i <= rings; i++ ) {
+    for ( int j = 0; j <= segs; j++ ) { fprintf( fp, "vt %f %f\n", (float)j / segs, 1.0f - (float)i / rings ); }
+  }
+  const float h = 1e-3f;
+  for ( int i = 0; i <= rings; i++ ) {
+    for ( int j = 0; j <= segs; j++ ) {
+      float theta = pi * i / rings, phi = 2.0f * pi * ( j % segs ) / segs;
+      float p[3], dt[3], dp[3], n[3];
+      sphere_point( theta, phi, noise, p );
+      sphere_point( theta + h, phi, noise, dt );
+      sphere_point( theta, phi + h, noise, dp );
+      for ( int k = 0; k < 3; k++ ) {
+        dt[k] -= p[k];
+        dp[k] -= p[k];
+      }
+      // outward is d/dphi x d/dtheta. at the poles d/dphi is 0, so use the direction
+      n[0]    = dp[1] * dt[2] - dp[2] * dt[1];
+      n[1]    = dp[2] * dt[0] - dp[0] * dt[2];
+      n[2]    = dp[0] * dt[1] - dp[1] * dt[0];
+      float l = sqrtf( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+      if ( 0 == i || rings == i || l < 1e-12f ) {
+        n[0] = 0.0f;
+        n[1] = 0 == i ? 1.0f : -1.0f;
+        n[2] = 0.0f;
+        l    = 1.0f;
+      }
+      fprintf( fp, "vn %f %f %f\n", n[0] / l, n[1] / l, n[2] / l );
+    }
+  }
+  fprintf( fp, "s 1\n" );
+  for ( int i = 0; i < rings; i++ ) {
+    for ( int j = 0; j < segs; j++ ) {
+      int a = i * ( segs + 1 ) + j + 1, b = a + 1, c = a + segs + 1, d = c + 1;
+      if ( i > 0 ) { fprintf( fp, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", a, a, a, b, b, b, c, c, c ); }
+      if ( i < rings - 1 ) { fprintf( fp, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", b, b, b, d, d, d, c, c, c ); }
+    }
+  }
+  long sz = ftell( fp );
+  fclose( fp );
+  return sz > 0 ? (size_t)sz : 0;
+}
+
+// hash of a lattice point to -1 to 1
+static float lattice_value( int x, int z, int octave ) {
+  unsigned int h = (unsigned int)x * 374761393u + (unsigned int)z * 668265263u + (unsigned int)octave * 2147483647u;
+  h              = ( h ^ ( h >> 13 ) ) * 1274126177u;
+  h ^= h >> 16;
+  return (float)( h & 0xffffff ) / (float)0x7fffff - 1.0f;
+}
+
+// smoothstepped bilinear value noise, 6 octaves, each half as big and twice as fine. about -1 to 1
+static float terrain_height( float x, float z ) {
+  float sum = 0.0f, amp = 0.5f, freq = 0.05f;
+  for ( int o = 0; o < 6; o++ ) {
+    float fx = x * freq, fz = z * freq;
+    int ix = (int)floorf( fx ), iz = (int)floorf( fz );
+    float tx = fx - ix, tz = fz - iz;
+    tx       = tx * tx * ( 3.0f - 2.0f * tx );
+    tz       = tz * tz * ( 3.0f - 2.0f * tz );
+    float a = lattice_value( ix, iz, o ), b = lattice_value( ix + 1, iz, o );
+    float c = lattice_value( ix, iz + 1, o ), d = lattice_value( ix + 1, iz + 1, o );
+    sum += amp * ( a + ( b - a ) * tx + ( c - a ) * tz + ( a - b - c + d ) * tx * tz );
+    amp *= 0.5f;
+    freq *= 2.0f;
+  }
+  return sum;
+}
+
+size_t write_terrain_obj( const char* file_name, int face_count, float amplitude ) {
+  FILE* fp = fopen( file_name, "w" );
+  if ( !fp ) {
+    fprintf( stderr, "ERROR: could not write %s\n", file_name );
+    return 0;
+  }
+  int w = (int)sqrt( face_count / 2.0 );
+  if ( w < 1 ) { w = 1; }
+  fprintf( fp, "# synthetic terrain, %i faces, amplitude %g\no terrain\n", 2 * w * w, amplitude );
+  for ( int y = 0; y <= w; y++ ) {
+    for ( int x = 0; x <= w; x++ ) {
+      float fx = (float)x / w * 100.0f - 50.0f, fz = (float)y / w * 100.0f - 50.0f;
+      fprintf( fp, "v %f %f %f\n", fx, amplitude * terrain_height( fx, fz ), fz );
+    }
+  }
+  for ( int y = 0; y <= w; y++ ) {
+    for ( int x = 0; x <= w; x++ ) { fprintf( fp, "vt %f %f\n", (float)x / w, (float)y / w ); }
+  }
+  // central differences over the heightfield, a fixed small step so the normals don't depend on the resolution
+  const float h = 0.01f;
+  for ( int y = 0; y <= w; y++ ) {
+    for ( int x = 0; x <= w; x++ ) {
+      float fx = (float)x / w * 100.0f - 50.0f, fz = (float)y / w * 100.0f - 50.0f;
+      float dx = amplitude * ( terrain_height( fx + h, fz ) - terrain_height( fx - h, fz ) ) / ( 2.0f * h );
+      float dz = amplitude * ( terrain_height( fx, fz + h ) - terrain_height( fx, fz - h ) ) / ( 2.0f * h );
+      float l  = sqrtf( dx * dx + 1.0f + dz * dz );
+      fprintf( fp, "vn %f %f %f\n", -dx / l, 1.0f / l, -dz / l );
+    }
+  }
+  fprintf( fp, "s 1\n" );
+  for ( int y = 0; y < w; y++ ) {
+    for ( int x = 0; x < w; x++ ) {
+      int a = y * ( w + 1 ) + x + 1, b = a + 1, c = a + w + 1, d = c + 1;
+      fprintf( fp, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", a, a, a, c, c, c, b, b, b );
+      fprintf( fp, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", b, b, b, c, c, c, d, d, d );
+    }
+  }
+  long sz = ftell( fp );
+  fclose( fp );
+  return sz > 0 ? (size_t)sz : 0;
+}
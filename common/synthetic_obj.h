@@ -0,0 +1,36 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Synthetic OBJ meshes of any size, for the mesh benchmarks.                   |
+\******************************************************************************/
+#ifndef _SYNTHETIC_OBJ_H_
+#define _SYNTHETIC_OBJ_H_
+
+#include <stddef.h>
+
+/* writes a wavy w * w quad grid with about face_count triangles, in the layout
+Blender exports: all v, then vt, then vn, then f a/b/c lines. most points are
+%f like Blender writes, but 1 in 8 use another format so the scanner's
+exponent, long-mantissa and strtof() fallback paths are all exercised. if
+relative_faces is set, every other face uses negative indices. returns the file
+size in bytes, or 0 on failure */
+size_t write_grid_obj( const char* file_name, int face_count, bool relative_faces );
+
+/* writes a closed UV sphere of radius 1 with about face_count triangles, wound
+counter-clockwise from outside. noise > 0 pushes the surface in and out by up
+to that fraction of the radius, for a lumpy, scan-like mesh. normals are the
+displaced surface's. same layout as write_grid_obj(), plain %f only. returns
+the file size in bytes, or 0 on failure */
+size_t write_sphere_obj( const char* file_name, int face_count, float noise );
+
+/* writes a square heightfield with about face_count triangles, displaced by
+fractal value noise up to amplitude (the square is 100 across), like a
+terrain scan: irregular heights and normals, unlike write_grid_obj()'s smooth
+waves. same layout as write_grid_obj(), plain %f only. returns the file size in
+bytes, or 0 on failure */
+size_t write_terrain_obj( const char* file_name, int face_count, float amplitude );
+
+#endif
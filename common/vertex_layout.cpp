@@ -0,0 +1,90 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Interleaved vertex layouts - see vertex_layout.h.                            |
+\******************************************************************************/
+#include "vertex_layout.h"
+#include "vertex_packing.h"
+#include <stdio.h>
+#include <string.h>
+
+// biggest vertex interleave_vertices() builds on the stack
+#define VERTEX_LAYOUT_MAX_STRIDE 256
+
+static void add_attrib( vertex_layout& l, unsigned int location, int components, vertex_attrib_type type, unsigned int offset ) {
+  vertex_attrib& a = l.attribs[l.attrib_count++];
+  a.location       = location;
+  a.components     = components;
+  a.type           = type;
+  a.offset         = offset;
+}
+
+vertex_layout make_vertex_layout( unsigned int flags, unsigned int alignment ) {
+  vertex_layout l;
+  memset( &l, 0, sizeof( l ) );
+  add_attrib( l, VERTEX_LOCATION_POINTS, 3, VERTEX_ATTRIB_FLOAT, 0 );
+  l.stride = 3 * sizeof( float );
+  if ( flags & VERTEX_LAYOUT_NORMALS ) {
+    add_attrib( l, VERTEX_LOCATION_NORMALS, 3, VERTEX_ATTRIB_FLOAT, l.stride );
+    l.stride += 3 * sizeof( float );
+  }
+  if ( flags & VERTEX_LAYOUT_TEX_COORDS ) {
+    add_attrib( l, VERTEX_LOCATION_TEX_COORDS, 2, VERTEX_ATTRIB_FLOAT, l.stride );
+    l.stride += 2 * sizeof( float );
+  }
+  if ( alignment > 1 && 0 == ( alignment & ( alignment - 1 ) ) ) { l.stride = ( l.stride + alignment - 1 ) & ~( alignment - 1 ); }
+  return l;
+}
+
+vertex_layout packed_vertex_layout() {
+  vertex_layout l;
+  memset( &l, 0, sizeof( l ) );
+  l.stride = sizeof( packed_vertex );
+  // pos[3] is padding, so the point is read as 3 components
+  add_attrib( l, VERTEX_LOCATION_POINTS, 3, VERTEX_ATTRIB_UNORM16, offsetof( packed_vertex, pos ) );
+  add_attrib( l, VERTEX_LOCATION_NORMALS, 2, VERTEX_ATTRIB_SNORM16, offsetof( packed_vertex, normal ) );
+  add_attrib( l, VERTEX_LOCATION_TEX_COORDS, 2, VERTEX_ATTRIB_HALF, offsetof( packed_vertex, tex_coord ) );
+  return l;
+}
+
+int find_vertex_attrib( const vertex_layout& layout, unsigned int location ) {
+  for ( int i = 0; i < layout.attrib_count; i++ ) {
+    if ( layout.attribs[i].location == location ) { return i; }
+  }
+  return -1;
+}
+
+bool interleave_vertices( const vertex_layout& layout, const float* points, const float* tex_coords, const float* normals, int vertex_count, void* out ) {
+  if ( layout.stride > VERTEX_LAYOUT_MAX_STRIDE ) {
+    fprintf( stderr, "ERROR: vertex stride %u too big to interleave\n", layout.stride );
+    return false;
+  }
+  const float* src[VERTEX_LAYOUT_MAX_ATTRIBS];
+  for ( int a = 0; a < layout.attrib_count; a++ ) {
+    const vertex_attrib& va = layout.attribs[a];
+    src[a]                  = NULL;
+    if ( VERTEX_ATTRIB_FLOAT == va.type ) {
+      if ( VERTEX_LOCATION_POINTS == va.location && 3 == va.components ) { src[a] = points; }
+      if ( VERTEX_LOCATION_NORMALS == va.location && 3 == va.components ) { src[a] = normals; }
+      if ( VERTEX_LOCATION_TEX_COORDS == va.location && 2 == va.components ) { src[a] = tex_coords; }
+    }
+    if ( !src[a] || va.offset + va.components * sizeof( float ) > layout.stride ) {
+      fprintf( stderr, "ERROR: can't interleave vertex attribute at location %u into this layout\n", va.location );
+      return false;
+    }
+  }
+  // each vertex is put together on the stack first, so out can be points
+  unsigned char vertex[VERTEX_LAYOUT_MAX_STRIDE];
+  for ( int i = vertex_count - 1; i >= 0; i-- ) {
+    memset( vertex, 0, layout.stride );
+    for ( int a = 0; a < layout.attrib_count; a++ ) {
+      const vertex_attrib& va = layout.attribs[a];
+      memcpy( &vertex[va.offset], &src[a][(size_t)i * va.components], va.components * sizeof( float ) );
+    }
+    memcpy( (unsigned char*)out + (size_t)i * layout.stride, vertex, layout.stride );
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Interleaved vertex layouts. Rather than one array (and one VBO) each for     |
+| points, normals and tex coords, every vertex's attributes sit side by side   |
+| in one buffer:  point normal tex | point normal tex | ...                    |
+| so a mesh is one VBO, and a vertex shader invocation reads one cache line.   |
+| vertex_layout says where each attribute is in a vertex; create_vao_from_     |
+| layout() in gl_utils turns it into the glVertexAttribPointer() calls.        |
+| No GL in here, so loaders and headless tools can use it too.                 |
+\******************************************************************************/
+#ifndef _VERTEX_LAYOUT_H_
+#define _VERTEX_LAYOUT_H_
+
+#include <stddef.h>
+
+#define VERTEX_LAYOUT_MAX_ATTRIBS 8
+
+// which attributes make_vertex_layout() includes. points always are
+#define VERTEX_LAYOUT_NORMALS 1u
+#define VERTEX_LAYOUT_TEX_COORDS 2u
+#define VERTEX_LAYOUT_ALL ( VERTEX_LAYOUT_NORMALS | VERTEX_LAYOUT_TEX_COORDS )
+
+// attribute locations, as the demos' shaders have them: layout( location = 0 ) in vec3 vertex_position; ...
+#define VERTEX_LOCATION_POINTS 0
+#define VERTEX_LOCATION_NORMALS 1
+#define VERTEX_LOCATION_TEX_COORDS 2
+
+/* component formats. the 16-bit ones are normalised (0 to 1, or -1 to 1), as
+vertex_packing writes them, except half floats */
+enum vertex_attrib_type { VERTEX_ATTRIB_FLOAT, VERTEX_ATTRIB_HALF, VERTEX_ATTRIB_UNORM16, VERTEX_ATTRIB_SNORM16 };
+
+// offset is in bytes from the start of the vertex
+struct vertex_attrib {
+  unsigned int location;
+  int components;
+  vertex_attrib_type type;
+  unsigned int offset;
+};
+
+// stride is the size of one vertex in bytes, padding included
+struct vertex_layout {
+  unsigned int stride;
+  int attrib_count;
+  vertex_attrib attribs[VERTEX_LAYOUT_MAX_ATTRIBS];
+};
+
+/* all-float layout of points, then normals, then tex coords, as flags pick.
+the stride is rounded up to a multiple of alignment bytes (a power of 2 - 4 for
+none, 16 so a vertex never straddles two cache lines) */
+vertex_layout make_vertex_layout( unsigned int flags, unsigned int alignment );
+
+// layout of vertex_packing's packed_vertex
+vertex_layout packed_vertex_layout();
+
+// index into layout.attribs of the attribute at location, or -1
+int find_vertex_attrib( const vertex_layout& layout, unsigned int location );
+
+/* copies load_obj_file style arrays into out, laid out as layout, which must
+be all-float with its attributes at the VERTEX_LOCATION_ locations. arrays the
+layout doesn't use may be NULL. padding is zeroed. out holds vertex_count *
+layout.stride bytes, and may be points itself, grown to that size with
+realloc(), since vertices are written last to first */
+bool interleave_vertices( const vertex_layout& layout, const float* points, const float* tex_coords, const float* normals, int vertex_count, void* out );
+
+#endif
@@ -0,0 +1,293 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Vertex attribute packing. See vertex_packing.h for the formats and the       |
+| matching glVertexAttribPointer() calls.                                      |
+\******************************************************************************/
+#include "vertex_packing.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+static float clampf( float v, float lo, float hi ) { return v < lo ? lo : ( v > hi ? hi : v ); }
+
+// -1 or 1, never 0, so that the octahedral fold doesn't collapse the axes
+static float sign_not_zero( float v ) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+/*---------------------------------POSITIONS----------------------------------*/
+void points_aabb( const float* points, size_t n, size_t stride, float* aabb_min, float* aabb_max ) {
+  if ( 0 == stride ) { stride = 3; }
+  for ( int c = 0; c < 3; c++ ) {
+    aabb_min[c] = n > 0 ? points[c] : 0.0f;
+    aabb_max[c] = aabb_min[c];
+  }
+  for ( size_t i = 0; i < n; i++ ) {
+    const float* p = &points[i * stride];
+    for ( int c = 0; c < 3; c++ ) {
+      if ( p[c] < aabb_min[c] ) { aabb_min[c] = p[c]; }
+      if ( p[c] > aabb_max[c] ) { aabb_max[c] = p[c]; }
+    }
+  }
+}
+
+void pack_positions_unorm16( const float* points, size_t n, const float* aabb_min, const float* aabb_max, unsigned short* out ) {
+  // in double: in float, rounding the offset and the scale could push a value near a half step onto the wrong side
+  double to_unorm[3];
+  for ( int c = 0; c < 3; c++ ) {
+    double extent = (double)aabb_max[c] - (double)aabb_min[c];
+    // flat axis - everything packs to 0
+    to_unorm[c] = extent > 0.0 ? 65535.0 / extent : 0.0;
+  }
+  for ( size_t i = 0; i < n; i++ ) {
+    for ( int c = 0; c < 3; c++ ) {
+      double q       = ( (double)points[i * 3 + c] - (double)aabb_min[c] ) * to_unorm[c];
+      q              = q < 0.0 ? 0.0 : ( q > 65535.0 ? 65535.0 : q );
+      out[i * 3 + c] = (unsigned short)( q + 0.5 );
+    }
+  }
+}
+
+float positions_unorm16_max_error( const float* aabb_min, const float* aabb_max ) {
+  double bound = 0.0;
+  for ( int c = 0; c < 3; c++ ) {
+    double extent = (double)aabb_max[c] - (double)aabb_min[c];
+    double big    = fmax( fabs( (double)aabb_min[c] ), fabs( (double)aabb_max[c] ) );
+    // half a step, then the unpack's float rounding: extent, step and offset each round once, then adding aabb_min rounds once more
+    double e = extent / 131070.0 + FLT_EPSILON * ( 1.5 * extent + 0.5 * big );
+    if ( e > bound ) { bound = e; }
+  }
+  return (float)bound;
+}
+
+void unpack_positions_unorm16( const unsigned short* packed, size_t n, const float* aabb_min, const float* aabb_max, float* out ) {
+  float step[3];
+  for ( int c = 0; c < 3; c++ ) { step[c] = ( aabb_max[c] - aabb_min[c] ) / 65535.0f; }
+  for ( size_t i = 0; i < n; i++ ) {
+    for ( int c = 0; c < 3; c++ ) { out[i * 3 + c] = aabb_min[c] + (float)packed[i * 3 + c] * step[c]; }
+  }
+}
+
+mat4 quantised_to_mesh_mat4( const float* aabb_min, const float* aabb_max ) {
+  // column-major: scale by the box extent, then translate to its min corner
+  return mat4( aabb_max[0] - aabb_min[0], 0.0f, 0.0f, 0.0f, 0.0f, aabb_max[1] - aabb_min[1], 0.0f, 0.0f, 0.0f, 0.0f, aabb_max[2] - aabb_min[2], 0.0f,
+    aabb_min[0], aabb_min[1], aabb_min[2], 1.0f );
+}
+
+/*----------------------------------NORMALS-----------------------------------*/
+/* the shader side is the same as oct_decode() below:
+vec3 oct_decode( vec2 e ) {
+  vec3 v = vec3( e.xy, 1.0 - abs( e.x ) - abs( e.y ) );
+  if ( v.z < 0.0 ) { v.xy = ( 1.0 - abs( v.yx ) ) * sign( v.xy ); }
+  return normalize( v );
+}
+GLSL's sign() returns 0 for 0, but the folded region never has x or y == 0 */
+static void oct_decode( short qx, short qy, float* v ) {
+  float x = clampf( (float)qx / 32767.0f, -1.0f, 1.0f );
+  float y = clampf( (float)qy / 32767.0f, -1.0f, 1.0f );
+  float z = 1.0f - fabsf( x ) - fabsf( y );
+  if ( z < 0.0f ) {
+    float fx = ( 1.0f - fabsf( y ) ) * sign_not_zero( x );
+    float fy = ( 1.0f - fabsf( x ) ) * sign_not_zero( y );
+    x        = fx;
+    y        = fy;
+  }
+  float len = sqrtf( x * x + y * y + z * z );
+  v[0]      = x / len;
+  v[1]      = y / len;
+  v[2]      = z / len;
+}
+
+void pack_normals_oct16( const float* normals, size_t n, short* out ) {
+  for ( size_t i = 0; i < n; i++ ) {
+    const float* v = &normals[i * 3];
+    float l1       = fabsf( v[0] ) + fabsf( v[1] ) + fabsf( v[2] );
+    if ( l1 <= 0.0f ) {
+      // zero-length normal. encode +z rather than NaN
+      out[i * 2] = out[i * 2 + 1] = 0;
+      continue;
+    }
+    // project onto the octahedron, then fold the lower half over the diagonals
+    float x = v[0] / l1, y = v[1] / l1;
+    if ( v[2] < 0.0f ) {
+      float fx = ( 1.0f - fabsf( y ) ) * sign_not_zero( x );
+      float fy = ( 1.0f - fabsf( x ) ) * sign_not_zero( y );
+      x        = fx;
+      y        = fy;
+    }
+    double len = sqrt( (double)v[0] * v[0] + (double)v[1] * v[1] + (double)v[2] * v[2] );
+    // plain rounding isn't always the closest code, so try the 4 around it
+    float bx = floorf( clampf( x, -1.0f, 1.0f ) * 32767.0f );
+    float by = floorf( clampf( y, -1.0f, 1.0f ) * 32767.0f );
+    /* compared in double and divided by both lengths. neighbouring codes differ by
+    ~1e-9 in cosine, less than the rounding in a float dot product */
+    double best_dot = -2.0;
+    short best[2]   = { 0, 0 };
+    for ( int j = 0; j < 4; j++ ) {
+      short qx = (short)clampf( bx + (float)( j & 1 ), -32767.0f, 32767.0f );
+      short qy = (short)clampf( by + (float)( j >> 1 ), -32767.0f, 32767.0f );
+      float d[3];
+      oct_decode( qx, qy, d );
+      double ld = sqrt( (double)d[0] * d[0] + (double)d[1] * d[1] + (double)d[2] * d[2] );
+      double dp = ( (double)d[0] * v[0] + (double)d[1] * v[1] + (double)d[2] * v[2] ) / ( len * ld );
+      if ( dp > best_dot ) {
+        best_dot = dp;
+        best[0]  = qx;
+        best[1]  = qy;
+      }
+    }
+    out[i * 2]     = best[0];
+    out[i * 2 + 1] = best[1];
+  }
+}
+
+void unpack_normals_oct16( const short* packed, size_t n, float* out ) {
+  for ( size_t i = 0; i < n; i++ ) { oct_decode( packed[i * 2], packed[i * 2 + 1], &out[i * 3] ); }
+}
+
+/*---------------------------------TEX COORDS---------------------------------*/
+unsigned short float_to_half( float f ) {
+  unsigned int x;
+  memcpy( &x, &f, sizeof( x ) );
+  unsigned int sign = ( x >> 16 ) & 0x8000;
+  unsigned int exp  = ( x >> 23 ) & 0xff;
+  unsigned int mant = x & 0x7fffff;
+  // inf stays inf and NaN stays a (quiet) NaN
+  if ( 0xff == exp ) { return (unsigned short)( sign | 0x7c00 | ( mant ? 0x200 : 0 ) ); }
+  int e = (int)exp - 127 + 15;
+  if ( e >= 0x1f ) { return (unsigned short)( sign | 0x7c00 ); }
+  if ( e <= 0 ) {
+    // subnormal half, or too small even for that
+    if ( e < -10 ) { return (unsigned short)sign; }
+    mant |= 0x800000;
+    unsigned int shift   = (unsigned int)( 14 - e );
+    unsigned int h       = mant >> shift;
+    unsigned int rem     = mant & ( ( 1u << shift ) - 1 );
+    unsigned int halfway = 1u << ( shift - 1 );
+    if ( rem > halfway || ( rem == halfway && ( h & 1 ) ) ) { h++; }
+    return (unsigned short)( sign | h );
+  }
+  unsigned int h   = sign | ( (unsigned int)e << 10 ) | ( mant >> 13 );
+  unsigned int rem = mant & 0x1fff;
+  // a carry out of the mantissa rolls into the exponent, up to inf, which is correct
+  if ( rem > 0x1000 || ( rem == 0x1000 && ( h & 1 ) ) ) { h++; }
+  return (unsigned short)h;
+}
+
+float half_to_float( unsigned short h ) {
+  unsigned int sign = ( (unsigned int)h & 0x8000 ) << 16;
+  unsigned int exp  = ( h >> 10 ) & 0x1f;
+  unsigned int mant = h & 0x3ff;
+  unsigned int x;
+  if ( 0 == exp ) {
+    // zero or subnormal: mant * 2^-24
+    float f = (float)mant * 5.9604644775390625e-8f;
+    return sign ? -f : f;
+  } else if ( 0x1f == exp ) {
+    x = sign | 0x7f800000 | ( mant << 13 );
+  } else {
+    x = sign | ( ( exp + 112 ) << 23 ) | ( mant << 13 );
+  }
+  float f;
+  memcpy( &f, &x, sizeof( f ) );
+  return f;
+}
+
+void pack_halfs( const float* in, size_t count, unsigned short* out ) {
+  for ( size_t i = 0; i < count; i++ ) { out[i] = float_to_half( in[i] ); }
+}
+
+void unpack_halfs( const unsigned short* packed, size_t count, float* out ) {
+  for ( size_t i = 0; i < count; i++ ) { out[i] = half_to_float( packed[i] ); }
+}
+
+void pack_unorm16( const float* in, size_t count, unsigned short* out ) {
+  for ( size_t i = 0; i < count; i++ ) { out[i] = (unsigned short)( clampf( in[i], 0.0f, 1.0f ) * 65535.0f + 0.5f ); }
+}
+
+void unpack_unorm16( const unsigned short* packed, size_t count, float* out ) {
+  for ( size_t i = 0; i < count; i++ ) { out[i] = (float)packed[i] / 65535.0f; }
+}
+
+/*--------------------------------WHOLE MESH----------------------------------*/
+/* the batched packers write tightly packed streams, so each chunk is packed a
+stream at a time into these, then interleaved. small enough for the stack */
+#define PACK_MESH_CHUNK 256
+
+void pack_mesh( const float* points, const float* normals, const float* tex_coords, size_t n, packed_vertex* out, float* aabb_min, float* aabb_max ) {
+  unsigned short pos[PACK_MESH_CHUNK * 3], tc[PACK_MESH_CHUNK * 2];
+  short nrm[PACK_MESH_CHUNK * 2];
+  points_aabb( points, n, 3, aabb_min, aabb_max );
+  for ( size_t first = 0; first < n; first += PACK_MESH_CHUNK ) {
+    size_t count = n - first < PACK_MESH_CHUNK ? n - first : PACK_MESH_CHUNK;
+    pack_positions_unorm16( &points[first * 3], count, aabb_min, aabb_max, pos );
+    if ( normals ) { pack_normals_oct16( &normals[first * 3], count, nrm ); }
+    if ( tex_coords ) { pack_halfs( &tex_coords[first * 2], count * 2, tc ); }
+    for ( size_t i = 0; i < count; i++ ) {
+      packed_vertex* v = &out[first + i];
+      memcpy( v->pos, &pos[i * 3], 3 * sizeof( unsigned short ) );
+      v->pos[3] = 0;
+      if ( normals ) {
+        memcpy( v->normal, &nrm[i * 2], 2 * sizeof( short ) );
+      } else {
+        v->normal[0] = v->normal[1] = 0;
+      }
+      if ( tex_coords ) {
+        memcpy( v->tex_coord, &tc[i * 2], 2 * sizeof( unsigned short ) );
+      } else {
+        v->tex_coord[0] = v->tex_coord[1] = 0;
+      }
+    }
+  }
+}
+
+void unpack_mesh( const packed_vertex* packed, size_t n, const float* aabb_min, const float* aabb_max, float* points, float* normals, float* tex_coords ) {
+  unsigned short pos[PACK_MESH_CHUNK * 3], tc[PACK_MESH_CHUNK * 2];
+  short nrm[PACK_MESH_CHUNK * 2];
+  for ( size_t first = 0; first < n; first += PACK_MESH_CHUNK ) {
+    size_t count = n - first < PACK_MESH_CHUNK ? n - first : PACK_MESH_CHUNK;
+    for ( size_t i = 0; i < count; i++ ) {
+      const packed_vertex* v = &packed[first + i];
+      memcpy( &pos[i * 3], v->pos, 3 * sizeof( unsigned short ) );
+      memcpy( &nrm[i * 2], v->normal, 2 * sizeof( short ) );
+      memcpy( &tc[i * 2], v->tex_coord, 2 * sizeof( unsigned short ) );
+    }
+    unpack_positions_unorm16( pos, count, aabb_min, aabb_max, &points[first * 3] );
+    if ( normals ) { unpack_normals_oct16( nrm, count, &normals[first * 3] ); }
+    if ( tex_coords ) { unpack_halfs( tc, count * 2, &tex_coords[first * 2] ); }
+  }
+}
+
+/*-------------------------------ERROR METRICS--------------------------------*/
+packing_error measure_error( const float* original, const float* unpacked, size_t count ) {
+  packing_error e = { 0.0f, 0.0f };
+  double sum_sq   = 0.0;
+  for ( size_t i = 0; i < count; i++ ) {
+    float d = fabsf( original[i] - unpacked[i] );
+    if ( d > e.max_err ) { e.max_err = d; }
+    sum_sq += (double)d * d;
+  }
+  e.rms_err = count > 0 ? (float)sqrt( sum_sq / (double)count ) : 0.0f;
+  return e;
+}
+
+packing_error measure_normal_error_deg( const float* original, const float* unpacked, size_t n ) {
+  packing_error e = { 0.0f, 0.0f };
+  double sum_sq   = 0.0;
+  for ( size_t i = 0; i < n; i++ ) {
+    const float* a = &original[i * 3];
+    const float* b = &unpacked[i * 3];
+    double dp      = (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+    // acos loses precision near 1, atan2 of |a x b| and a.b doesn't. neither needs unit vectors
+    double cx  = (double)a[1] * b[2] - (double)a[2] * b[1];
+    double cy  = (double)a[2] * b[0] - (double)a[0] * b[2];
+    double cz  = (double)a[0] * b[1] - (double)a[1] * b[0];
+    double deg = atan2( sqrt( cx * cx + cy * cy + cz * cz ), dp ) * 57.29577951308232;
+    if ( deg > e.max_err ) { e.max_err = (float)deg; }
+    sum_sq += deg * deg;
+  }
+  e.rms_err = n > 0 ? (float)sqrt( sum_sq / (double)n ) : 0.0f;
+  return e;
+}
@@ -0,0 +1,90 @@
+/******************************************************************************\
+| OpenGL 4 Example Code.                                                       |
+| Accompanies written series "Anton's OpenGL 4 Tutorials"                      |
+| Email: anton at antongerdelan dot net                                        |
+| See individual libraries' separate legal notices                             |
+|******************************************************************************|
+| Vertex attribute packing. Shrinks the 32-bit float arrays that come out of   |
+| load_obj_file (or Assimp) into smaller integer/half-float formats that GL    |
+| can read directly:                                                           |
+| positions  - 3x unsigned 16-bit, quantised to the mesh's bounding box        |
+|              glVertexAttribPointer( i, 3, GL_UNSIGNED_SHORT, GL_TRUE, ... )  |
+|              then scale back up with quantised_to_mesh_mat4() in the shader  |
+|              or folded into the model matrix                                 |
+| normals    - 2x signed 16-bit octahedral encoding                            |
+|              glVertexAttribPointer( i, 2, GL_SHORT, GL_TRUE, ... ) and then  |
+|              decode in the vertex shader (see oct_decode() in the .cpp)      |
+| tex coords - 2x half float (any range), GL_HALF_FLOAT, GL_FALSE, or          |
+|              2x unsigned 16-bit (0 to 1 only), GL_UNSIGNED_SHORT, GL_TRUE    |
+| packed_vertex puts all three in 16 bytes, vs 32 bytes for 8 floats.          |
+| Every pack function has an unpack function for measuring the error.          |
+\******************************************************************************/
+#ifndef _VERTEX_PACKING_H_
+#define _VERTEX_PACKING_H_
+
+#include "maths_funcs.h"
+#include <stddef.h>
+
+/* one vertex in 16 bytes. pos[3] is padding, to keep the normal 4-byte
+aligned. attribute byte offsets are 0 (pos), 8 (normal), and 12 (tex coord) */
+struct packed_vertex {
+  unsigned short pos[4];
+  short normal[2];
+  unsigned short tex_coord[2];
+};
+
+struct packing_error {
+  float max_err;
+  float rms_err;
+};
+
+/*---------------------------------POSITIONS----------------------------------*/
+// bounding box of n points, each starting every "stride" floats (0 = 3)
+void points_aabb( const float* points, size_t n, size_t stride, float* aabb_min, float* aabb_max );
+/* unorm16 per axis, 0 at aabb_min and 65535 at aabb_max. the packing rounds to
+the nearest step, so is out by at most half a step: ( max - min ) / 131070. the
+float maths in the unpack adds a few ulps on top of that - see
+positions_unorm16_max_error() */
+void pack_positions_unorm16( const float* points, size_t n, const float* aabb_min, const float* aabb_max, unsigned short* out );
+void unpack_positions_unorm16( const unsigned short* packed, size_t n, const float* aabb_min, const float* aabb_max, float* out );
+/* largest error any coordinate can have after a pack and unpack with this box,
+over all 3 axes: ( max - min ) / 131070 + FLT_EPSILON * ( 1.5 * ( max - min ) +
+0.5 * max( |min|, |max| ) ) */
+float positions_unorm16_max_error( const float* aabb_min, const float* aabb_max );
+// matrix taking normalised [0,1] positions back to mesh space. use as M * quantised_to_mesh_mat4( ... )
+mat4 quantised_to_mesh_mat4( const float* aabb_min, const float* aabb_max );
+
+/*----------------------------------NORMALS-----------------------------------*/
+/* octahedral encoding, as surveyed in Cigolle et al. "A Survey of Efficient
+Representations for Independent Unit Vectors" (2014). picks the best of the 4
+nearest 16-bit codes, so max error is ~0.003 degrees. normals needn't be unit */
+void pack_normals_oct16( const float* normals, size_t n, short* out );
+// unpacked normals are unit length
+void unpack_normals_oct16( const short* packed, size_t n, float* out );
+
+/*---------------------------------TEX COORDS---------------------------------*/
+// IEEE 754 half float, round-to-nearest-even. ~3 significant digits. count is number of floats
+unsigned short float_to_half( float f );
+float half_to_float( unsigned short h );
+void pack_halfs( const float* in, size_t count, unsigned short* out );
+void unpack_halfs( const unsigned short* packed, size_t count, float* out );
+// values are clamped to 0 to 1 first
+void pack_unorm16( const float* in, size_t count, unsigned short* out );
+void unpack_unorm16( const unsigned short* packed, size_t count, float* out );
+
+/*--------------------------------WHOLE MESH----------------------------------*/
+/* packs load_obj_file style arrays into packed_vertex. tex coords go in as half
+floats. aabb_min and aabb_max are filled in with the bounds for unpacking.
+normals or tex_coords may be NULL, e.g. from an OBJ without vn, and that field
+is then zeroed: the normal decodes as +z and the tex coord as 0,0 */
+void pack_mesh( const float* points, const float* normals, const float* tex_coords, size_t n, packed_vertex* out, float* aabb_min, float* aabb_max );
+// normals or tex_coords may be NULL to skip that field
+void unpack_mesh( const packed_vertex* packed, size_t n, const float* aabb_min, const float* aabb_max, float* points, float* normals, float* tex_coords );
+
+/*-------------------------------ERROR METRICS--------------------------------*/
+// largest and root-mean-square absolute difference over count floats
+packing_error measure_error( const float* original, const float* unpacked, size_t count );
+// angle in degrees between n pairs of xyz normals
+packing_error measure_normal_error_deg( const float* original, const float* unpacked, size_t n );
+
+#endif